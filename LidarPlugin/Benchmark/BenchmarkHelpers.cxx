@@ -0,0 +1,344 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BenchmarkHelpers.h"
+
+#include "NetworkPacket.h"
+#include "vtkDataPacket.h"
+#include "vtkPacketFileWriter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <sstream>
+
+using namespace DataPacketFixedLength;
+
+namespace
+{
+//-----------------------------------------------------------------------------
+std::string ToJSON(const std::string& value)
+{
+  std::ostringstream os;
+  os << '"';
+  for (char c : value)
+  {
+    switch (c)
+    {
+      case '"': os << "\\\""; break;
+      case '\\': os << "\\\\"; break;
+      case '\n': os << "\\n"; break;
+      case '\t': os << "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20)
+        {
+          os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+        }
+        else
+        {
+          os << c;
+        }
+    }
+  }
+  os << '"';
+  return os.str();
+}
+
+//-----------------------------------------------------------------------------
+std::string ToJSON(double value)
+{
+  if (!std::isfinite(value))
+  {
+    return "null";
+  }
+  std::ostringstream os;
+  os << std::setprecision(9) << value;
+  return os.str();
+}
+
+//-----------------------------------------------------------------------------
+//! Packet layout of a sensor spinning at 600 rpm in strongest return mode
+struct SyntheticSensorLayout
+{
+  const char* Name;
+  SensorType Type;
+  //! Identifiers of the successive blocks of a firing sequence
+  std::vector<uint16_t> BlockIdentifiers;
+  //! Number of firings of the lasers stored in a single block (2 for the VLP-16)
+  int FiringsPerBlock;
+  //! Time between two packets, in seconds
+  double PacketPeriod;
+};
+
+//-----------------------------------------------------------------------------
+const std::vector<SyntheticSensorLayout>& GetSyntheticLayouts()
+{
+  // a firing sequence lasts 55.296 us, except for the HDL-64 which sends
+  // about 3472 packets per second
+  static const std::vector<SyntheticSensorLayout> layouts = {
+    { "HDL-64", HDL64, { BLOCK_0_TO_31, BLOCK_32_TO_63 }, 1, 1. / 3472. },
+    { "VLP-16", VLP16, { BLOCK_0_TO_31 }, 2, 24 * 55.296e-6 },
+    { "VLP-32c", VLP32C, { BLOCK_0_TO_31 }, 1, 12 * 55.296e-6 },
+    { "VLS-128", VLS128, { BLOCK_0_TO_31, BLOCK_32_TO_63, BLOCK_64_TO_95, BLOCK_96_TO_127 }, 1,
+      3 * 55.296e-6 },
+  };
+  return layouts;
+}
+
+//-----------------------------------------------------------------------------
+//! Return of a laser in a smooth synthetic scene, with some empty returns
+HDLLaserReturn SyntheticReturn(int laserId, double azimuth)
+{
+  HDLLaserReturn laserReturn;
+  const int sector = static_cast<int>(azimuth);
+  if ((laserId * 7 + sector) % 20 == 0)
+  {
+    laserReturn.distance = 0;
+    laserReturn.intensity = 0;
+    return laserReturn;
+  }
+  // distance in 2 mm units
+  const double distance = 10. + 8. * std::sin(azimuth * 1.7e-4 * (1 + laserId % 5)) + 0.05 * laserId;
+  laserReturn.distance = static_cast<uint16_t>(distance / 0.002);
+  laserReturn.intensity = static_cast<uint8_t>((laserId * 13 + sector / 10) & 0xFF);
+  return laserReturn;
+}
+}
+
+//-----------------------------------------------------------------------------
+LatencySummary SummarizeLatencies(std::vector<double> durations)
+{
+  LatencySummary summary;
+  summary.Count = durations.size();
+  if (durations.empty())
+  {
+    return summary;
+  }
+  std::sort(durations.begin(), durations.end());
+  auto percentile = [&durations](double p)
+  {
+    size_t rank = static_cast<size_t>(std::ceil(p * durations.size()));
+    return durations[std::min(durations.size(), std::max<size_t>(rank, 1)) - 1];
+  };
+  summary.Mean = std::accumulate(durations.begin(), durations.end(), 0.) / durations.size();
+  summary.Min = durations.front();
+  summary.P50 = percentile(0.5);
+  summary.P90 = percentile(0.9);
+  summary.P99 = percentile(0.99);
+  summary.Max = durations.back();
+  return summary;
+}
+
+//-----------------------------------------------------------------------------
+BenchmarkReport::BenchmarkReport(const std::string& benchmarkName)
+{
+  this->SetAttribute("benchmark", benchmarkName);
+}
+
+//-----------------------------------------------------------------------------
+void BenchmarkReport::SetAttribute(const std::string& key, const std::string& value)
+{
+  for (auto& attribute : this->Attributes)
+  {
+    if (attribute.first == key)
+    {
+      attribute.second = ToJSON(value);
+      return;
+    }
+  }
+  this->Attributes.emplace_back(key, ToJSON(value));
+}
+
+//-----------------------------------------------------------------------------
+void BenchmarkReport::Add(const std::string& stage, const std::string& measure, double value)
+{
+  this->AddRaw(stage, measure, ToJSON(value));
+}
+
+//-----------------------------------------------------------------------------
+void BenchmarkReport::Add(const std::string& stage, const std::string& measure,
+                          const LatencySummary& latency)
+{
+  std::ostringstream os;
+  os << "{ \"count\": " << latency.Count
+     << ", \"mean\": " << ToJSON(latency.Mean)
+     << ", \"min\": " << ToJSON(latency.Min)
+     << ", \"p50\": " << ToJSON(latency.P50)
+     << ", \"p90\": " << ToJSON(latency.P90)
+     << ", \"p99\": " << ToJSON(latency.P99)
+     << ", \"max\": " << ToJSON(latency.Max) << " }";
+  this->AddRaw(stage, measure, os.str());
+}
+
+//-----------------------------------------------------------------------------
+void BenchmarkReport::AddRaw(const std::string& stage, const std::string& measure,
+                             const std::string& json)
+{
+  auto it = std::find_if(this->Stages.begin(), this->Stages.end(),
+                         [&stage](const std::pair<std::string, Entries>& s) { return s.first == stage; });
+  if (it == this->Stages.end())
+  {
+    this->Stages.emplace_back(stage, Entries());
+    it = this->Stages.end() - 1;
+  }
+  it->second.emplace_back(measure, json);
+}
+
+//-----------------------------------------------------------------------------
+void BenchmarkReport::Write(std::ostream& os) const
+{
+  os << "{\n";
+  for (const auto& attribute : this->Attributes)
+  {
+    os << "  " << ToJSON(attribute.first) << ": " << attribute.second << ",\n";
+  }
+  os << "  \"stages\": {";
+  for (size_t i = 0; i < this->Stages.size(); ++i)
+  {
+    os << (i ? ",\n" : "\n") << "    " << ToJSON(this->Stages[i].first) << ": {";
+    const Entries& measures = this->Stages[i].second;
+    for (size_t j = 0; j < measures.size(); ++j)
+    {
+      os << (j ? ",\n" : "\n") << "      " << ToJSON(measures[j].first) << ": " << measures[j].second;
+    }
+    os << "\n    }";
+  }
+  os << "\n  }\n}\n";
+}
+
+//-----------------------------------------------------------------------------
+bool BenchmarkReport::Write(const std::string& filename) const
+{
+  if (filename.empty() || filename == "-")
+  {
+    this->Write(std::cout);
+    return true;
+  }
+  std::ofstream file(filename);
+  if (!file.is_open())
+  {
+    std::cerr << "Could not write the benchmark report: " << filename << std::endl;
+    return false;
+  }
+  this->Write(file);
+  return file.good();
+}
+
+//-----------------------------------------------------------------------------
+std::vector<std::string> GetSyntheticSensors()
+{
+  std::vector<std::string> sensors;
+  for (const SyntheticSensorLayout& layout : GetSyntheticLayouts())
+  {
+    sensors.push_back(layout.Name);
+  }
+  return sensors;
+}
+
+//-----------------------------------------------------------------------------
+bool WriteSyntheticCapture(const std::string& sensor, double duration, const std::string& filename)
+{
+  const auto& layouts = GetSyntheticLayouts();
+  auto layout = std::find_if(layouts.begin(), layouts.end(),
+                             [&sensor](const SyntheticSensorLayout& l) { return sensor == l.Name; });
+  if (layout == layouts.end())
+  {
+    std::cerr << "No synthetic capture available for sensor: " << sensor << std::endl;
+    return false;
+  }
+
+  vtkPacketFileWriter writer;
+  if (!writer.Open(filename))
+  {
+    std::cerr << "Could not write the synthetic capture " << filename << ": "
+              << writer.GetLastError() << std::endl;
+    return false;
+  }
+
+  // 600 rpm, in hundredths of degree per second
+  const double rotationSpeed = 360000.;
+  const int blocksPerFiring = static_cast<int>(layout->BlockIdentifiers.size());
+  const int firingsPerPacket = HDL_FIRING_PER_PKT / blocksPerFiring;
+  const double azimuthStep = rotationSpeed * layout->PacketPeriod / firingsPerPacket;
+  const int lasersPerFiring = HDL_LASER_PER_FIRING / layout->FiringsPerBlock;
+  const int nbPackets = static_cast<int>(duration / layout->PacketPeriod);
+  const unsigned char sourceIP[4] = { 192, 168, 1, 201 };
+  // arbitrary reception time of the first packet: 2019-01-01 00:00:00 UTC
+  const double firstPacketTime = 1546300800.;
+
+  double azimuth = 0.;
+  HDLDataPacket dataPacket;
+  for (int packetId = 0; packetId < nbPackets; ++packetId)
+  {
+    const double packetTime = packetId * layout->PacketPeriod;
+    for (int firing = 0; firing < firingsPerPacket; ++firing)
+    {
+      for (int bank = 0; bank < blocksPerFiring; ++bank)
+      {
+        HDLFiringData& block = dataPacket.firingData[firing * blocksPerFiring + bank];
+        block.blockIdentifier = layout->BlockIdentifiers[bank];
+        block.rotationalPosition = static_cast<uint16_t>(azimuth) % 36000;
+        for (int k = 0; k < HDL_LASER_PER_FIRING; ++k)
+        {
+          // the second firing of a VLP-16 block is half a step later
+          const int laserId = bank * HDL_LASER_PER_FIRING + k % lasersPerFiring;
+          const double returnAzimuth = azimuth + (k / lasersPerFiring) * azimuthStep / layout->FiringsPerBlock;
+          block.laserReturns[k] = SyntheticReturn(laserId, returnAzimuth);
+        }
+      }
+      azimuth = std::fmod(azimuth + azimuthStep, 36000.);
+    }
+    // microseconds since the top of the hour
+    dataPacket.gpsTimestamp = static_cast<uint32_t>(std::fmod(packetTime, 3600.) * 1e6);
+    dataPacket.factoryField1 = layout->Type == HDL64 ? 0 : STRONGEST_RETURN;
+    dataPacket.factoryField2 = layout->Type == HDL64 ? 0 : layout->Type;
+
+    std::unique_ptr<NetworkPacket> packet(NetworkPacket::BuildEthernetIP4UDP(
+      reinterpret_cast<const unsigned char*>(&dataPacket), sizeof(dataPacket), sourceIP, 2368, 2368));
+    const double receptionTime = firstPacketTime + packetTime;
+    packet->ReceptionTime.tv_sec = static_cast<long>(receptionTime);
+    packet->ReceptionTime.tv_usec = static_cast<long>((receptionTime - std::floor(receptionTime)) * 1e6);
+    if (!writer.WritePacket(*packet))
+    {
+      std::cerr << "Could not write the synthetic capture: " << filename << std::endl;
+      return false;
+    }
+  }
+  writer.Close();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+std::string ResolveCapture(const std::string& source, const std::string& reportFileName,
+                           double syntheticDuration)
+{
+  const std::string prefix = "synthetic:";
+  if (source.compare(0, prefix.size(), prefix) != 0)
+  {
+    return source;
+  }
+  const std::string sensor = source.substr(prefix.size());
+  const std::string capture = (reportFileName.empty() || reportFileName == "-")
+    ? "synthetic-" + sensor + ".pcap" : reportFileName + ".pcap";
+  if (!WriteSyntheticCapture(sensor, syntheticDuration, capture))
+  {
+    return std::string();
+  }
+  return capture;
+}
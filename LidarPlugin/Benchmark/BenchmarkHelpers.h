@@ -0,0 +1,127 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef BENCHMARK_HELPERS_H
+#define BENCHMARK_HELPERS_H
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief BenchmarkTimer wall-clock stopwatch
+ */
+class BenchmarkTimer
+{
+public:
+  BenchmarkTimer() { this->Restart(); }
+
+  void Restart() { this->Start = std::chrono::steady_clock::now(); }
+
+  //! Seconds elapsed since the construction or the last Restart()
+  double GetElapsedTime() const
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - this->Start).count();
+  }
+
+private:
+  std::chrono::steady_clock::time_point Start;
+};
+
+/**
+ * @brief LatencySummary distribution of a set of durations, in seconds
+ */
+struct LatencySummary
+{
+  size_t Count = 0;
+  double Mean = 0.;
+  double Min = 0.;
+  double P50 = 0.;
+  double P90 = 0.;
+  double P99 = 0.;
+  double Max = 0.;
+};
+
+//! Summarize durations with nearest-rank percentiles
+LatencySummary SummarizeLatencies(std::vector<double> durations);
+
+/**
+ * @brief BenchmarkReport collect the measures of a benchmark run and write them
+ * as JSON, so that the results of successive runs can be tracked:
+ *
+ * { "benchmark": "<name>", "<attribute>": "<value>", ...,
+ *   "stages": { "<stage>": { "<measure>": <value>, ... }, ... } }
+ *
+ * The attributes, stages and measures are written in the order they are added.
+ * The durations are given in seconds, a latency summary is written as an object
+ * with the count and the mean, min, p50, p90, p99 and max durations.
+ */
+class BenchmarkReport
+{
+public:
+  explicit BenchmarkReport(const std::string& benchmarkName);
+
+  //! Describe the run (sensor, data source, number of threads, ...)
+  void SetAttribute(const std::string& key, const std::string& value);
+
+  void Add(const std::string& stage, const std::string& measure, double value);
+  void Add(const std::string& stage, const std::string& measure, const LatencySummary& latency);
+
+  void Write(std::ostream& os) const;
+
+  /**
+   * @brief Write write the report to a file, or to the standard output if the
+   *        filename is empty or "-"
+   * @return false if the file could not be written
+   */
+  bool Write(const std::string& filename) const;
+
+private:
+  void AddRaw(const std::string& stage, const std::string& measure, const std::string& json);
+
+  typedef std::vector<std::pair<std::string, std::string>> Entries;
+  Entries Attributes;
+  std::vector<std::pair<std::string, Entries>> Stages;
+};
+
+/**
+ * @brief GetSyntheticSensors names of the sensors for which a synthetic
+ *        capture can be generated, same names as the calibration files
+ */
+std::vector<std::string> GetSyntheticSensors();
+
+/**
+ * @brief WriteSyntheticCapture write a pcap file of a Velodyne sensor spinning
+ *        at 600 rpm in strongest return mode, with the packet rate and the
+ *        firing layout of the real sensor but a synthetic scene. Some returns
+ *        are empty, as in a real capture.
+ * @param sensor one of GetSyntheticSensors()
+ * @param duration duration of the capture in seconds
+ * @param filename pcap file to write
+ * @return false if the sensor is unknown or the file could not be written
+ */
+bool WriteSyntheticCapture(const std::string& sensor, double duration, const std::string& filename);
+
+/**
+ * @brief ResolveCapture return the pcap file to benchmark: either the given
+ *        file, or for "synthetic:<sensor>" a synthetic capture written next
+ *        to the report
+ * @return an empty string if the synthetic capture could not be written
+ */
+std::string ResolveCapture(const std::string& source, const std::string& reportFileName,
+                           double syntheticDuration);
+
+#endif // BENCHMARK_HELPERS_H
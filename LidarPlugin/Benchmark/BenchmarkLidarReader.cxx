@@ -0,0 +1,226 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BenchmarkHelpers.h"
+#include "vtkLidarFramesExporter.h"
+#include "vtkLidarReader.h"
+#include "vtkPacketFileReader.h"
+#include "vtkVelodynePacketInterpreter.h"
+
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+namespace
+{
+//! Number of times the in-memory decoding is repeated, the fastest run is kept
+constexpr int DecodeRepetitions = 3;
+//! Number of frames requested in random order
+constexpr int RandomFrameRequests = 100;
+//! Number of frames exported for each format
+constexpr int ExportedFrames = 50;
+
+//-----------------------------------------------------------------------------
+//! Decode packets already in memory, as the stream does, without any I/O
+void BenchmarkDecode(const std::vector<std::vector<unsigned char>>& packets,
+                     const std::string& calibrationFileName, BenchmarkReport& report)
+{
+  double bestTime = -1.;
+  double nbPoints = 0.;
+  int nbFrames = 0;
+  for (int repetition = 0; repetition < DecodeRepetitions; ++repetition)
+  {
+    auto interpreter = vtkSmartPointer<vtkVelodynePacketInterpreter>::New();
+    interpreter->SetCalibrationFileName(calibrationFileName);
+    interpreter->LoadCalibration(calibrationFileName);
+    interpreter->ResetCurrentFrame();
+    nbPoints = 0.;
+    nbFrames = 0;
+
+    BenchmarkTimer timer;
+    for (const std::vector<unsigned char>& packet : packets)
+    {
+      interpreter->ProcessPacket(packet.data(), static_cast<unsigned int>(packet.size()));
+      if (interpreter->IsNewFrameReady())
+      {
+        nbPoints += interpreter->GetLastFrameAvailable()->GetNumberOfPoints();
+        ++nbFrames;
+        interpreter->ClearAllFramesAvailable();
+      }
+    }
+    const double elapsed = timer.GetElapsedTime();
+    bestTime = bestTime < 0. ? elapsed : std::min(bestTime, elapsed);
+  }
+
+  report.Add("decode", "packets", static_cast<double>(packets.size()));
+  report.Add("decode", "frames", nbFrames);
+  report.Add("decode", "points", nbPoints);
+  report.Add("decode", "seconds", bestTime);
+  report.Add("decode", "packets_per_second", packets.size() / bestTime);
+  report.Add("decode", "points_per_second", nbPoints / bestTime);
+}
+
+//-----------------------------------------------------------------------------
+//! Export the first frames of the capture and measure the encoding throughput
+void BenchmarkExport(vtkLidarReader* reader, int format, const std::string& stage,
+                     const std::string& outputDirectory, BenchmarkReport& report)
+{
+  boost::filesystem::remove_all(outputDirectory);
+  boost::filesystem::create_directories(outputDirectory);
+
+  vtkNew<vtkLidarFramesExporter> exporter;
+  exporter->SetReader(reader);
+  exporter->SetOutputDirectory(outputDirectory);
+  exporter->SetFilePrefix("benchmark");
+  exporter->SetFirstFrame(0);
+  exporter->SetLastFrame(ExportedFrames - 1);
+  exporter->SetFormat(format);
+
+  BenchmarkTimer timer;
+  const int nbWritten = exporter->Write();
+  const double elapsed = timer.GetElapsedTime();
+
+  double nbBytes = 0.;
+  for (boost::filesystem::directory_iterator it(outputDirectory), end; it != end; ++it)
+  {
+    nbBytes += boost::filesystem::file_size(it->path());
+  }
+  boost::filesystem::remove_all(outputDirectory);
+
+  report.Add(stage, "frames", nbWritten);
+  report.Add(stage, "seconds", elapsed);
+  report.Add(stage, "frames_per_second", nbWritten / elapsed);
+  report.Add(stage, "megabytes_per_second", nbBytes / (1024. * 1024.) / elapsed);
+}
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Measure the offline processing of a capture:
+ * - decode: packets decoded per second, the packets being already in memory
+ * - frame_index: time to build the frame index of the file
+ * - get_frame: GetFrame latency when playing the frames in order and in random order
+ * - export_binary, export_csv: throughput of vtkLidarFramesExporter
+ */
+int main(int argc, char* argv[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Wrong number of arguments. Usage: BenchmarkLidarReader "
+              << "<pcapFileName|synthetic:<sensor>> <correctionFileName> <report.json> [sensor]"
+              << std::endl;
+    return 1;
+  }
+  const std::string source = argv[1];
+  const std::string correctionFileName = argv[2];
+  const std::string reportFileName = argv[3];
+  const std::string sensor = argc > 4 ? argv[4] : "";
+
+  // 10 seconds of synthetic data, about 100 frames
+  const std::string pcapFileName = ResolveCapture(source, reportFileName, 10.);
+  if (pcapFileName.empty())
+  {
+    return 1;
+  }
+
+  BenchmarkReport report("LidarReader");
+  report.SetAttribute("sensor", sensor);
+  report.SetAttribute("source", source);
+  report.SetAttribute("hardware_threads", std::to_string(boost::thread::hardware_concurrency()));
+
+  // Load the lidar packets in memory
+  std::vector<std::vector<unsigned char>> packets;
+  {
+    vtkPacketFileReader packetReader;
+    if (!packetReader.Open(pcapFileName))
+    {
+      std::cerr << "Could not open " << pcapFileName << ": " << packetReader.GetLastError() << std::endl;
+      return 1;
+    }
+    auto interpreter = vtkSmartPointer<vtkVelodynePacketInterpreter>::New();
+    const unsigned char* data = nullptr;
+    unsigned int dataLength = 0;
+    double timeSinceStart = 0.;
+    while (packetReader.NextPacket(data, dataLength, timeSinceStart))
+    {
+      if (interpreter->IsLidarPacket(data, dataLength))
+      {
+        packets.emplace_back(data, data + dataLength);
+      }
+    }
+  }
+  if (packets.empty())
+  {
+    std::cerr << "No lidar packet found in " << pcapFileName << std::endl;
+    return 1;
+  }
+  BenchmarkDecode(packets, correctionFileName, report);
+  packets.clear();
+
+  // Frame index
+  vtkNew<vtkLidarReader> reader;
+  reader->SetInterpreter(vtkSmartPointer<vtkVelodynePacketInterpreter>::New());
+  reader->SetFileName(pcapFileName);
+  reader->SetCalibrationFileName(correctionFileName);
+  BenchmarkTimer timer;
+  reader->UpdateInformation();
+  const double indexTime = timer.GetElapsedTime();
+  const int nbFrames = reader->GetNumberOfFrames();
+  report.Add("frame_index", "frames", nbFrames);
+  report.Add("frame_index", "seconds", indexTime);
+  if (nbFrames == 0)
+  {
+    std::cerr << "The reader found no frame in " << pcapFileName << std::endl;
+    report.Write(reportFileName);
+    return 1;
+  }
+
+  // GetFrame latency
+  reader->Open();
+  std::vector<double> latencies;
+  for (int frame = 0; frame < nbFrames; ++frame)
+  {
+    timer.Restart();
+    reader->GetFrame(frame);
+    latencies.push_back(timer.GetElapsedTime());
+  }
+  report.Add("get_frame", "sequential_latency", SummarizeLatencies(latencies));
+
+  latencies.clear();
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<int> randomFrame(0, nbFrames - 1);
+  for (int k = 0; k < RandomFrameRequests; ++k)
+  {
+    const int frame = randomFrame(generator);
+    timer.Restart();
+    reader->GetFrame(frame);
+    latencies.push_back(timer.GetElapsedTime());
+  }
+  report.Add("get_frame", "random_latency", SummarizeLatencies(latencies));
+
+  // Export
+  const std::string exportDirectory = (reportFileName.empty() || reportFileName == "-")
+    ? "benchmark-export" : reportFileName + ".export";
+  BenchmarkExport(reader.Get(), vtkLidarFramesExporter::BINARY, "export_binary", exportDirectory, report);
+  BenchmarkExport(reader.Get(), vtkLidarFramesExporter::CSV, "export_csv", exportDirectory, report);
+
+  return report.Write(reportFileName) ? 0 : 1;
+}
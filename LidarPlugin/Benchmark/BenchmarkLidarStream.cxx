@@ -0,0 +1,201 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BenchmarkHelpers.h"
+#include "vtkLidarReader.h"
+#include "vtkLidarStream.h"
+#include "vtkPacketFileReader.h"
+#include "vvPacketSender.h"
+#include "vtkVelodynePacketInterpreter.h"
+
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+namespace
+{
+const std::string DestinationIp = "127.0.0.1";
+constexpr int DataPort = 2368;
+//! Time without any new frame after which the stream is considered drained
+constexpr double DrainTimeout = 0.5;
+
+//-----------------------------------------------------------------------------
+//! Native packet rate of the capture, in lidar packets per second
+double GetCapturePacketRate(const std::string& pcapFileName)
+{
+  vtkPacketFileReader packetReader;
+  if (!packetReader.Open(pcapFileName))
+  {
+    return 0.;
+  }
+  auto interpreter = vtkSmartPointer<vtkVelodynePacketInterpreter>::New();
+  const unsigned char* data = nullptr;
+  unsigned int dataLength = 0;
+  double time = 0., firstTime = -1., lastTime = 0.;
+  int nbPackets = 0;
+  while (packetReader.NextPacket(data, dataLength, time))
+  {
+    if (interpreter->IsLidarPacket(data, dataLength))
+    {
+      firstTime = firstTime < 0. ? time : firstTime;
+      lastTime = time;
+      ++nbPackets;
+    }
+  }
+  return lastTime > firstTime ? (nbPackets - 1) / (lastTime - firstTime) : 0.;
+}
+
+//-----------------------------------------------------------------------------
+//! Replay the capture at a fixed packet rate to a running stream
+void BenchmarkIngest(vtkLidarStream* stream, const std::string& pcapFileName, double packetRate,
+                     int expectedFrames, BenchmarkReport& report)
+{
+  std::ostringstream stage;
+  stage << "ingest_" << static_cast<long>(packetRate) << "_pps";
+
+  stream->Start();
+  // let the receiver open its socket
+  boost::this_thread::sleep(boost::posix_time::milliseconds(100));
+
+  // same pacing as PacketFileSender, but at a fixed rate
+  BenchmarkTimer timer;
+  size_t nbSent = 0;
+  vvPacketSender sender(pcapFileName, DestinationIp, DataPort);
+  while (!sender.IsDone())
+  {
+    sender.pumpPacket();
+    ++nbSent;
+    const double delay = nbSent / packetRate - timer.GetElapsedTime();
+    if (delay > 0.)
+    {
+      boost::this_thread::sleep(boost::posix_time::microseconds(static_cast<long>(delay * 1e6)));
+    }
+  }
+  const double sendTime = timer.GetElapsedTime();
+
+  // wait for the decoding of the queued packets
+  vtkIdType nbReceived = stream->GetNumberOfReceivedFrames();
+  BenchmarkTimer idle;
+  while (idle.GetElapsedTime() < DrainTimeout)
+  {
+    boost::this_thread::sleep(boost::posix_time::milliseconds(10));
+    const vtkIdType current = stream->GetNumberOfReceivedFrames();
+    if (current != nbReceived)
+    {
+      nbReceived = current;
+      idle.Restart();
+    }
+  }
+  const vtkIdType nbDroppedPackets = stream->GetNumberOfDroppedPackets();
+  const vtkIdType nbDroppedFrames = stream->GetNumberOfDroppedFrames();
+  stream->Stop();
+
+  // the last frame of the capture is never closed by a newer packet
+  const int expectedReceived = std::max(expectedFrames - 1, 1);
+  report.Add(stage.str(), "target_packets_per_second", packetRate);
+  report.Add(stage.str(), "achieved_packets_per_second", nbSent / sendTime);
+  report.Add(stage.str(), "packets_sent", static_cast<double>(nbSent));
+  report.Add(stage.str(), "packets_dropped_by_decoder", static_cast<double>(nbDroppedPackets));
+  report.Add(stage.str(), "frames_expected", expectedReceived);
+  report.Add(stage.str(), "frames_received", static_cast<double>(nbReceived));
+  report.Add(stage.str(), "frames_not_displayed", static_cast<double>(nbDroppedFrames));
+  report.Add(stage.str(), "frame_loss_ratio",
+             std::max(0., 1. - static_cast<double>(nbReceived) / expectedReceived));
+}
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Measure how a live stream keeps up with the packet rate: the capture
+ * is replayed on the loopback interface at several packet rates, and the
+ * frames decoded by the stream are compared to the frames of the capture.
+ * By default the capture is replayed at 1, 2 and 4 times its native rate.
+ */
+int main(int argc, char* argv[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Wrong number of arguments. Usage: BenchmarkLidarStream "
+              << "<pcapFileName|synthetic:<sensor>> <correctionFileName> <report.json> [sensor] "
+              << "[packet rates...]" << std::endl;
+    return 1;
+  }
+  const std::string source = argv[1];
+  const std::string correctionFileName = argv[2];
+  const std::string reportFileName = argv[3];
+  const std::string sensor = argc > 4 ? argv[4] : "";
+
+  // 5 seconds of synthetic data, about 50 frames
+  const std::string pcapFileName = ResolveCapture(source, reportFileName, 5.);
+  if (pcapFileName.empty())
+  {
+    return 1;
+  }
+
+  std::vector<double> packetRates;
+  for (int i = 5; i < argc; ++i)
+  {
+    packetRates.push_back(std::stod(argv[i]));
+  }
+  if (packetRates.empty())
+  {
+    const double nativeRate = GetCapturePacketRate(pcapFileName);
+    if (nativeRate <= 0.)
+    {
+      std::cerr << "Could not compute the packet rate of " << pcapFileName << std::endl;
+      return 1;
+    }
+    packetRates = { nativeRate, 2. * nativeRate, 4. * nativeRate };
+  }
+
+  // Reference number of frames
+  vtkNew<vtkLidarReader> reader;
+  reader->SetInterpreter(vtkSmartPointer<vtkVelodynePacketInterpreter>::New());
+  reader->SetFileName(pcapFileName);
+  reader->SetCalibrationFileName(correctionFileName);
+  reader->UpdateInformation();
+  const int expectedFrames = reader->GetNumberOfFrames();
+
+  BenchmarkReport report("LidarStream");
+  report.SetAttribute("sensor", sensor);
+  report.SetAttribute("source", source);
+  report.SetAttribute("hardware_threads", std::to_string(boost::thread::hardware_concurrency()));
+
+  vtkNew<vtkLidarStream> stream;
+  stream->SetInterpreter(vtkSmartPointer<vtkVelodynePacketInterpreter>::New());
+  stream->SetCalibrationFileName(correctionFileName);
+  stream->SetLidarPort(DataPort);
+  stream->SetIsForwarding(false);
+  stream->UpdateInformation();
+
+  try
+  {
+    for (double packetRate : packetRates)
+    {
+      BenchmarkIngest(stream.Get(), pcapFileName, packetRate, expectedFrames, report);
+    }
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "Caught Exception: " << e.what() << std::endl;
+    return 1;
+  }
+
+  return report.Write(reportFileName) ? 0 : 1;
+}
@@ -0,0 +1,165 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "BenchmarkHelpers.h"
+#include "Slam.h"
+#include "vtkLidarReader.h"
+#include "vtkSlam.h"
+#include "vtkSlamBatchRunner.h"
+#include "vtkVelodynePacketInterpreter.h"
+
+#include <vtkDataArray.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTable.h>
+
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <map>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+//! Same laser ordering as TestSlam, by increasing vertical angle
+std::vector<size_t> ComputeLaserMapping(vtkTable* calib)
+{
+  std::vector<size_t> laserIdMapping;
+  auto array = vtkDataArray::SafeDownCast(calib->GetColumnByName("verticalCorrection"));
+  if (array)
+  {
+    std::vector<double> verticalCorrection(array->GetNumberOfTuples());
+    for (vtkIdType i = 0; i < array->GetNumberOfTuples(); ++i)
+    {
+      verticalCorrection[i] = array->GetTuple1(i);
+    }
+    laserIdMapping = sortIdx(verticalCorrection);
+  }
+  return laserIdMapping;
+}
+
+//-----------------------------------------------------------------------------
+//! "Keypoints extraction" -> "keypoints_extraction"
+std::string ToMeasureName(const std::string& stage)
+{
+  std::string name;
+  for (char c : stage)
+  {
+    name += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::tolower(c)) : '_';
+  }
+  return name;
+}
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Measure the duration of each stage of the SLAM on a recorded capture.
+ * The frames are decoded before being processed, so that only the conversion
+ * to PCL and the SLAM itself are measured.
+ */
+int main(int argc, char* argv[])
+{
+  if (argc < 4)
+  {
+    std::cerr << "Wrong number of arguments. Usage: BenchmarkSlam "
+              << "<pcapFileName> <correctionFileName> <report.json> [sensor] [max number of frames]"
+              << std::endl;
+    return 1;
+  }
+  const std::string pcapFileName = argv[1];
+  const std::string correctionFileName = argv[2];
+  const std::string reportFileName = argv[3];
+  const std::string sensor = argc > 4 ? argv[4] : "";
+  const int maxFrames = argc > 5 ? std::stoi(argv[5]) : -1;
+
+  vtkNew<vtkLidarReader> reader;
+  reader->SetInterpreter(vtkSmartPointer<vtkVelodynePacketInterpreter>::New());
+  reader->SetFileName(pcapFileName);
+  reader->SetCalibrationFileName(correctionFileName);
+  reader->Update();
+  int nbFrames = reader->GetNumberOfFrames();
+  if (nbFrames < 3)
+  {
+    std::cerr << "Not enough frames in " << pcapFileName << std::endl;
+    return 1;
+  }
+  // skip the first and last frames, which are incomplete
+  nbFrames = maxFrames > 0 ? std::min(nbFrames - 2, maxFrames) : nbFrames - 2;
+  std::vector<size_t> laserIdMapping =
+    ComputeLaserMapping(vtkTable::SafeDownCast(reader->GetOutputDataObject(1)));
+
+  reader->Open();
+  std::vector<vtkSmartPointer<vtkPolyData>> frames;
+  for (int frame = 1; frame <= nbFrames; ++frame)
+  {
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    polyData->DeepCopy(reader->GetFrame(frame));
+    frames.push_back(polyData);
+  }
+
+  BenchmarkReport report("Slam");
+  report.SetAttribute("sensor", sensor);
+  report.SetAttribute("source", pcapFileName);
+  report.SetAttribute("hardware_threads", std::to_string(boost::thread::hardware_concurrency()));
+
+  Slam slam;
+  std::vector<double> conversionTimes, frameTimes;
+  std::map<std::string, std::vector<double>> stageTimes;
+  BenchmarkTimer total;
+  for (vtkPolyData* frame : frames)
+  {
+    BenchmarkTimer timer;
+    pcl::PointCloud<Slam::Point>::Ptr pc(new pcl::PointCloud<Slam::Point>);
+    PointCloudFromPolyData(frame, pc);
+    conversionTimes.push_back(timer.GetElapsedTime());
+
+    timer.Restart();
+    slam.AddFrame(pc, laserIdMapping);
+    frameTimes.push_back(timer.GetElapsedTime());
+    for (const auto& stage : slam.GetStageTimings())
+    {
+      stageTimes[stage.first].push_back(stage.second);
+    }
+  }
+  const double totalTime = total.GetElapsedTime();
+
+  report.Add("slam", "frames", static_cast<double>(frames.size()));
+  report.Add("slam", "seconds", totalTime);
+  report.Add("slam", "frames_per_second", frames.size() / totalTime);
+  report.Add("slam", "conversion", SummarizeLatencies(conversionTimes));
+  report.Add("slam", "add_frame", SummarizeLatencies(frameTimes));
+  for (const auto& stage : stageTimes)
+  {
+    report.Add("slam", ToMeasureName(stage.first), SummarizeLatencies(stage.second));
+  }
+
+  // Same frames, decoded and extracted in the background by the batch runner
+  vtkNew<vtkSlamBatchRunner> runner;
+  runner->SetReader(reader);
+  runner->SetFirstFrame(0);
+  runner->SetLastFrame(nbFrames - 1);
+  BenchmarkTimer batch;
+  if (runner->Start() && runner->Wait())
+  {
+    const double batchTime = batch.GetElapsedTime();
+    report.Add("slam_batch", "frames", static_cast<double>(runner->GetNumberOfProcessedFrames()));
+    report.Add("slam_batch", "seconds", batchTime);
+    report.Add("slam_batch", "frames_per_second", runner->GetNumberOfProcessedFrames() / batchTime);
+  }
+
+  return report.Write(reportFileName) ? 0 : 1;
+}
@@ -22,6 +22,7 @@
 #include "CameraProjection.h"
 #include "vtkEigenTools.h"
 #include "CeresCameraCalibrationCostFunctions.h"
+#include "SolverConfiguration.h"
 
 // STD
 #include <iostream>
@@ -201,6 +202,7 @@ double NonLinearPinholeCalibration(const std::vector<Eigen::Vector3d>& X, const
   options.max_num_iterations = 1000;
   options.linear_solver_type = ceres::DENSE_QR;
   options.minimizer_progress_to_stdout = false;
+  GetCalibrationSolverConfiguration().Apply(options);
 
   ceres::Solver::Summary summary;
   ceres::Solve(options, &problem, &summary);
@@ -241,6 +243,7 @@ double NonLinearFisheyeCalibration(const std::vector<Eigen::Vector3d>& X, const
   options.max_num_iterations = it;
   options.linear_solver_type = ceres::DENSE_QR;
   options.minimizer_progress_to_stdout = false;
+  GetCalibrationSolverConfiguration().Apply(options);
 
   ceres::Solver::Summary summary;
   ceres::Solve(options, &problem, &summary);
@@ -292,6 +295,7 @@ double BrownConradyPinholeCalibration(const std::vector<Eigen::Vector3d>& X, con
     options.max_num_iterations = it;
     options.linear_solver_type = ceres::DENSE_QR;
     options.minimizer_progress_to_stdout = false;
+    GetCalibrationSolverConfiguration().Apply(options);
 
     ceres::Solver::Summary summary;
     ceres::Solve(options, &problem, &summary);
@@ -23,6 +23,10 @@
 #include "vtkPCLConversions.h"
 #include "CameraProjection.h"
 #include "vtkEigenTools.h"
+#include "ParallelFor.h"
+
+// STD
+#include <numeric>
 
 // OPENCV
 #include <opencv2/highgui.hpp>
@@ -32,6 +36,9 @@
 #include <pcl/features/normal_3d.h>
 #include <pcl/features/normal_3d_omp.h>
 
+// Number of orientation bins of the HOG descriptors
+constexpr int HOGNbrBins = 9;
+
 //----------------------------------------------------------------------------
 double ComputeMutualInformation(cv::Mat syntheticImg, cv::Mat realImg, int dx = 0)
 {
@@ -115,23 +122,37 @@ void ProjectAllPoints(pcl::PointCloud<pcl::PointXYZINormal>::Ptr cloud,
                       std::vector<double>& projectionIntensity,
                       std::vector<double>& projectionDepth,
                       std::vector<double>& projectionNormalAngle,
-                      std::vector<bool>& hasPointProjected,
+                      std::vector<uchar>& hasPointProjected,
                       unsigned int H,
                       unsigned int W)
 {
   // Get the cneter of the camera
   Eigen::Vector3d C(cameraParams[3], cameraParams[4], cameraParams[5]);
 
-  // Project all the points on the image. If two differents points
-  // are projected on the same pixel, we keep the closest one (according to
-  // the center of the camera)
-  for (int i = 0; i < cloud->size(); ++i)
+  // Project all the points at once, in parallel. The bounds given are
+  // slightly larger than the image, the exact test is done below
+  const int nbrPoints = static_cast<int>(cloud->size());
+  std::vector<double> points(3 * nbrPoints);
+  for (int i = 0; i < nbrPoints; ++i)
+  {
+    points[3 * i + 0] = cloud->points[i].x;
+    points[3 * i + 1] = cloud->points[i].y;
+    points[3 * i + 2] = cloud->points[i].z;
+  }
+  std::vector<double> pixels(2 * nbrPoints);
+  const double imageBounds[4] = { 0., static_cast<double>(W), -1., static_cast<double>(H) };
+  std::vector<int> projectedPoints = ProjectPoints(ProjectionType::BrownConradyPinhole,
+                                                   cameraParams, points.data(), nbrPoints,
+                                                   imageBounds, pixels.data());
+
+  // If two differents points are projected on the same pixel, we keep the
+  // closest one (according to the center of the camera). The points are
+  // taken in their order so that the first one wins in case of equality.
+  for (int i : projectedPoints)
   {
-    // Project the point into the image plan
-    pcl::PointXYZINormal pt = cloud->points[i];
+    const pcl::PointXYZINormal& pt = cloud->points[i];
     Eigen::Vector3d X(pt.x, pt.y, pt.z);
-    Eigen::Vector2d y0 = BrownConradyPinholeProjection(cameraParams, X, true);
-    Eigen::Vector2d y(H - 1 - y0(1), y0(0));
+    Eigen::Vector2d y(H - 1 - pixels[2 * i + 1], pixels[2 * i]);
     if (y(1) < 0 || y(1) >= W ||
         y(0) < 0 || y(0) >= H)
     {
@@ -139,131 +160,118 @@ void ProjectAllPoints(pcl::PointCloud<pcl::PointXYZINormal>::Ptr cloud,
     }
     int u = static_cast<int>(std::floor(y(0)));
     int v = static_cast<int>(std::floor(y(1)));
+    const size_t pixel = u * W + v;
+
+    double depth = (X - C).norm();
+    if (hasPointProjected[pixel] && depth >= projectionDepth[pixel])
+    {
+      continue;
+    }
 
     // Compute the normal angle value
     Eigen::Vector3d XC = (C - X).normalized();
     Eigen::Vector3d N = Eigen::Vector3d(pt.normal_x, pt.normal_y, pt.normal_z).normalized();
-    double normalAngle = std::abs(N.dot(XC));
 
-    // If it is the first time a point is projected
-    // on this pixel. Just add the point
-    if (!hasPointProjected[u + H * v])
-    {
-      hasPointProjected[u + H * v] = true;
-      projectionMatching[u + H * v] = X;
-      projectionIntensity[u + H * v] = pt.intensity;
-      projectionDepth[u + H * v] = (X - C).norm();
-      projectionNormalAngle[u + H * v] = normalAngle;
-    }
-    // It is not the first point projected on this pixel
-    // keep the closest one from the camera center
-    else
-    {
-      double currentD = (projectionMatching[u + H * v] - C).norm();
-      double candidateD = (X - C).norm();
-      if (candidateD < currentD)
-      {
-        projectionMatching[u + H * v] = X;
-        projectionIntensity[u + H * v] = pt.intensity;
-        projectionDepth[u + H * v] = (X - C).norm();
-        projectionNormalAngle[u + H * v] = normalAngle;
-      }
-    }
+    hasPointProjected[pixel] = 1;
+    projectionMatching[pixel] = X;
+    projectionIntensity[pixel] = pt.intensity;
+    projectionDepth[pixel] = depth;
+    projectionNormalAngle[pixel] = std::abs(N.dot(XC));
   }
 }
 
 //----------------------------------------------------------------------------
-void ComputePointVisibility(std::vector<bool>& isPointVisible,
+void ComputePointVisibility(std::vector<uchar>& isPointVisible,
                             const std::vector<Eigen::Vector3d>& projectionMatching,
-                            const std::vector<bool>& hasPointProjected,
+                            const std::vector<uchar>& hasPointProjected,
                             unsigned int H,
                             unsigned int W,
                             int L)
 {
+  // The sector of a neighbor only depends on its offset to the
+  // current pixel, compute them once for the whole window
+  const int windowSize = 2 * L + 1;
+  std::vector<int> sectorOfOffset(windowSize * windowSize);
+  for (int du = -L; du <= L; ++du)
+  {
+    for (int dv = -L; dv <= L; ++dv)
+    {
+      double polar2DAngle = std::atan2(dv, du) + 3.14159265359;
+      int sectorIdx = std::floor(4.0 * polar2DAngle / 3.14159265359);
+      sectorOfOffset[(du + L) * windowSize + dv + L] = std::min(sectorIdx, 7);
+    }
+  }
+
   // Now, handle occultation using heuristic method.
-  // For each point, we will estimate the visibility
-  for (int i = 0; i < H; ++i)
+  // For each point, we will estimate the visibility.
+  // The rows are processed in parallel, each pixel only
+  // writes its own visibility
+  ParallelFor(0, static_cast<int>(H), [&](int firstRow, int lastRow)
   {
-    for (int j = 0; j < W; ++j)
+    for (int i = firstRow; i < lastRow; ++i)
     {
-      if (hasPointProjected[i + H * j])
+      for (int j = 0; j < static_cast<int>(W); ++j)
       {
-        // Get current 3D point and its corresponding pixel
-        Eigen::Vector2d Xpx(i, j);
-        Eigen::Vector3d P = projectionMatching[i + H * j];
+        if (!hasPointProjected[i * W + j])
+        {
+          continue;
+        }
+
+        // Get current 3D point
+        const Eigen::Vector3d& P = projectionMatching[i * W + j];
+        const Eigen::Vector3d PO = -1.0 * P;
 
         int umin = std::max(0, i - L); int vmin = std::max(0, j - L);
         int umax = std::min((int)(H) - 1, i + L); int vmax = std::min((int)(W) - 1, j + L);
-        std::vector<double> solidAnglesPerSector(8, std::numeric_limits<double>::max());
-        std::vector<bool> isSectorEmpty(8, true);
+        double solidAnglesPerSector[8];
+        bool isSectorEmpty[8];
+        std::fill(solidAnglesPerSector, solidAnglesPerSector + 8, std::numeric_limits<double>::max());
+        std::fill(isSectorEmpty, isSectorEmpty + 8, true);
 
         // Loop over points that has been projected
         // in a pixel belonging to the neighborhood
         // of the current pixel we are computing
         for (int u = umin; u <= umax; ++u)
         {
+          const int sectorRowOffset = (u - i + L) * windowSize + L - j;
           for (int v = vmin; v <= vmax; ++v)
           {
-            if (u == i && v == j)
+            if ((u == i && v == j) || !hasPointProjected[u * W + v])
             {
               continue;
             }
 
-            if (hasPointProjected[u + H * v])
+            // Now, compute the visibility angle
+            int sectorIdx = sectorOfOffset[sectorRowOffset + v];
+            Eigen::Vector3d PQ = projectionMatching[u * W + v] - P;
+            double angle = std::abs(SignedAngle(PO, PQ));
+
+            if (angle < solidAnglesPerSector[sectorIdx])
             {
-              // compute the image polar angle of the current
-              // neighbor pixel to determine the sector it is
-              // belonging to
-              Eigen::Vector2d Ypx = Eigen::Vector2d(u, v) - Xpx;
-              double polar2DAngle = std::atan2(Ypx(1), Ypx(0)) + 3.14159265359;
-              int sectorIdx = std::floor(4.0 * polar2DAngle / 3.14159265359);
-
-              // Now, compute the visibility angle
-              Eigen::Vector3d Q = projectionMatching[u + H * v];
-              Eigen::Vector3d PQ = Q - P;
-              Eigen::Vector3d PO = -1.0 * P;
-              double angle = std::abs(SignedAngle(PO, PQ));
-
-              if (angle < solidAnglesPerSector[sectorIdx])
-              {
-                solidAnglesPerSector[sectorIdx] = angle;
-                isSectorEmpty[sectorIdx] = false;
-              }
+              solidAnglesPerSector[sectorIdx] = angle;
+              isSectorEmpty[sectorIdx] = false;
             }
           }
         }
 
         // Now, compute the sum of the minimal angle visibility
         double sumAngle = 0;
-        unsigned int nbrNonEmptySector = 0;
-        unsigned int nbrSectorNonVisible = 0;
         for (int sectorIdx = 0; sectorIdx < 8; ++sectorIdx)
         {
           if (!isSectorEmpty[sectorIdx])
           {
             sumAngle += solidAnglesPerSector[sectorIdx];
-            nbrNonEmptySector++;
-            if (solidAnglesPerSector[sectorIdx] < 0.25)
-            {
-              nbrSectorNonVisible++;
-            }
           }
         }
 
         // remove this points
-        /*if (nbrSectorNonVisible >= 5)*/
         if (sumAngle < 2.0)
         {
-          isPointVisible[i + H * j] = false;
+          isPointVisible[i * W + j] = 0;
         }
-
-        /*if (nbrNonEmptySector <= 7)
-        {
-          isPointVisible[i + H * j] = true;
-        }*/
       }
     }
-  }
+  });
 }
 
 //----------------------------------------------------------------------------
@@ -290,12 +298,8 @@ int GetSectorId(int u, int v)
 }
 
 //----------------------------------------------------------------------------
-double QuadraticInterpolatation(const std::vector<Eigen::Vector2d>& points, const std::vector<double>& values)
+double QuadraticInterpolatation(const Eigen::Vector2d points[4], const double values[4])
 {
-  if (points.size() < 4 || values.size() < 4)
-  {
-    return 0;
-  }
   Eigen::Matrix<double, 4, 4> M;
   Eigen::Vector4d Y;
   for (int i = 0; i < 4; ++i)
@@ -313,10 +317,8 @@ double QuadraticInterpolatation(const std::vector<Eigen::Vector2d>& points, cons
 }
 
 //----------------------------------------------------------------------------
-void ComputeInterpolation(std::vector<cv::Mat> img, int L,
-                          const std::vector<Eigen::Vector3d>& projectionMatching,
-                          Eigen::Vector3d cameraCenter,
-                          unsigned int H, unsigned int W)
+void ComputeInterpolation(std::vector<cv::Mat>& img, int L,
+                          const std::vector<double>& projectionDepth)
 {
   for (int imgIndx = 0; imgIndx < img.size(); ++imgIndx)
   {
@@ -327,114 +329,80 @@ void ComputeInterpolation(std::vector<cv::Mat> img, int L,
     int H = img[imgIndx].rows;
     int W = img[imgIndx].cols;
 
-    // loop over pixels
-    for (int i = L; i < H - L; ++i)
+    // loop over pixels, the rows are processed in parallel
+    // since they only read the copy of the input image
+    ParallelFor(L, H - L, [&](int firstRow, int lastRow)
     {
-      for (int j = L; j < W - L; ++j)
+      for (int i = firstRow; i < lastRow; ++i)
       {
-        // Check if the value is already available
-        double currentValue = rawImg.at<uchar>(i, j);
-        if (currentValue != 255)
-        {
-          continue;
-        }
-
-        Eigen::Vector2d Xpx(i, j);
-
-        // anchor used for interpolation
-        std::vector<Eigen::Vector2d> interpolationAnchor(4, Eigen::Vector2d(0, 0));
-        std::vector<bool> anchorAvailable(4, false);
-        std::vector<double> anchorValue(4, 0);
-        std::vector<double> sectorDist(4, std::numeric_limits<double>::max());
-
-        // Loop over the neighborhood. The goal is to compute
-        // per sector the anchor point used to perform the
-        // quadratic interpolation
-        for (int u = i - L; u <= i + L; ++u)
+        const uchar* rawRow = rawImg.ptr<uchar>(i);
+        uchar* outputRow = img[imgIndx].ptr<uchar>(i);
+        for (int j = L; j < W - L; ++j)
         {
-          for (int v = j - L; v <= j + L; ++v)
+          // Check if the value is already available
+          if (rawRow[j] != 255)
           {
-            if (u == i && v == j)
-            {
-              continue;
-            }
-
-            // Get pixel value and check if data is available
-            int value = rawImg.at<uchar>(u, v);
-            if (value == 255)
-            {
-              continue;
-            }
+            continue;
+          }
 
-            // compute sector id
-            int sectorId = GetSectorId(u - i, v - j);
+          // anchor used for interpolation
+          Eigen::Vector2d interpolationAnchor[4];
+          bool anchorAvailable[4] = { false, false, false, false };
+          double anchorValue[4] = { 0, 0, 0, 0 };
+          double sectorDist[4];
 
-            if (sectorId == -1)
+          // Loop over the neighborhood. The goal is to compute
+          // per sector the anchor point used to perform the
+          // quadratic interpolation
+          for (int u = i - L; u <= i + L; ++u)
+          {
+            const uchar* neighborRow = rawImg.ptr<uchar>(u);
+            for (int v = j - L; v <= j + L; ++v)
             {
-              continue;
-            }
-
-            Eigen::Vector2d Ypx(u, v);
-            Eigen::Vector3d Y = projectionMatching[u + H * v];
+              // Get pixel value and check if data is available
+              int value = neighborRow[v];
+              if (value == 255)
+              {
+                continue;
+              }
 
-            if (!anchorAvailable[sectorId])
-            {
-              interpolationAnchor[sectorId] = Ypx - Xpx;
-              anchorAvailable[sectorId] = true;
-              anchorValue[sectorId] = value;
-              sectorDist[sectorId] = (Y - cameraCenter).norm();
-            }
-            else
-            {
-              // 2d-euclidean based distance
-              /*double currentD = interpolationAnchor[sectorId].norm();
-              double candidateD = (Ypx - Xpx).norm();*/
+              // compute sector id, the current pixel
+              // has no sector
+              int sectorId = GetSectorId(u - i, v - j);
+              if (sectorId == -1)
+              {
+                continue;
+              }
 
-              // 3d-euclidean based distance to cneter of camera
-              double candidateD = (Y - cameraCenter).norm();
-              if (candidateD < sectorDist[sectorId])
+              // 3d-euclidean based distance to center of camera
+              double candidateD = projectionDepth[u * W + v];
+              if (!anchorAvailable[sectorId] || candidateD < sectorDist[sectorId])
               {
-                interpolationAnchor[sectorId] = Ypx - Xpx;
+                interpolationAnchor[sectorId] = Eigen::Vector2d(u - i, v - j);
+                anchorAvailable[sectorId] = true;
                 anchorValue[sectorId] = value;
                 sectorDist[sectorId] = candidateD;
               }
             }
           }
-        }
 
-        // Fill anchor and values that will be used for the
-        // quadratic interpolation
-        std::vector<Eigen::Vector2d> points;
-        std::vector<double> values;
-        for (int sectorId = 0; sectorId < 4; ++sectorId)
-        {
-          if (anchorAvailable[sectorId])
+          // Quadratic interpolation using a quadric, only
+          // if all the sectors have an anchor
+          double interpolatedValue = 255;
+          if (anchorAvailable[0] && anchorAvailable[1] &&
+              anchorAvailable[2] && anchorAvailable[3])
           {
-            points.push_back(interpolationAnchor[sectorId]);
-            values.push_back(anchorValue[sectorId]);
+            interpolatedValue = QuadraticInterpolatation(interpolationAnchor, anchorValue);
           }
+          outputRow[j] = static_cast<uchar>(interpolatedValue);
         }
-
-
-        double interpolatedValue = 255;
-        // Linear interpolation using a plan
-        //if (points.size() == 3)
-        //{
-        //
-        //}
-        // Quadratic interpolation using a quadric
-        if (points.size() == 4)
-        {
-         interpolatedValue = QuadraticInterpolatation(points, values);
-        }
-        img[imgIndx].at<uchar>(i, j) = interpolatedValue;
       }
-    }
+    });
   }
 }
 
 //----------------------------------------------------------------------------
-void ComputeMedianFilter(std::vector<cv::Mat> img, int L)
+void ComputeMedianFilter(std::vector<cv::Mat>& img, int L)
 {
   for (int imgIndx = 0; imgIndx < img.size(); ++imgIndx)
   {
@@ -445,42 +413,46 @@ void ComputeMedianFilter(std::vector<cv::Mat> img, int L)
     int H = img[imgIndx].rows;
     int W = img[imgIndx].cols;
 
-    // loop over pixels
-    for (int i = L; i < H - L; ++i)
+    // loop over pixels, the rows are processed in parallel
+    ParallelFor(L, H - L, [&](int firstRow, int lastRow)
     {
-      for (int j = L; j < W - L; ++j)
+      // values of the neighborhood, allocated once per thread
+      std::vector<uchar> neighborhoodValues;
+      neighborhoodValues.reserve((2 * L + 1) * (2 * L + 1));
+
+      for (int i = firstRow; i < lastRow; ++i)
       {
-        // Check if the value is available
-        double currentValue = rawImg.at<uchar>(i, j);
-        if (currentValue == 255)
+        uchar* outputRow = img[imgIndx].ptr<uchar>(i);
+        for (int j = L; j < W - L; ++j)
         {
-          continue;
-        }
-
-        std::vector<int> neighborhoodValues;
+          // Check if the value is available
+          if (rawImg.at<uchar>(i, j) == 255)
+          {
+            continue;
+          }
 
-        // Loop over the neighborhood
-        for (int u = i - L; u <= i + L; ++u)
-        {
-          for (int v = j - L; v <= j + L; ++v)
+          // Loop over the neighborhood
+          neighborhoodValues.clear();
+          for (int u = i - L; u <= i + L; ++u)
           {
-            // Get pixel value and check if data is available
-            int value = rawImg.at<uchar>(u, v);
-            if (value == 255)
+            const uchar* neighborRow = rawImg.ptr<uchar>(u);
+            for (int v = j - L; v <= j + L; ++v)
             {
-              continue;
+              // Get pixel value and check if data is available
+              if (neighborRow[v] != 255)
+              {
+                neighborhoodValues.push_back(neighborRow[v]);
+              }
             }
-            neighborhoodValues.push_back(value);
           }
-        }
-
-        // sort the values
-        std::sort(neighborhoodValues.begin(), neighborhoodValues.end());
 
-        int idx = std::floor(((double)neighborhoodValues.size() - 1.0) / 2.0);
-        img[imgIndx].at<uchar>(i, j) = neighborhoodValues[idx];
+          // select the median, without sorting all the values
+          auto median = neighborhoodValues.begin() + (neighborhoodValues.size() - 1) / 2;
+          std::nth_element(neighborhoodValues.begin(), median, neighborhoodValues.end());
+          outputRow[j] = *median;
+        }
       }
-    }
+    });
   }
 }
 
@@ -491,103 +463,134 @@ void ComputeImageGradient(cv::Mat img, std::vector<Eigen::Vector2d>& gradients,
 
   int H = img.rows;
   int W = img.cols;
-  double maxG = 0.0;
 
   gradients = std::vector<Eigen::Vector2d>(H * W, Eigen::Vector2d(0, 0));
   std::vector<double> gradientNorm(H * W, 0.0);
-  for (int i = 0; i < H; ++i)
+  std::vector<double> maxGPerRow(H, 0.0);
+  ParallelFor(0, H, [&](int firstRow, int lastRow)
   {
-    for (int j = 0; j < W; ++j)
+    for (int i = firstRow; i < lastRow; ++i)
     {
-      int imin = std::max(i - 1, 0);
-      int imax = std::min(H - 1, i + 1);
-
-      int jmin = std::max(j - 1, 0);
-      int jmax = std::min(W - 1, j + 1);
-
-      uchar currentValue = img.at<uchar>(i, j);
-
-      // Estimate partial derivation using central finite difference
-      double gX = ((double)(img.at<uchar>(i, jmax)) - (double)(img.at<uchar>(i, jmin))) / 2.0;
-      double gY = ((double)(img.at<uchar>(imax, j)) - (double)(img.at<uchar>(imin, j))) / 2.0;
-      double normG = std::sqrt(gX * gX + gY * gY);
-      maxG = std::max(maxG, normG);
-      gradientNorm[i + H * j] = normG;
-
-      // set gradient value to zero to preserve empty data
-      if (manageEmptyData && currentValue == 255)
+      const uchar* row = img.ptr<uchar>(i);
+      const uchar* previousRow = img.ptr<uchar>(std::max(i - 1, 0));
+      const uchar* nextRow = img.ptr<uchar>(std::min(H - 1, i + 1));
+      for (int j = 0; j < W; ++j)
       {
-        gradientNorm[i + H * j] = 0;
-      }
+        int jmin = std::max(j - 1, 0);
+        int jmax = std::min(W - 1, j + 1);
+
+        // Estimate partial derivation using central finite difference
+        double gX = ((double)(row[jmax]) - (double)(row[jmin])) / 2.0;
+        double gY = ((double)(nextRow[j]) - (double)(previousRow[j])) / 2.0;
+        double normG = std::sqrt(gX * gX + gY * gY);
+        maxGPerRow[i] = std::max(maxGPerRow[i], normG);
+        gradientNorm[i * W + j] = normG;
+
+        // set gradient value to zero to preserve empty data
+        if (manageEmptyData && row[j] == 255)
+        {
+          gradientNorm[i * W + j] = 0;
+        }
 
-      // store the gradient vector
-      gradients[i + H * j] = Eigen::Vector2d(gX, gY);
+        // store the gradient vector
+        gradients[i * W + j] = Eigen::Vector2d(gX, gY);
+      }
     }
-  }
+  });
+  double maxG = *std::max_element(maxGPerRow.begin(), maxGPerRow.end());
 
-  for (int i = 0; i < H; ++i)
+  ParallelFor(0, H, [&](int firstRow, int lastRow)
   {
-    for (int j = 0; j < W; ++j)
+    for (int i = firstRow; i < lastRow; ++i)
     {
-      img.at<uchar>(i, j) = static_cast<uchar>(254.0 * gradientNorm[i + H * j] / maxG);
+      uchar* row = img.ptr<uchar>(i);
+      for (int j = 0; j < W; ++j)
+      {
+        row[j] = static_cast<uchar>(254.0 * gradientNorm[i * W + j] / maxG);
+      }
     }
-  }
+  });
 }
 
 //----------------------------------------------------------------------------
 void ComputeHOGDescriptor(const std::vector<Eigen::Vector2d>& gradient,
-                          std::vector<std::vector<double>>& HOG,
+                          std::vector<double>& HOG,
                           int cellSize, int H, int W)
 {
   // To avoid computing multiple time magnitude and angle of gradient,
   // preprocess it
-  std::vector<Eigen::Vector2d> polarGradient(H * W);
-  for (int k = 0; k < H * W; ++k)
+  std::vector<double> gradientNorm(H * W, 0.0);
+  std::vector<uchar> gradientBin(H * W, 0);
+  ParallelFor(0, H * W, [&](int begin, int end)
   {
-    double gradNorm = gradient[k].norm();
-    if (gradNorm < 1e-5)
+    for (int k = begin; k < end; ++k)
     {
-      polarGradient[k] = Eigen::Vector2d(0, 0);
+      double gradNorm = gradient[k].norm();
+      if (gradNorm >= 1e-5)
+      {
+        double angle = std::abs(atan2(gradient[k](1),  gradient[k](0)));
+        gradientNorm[k] = gradNorm;
+        gradientBin[k] = static_cast<uchar>(std::floor(HOGNbrBins * angle / (vtkMath::Pi() + 0.0001)));
+      }
     }
-    else
+  }, 0, W);
+
+  // The histogram of a cell is separable: first accumulate the
+  // histograms over the horizontal extent of the cell, then sum
+  // these row histograms over its vertical extent
+  std::vector<double> rowHOG(H * W * HOGNbrBins, 0.0);
+  ParallelFor(0, H, [&](int firstRow, int lastRow)
+  {
+    for (int i = firstRow; i < lastRow; ++i)
     {
-      double angle = std::abs(atan2(gradient[k](1),  gradient[k](0)));
-      polarGradient[k] = Eigen::Vector2d(gradNorm, angle);
+      for (int j = 0; j < W; ++j)
+      {
+        int vmin = std::max(j - cellSize, 0);
+        int vmax = std::min(W - 1, j + cellSize);
+        double* histogram = &rowHOG[(i * W + j) * HOGNbrBins];
+        for (int v = vmin; v <= vmax; ++v)
+        {
+          histogram[gradientBin[i * W + v]] += gradientNorm[i * W + v];
+        }
+      }
     }
-  }
+  });
 
-  HOG = std::vector<std::vector<double>>(H * W, std::vector<double>(9, 0));
-
-  // loop over pixels
-  for (int i = 0; i < H; ++i)
+  HOG.assign(H * W * HOGNbrBins, 0.0);
+  ParallelFor(0, H, [&](int firstRow, int lastRow)
   {
-    for (int j = 0; j < W; ++j)
+    for (int i = firstRow; i < lastRow; ++i)
     {
       int umin = std::max(i - cellSize, 0);
       int umax = std::min(H - 1, i + cellSize);
+      double* histograms = &HOG[i * W * HOGNbrBins];
 
-      int vmin = std::max(j - cellSize, 0);
-      int vmax = std::min(W - 1, j + cellSize);
-
-      // loop over the cell
-      double sumGradNorm = 0;
+      // loop over the rows of the cell
       for (int u = umin; u <= umax; ++u)
       {
-        for (int v = vmin; v <= vmax; ++v)
+        const double* rowHistograms = &rowHOG[u * W * HOGNbrBins];
+        for (int k = 0; k < W * HOGNbrBins; ++k)
         {
-          int bin = std::floor(9.0 * polarGradient[u + H * v](1) / (vtkMath::Pi() + 0.0001));
-          HOG[i + H * j][bin] += polarGradient[u + H * v](0);
-          sumGradNorm += polarGradient[u + H * v](0);
+          histograms[k] += rowHistograms[k];
         }
       }
 
-      // normalized the histogram
-      for (int k = 0; k < 9; ++k)
+      // normalized the histograms, a cell without
+      // any gradient keeps an empty histogram
+      for (int j = 0; j < W; ++j)
       {
-        HOG[i + H * j][k] /= sumGradNorm;
+        double* histogram = &histograms[j * HOGNbrBins];
+        double sumGradNorm = std::accumulate(histogram, histogram + HOGNbrBins, 0.0);
+        if (sumGradNorm > 0)
+        {
+          for (int k = 0; k < HOGNbrBins; ++k)
+          {
+            histogram[k] /= sumGradNorm;
+          }
+        }
       }
     }
-  }
+  });
 }
 
 //----------------------------------------------------------------------------
@@ -627,6 +630,16 @@ MIDHOGCalibration::MIDHOGCalibration(const cv::Mat& image,
   this->NeighborRadius = neighborRadius;
 
   this->ComputeCloudNormals();
+
+  // The real image does not depend on the camera parameters, its
+  // gradient and HOG descriptors are computed once for all the
+  // synthetic images. The gradient is computed on a copy since it
+  // overwrites its input.
+  if (!this->Image.empty())
+  {
+    ComputeImageGradient(this->Image.clone(), this->ImageGradient);
+    ComputeHOGDescriptor(this->ImageGradient, this->ImageHOG, 8, this->Image.rows, this->Image.cols);
+  }
 }
 
 //----------------------------------------------------------------------------
@@ -658,6 +671,7 @@ void MIDHOGCalibration::ComputeCloudNormals()
 void MIDHOGCalibration::CreateSyntheticImage()
 {
   // create a white image
+  this->SyntheticImage.clear();
   this->SyntheticImage.push_back(255.0 * cv::Mat::ones(this->Image.size(), CV_8UC1));
   this->SyntheticImage.push_back(255.0 * cv::Mat::ones(this->Image.size(), CV_8UC1));
   this->SyntheticImage.push_back(255.0 * cv::Mat::ones(this->Image.size(), CV_8UC1));
@@ -667,19 +681,20 @@ void MIDHOGCalibration::CreateSyntheticImage()
   // Create the synthetic image
   // First, project all the points on the image. If two differents points
   // are projected on the same pixel, we keep the closest one (according to
-  // the center of the camera)
-  std::vector<Eigen::Vector3d> projectionMatching(this->Image.cols * this->Image.rows, Eigen::Vector3d::Zero());
-  std::vector<double> projectionIntensity(this->Image.cols * this->Image.rows, 0);
-  std::vector<double> projectionDepth(this->Image.cols * this->Image.rows, 0);
-  std::vector<double> projectionNormalAngle(this->Image.cols * this->Image.rows, 0);
-  std::vector<bool> hasPointProjected(this->Image.cols * this->Image.rows, false);
+  // the center of the camera). The pixels are stored in row-major order,
+  // like the images.
+  std::vector<Eigen::Vector3d> projectionMatching(H * W, Eigen::Vector3d::Zero());
+  std::vector<double> projectionIntensity(H * W, 0);
+  std::vector<double> projectionDepth(H * W, 0);
+  std::vector<double> projectionNormalAngle(H * W, 0);
+  std::vector<uchar> hasPointProjected(H * W, 0);
   ProjectAllPoints(this->Cloud, this->CameraParams, projectionMatching,
                    projectionIntensity, projectionDepth, projectionNormalAngle,
                    hasPointProjected, H, W);
 
   // Now, handle occultation using heuristic method.
   // For each point, we will estimate the visibility
-  std::vector<bool> isPointVisible(this->Image.cols * this->Image.rows, true);
+  std::vector<uchar> isPointVisible(H * W, 1);
   ComputePointVisibility(isPointVisible, projectionMatching,
                          hasPointProjected, H, W, this->NeighborRadius);
 
@@ -692,47 +707,43 @@ void MIDHOGCalibration::CreateSyntheticImage()
 
   // Once the visibility has been computed, we can create the image of
   // visible projected 3D points
-  Eigen::Vector3d C(this->CameraParams[3], this->CameraParams[4], this->CameraParams[5]);
   for (int i = 0; i < H; ++i)
   {
     for (int j = 0; j < W; ++j)
     {
-      if (hasPointProjected[i + H * j] && isPointVisible[i + H * j])
+      const size_t pixel = i * W + j;
+      if (hasPointProjected[pixel] && isPointVisible[pixel])
       {
-        this->SyntheticImage[0].at<uchar>(i, j) = projectionIntensity[i + H * j];
-        this->SyntheticImage[1].at<uchar>(i, j) = static_cast<uchar>(254.0 -  254.0 * projectionDepth[i + H * j] / maxD);
-        if (!std::isnan(projectionNormalAngle[i + H * j]))
+        this->SyntheticImage[0].at<uchar>(i, j) = projectionIntensity[pixel];
+        this->SyntheticImage[1].at<uchar>(i, j) = static_cast<uchar>(254.0 -  254.0 * projectionDepth[pixel] / maxD);
+        if (!std::isnan(projectionNormalAngle[pixel]))
         {
-          this->SyntheticImage[2].at<uchar>(i, j) = static_cast<uchar>(254.0 * projectionNormalAngle[i + H * j]);
+          this->SyntheticImage[2].at<uchar>(i, j) = static_cast<uchar>(254.0 * projectionNormalAngle[pixel]);
         }
       }
     }
   }
 
   // Finally, we will interpole missing data
-  ComputeInterpolation(this->SyntheticImage, this->NeighborRadiusInterpolation, projectionMatching, C, H, W);
+  ComputeInterpolation(this->SyntheticImage, this->NeighborRadiusInterpolation, projectionDepth);
 
   // Compute median filter to remove salt noise
   ComputeMedianFilter(this->SyntheticImage, this->NeighborRadiusMedianFilter);
 
   std::vector<std::vector<Eigen::Vector2d>> syntheticImgGradients(3);
-  std::vector<Eigen::Vector2d> realImgGradient;
 
   // Compute gradient image
   for (int i = 0; i < 3; ++i)
   {
     ComputeImageGradient(this->SyntheticImage[i], syntheticImgGradients[i], true);
   }
-  ComputeImageGradient(this->Image, realImgGradient);
-
-  std::vector<std::vector<std::vector<double>>> syntheticImgHOG(3);
-  std::vector<std::vector<double>> realImgHOG;
 
+  // HOG descriptors, HOGNbrBins contiguous values per pixel
+  std::vector<std::vector<double>> syntheticImgHOG(3);
   for (int i = 0; i < 3; ++i)
   {
     ComputeHOGDescriptor(syntheticImgGradients[i], syntheticImgHOG[i], 8, H, W);
   }
-  ComputeHOGDescriptor(realImgGradient, realImgHOG, 8, H, W);
 
   // extract keypoints using harris corner to then, compare
   // their HOG descriptor with the synthetic image ones
@@ -81,6 +81,13 @@ protected:
   // the current camera parameters estimation
   std::vector<cv::Mat> SyntheticImage;
 
+  // Gradient and HOG descriptors of the real image, computed once
+  // since they do not depend on the camera parameters. They are
+  // stored in row-major order, with 9 contiguous bins per pixel
+  // for the HOG descriptors
+  std::vector<Eigen::Vector2d> ImageGradient;
+  std::vector<double> ImageHOG;
+
   // Radius of the neighbor (in pixel) used to check the visibility
   // of the 3D point once projected on the image. To compute if a point
   // is visible we will estimate its solid angle using the points that
@@ -91,9 +91,12 @@ std::vector<std::vector<double>> ComputeTurns(
               << poseTrajectory->GetNumberOfTransforms()
               << " samples" << std::endl;
   }
+  std::vector<double> prevTimes, nextTimes;
+  prevTimes.reserve(poseTrajectory->GetNumberOfTransforms());
+  nextTimes.reserve(poseTrajectory->GetNumberOfTransforms());
+  vtkSmartPointer<vtkTransform> sample = vtkSmartPointer<vtkTransform>::New();
   for (int i = 0; i < poseTrajectory->GetNumberOfTransforms(); i++)
   {
-    vtkSmartPointer<vtkTransform> sample = vtkSmartPointer<vtkTransform>::New();
     double t;
     poseTrajectory->GetSample(i, sample, t);
     if (t - 0.5 * timeWindow < poseTrajectory->GetMinimumT()
@@ -103,13 +106,21 @@ std::vector<std::vector<double>> ComputeTurns(
     }
     sampleId.push_back(i);
     sampleTime.push_back(t);
+    prevTimes.push_back(t - 0.5 * timeWindow);
+    nextTimes.push_back(t + 0.5 * timeWindow);
+  }
 
-    vtkSmartPointer<vtkTransform> prev = vtkSmartPointer<vtkTransform>::New();
-    poseTrajectory->InterpolateTransform(t - 0.5 * timeWindow, prev);
-    vtkSmartPointer<vtkTransform> next = vtkSmartPointer<vtkTransform>::New();
-    poseTrajectory->InterpolateTransform(t + 0.5 * timeWindow, next);
-    Eigen::AngleAxisd aa = Eigen::AngleAxisd(RotationMatrixFromTransform(next)
-		    * RotationMatrixFromTransform(prev).transpose());
+  // The times are increasing, so the orientations at the beginning and at
+  // the end of the windows are interpolated in a single pass each
+  std::vector<double> positions, prevRotations, nextRotations;
+  poseTrajectory->InterpolateTransforms(prevTimes, positions, prevRotations);
+  poseTrajectory->InterpolateTransforms(nextTimes, positions, nextRotations);
+  using RowMajorMatrix3d = Eigen::Matrix<double, 3, 3, Eigen::RowMajor>;
+  for (size_t k = 0; k < sampleTime.size(); k++)
+  {
+    Eigen::Map<const RowMajorMatrix3d> prev(&prevRotations[9 * k]);
+    Eigen::Map<const RowMajorMatrix3d> next(&nextRotations[9 * k]);
+    Eigen::AngleAxisd aa = Eigen::AngleAxisd(Eigen::Matrix3d(next * prev.transpose()));
     double curvature = std::abs(aa.angle()) / timeWindow;
     sampleStatus.push_back(curvature >= curveTreshold);
   }
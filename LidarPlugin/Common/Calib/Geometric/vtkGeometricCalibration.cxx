@@ -24,6 +24,9 @@
 #include "vtkConversions.h"
 #include "vtkTemporalTransformsReader.h"
 #include "CeresCostFunctions.h"
+#include "ParallelFor.h"
+#include "SolverConfiguration.h"
+#include "TrajectoryInterpolator.h"
 
 // STD
 #include <stdlib.h>
@@ -52,29 +55,51 @@ std::pair<double, AnglePositionVector> EstimateCalibrationFromPoses(const std::s
 }
 
 //----------------------------------------------------------------------------
-std::pair<double, AnglePositionVector> EstimateCalibrationFromPoses(
-                                              vtkSmartPointer<vtkTemporalTransforms> sourceSensor,
-                                              vtkSmartPointer<vtkTemporalTransforms> targetSensor,
+// Same as EstimateCalibrationFromPoses, from trajectories already loaded.
+// They are only read, so several calibrations can run in parallel on them.
+std::pair<double, AnglePositionVector> EstimateCalibrationFromTrajectories(
+                                              const TrajectoryInterpolator& sourceSensor,
+                                              const TrajectoryInterpolator& targetSensor,
                                               const double timeScaleAnalysisBound,
                                               const double timeScaleAnalysisStep,
-                                              const double timeStep)
+                                              const double timeStep,
+                                              unsigned int numberOfThreads)
 {
-  Eigen::Matrix3d P1, P2, Q1, Q2;
-  Eigen::Vector3d U1, U2, V1, V2;
-
   // Parameters to estimate
   // - Rotation euler angles from 0 to 2
   // - Translation coordinates from 3 to 5
   AnglePositionVector calibEstimation = AnglePositionVector::Zero();
+  if (sourceSensor.IsEmpty() || targetSensor.IsEmpty())
+  {
+    std::cerr << "Cannot estimate the calibration from an empty trajectory" << std::endl;
+    return std::pair<double, AnglePositionVector>(0., calibEstimation);
+  }
+  double tmin = std::max(sourceSensor.GetMinimumTime(), targetSensor.GetMinimumTime());
+  double tmax = std::min(sourceSensor.GetMaximumTime(), targetSensor.GetMaximumTime());
 
-  // Create the transforms interpolators
-  vtkSmartPointer<vtkCustomTransformInterpolator> sourceSensorTransforms = sourceSensor->CreateInterpolator();
-  vtkSmartPointer<vtkCustomTransformInterpolator> targetSensorTransforms = targetSensor->CreateInterpolator();
-  sourceSensorTransforms->SetInterpolationTypeToLinear();
-  targetSensorTransforms->SetInterpolationTypeToLinear();
-  double tmin = std::max(sourceSensorTransforms->GetMinimumT(), targetSensorTransforms->GetMinimumT());
-  double tmax = std::min(sourceSensorTransforms->GetMaximumT(), targetSensorTransforms->GetMaximumT());
-  vtkSmartPointer<vtkTransform> transform = vtkSmartPointer<vtkTransform>::New();
+  // The two time positions used to express each solid-system geometric
+  // constraint, stored as consecutive pairs (t0, t1)
+  std::vector<double> times;
+  // Loop over the time index
+  for (double time = tmin + timeScaleAnalysisBound; time < tmax - timeScaleAnalysisBound; time += timeStep)
+  {
+    // Loop over the deltaTime multi-resolution "solid-system" assumption constraint
+    for (double dt = 0; dt <= timeScaleAnalysisBound;  dt += timeScaleAnalysisStep)
+    {
+      times.push_back(time - dt);
+      times.push_back(time + dt);
+    }
+  }
+
+  // Sample the two trajectories at once
+  const size_t nbrTimes = times.size();
+  std::vector<double> sourcePositions(3 * nbrTimes), sourceRotations(9 * nbrTimes);
+  std::vector<double> targetPositions(3 * nbrTimes), targetRotations(9 * nbrTimes);
+  sourceSensor.InterpolateRotations(times.data(), nbrTimes, sourcePositions.data(),
+                                    sourceRotations.data(), numberOfThreads);
+  targetSensor.InterpolateRotations(times.data(), nbrTimes, targetPositions.data(),
+                                    targetRotations.data(), numberOfThreads);
+  using RowMajorMatrix3d = Eigen::Matrix<double, 3, 3, Eigen::RowMajor>;
 
   // We want to estimate our 6-DOF parameters using a non
   // linear least square minimization. The non linear part
@@ -82,46 +107,30 @@ std::pair<double, AnglePositionVector> EstimateCalibrationFromPoses(
   // endomorphism SO(3). To minimize it we use CERES to perform
   // the Levenberg-Marquardt algorithm.
   ceres::Problem problem;
-
-  // Loop over the time index
-  for (double time = tmin + timeScaleAnalysisBound; time < tmax - timeScaleAnalysisBound; time += timeStep)
+  for (size_t k = 0; k < nbrTimes; k += 2)
   {
-    // Loop over the deltaTime multi-resolution "solid-system" assumption constraint
-    for (double dt = 0; dt <= timeScaleAnalysisBound;  dt += timeScaleAnalysisStep)
-    {
-      // The two time positions that will be used to express
-      // the solid-system geometric constraints that link
-      // the two sensor poses trajectories
-      double t0 = time - dt;
-      double t1 = time + dt;
-
-      //======================== Time: t0 ==================================
-      // Sensor 1
-      sourceSensorTransforms->InterpolateTransform(t0, transform);
-      std::pair<Eigen::Vector3d, Eigen::Vector3d> sensor1T0Pose = GetPoseParamsFromTransform(transform);
-      P1 = RollPitchYawToMatrix(sensor1T0Pose.first); V1 = sensor1T0Pose.second;
-      // Sensor 2
-      targetSensorTransforms->InterpolateTransform(t0, transform);
-      std::pair<Eigen::Vector3d, Eigen::Vector3d> sensor2T0Pose = GetPoseParamsFromTransform(transform);
-      Q1 = RollPitchYawToMatrix(sensor2T0Pose.first); U1 = sensor2T0Pose.second;
-
-      //======================== Time: t1 ==================================
-      // Sensor 1
-      sourceSensorTransforms->InterpolateTransform(t1, transform);
-      std::pair<Eigen::Vector3d, Eigen::Vector3d> sensor1T1Pose = GetPoseParamsFromTransform(transform);
-      P2 = RollPitchYawToMatrix(sensor1T1Pose.first); V2 = sensor1T1Pose.second;
-      // Sensor 2
-      targetSensorTransforms->InterpolateTransform(t1, transform);
-      std::pair<Eigen::Vector3d, Eigen::Vector3d> sensor2T1Pose = GetPoseParamsFromTransform(transform);
-      Q2 = RollPitchYawToMatrix(sensor2T1Pose.first); U2 = sensor2T1Pose.second;
-
-      // add this geometric constraint non-linear least square residu to the global
-      // cost function that is the sum of all residuals functions
-      ceres::CostFunction* cost_function = new ceres::AutoDiffCostFunction<CostFunctions::FrobeniusDistanceRotationAndTranslationCalibrationResidual, 1, 6>
-                (new CostFunctions::FrobeniusDistanceRotationAndTranslationCalibrationResidual(P1, P2, Q1, Q2, V1, V2, U1, U2));
-      problem.AddResidualBlock(cost_function, nullptr, calibEstimation.data());
-    } // Loop over the deltaTime multi-resolution "solid-system" assumption constraint
-  } // Loop over the time
+    //======================== Time: t0 ==================================
+    // Sensor 1
+    Eigen::Matrix3d P1 = Eigen::Map<const RowMajorMatrix3d>(&sourceRotations[9 * k]);
+    Eigen::Vector3d V1 = Eigen::Map<const Eigen::Vector3d>(&sourcePositions[3 * k]);
+    // Sensor 2
+    Eigen::Matrix3d Q1 = Eigen::Map<const RowMajorMatrix3d>(&targetRotations[9 * k]);
+    Eigen::Vector3d U1 = Eigen::Map<const Eigen::Vector3d>(&targetPositions[3 * k]);
+
+    //======================== Time: t1 ==================================
+    // Sensor 1
+    Eigen::Matrix3d P2 = Eigen::Map<const RowMajorMatrix3d>(&sourceRotations[9 * (k + 1)]);
+    Eigen::Vector3d V2 = Eigen::Map<const Eigen::Vector3d>(&sourcePositions[3 * (k + 1)]);
+    // Sensor 2
+    Eigen::Matrix3d Q2 = Eigen::Map<const RowMajorMatrix3d>(&targetRotations[9 * (k + 1)]);
+    Eigen::Vector3d U2 = Eigen::Map<const Eigen::Vector3d>(&targetPositions[3 * (k + 1)]);
+
+    // add this geometric constraint non-linear least square residu to the global
+    // cost function that is the sum of all residuals functions
+    ceres::CostFunction* cost_function = new ceres::AutoDiffCostFunction<CostFunctions::FrobeniusDistanceRotationAndTranslationCalibrationResidual, 1, 6>
+              (new CostFunctions::FrobeniusDistanceRotationAndTranslationCalibrationResidual(P1, P2, Q1, Q2, V1, V2, U1, U2));
+    problem.AddResidualBlock(cost_function, nullptr, calibEstimation.data());
+  }
 
   // Solve the optimization problem
   // Option of the solver
@@ -129,6 +138,7 @@ std::pair<double, AnglePositionVector> EstimateCalibrationFromPoses(
   options.max_num_iterations = 75;
   options.linear_solver_type = ceres::DENSE_QR;
   options.minimizer_progress_to_stdout = false;
+  GetCalibrationSolverConfiguration().Apply(options, numberOfThreads);
   // Solve
   ceres::Solver::Summary summary;
   ceres::Solve(options, &problem, &summary);
@@ -137,6 +147,26 @@ std::pair<double, AnglePositionVector> EstimateCalibrationFromPoses(
   return std::pair<double, AnglePositionVector>(summary.final_cost, calibEstimation);
 }
 
+//----------------------------------------------------------------------------
+std::pair<double, AnglePositionVector> EstimateCalibrationFromPoses(
+                                              vtkSmartPointer<vtkTemporalTransforms> sourceSensor,
+                                              vtkSmartPointer<vtkTemporalTransforms> targetSensor,
+                                              const double timeScaleAnalysisBound,
+                                              const double timeScaleAnalysisStep,
+                                              const double timeStep)
+{
+  // Create the transforms interpolators
+  vtkSmartPointer<vtkCustomTransformInterpolator> sourceSensorTransforms = sourceSensor->CreateInterpolator();
+  vtkSmartPointer<vtkCustomTransformInterpolator> targetSensorTransforms = targetSensor->CreateInterpolator();
+  sourceSensorTransforms->SetInterpolationTypeToLinear();
+  targetSensorTransforms->SetInterpolationTypeToLinear();
+
+  return EstimateCalibrationFromTrajectories(sourceSensorTransforms->GetTrajectoryInterpolator(),
+                                             targetSensorTransforms->GetTrajectoryInterpolator(),
+                                             timeScaleAnalysisBound, timeScaleAnalysisStep, timeStep,
+                                             GetCalibrationSolverConfiguration().GetNumberOfThreads());
+}
+
 //----------------------------------------------------------------------------
 vtkSmartPointer<vtkTemporalTransforms> EstimateCalibrationFromPosesAndApply(
                                             vtkSmartPointer<vtkTemporalTransforms> sourceSensor,
@@ -188,6 +218,30 @@ struct CombinationTry
   }
 };
 
+//-----------------------------------------------------------------------------
+Eigen::Matrix3d ChangeConvention(const Eigen::Matrix3d& rotation,
+                                 const int anglesOrder[3],
+                                 const int matrixOrder[3],
+                                 const double sign[3])
+{
+  // Get the euler-angles with respect to the convention:
+  // R(rx, ry, rz) = Rz(rz)*Ry(ry)*Rx(rx)
+  Eigen::Vector3d eulerAngles = MatrixToRollPitchYaw(rotation);
+
+  // Now, change the euler angle convention using the current
+  // convention parameters
+  double rx = sign[0] * eulerAngles(anglesOrder[0]); // rx can be +1/-1 * r x/y/z
+  double ry = sign[1] * eulerAngles(anglesOrder[1]); // ry can be +1/-1 * r x/y/z
+  double rz = sign[2] * eulerAngles(anglesOrder[2]); // rz can be +1/-1 * r x/y/z
+
+  // Compute the rotation around canonic axis
+  Eigen::Matrix3d Rot[3];
+  Rot[0] = Eigen::Matrix3d(Eigen::AngleAxisd(rx, Eigen::Vector3d::UnitX()));
+  Rot[1] = Eigen::Matrix3d(Eigen::AngleAxisd(ry, Eigen::Vector3d::UnitY()));
+  Rot[2] = Eigen::Matrix3d(Eigen::AngleAxisd(rz, Eigen::Vector3d::UnitZ()));
+  return Rot[matrixOrder[0]] * Rot[matrixOrder[1]] * Rot[matrixOrder[2]];
+}
+
 //-----------------------------------------------------------------------------
 vtkSmartPointer<vtkTemporalTransforms> ChangeConvention(vtkSmartPointer<vtkTemporalTransforms> inputPoses,
                                                         int anglesOrder[3],
@@ -207,25 +261,10 @@ vtkSmartPointer<vtkTemporalTransforms> ChangeConvention(vtkSmartPointer<vtkTempo
     // Get the angle-axis representation
     double* xyzw = xyzwArray->GetTuple4(transformIndex);
 
-    // Compute the corresponding rotation and get the euler-angles with respect
-    // to the convention:
-    // R(rx, ry, rz) = Rz(rz)*Ry(ry)*Rx(rx)
+    // Compute the corresponding rotation and change its convention
     Eigen::AngleAxisd angleAxis(xyzw[3], Eigen::Vector3d(xyzw[0], xyzw[1], xyzw[2]));
-    Eigen::Matrix3d rotation = angleAxis.toRotationMatrix();
-    Eigen::Vector3d eulerAngles = MatrixToRollPitchYaw(rotation);
-
-    // Now, change the euler angle convention using the current
-    // convention parameters
-    double rx = sign[0] * eulerAngles(anglesOrder[0]); // rx can be +1/-1 * r x/y/z
-    double ry = sign[1] * eulerAngles(anglesOrder[1]); // ry can be +1/-1 * r x/y/z
-    double rz = sign[2] * eulerAngles(anglesOrder[2]); // rz can be +1/-1 * r x/y/z
-
-    // Compute the rotation around canonic axis
-    std::vector<Eigen::Matrix3d> Rot(3);
-    Rot[0] = Eigen::Matrix3d(Eigen::AngleAxisd(rx, Eigen::Vector3d::UnitX()));
-    Rot[1] = Eigen::Matrix3d(Eigen::AngleAxisd(ry, Eigen::Vector3d::UnitY()));
-    Rot[2] = Eigen::Matrix3d(Eigen::AngleAxisd(rz, Eigen::Vector3d::UnitZ()));
-    Eigen::Matrix3d newRotation = Rot[matrixOrder[0]] * Rot[matrixOrder[1]] * Rot[matrixOrder[2]];
+    Eigen::Matrix3d newRotation = ChangeConvention(angleAxis.toRotationMatrix(), anglesOrder,
+                                                   matrixOrder, sign);
 
     // Get the axis angle representation of this new rotation
     Eigen::AngleAxisd newAngleAxis(newRotation);
@@ -252,12 +291,19 @@ void EstimateEulerAngleConvention(const std::string& sourceSensorFilename,
 //-----------------------------------------------------------------------------
 void EstimateEulerAngleConvention(vtkSmartPointer<vtkTemporalTransforms> sourceSensor, vtkSmartPointer<vtkTemporalTransforms> targetSensor)
 {
+  // One convention to try
+  struct Combination
+  {
+    int anglesOrder[3];
+    int matrixOrder[3];
+    double sign[3];
+  };
+  std::vector<Combination> combinations;
+  combinations.reserve(288); // 6 angles positions * 6 matrix order * 8 signs
+
   int anglesOrder[3] = {0, 1, 2};
   int matrixOrder[3] = {0, 1, 2};
-  std::vector<CombinationTry> results;
-  results.reserve(288); // 6 angles positions * 6 matrix order * 8 signs
   bool shouldPermutAngles = true;
-  int combinationCount = 0;
 
   // Loop over the angles positions permutations
   while (shouldPermutAngles)
@@ -269,39 +315,74 @@ void EstimateEulerAngleConvention(vtkSmartPointer<vtkTemporalTransforms> sourceS
       // Loop over the angles signs
       for (int signIndex = 0; signIndex < 8; ++signIndex)
       {
-        double sign[3];
+        Combination combination;
+        std::copy(anglesOrder, anglesOrder + 3, combination.anglesOrder);
+        std::copy(matrixOrder, matrixOrder + 3, combination.matrixOrder);
         // convert signIndex into binary code using -1 and 1
         int quotient = signIndex;
-        sign[2] = (quotient % 2) ? 1.0 : -1.0;
+        combination.sign[2] = (quotient % 2) ? 1.0 : -1.0;
         quotient = quotient / 2;
-        sign[1] = (quotient % 2) ? 1.0 : -1.0;
+        combination.sign[1] = (quotient % 2) ? 1.0 : -1.0;
         quotient = quotient / 2;
-        sign[0] = (quotient % 2) ? 1.0 : -1.0;
-
-        // Create a new vtkTemporalTransforms according to the current euler angle convention
-        vtkSmartPointer<vtkTemporalTransforms> targetPosesCurrCombination = ChangeConvention(targetSensor,
-                                                                                              anglesOrder,
-                                                                                              matrixOrder,
-                                                                                              sign);
-
-        // Compute the calibration and get the final residual value
-        std::pair<double, AnglePositionVector> estimation = EstimateCalibrationFromPoses(
-                                                                       targetPosesCurrCombination, sourceSensor);
-
-        // Store the combination try
-        Eigen::Vector3d Angles = estimation.second.segment(0, 3);
-        Eigen::Vector3d T = estimation.second.segment(3, 3);
-        CombinationTry currentTry(combinationCount, anglesOrder, matrixOrder, sign,
-                                  Angles, T, estimation.first);
-        results.push_back(currentTry);
-
-        combinationCount++;
+        combination.sign[0] = (quotient % 2) ? 1.0 : -1.0;
+        combinations.push_back(combination);
       } // Loop over the angles signs
       shouldPermutMatrix = std::next_permutation(matrixOrder, matrixOrder + 3);
     } // Loop over matrix multiplication order
     shouldPermutAngles = std::next_permutation(anglesOrder, anglesOrder + 3);
   } // Loop over the angles positions permutations
 
+  // The trajectories are read once, the VTK objects are not used by the
+  // threads below. Changing the convention of the target poses only changes
+  // their orientations, the trajectory of each combination is built from them.
+  vtkSmartPointer<vtkCustomTransformInterpolator> sourceSensorTransforms = sourceSensor->CreateInterpolator();
+  vtkSmartPointer<vtkCustomTransformInterpolator> targetSensorTransforms = targetSensor->CreateInterpolator();
+  sourceSensorTransforms->SetInterpolationTypeToLinear();
+  targetSensorTransforms->SetInterpolationTypeToLinear();
+  const TrajectoryInterpolator& sourceTrajectory = sourceSensorTransforms->GetTrajectoryInterpolator();
+  const TrajectoryInterpolator& targetTrajectory = targetSensorTransforms->GetTrajectoryInterpolator();
+
+  // The combinations are independent problems, solve them in parallel,
+  // each one with a single thread
+  std::vector<std::pair<double, AnglePositionVector>> estimations(combinations.size());
+  ParallelFor(0, static_cast<int>(combinations.size()), [&](int begin, int end)
+  {
+    for (int combinationIndex = begin; combinationIndex < end; ++combinationIndex)
+    {
+      const Combination& combination = combinations[combinationIndex];
+
+      // Create the target trajectory according to the current euler angle convention
+      TrajectoryInterpolator targetPosesCurrCombination;
+      targetPosesCurrCombination.Reserve(targetTrajectory.GetNumberOfPoses());
+      for (size_t poseIndex = 0; poseIndex < targetTrajectory.GetNumberOfPoses(); ++poseIndex)
+      {
+        Eigen::Map<const Eigen::Quaterniond> orientation(&targetTrajectory.GetOrientations()[4 * poseIndex]);
+        Eigen::Map<const Eigen::Vector3d> position(&targetTrajectory.GetPositions()[3 * poseIndex]);
+        Eigen::Matrix3d newRotation = ChangeConvention(orientation.toRotationMatrix(), combination.anglesOrder,
+                                                       combination.matrixOrder, combination.sign);
+        targetPosesCurrCombination.AddPose(targetTrajectory.GetTimes()[poseIndex], position,
+                                           Eigen::Quaterniond(newRotation));
+      }
+
+      // Compute the calibration and get the final residual value
+      estimations[combinationIndex] = EstimateCalibrationFromTrajectories(targetPosesCurrCombination,
+                                                                          sourceTrajectory, 5.0, 0.2, 0.4, 1);
+    }
+  }, GetCalibrationSolverConfiguration().GetNumberOfThreads());
+
+  // Store the combination tries
+  std::vector<CombinationTry> results;
+  results.reserve(combinations.size());
+  for (size_t combinationIndex = 0; combinationIndex < combinations.size(); ++combinationIndex)
+  {
+    Combination& combination = combinations[combinationIndex];
+    const std::pair<double, AnglePositionVector>& estimation = estimations[combinationIndex];
+    Eigen::Vector3d Angles = estimation.second.segment(0, 3);
+    Eigen::Vector3d T = estimation.second.segment(3, 3);
+    results.push_back(CombinationTry(combinationIndex, combination.anglesOrder, combination.matrixOrder,
+                                     combination.sign, Angles, T, estimation.first));
+  }
+
   // Now, store the combination try using the final residual value
   std::sort(results.begin(), results.end(), [](CombinationTry const& a, CombinationTry const& b)
   {
@@ -328,22 +409,29 @@ std::pair<double, AnglePositionVector> MatchTrajectoriesWithIsometry(vtkSmartPoi
   double tmax = std::min(sourceSensorTransforms->GetMaximumT(), targetSensorTransforms->GetMaximumT());
   const double deltaTime = 0.2; // 200ms
 
-  // usefull transform
-  auto currTransform = vtkSmartPointer<vtkTransform>::New();
+  // Sample the positions of the two sensors at once
+  std::vector<double> times;
+  for (double time = tmin; time < tmax; time += deltaTime)
+  {
+    times.push_back(time);
+  }
+  const unsigned int nbrThreads = GetCalibrationSolverConfiguration().GetNumberOfThreads();
+  std::vector<double> sourcePositions(3 * times.size()), targetPositions(3 * times.size());
+  std::vector<double> orientations(4 * times.size());
+  sourceSensorTransforms->GetTrajectoryInterpolator().Interpolate(times.data(), times.size(),
+                                 sourcePositions.data(), orientations.data(), nbrThreads);
+  targetSensorTransforms->GetTrajectoryInterpolator().Interpolate(times.data(), times.size(),
+                                 targetPositions.data(), orientations.data(), nbrThreads);
 
   ceres::Problem problem;
-  Eigen::Vector3d X, Y;
   AnglePositionVector transformParams = AnglePositionVector::Zero();
 
   // Loop over the time
-  for (double time = tmin; time < tmax; time += deltaTime)
+  for (size_t k = 0; k < times.size(); ++k)
   {
-    // Get the position of the sensor 1 for time
-    sourceSensorTransforms->InterpolateTransform(time, currTransform);
-    X = GetPoseParamsFromTransform(currTransform).second;
-    // Get the position of the sensor 2 for time
-    targetSensorTransforms->InterpolateTransform(time, currTransform);
-    Y = GetPoseParamsFromTransform(currTransform).second;
+    // Position of the sensor 1 and of the sensor 2 for time
+    Eigen::Vector3d X = Eigen::Map<const Eigen::Vector3d>(&sourcePositions[3 * k]);
+    Eigen::Vector3d Y = Eigen::Map<const Eigen::Vector3d>(&targetPositions[3 * k]);
 
     // Add the geometric contraint residual function
     // to the non-linear least square problem
@@ -360,6 +448,7 @@ std::pair<double, AnglePositionVector> MatchTrajectoriesWithIsometry(vtkSmartPoi
   options.max_num_iterations = 75;
   options.linear_solver_type = ceres::DENSE_QR;
   options.minimizer_progress_to_stdout = false;
+  GetCalibrationSolverConfiguration().Apply(options);
   // Solve
   ceres::Solver::Summary summary;
   ceres::Solve(options, &problem, &summary);
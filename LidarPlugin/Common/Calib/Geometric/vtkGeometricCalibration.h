@@ -100,6 +100,9 @@ typedef Eigen::Matrix<double, 6, 1> AnglePositionVector;
 *        - 6: number of possible permutation for matrix multiplication order
 *        - 8: number of possible sign assigned to the angles
 *
+*        The combinations are independent problems, solved in parallel
+*        with the threads of GetCalibrationSolverConfiguration()
+*
 * \@param targetSensor Poses trajectory of the first sensor
 * \@param Sensor2Poses Poses trajectory of the second sensor
 */
@@ -21,6 +21,12 @@
 #include "eigenFFTCorrelation.h"
 #include "interpolator1D.h"
 
+// Number of samples of the decimated signals used by the coarse search of the
+// time shift, and the largest decimation factor (the refinement at full rate
+// costs a number of correlation products proportional to it)
+constexpr int CoarseCorrelationLength = 8192;
+constexpr int MaximumDecimation = 32;
+
 std::string ToString(CorrelationStrategy correlationStrategy)
 {
   switch (correlationStrategy)
@@ -50,27 +56,93 @@ std::string ToString(CorrelationStrategy correlationStrategy)
   }
 }
 
+namespace
+{
+// Poses of a trajectory sampled at increasing times, see
+// vtkCustomTransformInterpolator::InterpolateTransforms
+class SampledPoses
+{
+public:
+  SampledPoses(const vtkSmartPointer<vtkCustomTransformInterpolator>& transform,
+               const std::vector<double>& times)
+  {
+    transform->InterpolateTransforms(times, this->Positions, this->Rotations);
+  }
+
+  Eigen::Vector3d Position(size_t k) const
+  {
+    return Eigen::Map<const Eigen::Vector3d>(&this->Positions[3 * k]);
+  }
+
+  Eigen::Matrix3d Rotation(size_t k) const
+  {
+    return Eigen::Map<const Eigen::Matrix<double, 3, 3, Eigen::RowMajor>>(&this->Rotations[9 * k]);
+  }
+
+private:
+  std::vector<double> Positions;
+  std::vector<double> Rotations;
+};
+
+// Times from tMin (included) to tMax (excluded), incremented by period
+std::vector<double> AccumulatedTimes(double tMin, double tMax, double period)
+{
+  std::vector<double> times;
+  for (double time = tMin; time < tMax; time = time + period)
+  {
+    times.push_back(time);
+  }
+  return times;
+}
+
+// steps times from tMin, separated by period
+std::vector<double> RegularTimes(double tMin, int steps, double period)
+{
+  std::vector<double> times(std::max(0, steps));
+  for (int i = 0; i < steps; i++)
+  {
+    times[i] = tMin + i * period;
+  }
+  return times;
+}
+
+std::vector<double> ShiftedTimes(const std::vector<double>& times, double shift)
+{
+  std::vector<double> shifted(times.size());
+  for (size_t i = 0; i < times.size(); i++)
+  {
+    shifted[i] = times[i] + shift;
+  }
+  return shifted;
+}
+
+// Times of the transforms of the interpolator
+std::vector<double> TransformTimes(const vtkSmartPointer<vtkCustomTransformInterpolator>& transform)
+{
+  std::vector<std::vector<double>> transforms = transform->GetTransformList();
+  std::vector<double> times(transforms.size());
+  for (size_t i = 0; i < transforms.size(); i++)
+  {
+    times[i] = transforms[i][0];
+  }
+  return times;
+}
+}
+
 Interpolator1D<double> compute_speed_window(
     const vtkSmartPointer<vtkCustomTransformInterpolator>& transform,
     double window_width)
 {
-  std::vector<double> times = std::vector<double>();
-  std::vector<double> speeds = std::vector<double>();
-  vtkSmartPointer<vtkTransform> prev = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> next = vtkSmartPointer<vtkTransform>::New();
-
   double minMidWindowTime = transform->GetMinimumT() + 0.5 * window_width;
   double maxMidWindowTime = transform->GetMaximumT() - 0.5 * window_width;
-  double period = transform->GetPeriod();
-  double time = minMidWindowTime;
-  while (time < maxMidWindowTime)
+  std::vector<double> times = AccumulatedTimes(minMidWindowTime, maxMidWindowTime, transform->GetPeriod());
+  SampledPoses prev(transform, ShiftedTimes(times, -0.5 * window_width));
+  SampledPoses next(transform, ShiftedTimes(times, 0.5 * window_width));
+
+  std::vector<double> speeds = std::vector<double>(times.size());
+  for (size_t i = 0; i < times.size(); i++)
   {
-    transform->InterpolateTransform(time - 0.5 * window_width, prev);
-    transform->InterpolateTransform(time + 0.5 * window_width, next);
-    speeds.push_back((PositionVectorFromTransform(next)
-			    - PositionVectorFromTransform(prev)).norm() / window_width);
-    times.push_back(time);
-    time = time + period;
+    speeds[i] = (next.Position(i) - prev.Position(i)).norm() / window_width;
   }
 
   return Interpolator1D<double>(times, speeds);
@@ -80,27 +152,19 @@ Interpolator1D<double> compute_acc_window(
     const vtkSmartPointer<vtkCustomTransformInterpolator>& transform,
     double window_width)
 {
-  std::vector<double> times = std::vector<double>();
-  std::vector<double> accs = std::vector<double>();
-  vtkSmartPointer<vtkTransform> prev = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> next = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> curr = vtkSmartPointer<vtkTransform>::New();
-
   double minMidWindowTime = transform->GetMinimumT() + 0.5 * window_width;
   double maxMidWindowTime = transform->GetMaximumT() - 0.5 * window_width;
-  double period = transform->GetPeriod();
-  double time = minMidWindowTime;
-  while (time < maxMidWindowTime)
+  std::vector<double> times = AccumulatedTimes(minMidWindowTime, maxMidWindowTime, transform->GetPeriod());
+  SampledPoses prev(transform, ShiftedTimes(times, -0.5 * window_width));
+  SampledPoses curr(transform, times);
+  SampledPoses next(transform, ShiftedTimes(times, 0.5 * window_width));
+
+  std::vector<double> accs = std::vector<double>(times.size());
+  for (size_t i = 0; i < times.size(); i++)
   {
-    transform->InterpolateTransform(time - 0.5 * window_width, prev);
-    transform->InterpolateTransform(time, curr);
-    transform->InterpolateTransform(time + 0.5 * window_width, next);
-    Eigen::Vector3d a = (PositionVectorFromTransform(next)
-		    + PositionVectorFromTransform(prev)
-		    - 2 * PositionVectorFromTransform(curr)) / (window_width * window_width);
-    accs.push_back(a.norm());
-    times.push_back(time);
-    time = time + period;
+    Eigen::Vector3d a = (next.Position(i) + prev.Position(i) - 2 * curr.Position(i))
+                        / (window_width * window_width);
+    accs[i] = a.norm();
   }
 
   return Interpolator1D<double>(times, accs);
@@ -110,31 +174,20 @@ Interpolator1D<double> compute_jerk_window(
     const vtkSmartPointer<vtkCustomTransformInterpolator>& transform,
     double window_width)
 {
-  std::vector<double> times = std::vector<double>();
-  std::vector<double> jerks = std::vector<double>();
-  vtkSmartPointer<vtkTransform> t1 = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> t2 = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> t3 = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> t4 = vtkSmartPointer<vtkTransform>::New();
-
   double minMidWindowTime = transform->GetMinimumT() + 0.5 * window_width;
   double maxMidWindowTime = transform->GetMaximumT() - 0.5 * window_width;
-  double period = transform->GetPeriod();
-  double time = minMidWindowTime;
-  while (time < maxMidWindowTime)
+  std::vector<double> times = AccumulatedTimes(minMidWindowTime, maxMidWindowTime, transform->GetPeriod());
+  SampledPoses t1(transform, ShiftedTimes(times, - 0.5 * window_width));
+  SampledPoses t2(transform, ShiftedTimes(times, (- 0.5 + 1.0/3.0) * window_width));
+  SampledPoses t3(transform, ShiftedTimes(times, (- 0.5 + 2.0/3.0) * window_width));
+  SampledPoses t4(transform, ShiftedTimes(times, (- 0.5 + 3.0/3.0) * window_width));
+
+  std::vector<double> jerks = std::vector<double>(times.size());
+  for (size_t i = 0; i < times.size(); i++)
   {
-    transform->InterpolateTransform(time - 0.5 * window_width, t1);
-    transform->InterpolateTransform(time + (- 0.5 + 1.0/3.0) * window_width, t2);
-    transform->InterpolateTransform(time + (- 0.5 + 2.0/3.0) * window_width, t3);
-    transform->InterpolateTransform(time + (- 0.5 + 3.0/3.0) * window_width, t4);
-    Eigen::Vector3d j = (PositionVectorFromTransform(t4)
-		   - 3 * PositionVectorFromTransform(t3)
-		   + 3 * PositionVectorFromTransform(t2)
-		   - PositionVectorFromTransform(t1))
-	    / std::pow(window_width, 3.0);
-    jerks.push_back(j.norm());
-    times.push_back(time);
-    time = time + period;
+    Eigen::Vector3d j = (t4.Position(i) - 3 * t3.Position(i) + 3 * t2.Position(i) - t1.Position(i))
+                        / std::pow(window_width, 3.0);
+    jerks[i] = j.norm();
   }
 
   return Interpolator1D<double>(times, jerks);
@@ -143,24 +196,19 @@ Interpolator1D<double> compute_jerk_window(
 Interpolator1D<double> compute_dPos(
     const vtkSmartPointer<vtkCustomTransformInterpolator>& transform)
 {
-  std::vector<std::vector<double>> transforms = transform->GetTransformList();
-  std::vector<double> t = std::vector<double>(transforms.size() - 1);
-  std::vector<double> x = std::vector<double>(transforms.size() - 1);
-  vtkSmartPointer<vtkTransform> prev = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> curr = vtkSmartPointer<vtkTransform>::New();
-  for (unsigned int i = 0; i < transforms.size() - 1; i++)
+  std::vector<double> times = TransformTimes(transform);
+  SampledPoses poses(transform, times);
+  std::vector<double> t = std::vector<double>(times.size() - 1);
+  std::vector<double> x = std::vector<double>(times.size() - 1);
+  for (unsigned int i = 0; i < times.size() - 1; i++)
   {
-    double t0 = transforms[i][0];
-    double t1 = transforms[i+1][0];
+    double t0 = times[i];
+    double t1 = times[i+1];
     t[i] = 0.5 * (t0 + t1);
-    transform->InterpolateTransform(t0, prev);
-    transform->InterpolateTransform(t1, curr);
     if (std::abs(t1 - t0) < 0.0001) {
       x[i] = 0.0;
     } else {
-      x[i] = (PositionVectorFromTransform(curr)
-		      - PositionVectorFromTransform(prev)).norm()
-	      / (t1 - t0);
+      x[i] = (poses.Position(i + 1) - poses.Position(i)).norm() / (t1 - t0);
     }
   }
   return Interpolator1D<double>(t, x);
@@ -169,20 +217,13 @@ Interpolator1D<double> compute_dPos(
 Interpolator1D<double> compute_length(
     const vtkSmartPointer<vtkCustomTransformInterpolator>& transform)
 {
-  std::vector<std::vector<double>> transforms = transform->GetTransformList();
-  std::vector<double> t = std::vector<double>(transforms.size());
-  std::vector<double> x = std::vector<double>(transforms.size());
-  vtkSmartPointer<vtkTransform> prev = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> curr = vtkSmartPointer<vtkTransform>::New();
-  t[0] = transforms[0][0];
+  std::vector<double> t = TransformTimes(transform);
+  SampledPoses poses(transform, t);
+  std::vector<double> x = std::vector<double>(t.size());
   x[0] = 0.0;
-  for (unsigned int i = 1; i < transforms.size(); i++)
+  for (unsigned int i = 1; i < t.size(); i++)
   {
-    t[i] = transforms[i][0];
-    transform->InterpolateTransform(t[i-1], prev);
-    transform->InterpolateTransform(t[i], curr);
-    x[i] = x[i - 1] + (PositionVectorFromTransform(curr)
-		    - PositionVectorFromTransform(prev)).norm();
+    x[i] = x[i - 1] + (poses.Position(i) - poses.Position(i - 1)).norm();
   }
 
   return Interpolator1D<double>(t, x);
@@ -197,18 +238,16 @@ Interpolator1D<double> compute_derivated_length(
   double tMin = transform->GetMinimumT() + 0.5 * window_width;
   double tMax = transform->GetMaximumT() - 0.5 * window_width;
   int steps = (tMax - tMin) / transform->GetPeriod() + 1;
-  std::vector<double> derivated_length = std::vector<double>(steps);
-  std::vector<double> times = std::vector<double>(steps);
-  for (int i = 0; i < steps; i++)
+  std::vector<double> times = RegularTimes(tMin, steps, transform->GetPeriod());
+  // length is an interpolator so no need to check that the sample instants
+  // are not the same (they are not, even if the interpolation mode of
+  // this->Reference/Aligned is "NEAREST")
+  std::vector<double> lengthAfter = length.Get(ShiftedTimes(times, 0.5 * window_width));
+  std::vector<double> lengthBefore = length.Get(ShiftedTimes(times, -0.5 * window_width));
+  std::vector<double> derivated_length = std::vector<double>(times.size());
+  for (size_t i = 0; i < times.size(); i++)
   {
-    double time = tMin + i * transform->GetPeriod();
-    times[i] = time;
-    // length is an interpolator so no need to check that the sample instants
-    // are not the same (they are not, even if the interpolation mode of
-    // this->Reference/Aligned is "NEAREST")
-    derivated_length[i] = (length.Get(time + 0.5 * window_width)
-                           - length.Get(time - 0.5 * window_width))
-                    / window_width;
+    derivated_length[i] = (lengthAfter[i] - lengthBefore[i]) / window_width;
   }
 
   return Interpolator1D<double>(times, derivated_length);
@@ -217,19 +256,15 @@ Interpolator1D<double> compute_derivated_length(
 Interpolator1D<double> compute_dRot(
     const vtkSmartPointer<vtkCustomTransformInterpolator>& transform)
 {
-  std::vector<std::vector<double>> transforms = transform->GetTransformList();
-  std::vector<double> t = std::vector<double>(transforms.size() - 1);
-  std::vector<double> x = std::vector<double>(transforms.size() - 1);
-  vtkSmartPointer<vtkTransform> prev = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> curr = vtkSmartPointer<vtkTransform>::New();
-  for (int i = 0; i < static_cast<int>(transforms.size()) - 1; i++)
+  std::vector<double> times = TransformTimes(transform);
+  SampledPoses poses(transform, times);
+  std::vector<double> t = std::vector<double>(times.size() - 1);
+  std::vector<double> x = std::vector<double>(times.size() - 1);
+  for (int i = 0; i < static_cast<int>(times.size()) - 1; i++)
   {
-    double t0 = transforms[i][0];
-    double t1 = transforms[i+1][0];
-    transform->InterpolateTransform(t0, prev);
-    transform->InterpolateTransform(t1, curr);
-    Eigen::AngleAxisd aa = Eigen::AngleAxisd(RotationMatrixFromTransform(curr)
-		    * RotationMatrixFromTransform(prev).transpose());
+    double t0 = times[i];
+    double t1 = times[i+1];
+    Eigen::AngleAxisd aa = Eigen::AngleAxisd(poses.Rotation(i + 1) * poses.Rotation(i).transpose());
     t[i] = 0.5 * (t0 + t1);
     if (std::abs(t1 - t0) < 0.0001) {
       x[i] = 0.0;
@@ -245,25 +280,18 @@ Interpolator1D<double> compute_trajectory_angle(
     const vtkSmartPointer<vtkCustomTransformInterpolator>& transform,
     double window_width)
 {
-  vtkSmartPointer<vtkTransform> prev = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> curr = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> next = vtkSmartPointer<vtkTransform>::New();
   double tMin = transform->GetMinimumT() + 0.5 * window_width;
   double tMax = transform->GetMaximumT() - 0.5 * window_width;
   int steps = (tMax - tMin) / transform->GetPeriod() + 1;
-  std::vector<double> trajectory_angle = std::vector<double>(steps);
-  std::vector<double> times = std::vector<double>(steps);
-  for (int i = 0; i < steps; i++)
+  std::vector<double> times = RegularTimes(tMin, steps, transform->GetPeriod());
+  SampledPoses prev(transform, ShiftedTimes(times, -0.5 * window_width));
+  SampledPoses curr(transform, times);
+  SampledPoses next(transform, ShiftedTimes(times, 0.5 * window_width));
+  std::vector<double> trajectory_angle = std::vector<double>(times.size());
+  for (size_t i = 0; i < times.size(); i++)
   {
-    double time = tMin + i * transform->GetPeriod();
-    transform->InterpolateTransform(time - 0.5 * window_width, prev);
-    transform->InterpolateTransform(time, curr);
-    transform->InterpolateTransform(time + 0.5 * window_width, next);
-    times[i] = time;
-    trajectory_angle[i] = SignedAngle(PositionVectorFromTransform(curr)
-		    - PositionVectorFromTransform(prev),
-		    PositionVectorFromTransform(next)
-		    - PositionVectorFromTransform(curr));
+    trajectory_angle[i] = SignedAngle(curr.Position(i) - prev.Position(i),
+                                      next.Position(i) - curr.Position(i));
   }
 
   return Interpolator1D<double>(times, trajectory_angle);
@@ -273,20 +301,13 @@ Interpolator1D<double> compute_trajectory_angle(
 Interpolator1D<double> compute_orientation_arc(
     const vtkSmartPointer<vtkCustomTransformInterpolator>& transform)
 {
-  std::vector<std::vector<double>> transforms = transform->GetTransformList();
-  std::vector<double> t = std::vector<double>(transforms.size());
-  std::vector<double> x = std::vector<double>(transforms.size());
-  vtkSmartPointer<vtkTransform> prev = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> curr = vtkSmartPointer<vtkTransform>::New();
-  t[0] = transforms[0][0];
+  std::vector<double> t = TransformTimes(transform);
+  SampledPoses poses(transform, t);
+  std::vector<double> x = std::vector<double>(t.size());
   x[0] = 0.0;
-  for (unsigned int i = 1; i < transforms.size(); i++)
+  for (unsigned int i = 1; i < t.size(); i++)
   {
-    t[i] = transforms[i][0];
-    transform->InterpolateTransform(t[i-1], prev);
-    transform->InterpolateTransform(t[i], curr);
-    Eigen::AngleAxisd aa = Eigen::AngleAxisd(RotationMatrixFromTransform(curr)
-		    * RotationMatrixFromTransform(prev).transpose());
+    Eigen::AngleAxisd aa = Eigen::AngleAxisd(poses.Rotation(i) * poses.Rotation(i - 1).transpose());
     x[i] = x[i - 1] + std::abs(aa.angle());
   }
 
@@ -302,19 +323,16 @@ Interpolator1D<double> compute_derivated_orientation_arc(
   double tMin = transform->GetMinimumT() + 0.5 * window_width;
   double tMax = transform->GetMaximumT() - 0.5 * window_width;
   int steps = (tMax - tMin) / transform->GetPeriod() + 1;
-  std::vector<double> derivated_orientation_arc = std::vector<double>(steps);
-  std::vector<double> times = std::vector<double>(steps);
-  for (int i = 0; i < steps; i++)
+  std::vector<double> times = RegularTimes(tMin, steps, transform->GetPeriod());
+  // orientation_arc is an interpolator so no need to check that the sample
+  // instants are not the same (they are not, even if the interpolation mode of
+  // this->Reference/Aligned is "NEAREST")
+  std::vector<double> arcAfter = orientation_arc.Get(ShiftedTimes(times, 0.5 * window_width));
+  std::vector<double> arcBefore = orientation_arc.Get(ShiftedTimes(times, -0.5 * window_width));
+  std::vector<double> derivated_orientation_arc = std::vector<double>(times.size());
+  for (size_t i = 0; i < times.size(); i++)
   {
-    double time = tMin + i * transform->GetPeriod();
-    times[i] = time;
-    // length is an interpolator so no need to check that the sample instants
-    // are not the same (they are not, even if the interpolation mode of
-    // this->Reference/Aligned is "NEAREST")
-    derivated_orientation_arc[i] =
-                    (orientation_arc.Get(time + 0.5 * window_width)
-                     - orientation_arc.Get(time - 0.5 * window_width))
-                    / window_width;
+    derivated_orientation_arc[i] = (arcAfter[i] - arcBefore[i]) / window_width;
   }
 
   return Interpolator1D<double>(times, derivated_orientation_arc);
@@ -326,21 +344,16 @@ Interpolator1D<double> compute_orientation_angle(
     const vtkSmartPointer<vtkCustomTransformInterpolator>& transform,
     double window_width)
 {
-  vtkSmartPointer<vtkTransform> prev = vtkSmartPointer<vtkTransform>::New();
-  vtkSmartPointer<vtkTransform> next = vtkSmartPointer<vtkTransform>::New();
   double tMin = transform->GetMinimumT() + 0.5 * window_width;
   double tMax = transform->GetMaximumT() - 0.5 * window_width;
   int steps = (tMax - tMin) / transform->GetPeriod() + 1;
-  std::vector<double> orientation_angle = std::vector<double>(steps);
-  std::vector<double> times = std::vector<double>(steps);
-  for (int i = 0; i < steps; i++)
+  std::vector<double> times = RegularTimes(tMin, steps, transform->GetPeriod());
+  SampledPoses prev(transform, ShiftedTimes(times, -0.5 * window_width));
+  SampledPoses next(transform, ShiftedTimes(times, 0.5 * window_width));
+  std::vector<double> orientation_angle = std::vector<double>(times.size());
+  for (size_t i = 0; i < times.size(); i++)
   {
-    double time = tMin + i * transform->GetPeriod();
-    transform->InterpolateTransform(time - 0.5 * window_width, prev);
-    transform->InterpolateTransform(time + 0.5 * window_width, next);
-    times[i] = time;
-    Eigen::AngleAxisd angleAxis(RotationMatrixFromTransform(next)
-		    * RotationMatrixFromTransform(prev).transpose());
+    Eigen::AngleAxisd angleAxis(next.Rotation(i) * prev.Rotation(i).transpose());
     orientation_angle[i] = angleAxis.angle();
   }
 
@@ -442,18 +455,15 @@ double ComputeTimeShift(vtkSmartPointer<vtkTemporalTransforms> reference,
   double period = std::min(sig_reference.GetAveragePeriod(),
 		  sig_aligned.GetAveragePeriod());
   int steps = std::floor(tMax / period);
-  std::vector<double> reference_resampled = std::vector<double>(steps);
-  std::vector<double> aligned_resampled = std::vector<double>(steps);
-  for (int i = 0; i < steps; i++)
-  {
-    double time = 0.0 + i * period;
-    reference_resampled[i] = sig_reference.Get(time);
-    aligned_resampled[i] = sig_aligned.Get(time);
-  }
-
-  std::vector<double> test = fftcorrelate(reference_resampled, aligned_resampled);
-
-  int correlation = max_fftcorrelation(reference_resampled, aligned_resampled);
+  std::vector<double> times = RegularTimes(0.0, steps, period);
+  std::vector<double> reference_resampled = sig_reference.Get(times);
+  std::vector<double> aligned_resampled = sig_aligned.Get(times);
+
+  // Search the shift on decimated signals first, so that long trajectories
+  // only require a small FFT, then refine it at full rate
+  const int decimation = std::min(MaximumDecimation,
+                                  std::max(1, steps / CoarseCorrelationLength));
+  int correlation = max_multiresolution_correlation(reference_resampled, aligned_resampled, decimation);
   double correction = correlation * period;
   double delta_t = pre_resample - correction;
   return delta_t;
@@ -549,19 +559,19 @@ double ComputeScale(vtkSmartPointer<vtkTemporalTransforms> reference,
   double period = std::min(sig_reference.GetAveragePeriod(),
 		  sig_aligned.GetAveragePeriod());
   int steps = std::floor((tMax - tMin) / period);
+  std::vector<double> times = RegularTimes(tMin, steps, period);
+  std::vector<double> reference_resampled = sig_reference.Get(times);
+  std::vector<double> aligned_resampled = sig_aligned.Get(times);
   std::vector<double> ratios;
   for (int i = 0; i < steps; i++)
   {
-    double time = tMin + i * period;
-    double reference_resampled = sig_reference.Get(time);
-    double aligned_resampled = sig_aligned.Get(time);
-    if (reference_resampled < div_epsilon)
+    if (reference_resampled[i] < div_epsilon)
     {
       continue;
     }
     else
     {
-      ratios.push_back(aligned_resampled / reference_resampled);
+      ratios.push_back(aligned_resampled[i] / reference_resampled[i]);
     }
   }
 
@@ -19,9 +19,12 @@
 
 // LOCAL
 #include "CameraProjection.h"
+#include "ParallelFor.h"
 #include "vtkEigenTools.h"
 
 // STD
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -190,3 +193,151 @@ Eigen::Vector2d BrownConradyPinholeProjection(const Eigen::Matrix<double, 17, 1>
    Eigen::Vector3d Xpix = K * Xp1dh;
    return Eigen::Vector2d(Xpix(0) / Xpix(2), Xpix(1) / Xpix(2));
 }
+
+namespace
+{
+//! Number of points processed at once by ProjectPoints
+constexpr int ProjectionBlockSize = 1024;
+
+//----------------------------------------------------------------------------
+//! Distortion and intrinsics of the pinhole Brown-Conrady model, applied in place
+//! on the normalized coordinates. Written without branches to be vectorized.
+void BrownConradyDistortion(const Eigen::VectorXd& W, int count, double* x, double* y)
+{
+  const double k1 = W(11), k2 = W(12);
+  const double p1 = W(13), p2 = W(14);
+  const double p3 = W(15), p4 = W(16);
+  const double fx = W(6), fy = W(7), cx = W(8), cy = W(9), skew = W(10);
+  for (int i = 0; i < count; ++i)
+  {
+    const double x2 = x[i] * x[i];
+    const double y2 = y[i] * y[i];
+    const double xy = x[i] * y[i];
+    const double r2 = x2 + y2;
+    const double radial = r2 * (k1 + k2 * r2);
+    const double tangentialScale = 1 + r2 * (p3 + p4 * r2);
+    const double xd = x[i] + x[i] * radial + (p1 * (r2 + 2 * x2) + 2 * p2 * xy) * tangentialScale;
+    const double yd = y[i] + y[i] * radial + (2 * p1 * xy + p2 * (r2 + 2 * y2)) * tangentialScale;
+    x[i] = fx * xd + skew * yd + cx;
+    y[i] = fy * yd + cy;
+  }
+}
+
+//----------------------------------------------------------------------------
+//! Distortion and intrinsics of the fisheye model, applied in place on the
+//! normalized coordinates
+void FisheyeDistortion(const Eigen::VectorXd& W, int count, double* x, double* y)
+{
+  const double k1 = W(11), k2 = W(12), k3 = W(13), k4 = W(14);
+  const double fx = W(6), fy = W(7), cx = W(8), cy = W(9), skew = W(10);
+  for (int i = 0; i < count; ++i)
+  {
+    const double r = std::sqrt(x[i] * x[i] + y[i] * y[i]);
+    const double theta = std::atan(r);
+    const double theta2 = theta * theta;
+    const double thetad = theta * (1 + theta2 * (k1 + theta2 * (k2 + theta2 * (k3 + theta2 * k4))));
+    // thetad / r tends to 1 on the optical axis
+    const double scale = r > 0 ? thetad / r : 1.;
+    const double xd = scale * x[i];
+    const double yd = scale * y[i];
+    x[i] = fx * xd + skew * yd + cx;
+    y[i] = fy * yd + cy;
+  }
+}
+
+//----------------------------------------------------------------------------
+//! Intrinsics only, applied in place on the normalized coordinates
+void PinholeIntrinsics(const Eigen::VectorXd& W, int count, double* x, double* y)
+{
+  const double fx = W(6), fy = W(7), cx = W(8), cy = W(9), skew = W(10);
+  for (int i = 0; i < count; ++i)
+  {
+    const double xd = x[i];
+    x[i] = fx * xd + skew * y[i] + cx;
+    y[i] = fy * y[i] + cy;
+  }
+}
+}
+
+//----------------------------------------------------------------------------
+template <typename T>
+std::vector<int> ProjectPoints(ProjectionType type, const Eigen::VectorXd& W,
+                               const T* points, int nbPoints,
+                               const double imageBounds[4], double* pixels)
+{
+  // Extrinsic parameters, computed once for all points
+  const Eigen::Matrix3d Rt = RollPitchYawToMatrix(W(0), W(1), W(2)).transpose();
+  const Eigen::Vector3d Tr(W(3), W(4), W(5));
+
+  const int nbBlocks = (nbPoints + ProjectionBlockSize - 1) / ProjectionBlockSize;
+  std::vector<std::vector<int>> visibleByBlock(nbBlocks);
+  ParallelFor(0, nbBlocks, [&](int firstBlock, int lastBlock)
+  {
+    // normalized coordinates of the points in front of the camera, and their index
+    std::vector<double> x(ProjectionBlockSize), y(ProjectionBlockSize);
+    std::vector<int> indices(ProjectionBlockSize);
+    for (int block = firstBlock; block < lastBlock; ++block)
+    {
+      const int begin = block * ProjectionBlockSize;
+      const int end = std::min(begin + ProjectionBlockSize, nbPoints);
+
+      // Express the points in the camera reference frame, and cull the
+      // points behind the camera plane before the costly distortion
+      int count = 0;
+      for (int i = begin; i < end; ++i)
+      {
+        const Eigen::Vector3d X(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+        const Eigen::Vector3d Xcam = Rt * (X - Tr);
+        if (Xcam(2) <= 0)
+        {
+          pixels[2 * i] = -1;
+          pixels[2 * i + 1] = -1;
+          continue;
+        }
+        x[count] = Xcam(0) / Xcam(2);
+        y[count] = Xcam(1) / Xcam(2);
+        indices[count] = i;
+        ++count;
+      }
+
+      // Distortion and pixel coordinates
+      if (type == ProjectionType::BrownConradyPinhole)
+      {
+        BrownConradyDistortion(W, count, x.data(), y.data());
+      }
+      else if (type == ProjectionType::FishEye)
+      {
+        FisheyeDistortion(W, count, x.data(), y.data());
+      }
+      else
+      {
+        PinholeIntrinsics(W, count, x.data(), y.data());
+      }
+
+      std::vector<int>& visible = visibleByBlock[block];
+      for (int k = 0; k < count; ++k)
+      {
+        const int i = indices[k];
+        pixels[2 * i] = x[k];
+        pixels[2 * i + 1] = y[k];
+        if (x[k] >= imageBounds[0] && x[k] < imageBounds[1] &&
+            y[k] >= imageBounds[2] && y[k] < imageBounds[3])
+        {
+          visible.push_back(i);
+        }
+      }
+    }
+  });
+
+  std::vector<int> visible;
+  for (const std::vector<int>& blockVisible : visibleByBlock)
+  {
+    visible.insert(visible.end(), blockVisible.begin(), blockVisible.end());
+  }
+  return visible;
+}
+
+template std::vector<int> ProjectPoints<float>(ProjectionType, const Eigen::VectorXd&,
+                                               const float*, int, const double[4], double*);
+template std::vector<int> ProjectPoints<double>(ProjectionType, const Eigen::VectorXd&,
+                                                const double*, int, const double[4], double*);
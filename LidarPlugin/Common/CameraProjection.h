@@ -27,6 +27,9 @@
 // EIGEN
 #include <Eigen/Dense>
 
+// LOCAL
+#include "CameraModel.h"
+
 /**
    * @brief LoadCameraParamsFromCSV Load parameters from a csv file
    *
@@ -72,6 +75,31 @@ Eigen::Vector2d BrownConradyPinholeProjection(const Eigen::Matrix<double, 17, 1>
                                               const Eigen::Vector3d& X,
                                               bool shouldPlaneClip = false);
 
+/**
+   * @brief ProjectPoints Project a batch of 3D points in pixel coordinates.
+   *        This gives the same result as calling FisheyeProjection or
+   *        BrownConradyPinholeProjection with clipping on each point, but the
+   *        rotation and intrinsics are only computed once, the points behind
+   *        the camera are culled before the distortion, and the points are
+   *        processed in parallel.
+   *
+   * @param type camera model, Pinhole ignores the distortion parameters
+   * @param W camera model parameters (15 for the fisheye model, 17 otherwise)
+   * @param points coordinates of the points, x y z contiguous for each point
+   * @param nbPoints number of points
+   * @param imageBounds region of the image in which a projected point is kept:
+   *        [uMin, uMax[ x [vMin, vMax[ in pixel coordinates
+   * @param pixels the pixel coordinates of each point, 2 * nbPoints values.
+   *        (-1, -1) for the points behind the camera, the points out of the
+   *        image bounds keep their pixel coordinates.
+   * @return the indices of the points in front of the camera and inside the
+   *         image bounds, in increasing order
+   */
+template <typename T>
+std::vector<int> ProjectPoints(ProjectionType type, const Eigen::VectorXd& W,
+                               const T* points, int nbPoints,
+                               const double imageBounds[4], double* pixels);
+
 /**
    * @brief GetRGBColourFromReflectivity map the reflectivity signal
    *        onto a RGB color map
@@ -0,0 +1,217 @@
+//=========================================================================
+//
+// Copyright 2019 Kitware, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//=========================================================================
+#include "ParallelDBSCAN.h"
+#include "ParallelFor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+namespace
+{
+//! Number of points whose neighborhoods are stored in the same buffer
+constexpr int BlockSize = 1024;
+
+//-----------------------------------------------------------------------------
+//! Root of the set of a point, with path halving
+int Find(std::vector<std::atomic<int>>& parent, int x)
+{
+  while (true)
+  {
+    int p = parent[x].load();
+    if (p == x)
+    {
+      return x;
+    }
+    int grandParent = parent[p].load();
+    if (grandParent != p)
+    {
+      // another thread may have changed parent[x], in which case it is left untouched
+      parent[x].compare_exchange_weak(p, grandParent);
+    }
+    x = grandParent;
+  }
+}
+
+//-----------------------------------------------------------------------------
+//! Merge the sets of two points. A root is always linked to a root with a
+//! smaller index, so that concurrent unions can not create a cycle.
+void Unite(std::vector<std::atomic<int>>& parent, int a, int b)
+{
+  while (true)
+  {
+    a = Find(parent, a);
+    b = Find(parent, b);
+    if (a == b)
+    {
+      return;
+    }
+    if (a < b)
+    {
+      std::swap(a, b);
+    }
+    int expected = a;
+    if (parent[a].compare_exchange_strong(expected, b))
+    {
+      return;
+    }
+  }
+}
+}
+
+//-----------------------------------------------------------------------------
+ParallelDBSCAN::ParallelDBSCAN() = default;
+
+//-----------------------------------------------------------------------------
+ParallelDBSCAN::~ParallelDBSCAN() = default;
+
+//-----------------------------------------------------------------------------
+void ParallelDBSCAN::SetPoints(std::vector<double> coordinates, int dimension)
+{
+  this->Coordinates = std::move(coordinates);
+  this->Dimension = dimension;
+  this->Index.reset();
+  if (this->GetNumberOfPoints() > 0)
+  {
+    this->Index.reset(new index_t(dimension, *this, nanoflann::KDTreeSingleIndexAdaptorParams(10 /* max leaf */)));
+    this->Index->buildIndex();
+  }
+}
+
+//-----------------------------------------------------------------------------
+int ParallelDBSCAN::GetNumberOfPoints() const
+{
+  return this->Dimension > 0 ? static_cast<int>(this->Coordinates.size() / this->Dimension) : 0;
+}
+
+//-----------------------------------------------------------------------------
+size_t ParallelDBSCAN::kdtree_get_point_count() const
+{
+  return static_cast<size_t>(this->GetNumberOfPoints());
+}
+
+//-----------------------------------------------------------------------------
+std::vector<int> ParallelDBSCAN::Fit(double epsilon, int minPts, unsigned int numberOfThreads)
+{
+  const int nbPoints = this->GetNumberOfPoints();
+  this->NbCluster = 0;
+  if (!this->Index)
+  {
+    return std::vector<int>(nbPoints, LABEL::NOISE);
+  }
+
+  // Neighborhoods of all points. They are stored by blocks of consecutive
+  // points to avoid an allocation per point.
+  const int nbBlocks = (nbPoints + BlockSize - 1) / BlockSize;
+  std::vector<std::vector<int>> blockNeighbors(nbBlocks);
+  std::vector<int> neighborsBegin(nbPoints), neighborsEnd(nbPoints);
+  std::vector<char> isCore(nbPoints);
+  // nanoflann compares squared distances
+  const double squaredRadius = epsilon * epsilon;
+  ParallelFor(0, nbBlocks, [&](int firstBlock, int lastBlock)
+  {
+    std::vector<std::pair<int, double>> matches;
+    nanoflann::SearchParams params;
+    params.sorted = false;
+    for (int block = firstBlock; block < lastBlock; ++block)
+    {
+      std::vector<int>& neighbors = blockNeighbors[block];
+      const int end = std::min((block + 1) * BlockSize, nbPoints);
+      for (int i = block * BlockSize; i < end; ++i)
+      {
+        this->Index->radiusSearch(&this->Coordinates[i * this->Dimension], squaredRadius, matches, params);
+        neighborsBegin[i] = static_cast<int>(neighbors.size());
+        for (const std::pair<int, double>& match : matches)
+        {
+          neighbors.push_back(match.first);
+        }
+        neighborsEnd[i] = static_cast<int>(neighbors.size());
+        isCore[i] = static_cast<int>(matches.size()) >= minPts;
+      }
+    }
+  }, numberOfThreads);
+
+  // Merge the neighboring core points
+  std::vector<std::atomic<int>> parent(nbPoints);
+  for (int i = 0; i < nbPoints; ++i)
+  {
+    parent[i].store(i);
+  }
+  ParallelFor(0, nbBlocks, [&](int firstBlock, int lastBlock)
+  {
+    for (int block = firstBlock; block < lastBlock; ++block)
+    {
+      const std::vector<int>& neighbors = blockNeighbors[block];
+      const int end = std::min((block + 1) * BlockSize, nbPoints);
+      for (int i = block * BlockSize; i < end; ++i)
+      {
+        if (!isCore[i])
+        {
+          continue;
+        }
+        // the neighborhood relation is symmetric, each pair is processed once
+        for (int k = neighborsBegin[i]; k < neighborsEnd[i]; ++k)
+        {
+          int j = neighbors[k];
+          if (j < i && isCore[j])
+          {
+            Unite(parent, i, j);
+          }
+        }
+      }
+    }
+  }, numberOfThreads);
+
+  // Number the clusters in the order of their first core point
+  std::vector<int> label(nbPoints, LABEL::NOISE);
+  std::vector<int> clusterOfRoot(nbPoints, LABEL::NOISE);
+  for (int i = 0; i < nbPoints; ++i)
+  {
+    if (isCore[i])
+    {
+      int& cluster = clusterOfRoot[Find(parent, i)];
+      if (cluster == LABEL::NOISE)
+      {
+        cluster = ++this->NbCluster;
+      }
+      label[i] = cluster;
+    }
+  }
+
+  // Attach the border points to the cluster of one of their core neighbors
+  ParallelFor(0, nbBlocks, [&](int firstBlock, int lastBlock)
+  {
+    for (int block = firstBlock; block < lastBlock; ++block)
+    {
+      const std::vector<int>& neighbors = blockNeighbors[block];
+      const int end = std::min((block + 1) * BlockSize, nbPoints);
+      for (int i = block * BlockSize; i < end; ++i)
+      {
+        for (int k = neighborsBegin[i]; k < neighborsEnd[i] && !isCore[i]; ++k)
+        {
+          if (isCore[neighbors[k]])
+          {
+            label[i] = label[neighbors[k]];
+            break;
+          }
+        }
+      }
+    }
+  }, numberOfThreads);
+
+  return label;
+}
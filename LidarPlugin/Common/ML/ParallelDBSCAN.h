@@ -0,0 +1,100 @@
+//=========================================================================
+//
+// Copyright 2019 Kitware, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//=========================================================================
+#ifndef PARALLEL_DBSCAN_H
+#define PARALLEL_DBSCAN_H
+
+#include <nanoflann.hpp>
+
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Parallel implementation of the Density-Based Spatial Clustering of
+ * Applications with Noise algorithm, see DBSCAN for the serial one.
+ *
+ * The points are stored in a single contiguous buffer and indexed once by a
+ * KD-tree, which is kept between calls to Fit(): changing epsilon or the
+ * minimum number of points does not require to rebuild it.
+ *
+ * The clustering is done in three steps:
+ * - the neighborhoods of all points are computed with concurrent radius queries,
+ *   which gives the core points (at least MinPts neighbors, the point included)
+ * - the core points which are neighbors are merged with a lock-free union-find
+ * - each remaining point is attached to the cluster of one of its core neighbors,
+ *   or labeled as noise
+ *
+ * The cluster ids are numbered in the order of the smallest index of their core
+ * points, which makes the result independent of the number of threads (except
+ * for the border points reachable from several clusters).
+ */
+class ParallelDBSCAN
+{
+public:
+  enum LABEL
+  {
+    NOISE = 0
+  };
+
+  ParallelDBSCAN();
+  ~ParallelDBSCAN();
+
+  /**
+   * @brief SetPoints set the points to cluster and build the KD-tree
+   * @param coordinates coordinates of the points, point i being stored in
+   *        [i * dimension, (i + 1) * dimension[
+   * @param dimension number of coordinates of each point
+   */
+  void SetPoints(std::vector<double> coordinates, int dimension);
+
+  //! Number of points given to SetPoints
+  int GetNumberOfPoints() const;
+
+  /**
+   * @brief Fit run the clustering on the points
+   * @param epsilon radius of the neighborhood of a point
+   * @param minPts minimum number of points in the neighborhood of a core point
+   * @param numberOfThreads 0 means one per hardware core
+   * @return the cluster id of each point, from 1 to GetNbCluster(), or NOISE
+   */
+  std::vector<int> Fit(double epsilon, int minPts, unsigned int numberOfThreads = 0);
+
+  int GetNbCluster() const { return this->NbCluster; }
+
+  //! @{ Interface expected by nanoflann
+  size_t kdtree_get_point_count() const;
+  double kdtree_get_pt(const size_t idx, const size_t dim) const
+  {
+    return this->Coordinates[idx * this->Dimension + dim];
+  }
+  template <class BBOX>
+  bool kdtree_get_bbox(BBOX&) const
+  {
+    return false;
+  }
+  //! @}
+
+private:
+  typedef nanoflann::metric_L2::traits<double, ParallelDBSCAN>::distance_t metric_t;
+  typedef nanoflann::KDTreeSingleIndexAdaptor<metric_t, ParallelDBSCAN, -1, int> index_t;
+
+  std::vector<double> Coordinates;
+  int Dimension = 3;
+  std::unique_ptr<index_t> Index;
+  int NbCluster = 0;
+};
+
+#endif // PARALLEL_DBSCAN_H
@@ -0,0 +1,76 @@
+//=========================================================================
+//
+// Copyright 2019 Kitware, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//=========================================================================
+
+#ifndef PARALLEL_FOR_H
+#define PARALLEL_FOR_H
+
+// BOOST
+#include <boost/thread/thread.hpp>
+
+// STD
+#include <algorithm>
+#include <vector>
+
+/**
+ * @brief ParallelFor split [begin, end[ in contiguous chunks and call
+ *        functor(chunkBegin, chunkEnd) for each of them on its own thread.
+ *        The calling thread processes the first chunk and waits for the others.
+ *        Each index is processed by exactly one call, so the functor only
+ *        needs to be safe for concurrent calls on disjoint ranges.
+ * @param begin first index
+ * @param end past the last index
+ * @param functor callable with the signature void(int chunkBegin, int chunkEnd)
+ * @param numberOfThreads maximum number of threads, 0 means one per hardware core
+ * @param minimumChunkSize do not create chunks smaller than that, small loops
+ *        are then processed on the calling thread only
+ */
+template <typename Functor>
+void ParallelFor(int begin, int end, Functor functor,
+                 unsigned int numberOfThreads = 0, int minimumChunkSize = 1)
+{
+  if (end <= begin)
+  {
+    return;
+  }
+  if (numberOfThreads == 0)
+  {
+    numberOfThreads = std::max(1u, boost::thread::hardware_concurrency());
+  }
+  int numberOfChunks = std::min(static_cast<int>(numberOfThreads),
+                                (end - begin) / std::max(1, minimumChunkSize));
+  if (numberOfChunks <= 1)
+  {
+    functor(begin, end);
+    return;
+  }
+
+  const int chunkSize = (end - begin + numberOfChunks - 1) / numberOfChunks;
+  std::vector<boost::thread> threads;
+  threads.reserve(numberOfChunks - 1);
+  for (int chunkBegin = begin + chunkSize; chunkBegin < end; chunkBegin += chunkSize)
+  {
+    const int chunkEnd = std::min(chunkBegin + chunkSize, end);
+    threads.emplace_back([&functor, chunkBegin, chunkEnd]() { functor(chunkBegin, chunkEnd); });
+  }
+  functor(begin, std::min(begin + chunkSize, end));
+  for (boost::thread& thread : threads)
+  {
+    thread.join();
+  }
+}
+
+#endif // PARALLEL_FOR_H
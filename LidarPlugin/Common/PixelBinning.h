@@ -0,0 +1,103 @@
+//=========================================================================
+//
+// Copyright 2019 Kitware, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//=========================================================================
+
+#ifndef PIXEL_BINNING_H
+#define PIXEL_BINNING_H
+
+// STD
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * @brief PixelBinning groups the values of projected points by pixel, with a
+ *        counting sort: a first pass counts the values of each pixel, a second
+ *        one copies them in a single flat buffer where the values of a pixel are
+ *        contiguous and stay in the order of the points.
+ *        Compared to one std::vector per pixel, this does only two allocations
+ *        whatever the image size, and the pixels can then be reduced in parallel
+ *        since they do not share any memory.
+ */
+class PixelBinning
+{
+public:
+  /**
+   * @brief Build fill the bins
+   * @param numberOfPixels number of pixels of the image
+   * @param pixelOfValue pixel index of each value, values with a negative index are ignored
+   * @param values value to store in the pixel
+   */
+  void Build(size_t numberOfPixels, const std::vector<int>& pixelOfValue,
+             const std::vector<double>& values)
+  {
+    // count the values of each pixel, shifted by one to get the offsets directly
+    this->Offsets.assign(numberOfPixels + 1, 0);
+    for (int pixel : pixelOfValue)
+    {
+      if (pixel >= 0)
+      {
+        this->Offsets[pixel + 1]++;
+      }
+    }
+    for (size_t pixel = 0; pixel < numberOfPixels; ++pixel)
+    {
+      this->Offsets[pixel + 1] += this->Offsets[pixel];
+    }
+
+    // scatter the values
+    this->Values.resize(this->Offsets.back());
+    std::vector<size_t> cursor(this->Offsets.begin(), this->Offsets.end() - 1);
+    for (size_t i = 0; i < pixelOfValue.size(); ++i)
+    {
+      if (pixelOfValue[i] >= 0)
+      {
+        this->Values[cursor[pixelOfValue[i]]++] = values[i];
+      }
+    }
+  }
+
+  size_t GetNumberOfPixels() const { return this->Offsets.empty() ? 0 : this->Offsets.size() - 1; }
+
+  //! Values of a pixel, in the order they have been given to Build()
+  double* Begin(size_t pixel) { return this->Values.data() + this->Offsets[pixel]; }
+  double* End(size_t pixel) { return this->Values.data() + this->Offsets[pixel + 1]; }
+  bool IsEmpty(size_t pixel) const { return this->Offsets[pixel] == this->Offsets[pixel + 1]; }
+
+  /**
+   * @brief Rank return the value which would be at position
+   *        floor((size - 1) * percentile) if the values of the pixel were sorted.
+   *        The values of the pixel are reordered. The pixel must not be empty.
+   */
+  double Rank(size_t pixel, double percentile)
+  {
+    return RankInPlace(this->Begin(pixel), this->End(pixel), percentile);
+  }
+
+  //! Same as Rank() for any range of values
+  static double RankInPlace(double* begin, double* end, double percentile)
+  {
+    const size_t rankIndex = static_cast<size_t>(std::floor((end - begin - 1) * percentile));
+    std::nth_element(begin, begin + rankIndex, end);
+    return begin[rankIndex];
+  }
+
+private:
+  std::vector<double> Values;
+  std::vector<size_t> Offsets;
+};
+
+#endif // PIXEL_BINNING_H
@@ -21,6 +21,7 @@
 #include "RegistrationTools.h"
 #include "vtkEigenTools.h"
 #include "CeresCostFunctions.h"
+#include "SolverConfiguration.h"
 // STD
 #include <iostream>
 // PCL
@@ -131,6 +132,7 @@ Eigen::Matrix4d ICPPointToPlaneRegistration(pcl::PointCloud<pcl::PointXYZ>::Ptr
     options.max_num_iterations = maxLMIteration;
     options.linear_solver_type = ceres::DENSE_QR;
     options.minimizer_progress_to_stdout = false;
+    GetCalibrationSolverConfiguration().Apply(options);
 
     ceres::Solver::Summary summary;
     ceres::Solve(options, &problem, &summary);
@@ -202,6 +204,7 @@ void ComputeSimilitude(const std::vector<Eigen::Vector3d>& X,
   options.max_num_iterations = 250;
   options.linear_solver_type = ceres::DENSE_QR;
   options.minimizer_progress_to_stdout = false;
+  GetCalibrationSolverConfiguration().Apply(options);
 
   ceres::Solver::Summary summary;
   ceres::Solve(options, &problem, &summary);
@@ -0,0 +1,54 @@
+//=========================================================================
+//
+// Copyright 2019 Kitware, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//=========================================================================
+
+#include "SolverConfiguration.h"
+
+// BOOST
+#include <boost/thread/thread.hpp>
+
+// STD
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+unsigned int SolverConfiguration::GetNumberOfThreads() const
+{
+  if (this->NumberOfThreads > 0)
+  {
+    return this->NumberOfThreads;
+  }
+  return std::max(1u, boost::thread::hardware_concurrency());
+}
+
+//-----------------------------------------------------------------------------
+void SolverConfiguration::Apply(ceres::Solver::Options& options, unsigned int numberOfThreads) const
+{
+  options.num_threads = numberOfThreads > 0 ? numberOfThreads : this->GetNumberOfThreads();
+  // the ceres versions before 1.14 factorize with a single thread otherwise
+  options.num_linear_solver_threads = options.num_threads;
+  options.sparse_linear_algebra_library_type = this->SparseBackend;
+  if (this->OverrideLinearSolver)
+  {
+    options.linear_solver_type = this->LinearSolver;
+  }
+}
+
+//-----------------------------------------------------------------------------
+SolverConfiguration& GetCalibrationSolverConfiguration()
+{
+  static SolverConfiguration configuration;
+  return configuration;
+}
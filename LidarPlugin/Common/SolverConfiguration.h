@@ -0,0 +1,69 @@
+//=========================================================================
+//
+// Copyright 2019 Kitware, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//=========================================================================
+
+#ifndef SOLVER_CONFIGURATION_H
+#define SOLVER_CONFIGURATION_H
+
+// CERES
+#include <ceres/ceres.h>
+
+#include "vvConfigure.h"
+
+/**
+ * @brief SolverConfiguration gathers the options of the Ceres solvers which
+ *        depend on the machine rather than on the problem: the number of
+ *        threads and the linear algebra. It is honoured by all the calibration
+ *        modules (geometric, camera, registration and trajectory
+ *        reoptimization), which keep their own iterations count and
+ *        minimizer settings.
+ *
+ * The configuration is global: set it before running the calibrations. It can
+ * be read from several threads, but must not be modified during a solve.
+ */
+struct LidarPlugin_EXPORT SolverConfiguration
+{
+  //! Number of threads used to evaluate the residuals and the jacobians, to
+  //! solve the linear systems, and by the calibrations which solve independent
+  //! problems in parallel.
+  //! 0 means one per hardware core.
+  unsigned int NumberOfThreads = 0;
+
+  //! If true, LinearSolver replaces the linear solver chosen by each module
+  bool OverrideLinearSolver = false;
+  ceres::LinearSolverType LinearSolver = ceres::DENSE_QR;
+
+  //! Library used by the sparse linear solvers (SPARSE_NORMAL_CHOLESKY, SPARSE_SCHUR, ...)
+  ceres::SparseLinearAlgebraLibraryType SparseBackend =
+    ceres::Solver::Options().sparse_linear_algebra_library_type;
+
+  //! NumberOfThreads, with 0 replaced by the number of hardware cores
+  unsigned int GetNumberOfThreads() const;
+
+  /**
+   * @brief Apply set the threads and the linear algebra of solver options
+   * @param options options already filled by the module, its linear solver
+   *        is only replaced if OverrideLinearSolver is true
+   * @param numberOfThreads if not 0, number of threads to use instead of the
+   *        configured one, typically 1 when problems are solved in parallel
+   */
+  void Apply(ceres::Solver::Options& options, unsigned int numberOfThreads = 0) const;
+};
+
+//! Configuration shared by all the calibration modules
+LidarPlugin_EXPORT SolverConfiguration& GetCalibrationSolverConfiguration();
+
+#endif // SOLVER_CONFIGURATION_H
@@ -0,0 +1,194 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "TrajectoryInterpolator.h"
+
+#include "ParallelFor.h"
+
+#include <algorithm>
+
+namespace
+{
+//! Below this number of times, the batch evaluation is not split between threads
+constexpr int MinimumChunkSize = 4096;
+}
+
+//-----------------------------------------------------------------------------
+TrajectoryInterpolator::Location TrajectoryInterpolator::Cursor::Locate(double time)
+{
+  Location location = this->Trajectory.Locate(time, this->Index);
+  this->Index = location.Index;
+  return location;
+}
+
+//-----------------------------------------------------------------------------
+void TrajectoryInterpolator::Cursor::Interpolate(double time, Eigen::Vector3d& position,
+                                                 Eigen::Quaterniond& orientation)
+{
+  this->Trajectory.Interpolate(this->Locate(time), position, orientation);
+}
+
+//-----------------------------------------------------------------------------
+void TrajectoryInterpolator::Clear()
+{
+  this->Times.clear();
+  this->Positions.clear();
+  this->Orientations.clear();
+}
+
+//-----------------------------------------------------------------------------
+void TrajectoryInterpolator::Reserve(size_t numberOfPoses)
+{
+  this->Times.reserve(numberOfPoses);
+  this->Positions.reserve(3 * numberOfPoses);
+  this->Orientations.reserve(4 * numberOfPoses);
+}
+
+//-----------------------------------------------------------------------------
+bool TrajectoryInterpolator::AddPose(double time, const Eigen::Vector3d& position,
+                                     const Eigen::Quaterniond& orientation)
+{
+  if (!this->Times.empty() && time <= this->Times.back())
+  {
+    return false;
+  }
+  this->Times.push_back(time);
+  this->Positions.insert(this->Positions.end(), position.data(), position.data() + 3);
+  const Eigen::Quaterniond q = orientation.normalized();
+  this->Orientations.insert(this->Orientations.end(), q.coeffs().data(), q.coeffs().data() + 4);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+TrajectoryInterpolator::Location TrajectoryInterpolator::Locate(double time) const
+{
+  Location location;
+  const size_t n = this->Times.size();
+  if (n < 2)
+  {
+    return location;
+  }
+  time = std::min(std::max(time, this->Times.front()), this->Times.back());
+
+  // first pose after the time, among the inner ones, so that the segment
+  // always has a pose after it
+  auto next = std::upper_bound(this->Times.begin() + 1, this->Times.end() - 1, time);
+  location.Index = static_cast<size_t>(next - this->Times.begin()) - 1;
+  const double t0 = this->Times[location.Index];
+  const double t1 = this->Times[location.Index + 1];
+  location.Alpha = (time - t0) / (t1 - t0);
+  return location;
+}
+
+//-----------------------------------------------------------------------------
+TrajectoryInterpolator::Location TrajectoryInterpolator::Locate(double time, size_t hint) const
+{
+  const size_t n = this->Times.size();
+  if (n < 2)
+  {
+    return Location();
+  }
+  time = std::min(std::max(time, this->Times.front()), this->Times.back());
+
+  // The hint segment, or the next one, are the usual cases with increasing queries
+  if (hint + 1 < n && this->Times[hint] <= time)
+  {
+    size_t index = hint;
+    if (time > this->Times[index + 1] && index + 2 < n && time <= this->Times[index + 2])
+    {
+      ++index;
+    }
+    if (time <= this->Times[index + 1])
+    {
+      Location location;
+      location.Index = index;
+      location.Alpha = (time - this->Times[index]) / (this->Times[index + 1] - this->Times[index]);
+      return location;
+    }
+  }
+  return this->Locate(time);
+}
+
+//-----------------------------------------------------------------------------
+void TrajectoryInterpolator::Interpolate(const Location& location, Eigen::Vector3d& position,
+                                         Eigen::Quaterniond& orientation) const
+{
+  if (this->Times.empty())
+  {
+    position.setZero();
+    orientation.setIdentity();
+    return;
+  }
+  const size_t i0 = location.Index;
+  const size_t i1 = std::min(i0 + 1, this->Times.size() - 1);
+  const double alpha = location.Alpha;
+
+  Eigen::Map<const Eigen::Vector3d> p0(&this->Positions[3 * i0]);
+  Eigen::Map<const Eigen::Vector3d> p1(&this->Positions[3 * i1]);
+  position = (1. - alpha) * p0 + alpha * p1;
+
+  Eigen::Map<const Eigen::Quaterniond> q0(&this->Orientations[4 * i0]);
+  Eigen::Map<const Eigen::Quaterniond> q1(&this->Orientations[4 * i1]);
+  orientation = q0.slerp(alpha, q1);
+}
+
+//-----------------------------------------------------------------------------
+void TrajectoryInterpolator::Interpolate(double time, Eigen::Vector3d& position,
+                                         Eigen::Quaterniond& orientation) const
+{
+  this->Interpolate(this->Locate(time), position, orientation);
+}
+
+//-----------------------------------------------------------------------------
+template <typename Output>
+void TrajectoryInterpolator::InterpolateBatch(const double* times, size_t n, Output output,
+                                              unsigned int numberOfThreads) const
+{
+  ParallelFor(0, static_cast<int>(n), [&](int begin, int end)
+  {
+    Cursor cursor(*this);
+    Eigen::Vector3d position;
+    Eigen::Quaterniond orientation;
+    for (int k = begin; k < end; ++k)
+    {
+      cursor.Interpolate(times[k], position, orientation);
+      output(k, position, orientation);
+    }
+  }, numberOfThreads, MinimumChunkSize);
+}
+
+//-----------------------------------------------------------------------------
+void TrajectoryInterpolator::Interpolate(const double* times, size_t n, double* positions,
+                                         double* orientations, unsigned int numberOfThreads) const
+{
+  this->InterpolateBatch(times, n,
+    [positions, orientations](int k, const Eigen::Vector3d& position, const Eigen::Quaterniond& orientation)
+    {
+      std::copy(position.data(), position.data() + 3, positions + 3 * k);
+      std::copy(orientation.coeffs().data(), orientation.coeffs().data() + 4, orientations + 4 * k);
+    }, numberOfThreads);
+}
+
+//-----------------------------------------------------------------------------
+void TrajectoryInterpolator::InterpolateRotations(const double* times, size_t n, double* positions,
+                                                  double* rotations, unsigned int numberOfThreads) const
+{
+  this->InterpolateBatch(times, n,
+    [positions, rotations](int k, const Eigen::Vector3d& position, const Eigen::Quaterniond& orientation)
+    {
+      std::copy(position.data(), position.data() + 3, positions + 3 * k);
+      Eigen::Map<Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> rotation(rotations + 9 * k);
+      rotation = orientation.toRotationMatrix();
+    }, numberOfThreads);
+}
@@ -0,0 +1,121 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef TRAJECTORY_INTERPOLATOR_H
+#define TRAJECTORY_INTERPOLATOR_H
+
+// EIGEN
+#include <Eigen/Geometry>
+
+// STD
+#include <cstddef>
+#include <vector>
+
+/**
+ * @brief Linear interpolation of a trajectory: the positions are interpolated
+ *        linearly and the orientations with SLERP, as done by
+ *        vtkCustomTransformInterpolator with the linear interpolation type.
+ *
+ * The poses are stored in contiguous arrays: the times, the positions (x, y, z)
+ * and the orientations as quaternions (x, y, z, w, the order of Eigen). The
+ * segment containing a time is found with a single binary search, shared by
+ * the position and the orientation. For monotonic queries, a Cursor starts
+ * from the segment of the previous query, and the batch evaluation uses one
+ * cursor per thread. The times outside of the trajectory are clamped.
+ *
+ * Once filled, the interpolator is read only and can be used from several
+ * threads at once, each one with its own cursors.
+ */
+class TrajectoryInterpolator
+{
+public:
+  //! A time between the poses Index and Index + 1, at Alpha in [0, 1] of the segment
+  struct Location
+  {
+    size_t Index = 0;
+    double Alpha = 0.;
+  };
+
+  //! Keeps the segment of the last query, which makes increasing queries O(1)
+  class Cursor
+  {
+  public:
+    explicit Cursor(const TrajectoryInterpolator& trajectory) : Trajectory(trajectory) {}
+
+    Location Locate(double time);
+    void Interpolate(double time, Eigen::Vector3d& position, Eigen::Quaterniond& orientation);
+
+  private:
+    const TrajectoryInterpolator& Trajectory;
+    size_t Index = 0;
+  };
+
+  void Clear();
+  void Reserve(size_t numberOfPoses);
+
+  /**
+   * @brief Append a pose, the times must be strictly increasing
+   * @return false if the pose has not been added because its time is not
+   *         greater than the one of the last pose
+   */
+  bool AddPose(double time, const Eigen::Vector3d& position, const Eigen::Quaterniond& orientation);
+
+  size_t GetNumberOfPoses() const { return this->Times.size(); }
+  bool IsEmpty() const { return this->Times.empty(); }
+  double GetMinimumTime() const { return this->Times.front(); }
+  double GetMaximumTime() const { return this->Times.back(); }
+
+  const std::vector<double>& GetTimes() const { return this->Times; }
+  const std::vector<double>& GetPositions() const { return this->Positions; }
+  const std::vector<double>& GetOrientations() const { return this->Orientations; }
+
+  //! Find the segment containing a time with a binary search
+  Location Locate(double time) const;
+
+  /**
+   * @brief Find the segment containing a time, the segment hint and the next
+   *        one being checked before falling back to the binary search
+   */
+  Location Locate(double time, size_t hint) const;
+
+  void Interpolate(const Location& location, Eigen::Vector3d& position,
+                   Eigen::Quaterniond& orientation) const;
+  void Interpolate(double time, Eigen::Vector3d& position, Eigen::Quaterniond& orientation) const;
+
+  /**
+   * @brief Interpolate the trajectory at an array of times. The times are
+   *        split in contiguous chunks evaluated in parallel, each with its
+   *        own cursor, so increasing times are the fastest.
+   * @param times the n times to evaluate
+   * @param positions [out] 3 * n values
+   * @param orientations [out] 4 * n values, quaternions as (x, y, z, w)
+   * @param numberOfThreads 0 means one per hardware core
+   */
+  void Interpolate(const double* times, size_t n, double* positions, double* orientations,
+                   unsigned int numberOfThreads = 1) const;
+
+  //! Same as above, with the orientations given as 3x3 row major rotation matrices (9 * n values)
+  void InterpolateRotations(const double* times, size_t n, double* positions, double* rotations,
+                            unsigned int numberOfThreads = 1) const;
+
+private:
+  template <typename Output>
+  void InterpolateBatch(const double* times, size_t n, Output output, unsigned int numberOfThreads) const;
+
+  std::vector<double> Times;
+  std::vector<double> Positions;
+  std::vector<double> Orientations;
+};
+
+#endif // TRAJECTORY_INTERPOLATOR_H
@@ -16,7 +16,10 @@
 //=========================================================================
 
 #include <unsupported/Eigen/FFT>
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <vector>
 
 // This function was desgined to have the same output as
 // scipy.signal.fftconvolve
@@ -97,3 +100,93 @@ int max_fftcorrelation(const std::vector<T>& a,
       - b.size() + 1;
 }
 
+
+// Correlation of a and b at a single shift, with the convention of
+// max_fftcorrelation: sum of a[i] * b[i - shift]
+template<typename T>
+T correlation_at_shift(const std::vector<T>& a,
+                       const std::vector<T>& b,
+                       int shift)
+{
+  int begin = std::max(0, shift);
+  int end = std::min(static_cast<int>(a.size()), static_cast<int>(b.size()) + shift);
+  T sum = 0.0;
+  for (int i = begin; i < end; i++)
+  {
+    sum += a[i] * b[i - shift];
+  }
+  return sum;
+}
+
+
+// Compute the shift between a and b like max_fftcorrelation, with a coarse
+// to fine search: the signals are decimated by averaging blocks of
+// "decimation" samples and correlated with an FFT, then the correlation is
+// evaluated at full rate around the best coarse shifts only.
+template<typename T>
+int max_multiresolution_correlation(const std::vector<T>& a,
+                                    const std::vector<T>& b,
+                                    int decimation,
+                                    int nbCandidates = 3)
+{
+  if (decimation <= 1)
+  {
+    return max_fftcorrelation(a, b);
+  }
+
+  auto decimate = [decimation](const std::vector<T>& x)
+  {
+    std::vector<T> decimated((x.size() + decimation - 1) / decimation, 0.0);
+    for (unsigned int i = 0; i < x.size(); i++)
+    {
+      decimated[i / decimation] += x[i] / decimation;
+    }
+    return decimated;
+  };
+  std::vector<T> a_coarse = decimate(a);
+  std::vector<T> b_coarse = decimate(b);
+  std::vector<T> corr = fftcorrelate(a_coarse, b_coarse);
+
+  // best coarse shifts, which are not neighbors of a better one
+  std::vector<int> order(corr.size());
+  for (unsigned int i = 0; i < corr.size(); i++)
+  {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), [&corr](int i, int j) { return corr[i] > corr[j]; });
+  std::vector<int> candidates;
+  for (unsigned int k = 0; k < order.size() && static_cast<int>(candidates.size()) < nbCandidates; k++)
+  {
+    bool isNeighbor = false;
+    for (int candidate : candidates)
+    {
+      isNeighbor |= std::abs(candidate - order[k]) <= 1;
+    }
+    if (!isNeighbor)
+    {
+      candidates.push_back(order[k]);
+    }
+  }
+
+  // refine at full rate, the first best shift is kept like with max_element
+  int best_shift = 0;
+  T best_corr = -std::numeric_limits<T>::infinity();
+  const int min_shift = 1 - static_cast<int>(b.size());
+  const int max_shift = static_cast<int>(a.size()) - 1;
+  for (int candidate : candidates)
+  {
+    int coarse_shift = (candidate - static_cast<int>(b_coarse.size()) + 1) * decimation;
+    int begin = std::max(min_shift, coarse_shift - 2 * decimation);
+    int end = std::min(max_shift, coarse_shift + 2 * decimation);
+    for (int shift = begin; shift <= end; shift++)
+    {
+      T value = correlation_at_shift(a, b, shift);
+      if (value > best_corr || (value == best_corr && shift < best_shift))
+      {
+        best_corr = value;
+        best_shift = shift;
+      }
+    }
+  }
+  return best_shift;
+}
@@ -53,6 +53,32 @@ public:
     return alpha * this->x[inf] + (1.0 - alpha) * this->x[sup];
   }
 
+  // Same as Get for each time, the times must be increasing so that the
+  // samples are walked through only once
+  std::vector<T> Get(const std::vector<T>& times)
+  {
+    std::vector<T> values(times.size(), 0.0);
+    size_t sup = 1;
+    for (size_t i = 0; i < times.size(); i++)
+    {
+      // the signal is clamped to 0.0 outside its support
+      T time = times[i];
+      if (time < this->t[0] || time > this->t[this->t.size() - 1])
+      {
+        continue;
+      }
+
+      while (sup < this->t.size() - 1 && this->t[sup] < time)
+      {
+        sup++;
+      }
+      size_t inf = sup - 1;
+      T alpha = (this->t[sup] - time) / (this->t[sup] - this->t[inf]);
+      values[i] = alpha * this->x[inf] + (1.0 - alpha) * this->x[sup];
+    }
+    return values;
+  }
+
   void ApplyTimeShift(T shift)
   {
     for (unsigned int i = 0; i < this->t.size(); i++)
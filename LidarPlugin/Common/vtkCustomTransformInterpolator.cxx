@@ -13,8 +13,10 @@
 
 =========================================================================*/
 #include "vtkCustomTransformInterpolator.h"
+#include "TrajectoryInterpolator.h"
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
+#include "vtkNew.h"
 #include "vtkObjectFactory.h"
 #include "vtkProp3D.h"
 #include "vtkPatch/vtkCustomQuaternion.h"
@@ -128,6 +130,7 @@ vtkCustomTransformInterpolator::vtkCustomTransformInterpolator()
 
   // Quaternion interpolation
   this->TransformList = new vtkTransformList;
+  this->LinearTrajectory = new TrajectoryInterpolator;
   this->Initialized = 0;
 }
 
@@ -135,6 +138,7 @@ vtkCustomTransformInterpolator::vtkCustomTransformInterpolator()
 vtkCustomTransformInterpolator::~vtkCustomTransformInterpolator()
 {
   delete this->TransformList;
+  delete this->LinearTrajectory;
 
   if (this->PositionInterpolator)
   {
@@ -465,6 +469,15 @@ void vtkCustomTransformInterpolator::InitializeInterpolation()
     this->PositionInterpolator->FillFromData(nb, time, Position);
     this->ScaleInterpolator->FillFromData(nb, time, Scale);
 
+    // The list is sorted by strictly increasing times
+    this->LinearTrajectory->Clear();
+    this->LinearTrajectory->Reserve(nb);
+    for (iter = this->TransformList->begin(); iter != this->TransformList->end(); ++iter)
+    {
+      Eigen::Quaterniond q(iter->Q.GetW(), iter->Q.GetX(), iter->Q.GetY(), iter->Q.GetZ());
+      this->LinearTrajectory->AddPose(iter->Time, Eigen::Vector3d(iter->P), q);
+    }
+
     for (int k = 0; k < 3; ++k)
     {
       delete [] Position[k];
@@ -498,6 +511,32 @@ void vtkCustomTransformInterpolator::InterpolateTransform(double t, vtkTransform
   xform->Identity();
   this->InitializeInterpolation();
 
+  // The position, orientation and scale share the same segment
+  if (this->InterpolationType == INTERPOLATION_TYPE_LINEAR)
+  {
+    TrajectoryInterpolator::Location location = this->LinearTrajectory->Locate(t);
+    Eigen::Vector3d P;
+    Eigen::Quaterniond Q;
+    this->LinearTrajectory->Interpolate(location, P, Q);
+    const vtkQTransform& T0 = this->TransformVector[location.Index];
+    const vtkQTransform& T1 = this->TransformVector[std::min(location.Index + 1, this->TransformVector.size() - 1)];
+
+    // same matrix as Translate(P), then RotateWXYZ and Scale(S)
+    Eigen::Matrix3d R = Q.toRotationMatrix();
+    double M[16] = { 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 0., 1. };
+    for (int j = 0; j < 3; ++j)
+    {
+      const double S = (1. - location.Alpha) * T0.S[j] + location.Alpha * T1.S[j];
+      for (int i = 0; i < 3; ++i)
+      {
+        M[4 * i + j] = R(i, j) * S;
+      }
+      M[4 * j + 3] = P(j);
+    }
+    xform->SetMatrix(M);
+    return;
+  }
+
   // Evaluate the interpolators
   if (t < this->TransformList->front().Time)
   {
@@ -521,6 +560,53 @@ void vtkCustomTransformInterpolator::InterpolateTransform(double t, vtkTransform
   xform->Scale(S);
 }
 
+//----------------------------------------------------------------------------
+void vtkCustomTransformInterpolator::InterpolateTransforms(const std::vector<double>& t,
+                                                           std::vector<double>& positions,
+                                                           std::vector<double>& rotations)
+{
+  positions.resize(3 * t.size());
+  rotations.resize(9 * t.size());
+  if (this->TransformList->empty())
+  {
+    return;
+  }
+
+  this->InitializeInterpolation();
+
+  // The single pass is only possible with the linear interpolation, which is
+  // the only one filling TransformVector
+  if (this->InterpolationType != INTERPOLATION_TYPE_LINEAR || this->TransformVector.size() < 2)
+  {
+    vtkNew<vtkTransform> xform;
+    vtkNew<vtkMatrix4x4> M;
+    for (size_t k = 0; k < t.size(); ++k)
+    {
+      this->InterpolateTransform(t[k], xform.GetPointer());
+      xform->GetMatrix(M.GetPointer());
+      for (int i = 0; i < 3; ++i)
+      {
+        positions[3 * k + i] = M->Element[i][3];
+        for (int j = 0; j < 3; ++j)
+        {
+          rotations[9 * k + 3 * i + j] = M->Element[i][j];
+        }
+      }
+    }
+    return;
+  }
+
+  // the cursor keeps the segment from one time to the next, as the times are increasing
+  this->LinearTrajectory->InterpolateRotations(t.data(), t.size(), positions.data(), rotations.data());
+}
+
+//----------------------------------------------------------------------------
+const TrajectoryInterpolator& vtkCustomTransformInterpolator::GetTrajectoryInterpolator()
+{
+  this->InitializeInterpolation();
+  return *this->LinearTrajectory;
+}
+
 //----------------------------------------------------------------------------
 void vtkCustomTransformInterpolator::InterpolateTransformNearest(double t,
                                                     vtkTransform *xform)
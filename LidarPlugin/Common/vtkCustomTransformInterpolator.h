@@ -57,6 +57,7 @@ class vtkCustomTupleInterpolator;
 class vtkCustomQuaternionInterpolator;
 class vtkTransformList;
 struct vtkQTransform;
+class TrajectoryInterpolator;
 
 class VTK_EXPORT vtkCustomTransformInterpolator : public vtkObject
 {
@@ -110,6 +111,25 @@ public:
   // (min,max) values, then t is clamped.
   void InterpolateTransform(double t, vtkTransform* xform);
 
+  // Description:
+  // Interpolate the list of transforms at increasing times t, with a single
+  // pass over the list instead of a search per time. For each time, fill 3
+  // values in positions and a 3x3 row major rotation matrix in rotations.
+  // Like InterpolateTransform, the times outside of the (min,max) range
+  // are clamped. The scale is ignored.
+  void InterpolateTransforms(const std::vector<double>& t,
+                             std::vector<double>& positions,
+                             std::vector<double>& rotations);
+
+#ifndef __VTK_WRAP__
+  // Description:
+  // Return the transforms as a compact linear interpolator, which finds the
+  // segment of a time once for both the position and the orientation and
+  // provides cursors for monotonic queries. It is used for the linear
+  // interpolation type, and is valid until the list of transforms is modified.
+  const TrajectoryInterpolator& GetTrajectoryInterpolator();
+#endif
+
   // Description:
   // Return the transform list
   std::vector<std::vector<double> > GetTransformList();
@@ -194,6 +214,9 @@ protected:
   vtkTransformList* TransformList;
   std::vector<vtkQTransform> TransformVector;
 
+  // Same transforms, without the scale, in contiguous arrays
+  TrajectoryInterpolator* LinearTrajectory;
+
 private:
   vtkCustomTransformInterpolator(const vtkCustomTransformInterpolator&); // Not implemented.
   void operator=(const vtkCustomTransformInterpolator&);                   // Not implemented.
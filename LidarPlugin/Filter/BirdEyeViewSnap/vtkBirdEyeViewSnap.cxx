@@ -16,6 +16,8 @@
 
 // LOCAL
 #include "vtkBirdEyeViewSnap.h"
+#include "ParallelFor.h"
+#include "PixelBinning.h"
 
 // STD
 #include <iostream>
@@ -102,7 +104,9 @@ int vtkBirdEyeViewSnap::RequestData(vtkInformation *vtkNotUsed(request),
     return 0;
   }
 
-  // transform the input
+  // transform the input, in new points to leave the input untouched
+  auto transformedPoints = vtkSmartPointer<vtkPoints>::New();
+  transformedPoints->SetNumberOfPoints(input->GetNumberOfPoints());
   Eigen::Matrix<double, 3, 1> point;
   double vtkpoint[3];
   for (unsigned int k = 0; k < input->GetNumberOfPoints(); ++k)
@@ -113,8 +117,9 @@ int vtkBirdEyeViewSnap::RequestData(vtkInformation *vtkNotUsed(request),
     vtkpoint[0] = point(0);
     vtkpoint[1] = point(1);
     vtkpoint[2] = point(2);
-    output->GetPoints()->SetPoint(k, vtkpoint);
+    transformedPoints->SetPoint(k, vtkpoint);
   }
+  output->SetPoints(transformedPoints);
 
   // Create the bird eye view image
   double bounds[6];
@@ -129,22 +134,34 @@ int vtkBirdEyeViewSnap::RequestData(vtkInformation *vtkNotUsed(request),
   image->SetDimensions(H, W, 1);
   image->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
   unsigned char* dataPointer = static_cast<unsigned char*>(image->GetScalarPointer());
-  std::fill(dataPointer, dataPointer + H * W, 0);
 
   // Get the reflectivity array
   vtkDataArray* intensity = output->GetPointData()->GetArray("intensity");
 
+  // Group the points by pixel
+  std::vector<int> pixelOfPoint(output->GetNumberOfPoints());
+  std::vector<double> valueOfPoint(output->GetNumberOfPoints());
   for (unsigned int k = 0; k < output->GetNumberOfPoints(); ++k)
   {
     // Compute pixel coordinate
     output->GetPoint(k, vtkpoint);
     x = std::floor((vtkpoint[0] - bounds[0]) / (bounds[1] - bounds[0]) * (H - 1));
     y = std::floor((vtkpoint[1] - bounds[2]) / (bounds[3] - bounds[2]) * (W - 1));
-
-    // set value
-    unsigned char value = intensity->GetVariantValue(k).ToUnsignedChar();
-    image->SetScalarComponentFromDouble(x, y, 0, 0, value);
+    pixelOfPoint[k] = x + H * y;
+    valueOfPoint[k] = intensity->GetVariantValue(k).ToUnsignedChar();
   }
+  PixelBinning pixels;
+  pixels.Build(H * W, pixelOfPoint, valueOfPoint);
+
+  // set value, the last point projected in a pixel gives its value
+  ParallelFor(0, static_cast<int>(W), [&](int firstRow, int lastRow)
+  {
+    for (unsigned int pixel = firstRow * H; pixel < lastRow * H; ++pixel)
+    {
+      dataPointer[pixel] = pixels.IsEmpty(pixel) ? 0 :
+        static_cast<unsigned char>(*(pixels.End(pixel) - 1));
+    }
+  });
 
   // Save the image
   std::stringstream ss;
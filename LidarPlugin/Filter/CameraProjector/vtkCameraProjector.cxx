@@ -25,6 +25,7 @@
 // VTK
 #include <vtkImageData.h>
 #include <vtkDataArray.h>
+#include <vtkIdList.h>
 #include <vtkIntArray.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
@@ -122,47 +123,63 @@ int vtkCameraProjector::RequestData(vtkInformation *vtkNotUsed(request),
   }
 
   Eigen::VectorXd W = this->Model.GetParametersVector();
-
-  // Project the points in the image
-  for (int pointIndex = 0; pointIndex < outCloud->GetNumberOfPoints(); ++pointIndex)
+  const int width = inImg->GetDimensions()[0];
+  const int height = inImg->GetDimensions()[1];
+
+  // Project all the points at once, directly from the points buffer when possible
+  ProjectionType type = (this->Type == ProjectionType::BrownConradyPinhole) ?
+                          ProjectionType::BrownConradyPinhole : ProjectionType::FishEye;
+  const double imageBounds[4] = {0., static_cast<double>(width), 0., static_cast<double>(height)};
+  const int nbPoints = outCloud->GetNumberOfPoints();
+  std::vector<double> pixels(2 * nbPoints);
+  std::vector<int> visible;
+  vtkDataArray* positions = outCloud->GetPoints()->GetData();
+  if (positions->GetDataType() == VTK_FLOAT)
   {
-    double* pos = outCloud->GetPoint(pointIndex);
-    Eigen::Vector3d X(pos[0], pos[1], pos[2]);
-    Eigen::Vector2d y;
-
-    if (this->Type == ProjectionType::BrownConradyPinhole)
-    {
-      y = BrownConradyPinholeProjection(W, X, true);
-    }
-    else
-    {
-      y = FisheyeProjection(W, X, true);
-    }
-
-    // y represents the pixel coordinates using opencv convention, we need to
-    // go back to vtkImageData pixel convention
-    int vtkRaw = y(1);
-    int vtkCol = y(0);
-
-    if ((vtkRaw < 0) || (vtkRaw >= inImg->GetDimensions()[1]) ||
-        (vtkCol < 0) || (vtkCol >= inImg->GetDimensions()[0]))
+    const float* xyz = static_cast<float*>(positions->GetVoidPointer(0));
+    visible = ProjectPoints(type, W, xyz, nbPoints, imageBounds, pixels.data());
+  }
+  else if (positions->GetDataType() == VTK_DOUBLE)
+  {
+    const double* xyz = static_cast<double*>(positions->GetVoidPointer(0));
+    visible = ProjectPoints(type, W, xyz, nbPoints, imageBounds, pixels.data());
+  }
+  else
+  {
+    std::vector<double> xyz(3 * nbPoints);
+    for (int pointIndex = 0; pointIndex < nbPoints; ++pointIndex)
     {
-      continue;
+      outCloud->GetPoint(pointIndex, &xyz[3 * pointIndex]);
     }
+    visible = ProjectPoints(type, W, xyz.data(), nbPoints, imageBounds, pixels.data());
+  }
 
-    vtkRaw = std::min(std::max(0, vtkRaw), inImg->GetDimensions()[1] - 1);
-    vtkCol = std::min(std::max(0, vtkCol), inImg->GetDimensions()[0] - 1);
+  // register the points which are in the image
+  const vtkIdType nbVisible = static_cast<vtkIdType>(visible.size());
+  vtkNew<vtkIdList> visibleIds;
+  visibleIds->SetNumberOfIds(nbVisible);
+  vtkPoints* projectedPoints = projectedCloud->GetPoints();
+  projectedPoints->SetNumberOfPoints(nbVisible);
+  for (vtkIdType k = 0; k < nbVisible; ++k)
+  {
+    visibleIds->SetId(k, visible[k]);
+    // the pixel coordinates use the opencv convention
+    projectedPoints->SetPoint(k, pixels[2 * visible[k]], pixels[2 * visible[k] + 1], 0);
+  }
+  for (int i = 0; i < projectedCloud->GetPointData()->GetNumberOfArrays(); ++i)
+  {
+    vtkAbstractArray* projectedArray = projectedCloud->GetPointData()->GetAbstractArray(i);
+    projectedArray->SetNumberOfTuples(nbVisible);
+    pointcloud->GetPointData()->GetAbstractArray(i)->GetTuples(visibleIds, projectedArray);
+  }
 
-    // register the point if it is valid
-    double pt[3] = {y(0), y(1), 0};
-    projectedCloud->GetPoints()->InsertNextPoint(pt);
-    for (int i = 0; i < projectedCloud->GetPointData()->GetNumberOfArrays(); ++i)
-    {
-      projectedCloud->GetPointData()->GetArray(i)->InsertNextTuple(
-            pointcloud->GetPointData()->GetArray(i)->GetTuple(pointIndex));
-    }
+  // Color the image with the points, and the points with the image
+  for (int pointIndex : visible)
+  {
+    // go back to vtkImageData pixel convention
+    int vtkRaw = std::min(static_cast<int>(pixels[2 * pointIndex + 1]), height - 1);
+    int vtkCol = std::min(static_cast<int>(pixels[2 * pointIndex]), width - 1);
 
-    // Get its color
     double intensityValue = intensity->GetTuple1(pointIndex);
     Eigen::Vector3d color = GetRGBColourFromReflectivity(intensityValue, 0, 255);
 
@@ -0,0 +1,92 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vtkDBSCANClustering.h"
+#include "ParallelDBSCAN.h"
+
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkIntArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <algorithm>
+
+//-----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkDBSCANClustering)
+
+//-----------------------------------------------------------------------------
+vtkDBSCANClustering::vtkDBSCANClustering()
+  : Clustering(new ParallelDBSCAN)
+{
+  this->SetNumberOfInputPorts(1);
+  this->SetNumberOfOutputPorts(1);
+}
+
+//-----------------------------------------------------------------------------
+vtkDBSCANClustering::~vtkDBSCANClustering() = default;
+
+//-----------------------------------------------------------------------------
+void vtkDBSCANClustering::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Epsilon: " << this->Epsilon << std::endl;
+  os << indent << "MinPts: " << this->MinPts << std::endl;
+  os << indent << "ReuseKDTree: " << this->ReuseKDTree << std::endl;
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << std::endl;
+  os << indent << "NumberOfClusters: " << this->NumberOfClusters << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+int vtkDBSCANClustering::RequestData(vtkInformation* vtkNotUsed(request),
+                                     vtkInformationVector** inputVector,
+                                     vtkInformationVector* outputVector)
+{
+  vtkPolyData* input = vtkPolyData::GetData(inputVector[0], 0);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector, 0);
+  output->ShallowCopy(input);
+
+  vtkPoints* points = input->GetPoints();
+  const vtkIdType nbPoints = input->GetNumberOfPoints();
+
+  // The tree only depends on the points: a new vtkPoints object, or any
+  // modification of the current one, gives a new modification time
+  const vtkMTimeType pointsTime = points ? points->GetMTime() : 0;
+  if (!this->ReuseKDTree || pointsTime != this->IndexedPointsTime ||
+      this->Clustering->GetNumberOfPoints() != nbPoints)
+  {
+    std::vector<double> coordinates(3 * nbPoints);
+    for (vtkIdType i = 0; i < nbPoints; ++i)
+    {
+      points->GetPoint(i, &coordinates[3 * i]);
+    }
+    this->Clustering->SetPoints(std::move(coordinates), 3);
+    this->IndexedPointsTime = pointsTime;
+    vtkDebugMacro("KD-tree built on " << nbPoints << " points");
+  }
+
+  std::vector<int> labels = this->Clustering->Fit(this->Epsilon, this->MinPts, this->NumberOfThreads);
+  this->NumberOfClusters = this->Clustering->GetNbCluster();
+
+  auto clusterId = vtkSmartPointer<vtkIntArray>::New();
+  clusterId->SetName("cluster_id");
+  clusterId->SetNumberOfTuples(nbPoints);
+  std::copy(labels.begin(), labels.end(), clusterId->GetPointer(0));
+  output->GetPointData()->AddArray(clusterId);
+
+  return 1;
+}
@@ -0,0 +1,84 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VTKDBSCANCLUSTERING_H
+#define VTKDBSCANCLUSTERING_H
+
+#include <vtkPolyDataAlgorithm.h>
+
+#include <memory>
+
+class ParallelDBSCAN;
+
+/**
+ * @brief The vtkDBSCANClustering class segments a point cloud with the DBSCAN
+ * algorithm (see ParallelDBSCAN) and adds the cluster of each point as the
+ * "cluster_id" point data array. The noise points have the id 0.
+ *
+ * The KD-tree built on the input points can be kept between two executions:
+ * when only Epsilon or MinPts change, the clustering is run again on the same tree.
+ */
+class VTK_EXPORT vtkDBSCANClustering : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkDBSCANClustering* New();
+  vtkTypeMacro(vtkDBSCANClustering, vtkPolyDataAlgorithm)
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  //! Radius of the neighborhood of a point, in the unit of the input points
+  vtkGetMacro(Epsilon, double)
+  vtkSetClampMacro(Epsilon, double, 0., VTK_DOUBLE_MAX)
+
+  //! Minimum number of points in the neighborhood of a core point, the point included
+  vtkGetMacro(MinPts, int)
+  vtkSetClampMacro(MinPts, int, 1, VTK_INT_MAX)
+
+  //! Keep the KD-tree while the input points do not change
+  vtkGetMacro(ReuseKDTree, bool)
+  vtkSetMacro(ReuseKDTree, bool)
+  vtkBooleanMacro(ReuseKDTree, bool)
+
+  //! Number of threads, 0 means one per hardware core
+  vtkGetMacro(NumberOfThreads, int)
+  vtkSetClampMacro(NumberOfThreads, int, 0, VTK_INT_MAX)
+
+  //! Number of clusters found by the last execution
+  vtkGetMacro(NumberOfClusters, int)
+
+protected:
+  vtkDBSCANClustering();
+  ~vtkDBSCANClustering();
+
+  int RequestData(vtkInformation* request,
+                  vtkInformationVector** inputVector,
+                  vtkInformationVector* outputVector) override;
+
+  double Epsilon = 0.5;
+  int MinPts = 10;
+  bool ReuseKDTree = true;
+  int NumberOfThreads = 0;
+  int NumberOfClusters = 0;
+
+private:
+  //! Clustering algorithm, holding the KD-tree of the last input points
+  std::unique_ptr<ParallelDBSCAN> Clustering;
+
+  //! Modification time of the points indexed by the KD-tree, 0 if there is no tree
+  vtkMTimeType IndexedPointsTime = 0;
+
+  vtkDBSCANClustering(const vtkDBSCANClustering&) = delete;
+  void operator=(const vtkDBSCANClustering&) = delete;
+};
+
+#endif // VTKDBSCANCLUSTERING_H
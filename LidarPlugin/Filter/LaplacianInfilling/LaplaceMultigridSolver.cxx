@@ -0,0 +1,415 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// LOCAL
+#include "LaplaceMultigridSolver.h"
+#include "ParallelFor.h"
+
+// STD
+#include <cmath>
+
+// Eigen
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+
+namespace
+{
+//! Levels with less pixels are solved directly
+constexpr int CoarsestLevelSize = 4096;
+
+//! Rows processed by a thread at least, to amortize its creation on small levels
+constexpr int MinimumRowsPerThread = 32;
+
+//-----------------------------------------------------------------------------
+double Dot(const std::vector<double>& a, const std::vector<double>& b)
+{
+  double sum = 0.;
+  for (size_t i = 0; i < a.size(); ++i)
+  {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief Level is a 5-point symmetric operator on a regular grid: Diagonal holds
+ *        the diagonal coefficients, East (resp. North) the coupling between a
+ *        pixel and its right (resp. upper) neighbor. Pixels with a null diagonal
+ *        coefficient are not part of the system.
+ */
+struct LaplaceMultigridSolver::Level
+{
+  int Width = 0;
+  int Height = 0;
+  std::vector<double> Diagonal;
+  std::vector<double> East;
+  std::vector<double> North;
+
+  // working buffers of the V-cycle
+  std::vector<double> X;
+  std::vector<double> B;
+  std::vector<double> Residual;
+
+  void Resize(int width, int height)
+  {
+    this->Width = width;
+    this->Height = height;
+    size_t size = static_cast<size_t>(width) * height;
+    this->Diagonal.assign(size, 0.);
+    this->East.assign(size, 0.);
+    this->North.assign(size, 0.);
+    this->X.assign(size, 0.);
+    this->B.assign(size, 0.);
+    this->Residual.assign(size, 0.);
+  }
+
+  //! Sum of the off diagonal terms of a row multiplied by values
+  double OffDiagonalProduct(int x, int y, const std::vector<double>& values) const
+  {
+    int index = x + this->Width * y;
+    double sum = 0.;
+    if (x > 0)
+    {
+      sum += this->East[index - 1] * values[index - 1];
+    }
+    if (x < this->Width - 1)
+    {
+      sum += this->East[index] * values[index + 1];
+    }
+    if (y > 0)
+    {
+      sum += this->North[index - this->Width] * values[index - this->Width];
+    }
+    if (y < this->Height - 1)
+    {
+      sum += this->North[index] * values[index + this->Width];
+    }
+    return sum;
+  }
+};
+
+//-----------------------------------------------------------------------------
+struct LaplaceMultigridSolver::CoarseSolver
+{
+  std::vector<int> Indices; //!< index of each pixel in the system, -1 if not part of it
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> Solver;
+};
+
+//-----------------------------------------------------------------------------
+LaplaceMultigridSolver::LaplaceMultigridSolver() = default;
+
+//-----------------------------------------------------------------------------
+LaplaceMultigridSolver::~LaplaceMultigridSolver() = default;
+
+//-----------------------------------------------------------------------------
+void LaplaceMultigridSolver::Setup(int width, int height, const std::vector<bool>& isUnknown)
+{
+  this->Levels.clear();
+
+  // finest level: laplacian restricted to the unknowns
+  std::unique_ptr<Level> finest(new Level);
+  finest->Resize(width, height);
+  for (int y = 0; y < height; ++y)
+  {
+    for (int x = 0; x < width; ++x)
+    {
+      int index = x + width * y;
+      if (!isUnknown[index])
+      {
+        continue;
+      }
+      finest->Diagonal[index] = (x > 0) + (x < width - 1) + (y > 0) + (y < height - 1);
+      if (x < width - 1 && isUnknown[index + 1])
+      {
+        finest->East[index] = -1.;
+      }
+      if (y < height - 1 && isUnknown[index + width])
+      {
+        finest->North[index] = -1.;
+      }
+    }
+  }
+  this->Levels.push_back(std::move(finest));
+
+  // coarse levels: Galerkin product with the piecewise constant interpolation,
+  // which keeps a 5-point stencil
+  while (this->Levels.back()->Width * this->Levels.back()->Height > CoarsestLevelSize)
+  {
+    const Level& fine = *this->Levels.back();
+    std::unique_ptr<Level> coarse(new Level);
+    coarse->Resize((fine.Width + 1) / 2, (fine.Height + 1) / 2);
+    for (int y = 0; y < fine.Height; ++y)
+    {
+      for (int x = 0; x < fine.Width; ++x)
+      {
+        int index = x + fine.Width * y;
+        if (fine.Diagonal[index] == 0.)
+        {
+          continue;
+        }
+        int parent = x / 2 + coarse->Width * (y / 2);
+        coarse->Diagonal[parent] += fine.Diagonal[index];
+        // a coupling inside a block appears twice in the block diagonal term
+        if (fine.East[index] != 0.)
+        {
+          (x % 2 == 0 ? coarse->Diagonal[parent] : coarse->East[parent]) +=
+            (x % 2 == 0 ? 2. : 1.) * fine.East[index];
+        }
+        if (fine.North[index] != 0.)
+        {
+          (y % 2 == 0 ? coarse->Diagonal[parent] : coarse->North[parent]) +=
+            (y % 2 == 0 ? 2. : 1.) * fine.North[index];
+        }
+      }
+    }
+    this->Levels.push_back(std::move(coarse));
+  }
+
+  // coarsest level: direct solver
+  const Level& coarsest = *this->Levels.back();
+  this->Coarse.reset(new CoarseSolver);
+  this->Coarse->Indices.assign(coarsest.Diagonal.size(), -1);
+  int numberOfUnknowns = 0;
+  for (size_t index = 0; index < coarsest.Diagonal.size(); ++index)
+  {
+    if (coarsest.Diagonal[index] != 0.)
+    {
+      this->Coarse->Indices[index] = numberOfUnknowns++;
+    }
+  }
+  std::vector<Eigen::Triplet<double>> nonZeroCoefficient;
+  for (size_t index = 0; index < coarsest.Diagonal.size(); ++index)
+  {
+    int row = this->Coarse->Indices[index];
+    if (row < 0)
+    {
+      continue;
+    }
+    nonZeroCoefficient.push_back(Eigen::Triplet<double>(row, row, coarsest.Diagonal[index]));
+    if (coarsest.East[index] != 0.)
+    {
+      int column = this->Coarse->Indices[index + 1];
+      nonZeroCoefficient.push_back(Eigen::Triplet<double>(row, column, coarsest.East[index]));
+      nonZeroCoefficient.push_back(Eigen::Triplet<double>(column, row, coarsest.East[index]));
+    }
+    if (coarsest.North[index] != 0.)
+    {
+      int column = this->Coarse->Indices[index + coarsest.Width];
+      nonZeroCoefficient.push_back(Eigen::Triplet<double>(row, column, coarsest.North[index]));
+      nonZeroCoefficient.push_back(Eigen::Triplet<double>(column, row, coarsest.North[index]));
+    }
+  }
+  Eigen::SparseMatrix<double> matrix(numberOfUnknowns, numberOfUnknowns);
+  matrix.setFromTriplets(nonZeroCoefficient.begin(), nonZeroCoefficient.end());
+  this->Coarse->Solver.compute(matrix);
+}
+
+//-----------------------------------------------------------------------------
+void LaplaceMultigridSolver::Apply(const Level& level, const std::vector<double>& input,
+                                   std::vector<double>& output) const
+{
+  ParallelFor(0, level.Height, [&](int firstRow, int lastRow)
+  {
+    for (int y = firstRow; y < lastRow; ++y)
+    {
+      for (int x = 0; x < level.Width; ++x)
+      {
+        int index = x + level.Width * y;
+        output[index] = level.Diagonal[index] == 0. ? 0. :
+          level.Diagonal[index] * input[index] + level.OffDiagonalProduct(x, y, input);
+      }
+    }
+  }, 0, MinimumRowsPerThread);
+}
+
+//-----------------------------------------------------------------------------
+void LaplaceMultigridSolver::Smooth(Level& level, int color) const
+{
+  // the pixels of a color only depend on the pixels of the other color,
+  // so that they can be updated in any order
+  ParallelFor(0, level.Height, [&](int firstRow, int lastRow)
+  {
+    for (int y = firstRow; y < lastRow; ++y)
+    {
+      for (int x = (y + color) % 2; x < level.Width; x += 2)
+      {
+        int index = x + level.Width * y;
+        if (level.Diagonal[index] != 0.)
+        {
+          level.X[index] = (level.B[index] - level.OffDiagonalProduct(x, y, level.X)) / level.Diagonal[index];
+        }
+      }
+    }
+  }, 0, MinimumRowsPerThread);
+}
+
+//-----------------------------------------------------------------------------
+void LaplaceMultigridSolver::VCycle(size_t levelIndex)
+{
+  Level& level = *this->Levels[levelIndex];
+
+  // coarsest level
+  if (levelIndex == this->Levels.size() - 1)
+  {
+    Eigen::VectorXd b(this->Coarse->Solver.rows());
+    for (size_t index = 0; index < level.B.size(); ++index)
+    {
+      if (this->Coarse->Indices[index] >= 0)
+      {
+        b(this->Coarse->Indices[index]) = level.B[index];
+      }
+    }
+    Eigen::VectorXd x = this->Coarse->Solver.solve(b);
+    for (size_t index = 0; index < level.X.size(); ++index)
+    {
+      level.X[index] = this->Coarse->Indices[index] >= 0 ? x(this->Coarse->Indices[index]) : 0.;
+    }
+    return;
+  }
+
+  // pre smoothing, the post smoothing is done in the reverse order
+  // so that the V-cycle is a symmetric preconditioner
+  std::fill(level.X.begin(), level.X.end(), 0.);
+  this->Smooth(level, 0);
+  this->Smooth(level, 1);
+  this->Smooth(level, 0);
+  this->Smooth(level, 1);
+
+  // restriction of the residual
+  this->Apply(level, level.X, level.Residual);
+  Level& coarse = *this->Levels[levelIndex + 1];
+  std::fill(coarse.B.begin(), coarse.B.end(), 0.);
+  for (int y = 0; y < level.Height; ++y)
+  {
+    for (int x = 0; x < level.Width; ++x)
+    {
+      int index = x + level.Width * y;
+      if (level.Diagonal[index] != 0.)
+      {
+        coarse.B[x / 2 + coarse.Width * (y / 2)] += level.B[index] - level.Residual[index];
+      }
+    }
+  }
+
+  this->VCycle(levelIndex + 1);
+
+  // interpolation of the correction
+  ParallelFor(0, level.Height, [&](int firstRow, int lastRow)
+  {
+    for (int y = firstRow; y < lastRow; ++y)
+    {
+      for (int x = 0; x < level.Width; ++x)
+      {
+        int index = x + level.Width * y;
+        if (level.Diagonal[index] != 0.)
+        {
+          level.X[index] += coarse.X[x / 2 + coarse.Width * (y / 2)];
+        }
+      }
+    }
+  }, 0, MinimumRowsPerThread);
+
+  this->Smooth(level, 1);
+  this->Smooth(level, 0);
+  this->Smooth(level, 1);
+  this->Smooth(level, 0);
+}
+
+//-----------------------------------------------------------------------------
+int LaplaceMultigridSolver::Solve(std::vector<double>& grid, double tolerance, int maximumNumberOfIterations)
+{
+  this->Converged = false;
+  Level& finest = *this->Levels.front();
+  const size_t size = grid.size();
+
+  // right hand side: the known neighbors of each unknown
+  std::vector<double> b(size, 0.), x(size, 0.);
+  for (int y = 0; y < finest.Height; ++y)
+  {
+    for (int xIndex = 0; xIndex < finest.Width; ++xIndex)
+    {
+      int index = xIndex + finest.Width * y;
+      if (finest.Diagonal[index] == 0.)
+      {
+        continue;
+      }
+      x[index] = grid[index];
+      int neighbors[4] = { xIndex > 0 ? index - 1 : -1,
+                           xIndex < finest.Width - 1 ? index + 1 : -1,
+                           y > 0 ? index - finest.Width : -1,
+                           y < finest.Height - 1 ? index + finest.Width : -1 };
+      for (int neighbor : neighbors)
+      {
+        if (neighbor >= 0 && finest.Diagonal[neighbor] == 0.)
+        {
+          b[index] += grid[neighbor];
+        }
+      }
+    }
+  }
+
+  // preconditioned conjugate gradient
+  std::vector<double> r(size), p(size), Ap(size);
+  this->Apply(finest, x, Ap);
+  for (size_t index = 0; index < size; ++index)
+  {
+    r[index] = b[index] - Ap[index];
+  }
+  const double bNorm = std::sqrt(Dot(b, b));
+  double rz = 0.;
+  int iteration = 0;
+  for (; iteration <= maximumNumberOfIterations; ++iteration)
+  {
+    if (std::sqrt(Dot(r, r)) <= tolerance * bNorm)
+    {
+      this->Converged = true;
+      break;
+    }
+    if (iteration == maximumNumberOfIterations)
+    {
+      break;
+    }
+
+    // z = M^-1 r
+    finest.B = r;
+    this->VCycle(0);
+    const std::vector<double>& z = finest.X;
+
+    double previousRz = rz;
+    rz = Dot(r, z);
+    double beta = iteration == 0 ? 0. : rz / previousRz;
+    for (size_t index = 0; index < size; ++index)
+    {
+      p[index] = z[index] + beta * p[index];
+    }
+    this->Apply(finest, p, Ap);
+    double alpha = rz / Dot(p, Ap);
+    for (size_t index = 0; index < size; ++index)
+    {
+      x[index] += alpha * p[index];
+      r[index] -= alpha * Ap[index];
+    }
+  }
+
+  for (size_t index = 0; index < size; ++index)
+  {
+    if (finest.Diagonal[index] != 0.)
+    {
+      grid[index] = x[index];
+    }
+  }
+  return iteration;
+}
@@ -0,0 +1,81 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LAPLACE_MULTIGRID_SOLVER_H
+#define LAPLACE_MULTIGRID_SOLVER_H
+
+// STD
+#include <memory>
+#include <vector>
+
+/**
+ * @brief LaplaceMultigridSolver solve the Laplace equation with Dirichlet
+ *        boundary conditions on a regular 2D grid, without assembling any matrix.
+ *
+ * Some pixels of the grid are unknowns, the others keep their value and act as
+ * the boundary condition. The finite difference scheme uses the 4 neighbors of
+ * each pixel, the border of the grid is a free boundary.
+ *
+ * The system is solved with a conjugate gradient preconditioned by a multigrid
+ * V-cycle: the coarse levels are the Galerkin products of the fine operator with
+ * a piecewise constant interpolation on 2x2 blocks, the smoother is a red-black
+ * Gauss-Seidel (processed in parallel by rows) and the coarsest level is solved
+ * with a sparse Cholesky factorization. The number of iterations barely depends
+ * on the size of the grid.
+ */
+class LaplaceMultigridSolver
+{
+public:
+  LaplaceMultigridSolver();
+  ~LaplaceMultigridSolver();
+
+  /**
+   * @brief Setup build the multigrid hierarchy
+   * @param width number of columns of the grid
+   * @param height number of rows of the grid
+   * @param isUnknown for each pixel (flattened with x + width * y),
+   *        true if its value must be computed
+   */
+  void Setup(int width, int height, const std::vector<bool>& isUnknown);
+
+  /**
+   * @brief Solve compute the unknown pixels so that their laplacian is null
+   * @param grid values of the pixels, flattened with x + width * y. The
+   *        unknown pixels contain the initial guess and are replaced by the
+   *        solution, the others are the boundary condition and are not modified.
+   * @param tolerance relative residual under which the solver stops
+   * @param maximumNumberOfIterations maximum number of conjugate gradient iterations
+   * @return the number of iterations done
+   */
+  int Solve(std::vector<double>& grid, double tolerance, int maximumNumberOfIterations);
+
+  //! True if the last call to Solve reached the tolerance
+  bool HasConverged() const { return this->Converged; }
+
+private:
+  struct Level;
+
+  void Apply(const Level& level, const std::vector<double>& input, std::vector<double>& output) const;
+  void Smooth(Level& level, int color) const;
+  void VCycle(size_t levelIndex);
+
+  std::vector<std::unique_ptr<Level>> Levels;
+
+  struct CoarseSolver;
+  std::unique_ptr<CoarseSolver> Coarse;
+
+  bool Converged = false;
+};
+
+#endif // LAPLACE_MULTIGRID_SOLVER_H
@@ -16,30 +16,167 @@
 
 // LOCAL
 #include "vtkLaplacianInfilling.h"
+#include "LaplaceMultigridSolver.h"
+#include "ParallelFor.h"
 
 // STD
-#include <iostream>
-#include <fstream>
-#include <sstream>
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 // VTK
-#include <vtkObjectFactory.h>
+#include <vtkDataArray.h>
 #include <vtkImageData.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
-#include <vtkStreamingDemandDrivenPipeline.h>
-#include <vtkXMLImageDataWriter.h>
-
-// BOOST
-#include <boost/algorithm/string.hpp>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
 
 // Eigen
 #include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
 
 // Implementation of the New function
 vtkStandardNewMacro(vtkLaplacianInfilling)
 
+namespace
+{
+//! Holes with more pixels are solved with the selected solver, the others directly
+constexpr int SmallHoleSize = 4096;
+
+//-----------------------------------------------------------------------------
+bool IsHole(double value)
+{
+  return std::abs(value) <= std::numeric_limits<double>::epsilon();
+}
+
+//-----------------------------------------------------------------------------
+//! Get the 4 neighbors of a pixel flattened with x + xBound * y, -1 outside the image
+void GetNeighbors(int index, int xBound, int yBound, int neighbors[4])
+{
+  int x = index % xBound;
+  int y = index / xBound;
+  neighbors[0] = x != 0 ? index - 1 : -1;
+  neighbors[1] = x != xBound - 1 ? index + 1 : -1;
+  neighbors[2] = y != 0 ? index - xBound : -1;
+  neighbors[3] = y != yBound - 1 ? index + xBound : -1;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief LabelHoles split the holes of the image in 4-connected components
+ * @param values pixel values, flattened with x + xBound * y
+ * @return the pixels of each component
+ */
+std::vector<std::vector<int>> LabelHoles(const std::vector<double>& values, int xBound, int yBound)
+{
+  std::vector<std::vector<int>> components;
+  std::vector<bool> visited(values.size(), false);
+  int neighbors[4];
+  for (int seed = 0; seed < static_cast<int>(values.size()); ++seed)
+  {
+    if (visited[seed] || !IsHole(values[seed]))
+    {
+      continue;
+    }
+    // flood fill, the component is used as the queue
+    std::vector<int> component(1, seed);
+    visited[seed] = true;
+    for (size_t k = 0; k < component.size(); ++k)
+    {
+      GetNeighbors(component[k], xBound, yBound, neighbors);
+      for (int neighbor : neighbors)
+      {
+        if (neighbor >= 0 && !visited[neighbor] && IsHole(values[neighbor]))
+        {
+          visited[neighbor] = true;
+          component.push_back(neighbor);
+        }
+      }
+    }
+    components.push_back(std::move(component));
+  }
+  return components;
+}
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief SolveDirect fill a hole with a sparse Cholesky factorization
+ * @param localIndex index of each pixel of the hole in its system
+ * @param filled image in which the solution is written
+ * @return false if the hole could not be filled
+ */
+bool SolveDirect(const std::vector<int>& component, const std::vector<double>& values,
+                 const std::vector<int>& localIndex, int xBound, int yBound,
+                 std::vector<double>& filled)
+{
+  // The laplacian must be null on each hole. The finite difference scheme
+  // gives: deg * xi - sum(xj, j hole neighbor) = sum(yj, j known neighbor)
+  // The matrix is symmetric, and positive definite as soon as the hole
+  // touches a known pixel.
+  const int n = static_cast<int>(component.size());
+  std::vector<Eigen::Triplet<double>> nonZeroCoefficient;
+  nonZeroCoefficient.reserve(5 * n);
+  Eigen::VectorXd Y = Eigen::VectorXd::Zero(n);
+  int neighbors[4];
+  for (int k = 0; k < n; ++k)
+  {
+    GetNeighbors(component[k], xBound, yBound, neighbors);
+    int validNeigh = 0;
+    for (int neighbor : neighbors)
+    {
+      if (neighbor < 0)
+      {
+        continue;
+      }
+      validNeigh++;
+      if (IsHole(values[neighbor]))
+      {
+        nonZeroCoefficient.push_back(Eigen::Triplet<double>(k, localIndex[neighbor], -1.0));
+      }
+      else
+      {
+        Y(k) += values[neighbor];
+      }
+    }
+    nonZeroCoefficient.push_back(Eigen::Triplet<double>(k, k, static_cast<double>(validNeigh)));
+  }
+
+  Eigen::SparseMatrix<double> Laplacian(n, n);
+  Laplacian.setFromTriplets(nonZeroCoefficient.begin(), nonZeroCoefficient.end());
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver(Laplacian);
+  Eigen::VectorXd X = solver.solve(Y);
+  if (solver.info() != Eigen::Success)
+  {
+    return false;
+  }
+  for (int k = 0; k < n; ++k)
+  {
+    filled[component[k]] = X(k);
+  }
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+void vtkLaplacianInfilling::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "SolverType: " << this->SolverType << std::endl;
+  os << indent << "Tolerance: " << this->Tolerance << std::endl;
+  os << indent << "MaximumNumberOfIterations: " << this->MaximumNumberOfIterations << std::endl;
+  os << indent << "WarmStart: " << this->WarmStart << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+void vtkLaplacianInfilling::ResetWarmStart()
+{
+  this->PreviousSolution.clear();
+  this->PreviousDimensions[0] = 0;
+  this->PreviousDimensions[1] = 0;
+}
+
 //-----------------------------------------------------------------------------
 int vtkLaplacianInfilling::RequestData(vtkInformation *vtkNotUsed(request),
   vtkInformationVector **inputVector, vtkInformationVector *outputVector)
@@ -47,89 +184,158 @@ int vtkLaplacianInfilling::RequestData(vtkInformation *vtkNotUsed(request),
   // Get the input
   vtkImageData * inputImage = vtkImageData::GetData(inputVector[0]->GetInformationObject(0));
 
-  // Get the output
+  // Get the output, the scalars are deep copied to leave the input untouched
   vtkImageData* outputImage = vtkImageData::GetData(outputVector->GetInformationObject(0));
   outputImage->ShallowCopy(inputImage);
+  vtkDataArray* inputScalars = inputImage->GetPointData()->GetScalars();
+  if (!inputScalars)
+  {
+    vtkErrorMacro("The input image has no scalars");
+    return 0;
+  }
+  vtkSmartPointer<vtkDataArray> scalars = vtkSmartPointer<vtkDataArray>::Take(inputScalars->NewInstance());
+  scalars->DeepCopy(inputScalars);
+  outputImage->GetPointData()->SetScalars(scalars);
 
   int xBound = outputImage->GetDimensions()[0];
   int yBound = outputImage->GetDimensions()[1];
   int nParams = xBound * yBound;
 
-  Eigen::SparseMatrix<double> Laplacian(nParams, nParams);
-  Eigen::VectorXd Y(nParams); // The values of the laplacian required
+  // the pixels are flattened with x + xBound * y, as the image scalars
+  std::vector<double> values(nParams);
+  for (int index = 0; index < nParams; ++index)
+  {
+    values[index] = scalars->GetComponent(index, 0);
+  }
+
+  const bool useWarmStart = this->WarmStart &&
+                            this->PreviousDimensions[0] == xBound &&
+                            this->PreviousDimensions[1] == yBound &&
+                            static_cast<int>(this->PreviousSolution.size()) == nParams;
 
-  // Triplet of value: row, column and value
-  std::vector<Eigen::Triplet<double> > nonZeroCoefficient;
-  for (int x = 0; x < xBound; ++x)
+  // Only the holes are unknowns, and each connected component of holes
+  // is an independent problem. The known pixels are not part of any system.
+  std::vector<std::vector<int>> components = LabelHoles(values, xBound, yBound);
+  std::vector<int> smallHoles, largeHoles;
+  std::vector<int> localIndex(nParams, -1);
+  for (int componentIndex = 0; componentIndex < static_cast<int>(components.size()); ++componentIndex)
   {
-    for (int y = 0; y < yBound; ++y)
+    const std::vector<int>& component = components[componentIndex];
+    for (int k = 0; k < static_cast<int>(component.size()); ++k)
     {
-      int flattenIndex = x + xBound * y;
+      localIndex[component[k]] = k;
+    }
+    bool isSmall = this->SolverType == DIRECT || static_cast<int>(component.size()) <= SmallHoleSize;
+    (isSmall ? smallHoles : largeHoles).push_back(componentIndex);
+  }
+
+  // A hole without any known neighbor is the whole image, there is nothing to fill it with
+  if (components.size() == 1 && static_cast<int>(components[0].size()) == nParams)
+  {
+    vtkWarningMacro("The input image has no value to fill the holes with");
+    return 1;
+  }
+
+  std::vector<double> filled = values;
+  std::vector<char> succeeded(components.size(), 1);
 
-      // check if the current pixel has a value
-      double value = inputImage->GetScalarComponentAsDouble(x, y, 0, 0);
-      if ((std::abs(value) > std::numeric_limits<double>::epsilon()))
+  // small holes: one direct solve per hole, the holes are solved in parallel
+  ParallelFor(0, static_cast<int>(smallHoles.size()), [&](int first, int last)
+  {
+    for (int i = first; i < last; ++i)
+    {
+      int componentIndex = smallHoles[i];
+      succeeded[componentIndex] =
+        SolveDirect(components[componentIndex], values, localIndex, xBound, yBound, filled);
+    }
+  });
+
+  // large holes: one after the other, each solve being parallel. The system is
+  // defined on the bounding box of the hole, enlarged to contain its boundary.
+  int totalIterations = 0;
+  LaplaceMultigridSolver solver;
+  for (int componentIndex : largeHoles)
+  {
+    const std::vector<int>& component = components[componentIndex];
+    int xMin = xBound, xMax = 0, yMin = yBound, yMax = 0;
+    for (int index : component)
+    {
+      xMin = std::min(xMin, index % xBound);
+      xMax = std::max(xMax, index % xBound);
+      yMin = std::min(yMin, index / xBound);
+      yMax = std::max(yMax, index / xBound);
+    }
+    xMin = std::max(xMin - 1, 0);
+    yMin = std::max(yMin - 1, 0);
+    xMax = std::min(xMax + 1, xBound - 1);
+    yMax = std::min(yMax + 1, yBound - 1);
+    const int width = xMax - xMin + 1;
+    const int height = yMax - yMin + 1;
+
+    // The other holes of the box are not adjacent to this one, they are
+    // considered as known pixels without any effect on the solution
+    std::vector<double> grid(width * height);
+    std::vector<bool> isUnknown(width * height, false);
+    for (int y = yMin; y <= yMax; ++y)
+    {
+      for (int x = xMin; x <= xMax; ++x)
       {
-        // we don't want this value to be modified
-        // contraint: xi = yi
-        nonZeroCoefficient.push_back(Eigen::Triplet<double>(flattenIndex, flattenIndex, 1.0));
-        Y(flattenIndex) = value;
+        grid[(x - xMin) + width * (y - yMin)] = values[x + xBound * y];
       }
-      else
+    }
+    double boundarySum = 0;
+    int boundaryCount = 0;
+    int neighbors[4];
+    for (int index : component)
+    {
+      GetNeighbors(index, xBound, yBound, neighbors);
+      for (int neighbor : neighbors)
       {
-        // else fill it solving the laplace equation
-        // using finite difference scheme and Dirichlet
-        // boundary
-        int validNeigh = 0;
-
-        // Laplacian constraints matrix:
-        // Neighbors contraint
-        if (x != 0)
-        {
-          nonZeroCoefficient.push_back(Eigen::Triplet<double>(flattenIndex, flattenIndex - 1, 1));
-          validNeigh++;
-        }
-        if (x != xBound - 1)
-        {
-          nonZeroCoefficient.push_back(Eigen::Triplet<double>(flattenIndex, flattenIndex + 1, 1));
-          validNeigh++;
-        }
-        if (y != 0)
-        {
-          nonZeroCoefficient.push_back(Eigen::Triplet<double>(flattenIndex, flattenIndex - xBound, 1));
-          validNeigh++;
-        }
-        if (y != yBound - 1)
+        if (neighbor >= 0 && !IsHole(values[neighbor]))
         {
-          nonZeroCoefficient.push_back(Eigen::Triplet<double>(flattenIndex, flattenIndex + xBound, 1));
-          validNeigh++;
+          boundarySum += values[neighbor];
+          boundaryCount++;
         }
-        // Diagonal constraint
-        nonZeroCoefficient.push_back(Eigen::Triplet<double>(flattenIndex, flattenIndex, -1.0 * static_cast<double>(validNeigh)));
-        // We want the laplacian to be null
-        Y(flattenIndex) = 0;
       }
     }
-  }
+    for (int index : component)
+    {
+      // initial guess: previous solution, or mean of the hole boundary
+      int gridIndex = (index % xBound - xMin) + width * (index / xBound - yMin);
+      isUnknown[gridIndex] = true;
+      grid[gridIndex] = useWarmStart ? this->PreviousSolution[index] : boundarySum / boundaryCount;
+    }
 
-  // Fill Laplacian constraints matrix
-  Laplacian.setFromTriplets(nonZeroCoefficient.begin(), nonZeroCoefficient.end());
+    solver.Setup(width, height, isUnknown);
+    totalIterations += solver.Solve(grid, this->Tolerance, this->MaximumNumberOfIterations);
+    succeeded[componentIndex] = solver.HasConverged();
+    for (int index : component)
+    {
+      filled[index] = grid[(index % xBound - xMin) + width * (index / xBound - yMin)];
+    }
+  }
 
-  // Solving:
-  Eigen::SparseLU< Eigen::SparseMatrix<double> > solver(Laplacian);
-  Eigen::MatrixXd X = solver.solve(Y);
+  int failedComponents = std::count(succeeded.begin(), succeeded.end(), 0);
+  if (failedComponents > 0)
+  {
+    vtkWarningMacro(<< failedComponents << " of the " << components.size()
+                    << " holes could not be filled accurately");
+  }
+  vtkDebugMacro(<< smallHoles.size() << " small holes solved directly, " << largeHoles.size()
+                << " large holes solved in " << totalIterations << " iterations"
+                << (useWarmStart ? " with warm start" : ""));
 
-  // X contains the Dirichlet solution function
+  // filled contains the Dirichlet solution function
   // values i.e: 0-values pixel are filled with
   // laplacian
-  for (int x = 0; x < xBound; ++x)
+  for (int index = 0; index < nParams; ++index)
   {
-    for (int y = 0; y < yBound; ++y)
-    {
-      int flattendIndex = x + xBound * y;
-      outputImage->SetScalarComponentFromDouble(x, y, 0, 0, X(flattendIndex));
-    }
+    scalars->SetComponent(index, 0, filled[index]);
   }
 
+  this->PreviousSolution = std::move(filled);
+  this->PreviousDimensions[0] = xBound;
+  this->PreviousDimensions[1] = yBound;
+
   return 1;
 }
@@ -20,15 +20,57 @@
 // VTK
 #include <vtkImageAlgorithm.h>
 
+// STD
+#include <vector>
+
 /**
  * @brief vtkLaplacianInfilling fill missing data in an image
  *        solving the Dirichlet problem.
+ *
+ * The pixels with a null value are the unknowns, the other pixels are the
+ * Dirichlet boundary. Only the unknowns are solved for: the holes are split in
+ * 4-connected components, each one giving an independent symmetric positive
+ * definite system. The small components are solved in parallel with a sparse
+ * Cholesky factorization. The large ones are solved either the same way, or with
+ * a matrix-free conjugate gradient preconditioned by a multigrid V-cycle on the
+ * bounding box of the component (see LaplaceMultigridSolver), which scales to
+ * large rasters.
+ *
+ * When the filter is run on a time series of images with the same dimensions,
+ * the multigrid solver can start from the previous solution.
  */
 class VTK_EXPORT vtkLaplacianInfilling : public vtkImageAlgorithm
 {
 public:
   static vtkLaplacianInfilling *New();
   vtkTypeMacro(vtkLaplacianInfilling, vtkImageAlgorithm)
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum SolverTypes
+  {
+    DIRECT = 0,    /*!< sparse Cholesky factorization */
+    MULTIGRID = 1, /*!< conjugate gradient with a multigrid preconditioner */
+  };
+
+  //! Solver used for the large holes
+  vtkGetMacro(SolverType, int)
+  vtkSetClampMacro(SolverType, int, DIRECT, MULTIGRID)
+
+  //! Relative residual under which the multigrid solver stops
+  vtkGetMacro(Tolerance, double)
+  vtkSetMacro(Tolerance, double)
+
+  //! Maximum number of multigrid solver iterations per hole
+  vtkGetMacro(MaximumNumberOfIterations, int)
+  vtkSetClampMacro(MaximumNumberOfIterations, int, 1, VTK_INT_MAX)
+
+  //! Start the multigrid solver from the previous output if it has the same dimensions
+  vtkGetMacro(WarmStart, bool)
+  vtkSetMacro(WarmStart, bool)
+  vtkBooleanMacro(WarmStart, bool)
+
+  //! Forget the previous solution used by the warm start
+  void ResetWarmStart();
 
 protected:
   vtkLaplacianInfilling() = default;
@@ -36,6 +78,15 @@ protected:
 
   int RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *) override;
 
+  int SolverType = MULTIGRID;
+  double Tolerance = 1e-6;
+  int MaximumNumberOfIterations = 100;
+  bool WarmStart = true;
+
+  //! Filled image of the previous run and its dimensions, used by the warm start
+  std::vector<double> PreviousSolution;
+  int PreviousDimensions[2] = { 0, 0 };
+
 private:
   vtkLaplacianInfilling(const vtkLaplacianInfilling&) = delete;
   void operator=(const vtkLaplacianInfilling&) = delete;
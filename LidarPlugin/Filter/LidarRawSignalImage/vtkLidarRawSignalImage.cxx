@@ -15,6 +15,8 @@
 
 // LOCAL
 #include "vtkLidarRawSignalImage.h"
+#include "ParallelFor.h"
+#include "PixelBinning.h"
 
 #include <vtkObjectFactory.h>
 #include <vtkImageData.h>
@@ -119,12 +121,10 @@ int vtkLidarRawSignalImage::RequestData(vtkInformation *vtkNotUsed(request),
   }
 
   // Project each point one by one into the image
+  std::vector<int> pixelOfPoint(input->GetNumberOfPoints());
+  std::vector<double> valueOfPoint(input->GetNumberOfPoints());
   for (unsigned int indexPoint = 0; indexPoint < input->GetNumberOfPoints(); ++indexPoint)
   {
-    // Get the coordinate of the input point
-    double currPoint[3];
-    input->GetPoint(indexPoint, currPoint);
-
     // compute w coordinate of the image based
     // on the azimuth angle
     double azimuthAngle = azimuth->GetTuple1(indexPoint);
@@ -140,9 +140,24 @@ int vtkLidarRawSignalImage::RequestData(vtkInformation *vtkNotUsed(request),
     // resulting in an observed image distorded
     int idx = laserIndex->GetTuple1(indexPoint);
     int h = this->VerticallySortedIndex[idx];
-    double value = arrayToUse->GetTuple1(indexPoint);
-    outputImage->SetScalarComponentFromDouble(w, h, 0, 0, value);
+    bool isInImage = w >= 0 && w < this->Width && h >= 0 && h < this->Height;
+    pixelOfPoint[indexPoint] = isInImage ? w + this->Width * h : -1;
+    valueOfPoint[indexPoint] = arrayToUse->GetTuple1(indexPoint);
   }
+  PixelBinning pixels;
+  pixels.Build(this->Width * this->Height, pixelOfPoint, valueOfPoint);
+
+  // the last point projected in a pixel gives its value
+  ParallelFor(0, this->Height, [&](int firstRow, int lastRow)
+  {
+    for (int pixel = firstRow * this->Width; pixel < lastRow * this->Width; ++pixel)
+    {
+      if (!pixels.IsEmpty(pixel))
+      {
+        dataPointer[pixel] = static_cast<unsigned char>(*(pixels.End(pixel) - 1));
+      }
+    }
+  });
 
   return VTK_OK;
 }
@@ -116,7 +116,7 @@ int vtkPCLRansacModel::RequestData(vtkInformation *vtkNotUsed(request),
 
     case vtkPCLRansacModel::Plane:
       RANSACModel = pcl::SampleConsensusModel<pcl::PointXYZ>::Ptr(
-            new pcl::SampleConsensusModelLine<pcl::PointXYZ> (pointCloud));
+            new pcl::SampleConsensusModelPlane<pcl::PointXYZ> (pointCloud));
       break;
 
     default:
@@ -17,8 +17,11 @@
 // LOCAL
 #include "vtkPointCloudLinearProjector.h"
 #include "vtkEigenTools.h"
+#include "ParallelFor.h"
+#include "PixelBinning.h"
 
 // STD
+#include <algorithm>
 #include <cmath>
 #include <fstream>
 #include <iostream>
@@ -153,17 +156,20 @@ int vtkPointCloudLinearProjector::RequestData(vtkInformation* vtkNotUsed(request
   {
     image->AllocateScalars(VTK_DOUBLE, 1);
   }
-  // Compute distribution about the height of the data lying in a pixel
-  std::vector<std::vector<double> > perPixelDistribution(this->Resolution[0] * this->Resolution[1]);
-  for (vtkIdType pointIndex = 0; pointIndex < input->GetNumberOfPoints(); ++pointIndex)
+  // Group the values of the points by pixel
+  const vtkIdType numberOfPoints = input->GetNumberOfPoints();
+  std::vector<int> pixelOfPoint(numberOfPoints);
+  std::vector<double> valueOfPoint(numberOfPoints);
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; ++pointIndex)
   {
     transformedPoints->GetPoint(pointIndex, point);
     int xPixelCoord = std::floor((point[0] - boundingBox[0]) * scaleX);
     int yPixelCoord = std::floor((point[1] - boundingBox[2]) * scaleY);
-    perPixelDistribution[xPixelCoord + this->Resolution[0] * yPixelCoord].push_back(
-      this->HeightMap ? point[2] : values->GetTuple1(pointIndex)
-    );
+    pixelOfPoint[pointIndex] = xPixelCoord + this->Resolution[0] * yPixelCoord;
+    valueOfPoint[pointIndex] = this->HeightMap ? point[2] : values->GetTuple1(pointIndex);
   }
+  PixelBinning perPixelDistribution;
+  perPixelDistribution.Build(this->Resolution[0] * this->Resolution[1], pixelOfPoint, valueOfPoint);
 
   // fill the image
   double valueRange[2];
@@ -179,66 +185,76 @@ int vtkPointCloudLinearProjector::RequestData(vtkInformation* vtkNotUsed(request
 
   double valueShift = (this->ExportAsChar || this->ShiftToZero) ? valueRange[0] : 0.0;
   double valueScale = valueRange[1] - valueRange[0];
-  for (unsigned int y = 0; y < this->Resolution[1]; ++y)
+  vtkDataArray* scalars = image->GetPointData()->GetScalars();
+  const int dimX = static_cast<int>(this->Resolution[0]);
+  const int dimY = static_cast<int>(this->Resolution[1]);
+  // each row is independent, and writing distinct tuples of an allocated array is thread safe
+  ParallelFor(0, dimY, [&](int firstRow, int lastRow)
   {
-    for (unsigned int x = 0; x < this->Resolution[0]; ++x)
+    for (int y = firstRow; y < lastRow; ++y)
     {
-      unsigned int imageIndex = this->Resolution[0] * y + x;
-      double value = 0.0;
-      // if the pixel is empty, skip it
-      if (perPixelDistribution[imageIndex].size() > 0)
-      {
-        std::sort(perPixelDistribution[imageIndex].begin(), perPixelDistribution[imageIndex].end());
-        unsigned int rankIndex = std::floor((perPixelDistribution[imageIndex].size() - 1) * this->RankPercentile);
-        value = perPixelDistribution[imageIndex][rankIndex];
-      }
-      if (this->ExportAsChar)
-      {
-        value -= valueShift;
-        value = std::round((value / valueScale) * 0xff);
-      }
-      else if (this->ShiftToZero)
+      for (int x = 0; x < dimX; ++x)
       {
-        value -= valueShift;
+        unsigned int imageIndex = dimX * y + x;
+        double value = 0.0;
+        // if the pixel is empty, skip it
+        if (!perPixelDistribution.IsEmpty(imageIndex))
+        {
+          value = perPixelDistribution.Rank(imageIndex, this->RankPercentile);
+        }
+        if (this->ExportAsChar)
+        {
+          value -= valueShift;
+          value = std::round((value / valueScale) * 0xff);
+        }
+        else if (this->ShiftToZero)
+        {
+          value -= valueShift;
+        }
+        // Use unscaled values to match input values and ranges.
+        scalars->SetComponent(imageIndex, 0, value);
       }
-      // Use unscaled values to match input values and ranges.
-      image->SetScalarComponentFromDouble(x, y, 0, 0, value);
     }
-  }
+  });
 
   int neigh = this->MedianFilterWidth;
   if (this->ShouldMedianFilter)
   {
-    vtkSmartPointer<vtkImageData> tempImage = vtkSmartPointer<vtkImageData>::New();
-    tempImage->DeepCopy(image);
-    int dimX = static_cast<int>(this->Resolution[0]);
-    int dimY = static_cast<int>(this->Resolution[1]);
-    for (int x = 0; x < dimX; ++x)
+    // copy of the image before filtering
+    std::vector<double> unfiltered(dimX * dimY);
+    for (int imageIndex = 0; imageIndex < dimX * dimY; ++imageIndex)
     {
-      for (int y = 0; y < dimY; ++y)
+      unfiltered[imageIndex] = scalars->GetComponent(imageIndex, 0);
+    }
+    ParallelFor(0, dimY, [&](int firstRow, int lastRow)
+    {
+      std::vector<double> neighborhoodValues;
+      neighborhoodValues.reserve((2 * neigh + 1) * (2 * neigh + 1));
+      for (int y = firstRow; y < lastRow; ++y)
       {
-        if (tempImage->GetScalarComponentAsDouble(x, y, 0, 0) == 0)
-        {
-          continue;
-        }
-        std::vector<double> neighborhoodValues;
-        unsigned int minU = std::max(0, x - neigh);
-        unsigned int maxU = std::min(dimX - 1, x + neigh);
-        unsigned int minV = std::max(0, y - neigh);
-        unsigned int maxV = std::min(dimY - 1, y + neigh);
-
-        for (unsigned int u = minU; u <= maxU; ++u)
+        for (int x = 0; x < dimX; ++x)
         {
-          for (unsigned int v = minV; v <= maxV; ++v)
+          if (unfiltered[dimX * y + x] == 0)
           {
-            neighborhoodValues.push_back(tempImage->GetScalarComponentAsDouble(u, v, 0, 0));
+            continue;
           }
+          neighborhoodValues.clear();
+          int minU = std::max(0, x - neigh);
+          int maxU = std::min(dimX - 1, x + neigh);
+          int minV = std::max(0, y - neigh);
+          int maxV = std::min(dimY - 1, y + neigh);
+          for (int v = minV; v <= maxV; ++v)
+          {
+            neighborhoodValues.insert(neighborhoodValues.end(),
+                                      unfiltered.begin() + dimX * v + minU,
+                                      unfiltered.begin() + dimX * v + maxU + 1);
+          }
+          auto median = neighborhoodValues.begin() + neighborhoodValues.size() / 2;
+          std::nth_element(neighborhoodValues.begin(), median, neighborhoodValues.end());
+          scalars->SetComponent(dimX * y + x, 0, *median);
         }
-        std::sort(neighborhoodValues.begin(), neighborhoodValues.end());
-        double medianValue = neighborhoodValues[neighborhoodValues.size() / 2];
-        image->SetScalarComponentFromDouble(x, y, 0, 0, medianValue);
       }
-    }
+    });
   }
 
   vtkImageData* outputImage = vtkImageData::GetData(outputVector->GetInformationObject(0));
@@ -0,0 +1,293 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// LOCAL
+#include "RansacPlaneEstimator.h"
+#include "ParallelFor.h"
+
+// STD
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+
+// EIGEN
+#include <Eigen/Dense>
+
+namespace
+{
+//! Number of hypotheses scored together by the preemptive scheme
+constexpr int HypothesesPerBatch = 32;
+//! Number of points on which the hypotheses are scored before keeping the best half
+constexpr int PreemptiveBlockSize = 128;
+//! Number of points of the random subset used by the preemptive scoring
+constexpr int PreemptiveSubsetSize = 4096;
+//! Do not split the scoring on all points in chunks smaller than that
+constexpr int MinimumPointsPerThread = 1 << 16;
+}
+
+//-----------------------------------------------------------------------------
+RansacPlaneEstimator::RansacPlaneEstimator() = default;
+
+//-----------------------------------------------------------------------------
+template <typename T>
+void RansacPlaneEstimator::SetPoints(const T* xyz, int nbPoints)
+{
+  nbPoints = std::max(0, nbPoints);
+
+  // express the points relatively to the first one to keep the float
+  // precision for georeferenced clouds
+  for (int k = 0; k < 3; ++k)
+  {
+    this->Center[k] = nbPoints > 0 ? xyz[k] : 0.;
+  }
+  this->X.resize(nbPoints);
+  this->Y.resize(nbPoints);
+  this->Z.resize(nbPoints);
+  for (int i = 0; i < nbPoints; ++i)
+  {
+    this->X[i] = static_cast<float>(xyz[3 * i] - this->Center[0]);
+    this->Y[i] = static_cast<float>(xyz[3 * i + 1] - this->Center[1]);
+    this->Z[i] = static_cast<float>(xyz[3 * i + 2] - this->Center[2]);
+  }
+
+  // random subset of the points for the preemptive scoring
+  const int subsetSize = std::min(nbPoints, PreemptiveSubsetSize);
+  std::uniform_int_distribution<int> distribution(0, std::max(0, nbPoints - 1));
+  this->SubsetX.resize(subsetSize);
+  this->SubsetY.resize(subsetSize);
+  this->SubsetZ.resize(subsetSize);
+  for (int i = 0; i < subsetSize; ++i)
+  {
+    // all the points when there are few of them
+    const int index = subsetSize == nbPoints ? i : distribution(this->Generator);
+    this->SubsetX[i] = this->X[index];
+    this->SubsetY[i] = this->Y[index];
+    this->SubsetZ[i] = this->Z[index];
+  }
+  this->SubsetCursor = 0;
+}
+
+template void RansacPlaneEstimator::SetPoints<float>(const float*, int);
+template void RansacPlaneEstimator::SetPoints<double>(const double*, int);
+
+//-----------------------------------------------------------------------------
+int RansacPlaneEstimator::CountInliers(const float plane[4], const float* x, const float* y,
+                                       const float* z, int begin, int end) const
+{
+  // branchless so that it is vectorized
+  const float a = plane[0], b = plane[1], c = plane[2], d = plane[3];
+  const float threshold = static_cast<float>(this->Threshold);
+  int count = 0;
+  for (int i = begin; i < end; ++i)
+  {
+    count += std::abs(a * x[i] + b * y[i] + c * z[i] + d) < threshold;
+  }
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+int RansacPlaneEstimator::CountAllInliers(const float plane[4]) const
+{
+  std::atomic<int> count(0);
+  ParallelFor(0, this->GetNumberOfPoints(), [&](int begin, int end)
+  {
+    count += this->CountInliers(plane, this->X.data(), this->Y.data(), this->Z.data(), begin, end);
+  }, this->NumberOfThreads, MinimumPointsPerThread);
+  return count;
+}
+
+//-----------------------------------------------------------------------------
+bool RansacPlaneEstimator::SampleHypothesis(float plane[4])
+{
+  const int nbPoints = this->GetNumberOfPoints();
+  std::uniform_int_distribution<int> distribution(0, nbPoints - 1);
+  int i0 = distribution(this->Generator);
+  int i1 = distribution(this->Generator);
+  int i2 = distribution(this->Generator);
+  if (i0 == i1 || i0 == i2 || i1 == i2)
+  {
+    return false;
+  }
+
+  Eigen::Vector3f p0(this->X[i0], this->Y[i0], this->Z[i0]);
+  Eigen::Vector3f p1(this->X[i1], this->Y[i1], this->Z[i1]);
+  Eigen::Vector3f p2(this->X[i2], this->Y[i2], this->Z[i2]);
+  Eigen::Vector3f normal = (p2 - p0).cross(p1 - p0);
+  float norm = normal.norm();
+  if (!(norm > 1e-12f))
+  {
+    // aligned points
+    return false;
+  }
+  normal /= norm;
+  plane[0] = normal(0);
+  plane[1] = normal(1);
+  plane[2] = normal(2);
+  plane[3] = -normal.dot(p0);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool RansacPlaneEstimator::Estimate()
+{
+  this->NumberOfInliers = 0;
+  this->NumberOfIterations = 0;
+  this->Converged = false;
+  std::fill(this->BestPlane, this->BestPlane + 4, 0.f);
+  const int nbPoints = this->GetNumberOfPoints();
+  if (nbPoints < 3)
+  {
+    return false;
+  }
+
+  double requiredIterations = this->MaximumNumberOfIterations;
+  std::vector<std::array<float, 4>> hypotheses;
+  std::vector<int> scores;
+  std::vector<int> ranking;
+  while (this->NumberOfIterations < std::min<double>(requiredIterations, this->MaximumNumberOfIterations))
+  {
+    // Generate a batch of hypotheses
+    hypotheses.clear();
+    const unsigned int batchSize = std::min<unsigned int>(HypothesesPerBatch,
+                                                          this->MaximumNumberOfIterations - this->NumberOfIterations);
+    for (unsigned int k = 0; k < batchSize; ++k)
+    {
+      std::array<float, 4> plane;
+      if (this->SampleHypothesis(plane.data()))
+      {
+        hypotheses.push_back(plane);
+      }
+    }
+    this->NumberOfIterations += batchSize;
+    if (hypotheses.empty())
+    {
+      continue;
+    }
+
+    // Preemptive scoring: the hypotheses are scored on successive blocks of
+    // the random subset, the worst half being discarded after each block
+    scores.assign(hypotheses.size(), 0);
+    ranking.resize(hypotheses.size());
+    std::iota(ranking.begin(), ranking.end(), 0);
+    const int subsetSize = static_cast<int>(this->SubsetX.size());
+    int alive = static_cast<int>(hypotheses.size());
+    for (int block = 0; alive > 1 && block * PreemptiveBlockSize < subsetSize; ++block)
+    {
+      if (this->SubsetCursor >= subsetSize)
+      {
+        this->SubsetCursor = 0;
+      }
+      const int begin = this->SubsetCursor;
+      const int end = std::min(begin + PreemptiveBlockSize, subsetSize);
+      this->SubsetCursor = end;
+      for (int k = 0; k < alive; ++k)
+      {
+        scores[ranking[k]] += this->CountInliers(hypotheses[ranking[k]].data(), this->SubsetX.data(),
+                                                 this->SubsetY.data(), this->SubsetZ.data(), begin, end);
+      }
+      std::sort(ranking.begin(), ranking.begin() + alive,
+                [&scores](int a, int b) { return scores[a] > scores[b]; });
+      alive = (alive + 1) / 2;
+    }
+
+    // Score the remaining hypothesis on all points
+    const std::array<float, 4>& candidate = hypotheses[ranking[0]];
+    const unsigned int nbInliers = static_cast<unsigned int>(this->CountAllInliers(candidate.data()));
+    if (nbInliers > this->NumberOfInliers)
+    {
+      this->NumberOfInliers = nbInliers;
+      std::copy(candidate.begin(), candidate.end(), this->BestPlane);
+
+      // Adapt the number of hypotheses to the best inlier ratio
+      const double inlierRatio = static_cast<double>(nbInliers) / nbPoints;
+      if (inlierRatio >= this->RequiredInlierRatio)
+      {
+        this->Converged = true;
+        break;
+      }
+      const double sampleWithoutOutlier = std::pow(inlierRatio, 3);
+      if (sampleWithoutOutlier >= 1.)
+      {
+        break;
+      }
+      requiredIterations = std::log(1. - this->Confidence) / std::log(1. - sampleWithoutOutlier);
+    }
+  }
+  return this->NumberOfInliers > 0;
+}
+
+//-----------------------------------------------------------------------------
+void RansacPlaneEstimator::GetPlane(double plane[4]) const
+{
+  // go back from the coordinates relative to Center
+  for (int k = 0; k < 3; ++k)
+  {
+    plane[k] = this->BestPlane[k];
+  }
+  plane[3] = this->BestPlane[3] - (plane[0] * this->Center[0] + plane[1] * this->Center[1] + plane[2] * this->Center[2]);
+}
+
+//-----------------------------------------------------------------------------
+void RansacPlaneEstimator::GetRefinedPlane(double plane[4]) const
+{
+  // mean and covariance of the inliers
+  const float threshold = static_cast<float>(this->Threshold);
+  Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+  Eigen::Matrix3d sumOfSquares = Eigen::Matrix3d::Zero();
+  int count = 0;
+  for (int i = 0; i < this->GetNumberOfPoints(); ++i)
+  {
+    const float distance = this->BestPlane[0] * this->X[i] + this->BestPlane[1] * this->Y[i]
+                         + this->BestPlane[2] * this->Z[i] + this->BestPlane[3];
+    if (std::abs(distance) < threshold)
+    {
+      Eigen::Vector3d point(this->X[i], this->Y[i], this->Z[i]);
+      sum += point;
+      sumOfSquares += point * point.transpose();
+      ++count;
+    }
+  }
+  if (count < 3)
+  {
+    this->GetPlane(plane);
+    return;
+  }
+  Eigen::Vector3d center = sum / count;
+  Eigen::Matrix3d varianceCovariance = sumOfSquares / count - center * center.transpose();
+
+  // the normal is the eigen vector of the smallest eigen value
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eigenSolver(varianceCovariance);
+  Eigen::Vector3d normal = eigenSolver.eigenvectors().col(0);
+  center += Eigen::Vector3d(this->Center[0], this->Center[1], this->Center[2]);
+  plane[0] = normal(0);
+  plane[1] = normal(1);
+  plane[2] = normal(2);
+  plane[3] = -normal.dot(center);
+}
+
+//-----------------------------------------------------------------------------
+std::vector<char> RansacPlaneEstimator::GetInliers() const
+{
+  const float threshold = static_cast<float>(this->Threshold);
+  std::vector<char> isInlier(this->GetNumberOfPoints(), 0);
+  for (int i = 0; i < this->GetNumberOfPoints(); ++i)
+  {
+    const float distance = this->BestPlane[0] * this->X[i] + this->BestPlane[1] * this->Y[i]
+                         + this->BestPlane[2] * this->Z[i] + this->BestPlane[3];
+    isInlier[i] = std::abs(distance) < threshold;
+  }
+  return isInlier;
+}
@@ -0,0 +1,129 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef RANSAC_PLANE_ESTIMATOR_H
+#define RANSAC_PLANE_ESTIMATOR_H
+
+// STD
+#include <random>
+#include <vector>
+
+/**
+ * @brief RansacPlaneEstimator fit a plane to a point cloud with a preemptive
+ *        RANSAC and an adaptive number of iterations.
+ *
+ * The points are copied once as three contiguous float arrays, so that the
+ * point-plane distance loop can be vectorized by the compiler.
+ *
+ * The hypotheses are generated by batches. The hypotheses of a batch are
+ * first scored on successive blocks of a random subset of the points, keeping
+ * only the best half after each block (preemptive RANSAC), and only the last
+ * remaining one is scored on all points (in parallel for large clouds).
+ *
+ * The number of hypotheses is adapted to the best inlier ratio w found so far:
+ * the search stops once log(1 - Confidence) / log(1 - w^3) hypotheses have
+ * been generated, when w reaches RequiredInlierRatio, or after
+ * MaximumNumberOfIterations hypotheses.
+ */
+class RansacPlaneEstimator
+{
+public:
+  RansacPlaneEstimator();
+
+  /**
+   * @brief SetPoints copy the points to fit
+   * @param xyz coordinates of the points, x y z contiguous for each point
+   * @param nbPoints number of points
+   */
+  template <typename T>
+  void SetPoints(const T* xyz, int nbPoints);
+
+  int GetNumberOfPoints() const { return static_cast<int>(this->X.size()); }
+
+  //! Distance to the plane under which a point is an inlier
+  void SetThreshold(double threshold) { this->Threshold = threshold; }
+  double GetThreshold() const { return this->Threshold; }
+
+  //! Probability to have drawn at least one sample without outliers when stopping
+  void SetConfidence(double confidence) { this->Confidence = confidence; }
+  double GetConfidence() const { return this->Confidence; }
+
+  //! Maximum number of hypotheses
+  void SetMaximumNumberOfIterations(unsigned int iterations) { this->MaximumNumberOfIterations = iterations; }
+  unsigned int GetMaximumNumberOfIterations() const { return this->MaximumNumberOfIterations; }
+
+  //! Ratio of inliers from which the search stops immediately
+  void SetRequiredInlierRatio(double ratio) { this->RequiredInlierRatio = ratio; }
+  double GetRequiredInlierRatio() const { return this->RequiredInlierRatio; }
+
+  //! Maximum number of threads to score the hypotheses, 0 means one per hardware core
+  void SetNumberOfThreads(unsigned int numberOfThreads) { this->NumberOfThreads = numberOfThreads; }
+  unsigned int GetNumberOfThreads() const { return this->NumberOfThreads; }
+
+  /**
+   * @brief Estimate search the plane with the most inliers
+   * @return false if there are not enough points to define a plane
+   */
+  bool Estimate();
+
+  /**
+   * @brief GetPlane plane of the best hypothesis, defined by the three points
+   *        sampled: unit normal (a, b, c) and d with ax + by + cz + d = 0
+   */
+  void GetPlane(double plane[4]) const;
+
+  /**
+   * @brief GetRefinedPlane least squares plane of the inliers of the best
+   *        hypothesis, same convention as GetPlane
+   */
+  void GetRefinedPlane(double plane[4]) const;
+
+  //! Inlier flag of each point for the best hypothesis, in the order given to SetPoints
+  std::vector<char> GetInliers() const;
+
+  unsigned int GetNumberOfInliers() const { return this->NumberOfInliers; }
+  unsigned int GetNumberOfIterations() const { return this->NumberOfIterations; }
+
+  //! True if the search has stopped because RequiredInlierRatio was reached
+  bool HasConverged() const { return this->Converged; }
+
+private:
+  int CountInliers(const float plane[4], const float* x, const float* y, const float* z,
+                   int begin, int end) const;
+  int CountAllInliers(const float plane[4]) const;
+  bool SampleHypothesis(float plane[4]);
+
+  // coordinates relative to Center
+  std::vector<float> X, Y, Z;
+  double Center[3] = {0., 0., 0.};
+  // random subset of the points, and the start of its next block
+  std::vector<float> SubsetX, SubsetY, SubsetZ;
+  int SubsetCursor = 0;
+
+  double Threshold = 0.5;
+  double Confidence = 0.99;
+  unsigned int MaximumNumberOfIterations = 500;
+  double RequiredInlierRatio = 1.;
+  unsigned int NumberOfThreads = 0;
+
+  std::mt19937 Generator;
+
+  // best hypothesis, relative to Center
+  float BestPlane[4] = {0.f, 0.f, 0.f, 0.f};
+  unsigned int NumberOfInliers = 0;
+  unsigned int NumberOfIterations = 0;
+  bool Converged = false;
+};
+
+#endif // RANSAC_PLANE_ESTIMATOR_H
@@ -37,6 +37,11 @@ public:
   vtkGetMacro(RatioInliersRequired, double)
   vtkSetMacro(RatioInliersRequired, double)
 
+  /// Get/Set the probability to have drawn a sample without outliers before
+  /// stopping the ransac algorithm loop
+  vtkGetMacro(Confidence, double)
+  vtkSetMacro(Confidence, double)
+
   /// Get/Set the plane fitted parameters
   vtkGetVector4Macro(PlaneParam, double)
   vtkSetVector4Macro(PlaneParam, double)
@@ -75,6 +80,9 @@ private:
   /// ratio of inliers required to break the ransac algorithm loop
   double RatioInliersRequired = 0.3;
 
+  /// probability to have drawn a sample without outliers before stopping
+  double Confidence = 0.99;
+
   /// plane fitted parameters
   double PlaneParam[4] = {0, 0, 0, 0};
 
@@ -0,0 +1,414 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "PoseSolver.h"
+#include "ParallelFor.h"
+
+// STD
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <sstream>
+
+// EIGEN
+#include <Eigen/StdVector>
+
+namespace
+{
+//! Number of residuals accumulated in the same partial normal equations.
+//! The partial sums are added in a fixed order, so the result does not
+//! depend on the number of threads
+constexpr int ResidualsPerBlock = 256;
+//! Do not split the accumulation in chunks smaller than that
+constexpr int MinimumBlocksPerThread = 4;
+
+// Same defaults as ceres::Solver::Options
+constexpr double InitialTrustRegionRadius = 1e4;
+constexpr double MaxTrustRegionRadius = 1e16;
+constexpr double MinTrustRegionRadius = 1e-32;
+constexpr double MinLMDiagonal = 1e-6;
+constexpr double MaxLMDiagonal = 1e32;
+constexpr double MinRelativeDecrease = 1e-3;
+constexpr double FunctionTolerance = 1e-6;
+constexpr double GradientTolerance = 1e-10;
+constexpr double ParameterTolerance = 1e-8;
+// Same default as ceres::Covariance::Options
+constexpr double MinReciprocalConditionNumber = 1e-14;
+
+//-----------------------------------------------------------------------------
+//! Normal equations H * dx = -g of the IRLS problem, and the robust cost
+template <int N>
+struct NormalEquations
+{
+  Eigen::Matrix<double, N, N> H;
+  Eigen::Matrix<double, N, 1> g;
+  double Cost;
+
+  void SetZero()
+  {
+    this->H.setZero();
+    this->g.setZero();
+    this->Cost = 0.;
+  }
+
+  void Add(const NormalEquations<N>& other)
+  {
+    this->H += other.H;
+    this->g += other.g;
+    this->Cost += other.Cost;
+  }
+
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+//-----------------------------------------------------------------------------
+//! Unit quaternion (w, x, y, z) of R = Rz * Ry * Rx and its derivatives
+//! with respect to (rx, ry, rz)
+void EulerToQuaternion(const double* angles, Eigen::Vector4d& q, Eigen::Matrix<double, 4, 3>& dq)
+{
+  const double cx = std::cos(0.5 * angles[0]), sx = std::sin(0.5 * angles[0]);
+  const double cy = std::cos(0.5 * angles[1]), sy = std::sin(0.5 * angles[1]);
+  const double cz = std::cos(0.5 * angles[2]), sz = std::sin(0.5 * angles[2]);
+
+  q << cx * cy * cz + sx * sy * sz,
+       sx * cy * cz - cx * sy * sz,
+       cx * sy * cz + sx * cy * sz,
+       cx * cy * sz - sx * sy * cz;
+
+  dq << -sx * cy * cz + cx * sy * sz, -cx * sy * cz + sx * cy * sz, -cx * cy * sz + sx * sy * cz,
+         cx * cy * cz + sx * sy * sz, -sx * sy * cz - cx * cy * sz, -sx * cy * sz - cx * sy * cz,
+        -sx * sy * cz + cx * cy * sz,  cx * cy * cz - sx * sy * sz, -cx * sy * sz + sx * cy * cz,
+        -sx * cy * sz - cx * sy * cz, -cx * sy * sz - sx * cy * cz,  cx * cy * cz + sx * sy * sz;
+  dq *= 0.5;
+}
+
+//-----------------------------------------------------------------------------
+//! Rigid transform Y = R * X + T applied to all the keypoints
+class IsometryModel
+{
+public:
+  static constexpr int Size = 6;
+
+  explicit IsometryModel(const std::vector<Eigen::Vector3d>& X)
+    : X(X)
+  {
+  }
+
+  void Prepare(const double* w)
+  {
+    const double crx = std::cos(w[0]), srx = std::sin(w[0]);
+    const double cry = std::cos(w[1]), sry = std::sin(w[1]);
+    const double crz = std::cos(w[2]), srz = std::sin(w[2]);
+    Eigen::Matrix3d Rx, Ry, Rz, dRx, dRy, dRz;
+    Rx << 1., 0., 0., 0., crx, -srx, 0., srx, crx;
+    Ry << cry, 0., sry, 0., 1., 0., -sry, 0., cry;
+    Rz << crz, -srz, 0., srz, crz, 0., 0., 0., 1.;
+    dRx << 0., 0., 0., 0., -srx, -crx, 0., crx, -srx;
+    dRy << -sry, 0., cry, 0., 0., 0., -cry, 0., -sry;
+    dRz << -srz, -crz, 0., crz, -srz, 0., 0., 0., 0.;
+
+    this->R = Rz * Ry * Rx;
+    this->dR[0] = Rz * Ry * dRx;
+    this->dR[1] = Rz * dRy * Rx;
+    this->dR[2] = dRz * Ry * Rx;
+    this->T << w[3], w[4], w[5];
+  }
+
+  void Evaluate(int k, Eigen::Vector3d& Y, Eigen::Matrix<double, 3, Size>& J) const
+  {
+    const Eigen::Vector3d& x = this->X[k];
+    Y.noalias() = this->R * x;
+    Y += this->T;
+    for (int i = 0; i < 3; ++i)
+    {
+      J.col(i).noalias() = this->dR[i] * x;
+    }
+    J.rightCols<3>().setIdentity();
+  }
+
+private:
+  const std::vector<Eigen::Vector3d>& X;
+  Eigen::Matrix3d R;
+  Eigen::Matrix3d dR[3];
+  Eigen::Vector3d T;
+};
+
+//-----------------------------------------------------------------------------
+//! Transform interpolated between (R0, T0) and (R1, T1) at the acquisition
+//! time of each keypoint, SLERP for the rotation and linear interpolation for
+//! the translation, as in LinearTransformInterpolation
+class InterpolatedMotionModel
+{
+public:
+  static constexpr int Size = 12;
+
+  InterpolatedMotionModel(const std::vector<Eigen::Vector3d>& X, const std::vector<double>& times)
+    : X(X), Times(times)
+  {
+  }
+
+  void Prepare(const double* w)
+  {
+    EulerToQuaternion(w, this->Q0, this->dQ0);
+    EulerToQuaternion(w + 6, this->Q1, this->dQ1);
+    this->T0 << w[3], w[4], w[5];
+    this->T1 << w[9], w[10], w[11];
+
+    // Take the shortest path
+    double dot = this->Q0.dot(this->Q1);
+    if (dot < 0.)
+    {
+      dot = -dot;
+      this->Q1 = -this->Q1;
+      this->dQ1 = -this->dQ1;
+    }
+
+    // Same threshold as LinearTransformInterpolation to switch to a LERP
+    this->Lerp = (1. - dot) < 1e-6;
+    if (!this->Lerp)
+    {
+      this->Theta = std::acos(dot);
+      this->SinTheta = std::sin(this->Theta);
+      this->CosTheta = dot;
+      // dTheta / d(rx0, ry0, rz0, rx1, ry1, rz1)
+      const double dThetaDDot = -1. / this->SinTheta;
+      this->dTheta.head<3>() = dThetaDDot * (this->Q1.transpose() * this->dQ0).transpose();
+      this->dTheta.tail<3>() = dThetaDDot * (this->Q0.transpose() * this->dQ1).transpose();
+    }
+  }
+
+  void Evaluate(int k, Eigen::Vector3d& Y, Eigen::Matrix<double, 3, Size>& J) const
+  {
+    const Eigen::Vector3d& x = this->X[k];
+    const double s = this->Times[k];
+
+    // Interpolated quaternion and its derivatives wrt the 6 angles
+    Eigen::Matrix<double, 4, 6> dq;
+    double t1 = 1. - s, t2 = s;
+    if (this->Lerp)
+    {
+      dq.leftCols<3>() = t1 * this->dQ0;
+      dq.rightCols<3>() = t2 * this->dQ1;
+    }
+    else
+    {
+      const double a = (1. - s) * this->Theta;
+      const double b = s * this->Theta;
+      t1 = std::sin(a) / this->SinTheta;
+      t2 = std::sin(b) / this->SinTheta;
+      const double dt1 = ((1. - s) * std::cos(a) - t1 * this->CosTheta) / this->SinTheta;
+      const double dt2 = (s * std::cos(b) - t2 * this->CosTheta) / this->SinTheta;
+      dq.leftCols<3>() = t1 * this->dQ0;
+      dq.rightCols<3>() = t2 * this->dQ1;
+      dq.noalias() += (dt1 * this->Q0 + dt2 * this->Q1) * this->dTheta.transpose();
+    }
+    const Eigen::Vector4d q = t1 * this->Q0 + t2 * this->Q1;
+
+    // Rotate X with the normalized quaternion u = (w, v):
+    // R * X = X + 2w (v x X) + 2 v x (v x X)
+    const double norm = q.norm();
+    const Eigen::Vector4d u = q / norm;
+    const double uw = u(0);
+    const Eigen::Vector3d v = u.tail<3>();
+    const Eigen::Vector3d vx = v.cross(x);
+    Y = x + 2. * uw * vx + 2. * v.cross(vx);
+
+    Eigen::Matrix3d skewX;
+    skewX << 0., -x(2), x(1), x(2), 0., -x(0), -x(1), x(0), 0.;
+    Eigen::Matrix<double, 3, 4> dRXdu;
+    dRXdu.col(0) = 2. * vx;
+    dRXdu.rightCols<3>() = -2. * uw * skewX
+                           + 2. * (v.dot(x) * Eigen::Matrix3d::Identity() + v * x.transpose() - 2. * x * v.transpose());
+    const Eigen::Matrix4d dudq = (Eigen::Matrix4d::Identity() - u * u.transpose()) / norm;
+    const Eigen::Matrix<double, 3, 6> dRX = dRXdu * dudq * dq;
+
+    Y += (1. - s) * this->T0 + s * this->T1;
+    J.block<3, 3>(0, 0) = dRX.leftCols<3>();
+    J.block<3, 3>(0, 3) = (1. - s) * Eigen::Matrix3d::Identity();
+    J.block<3, 3>(0, 6) = dRX.rightCols<3>();
+    J.block<3, 3>(0, 9) = s * Eigen::Matrix3d::Identity();
+  }
+
+private:
+  const std::vector<Eigen::Vector3d>& X;
+  const std::vector<double>& Times;
+  Eigen::Vector4d Q0, Q1;
+  Eigen::Matrix<double, 4, 3> dQ0, dQ1;
+  Eigen::Vector3d T0, T1;
+  bool Lerp = true;
+  double Theta = 0., SinTheta = 0., CosTheta = 1.;
+  Eigen::Matrix<double, 6, 1> dTheta;
+};
+}
+
+//-----------------------------------------------------------------------------
+std::string PoseSolver::Summary::BriefReport() const
+{
+  std::ostringstream report;
+  report << "PoseSolver Report: Iterations: " << this->NumberOfIterations
+         << ", Initial cost: " << this->InitialCost
+         << ", Final cost: " << this->FinalCost
+         << ", Termination: " << (this->Converged ? "CONVERGENCE" : "NO_CONVERGENCE");
+  return report.str();
+}
+
+//-----------------------------------------------------------------------------
+PoseSolver::PoseSolver(const std::vector<Eigen::Matrix3d>& A, const std::vector<Eigen::Vector3d>& P,
+                       const std::vector<Eigen::Vector3d>& X, const std::vector<double>& coefficients)
+  : A(A), P(P), X(X), Coefficients(coefficients)
+{
+}
+
+//-----------------------------------------------------------------------------
+PoseSolver::Summary PoseSolver::SolveIsometry(double* parameters)
+{
+  IsometryModel model(this->X);
+  return this->Solve<IsometryModel::Size>(model, parameters);
+}
+
+//-----------------------------------------------------------------------------
+PoseSolver::Summary PoseSolver::SolveInterpolatedMotion(const std::vector<double>& times, double* parameters)
+{
+  InterpolatedMotionModel model(this->X, times);
+  return this->Solve<InterpolatedMotionModel::Size>(model, parameters);
+}
+
+//-----------------------------------------------------------------------------
+Eigen::MatrixXd PoseSolver::GetCovariance() const
+{
+  Eigen::SelfAdjointEigenSolver<Eigen::MatrixXd> eig(this->InformationMatrix);
+  if (eig.info() != Eigen::Success || this->InformationMatrix.size() == 0)
+  {
+    return Eigen::MatrixXd();
+  }
+  const double minEigenValue = std::max(MinReciprocalConditionNumber * eig.eigenvalues().maxCoeff(),
+                                        std::numeric_limits<double>::min());
+  const Eigen::VectorXd inverse = eig.eigenvalues().cwiseMax(minEigenValue).cwiseInverse();
+  return eig.eigenvectors() * inverse.asDiagonal() * eig.eigenvectors().transpose();
+}
+
+//-----------------------------------------------------------------------------
+template <int N, typename Model>
+PoseSolver::Summary PoseSolver::Solve(Model& model, double* parameters)
+{
+  using Vector = Eigen::Matrix<double, N, 1>;
+  using Matrix = Eigen::Matrix<double, N, N>;
+
+  Summary summary;
+  const int nbResiduals = static_cast<int>(this->X.size());
+  const int nbBlocks = (nbResiduals + ResidualsPerBlock - 1) / ResidualsPerBlock;
+  std::vector<NormalEquations<N>, Eigen::aligned_allocator<NormalEquations<N>>> partials(nbBlocks);
+  const double a = this->LossScale;
+
+  // Accumulate the IRLS normal equations at w. With s = c * Y^t * A * Y,
+  // the residual cost is 1/2 * c * rho(s) and its weight c^2 * rho'(s)
+  auto evaluate = [&](const Vector& w, NormalEquations<N>& result)
+  {
+    model.Prepare(w.data());
+    ParallelFor(0, nbBlocks, [&](int blockBegin, int blockEnd)
+    {
+      Eigen::Vector3d Y;
+      Eigen::Matrix<double, 3, N> J;
+      for (int block = blockBegin; block < blockEnd; ++block)
+      {
+        NormalEquations<N>& partial = partials[block];
+        partial.SetZero();
+        const int end = std::min((block + 1) * ResidualsPerBlock, nbResiduals);
+        for (int k = block * ResidualsPerBlock; k < end; ++k)
+        {
+          model.Evaluate(k, Y, J);
+          Y -= this->P[k];
+          const Eigen::Vector3d AY = this->A[k] * Y;
+          const double c = this->Coefficients[k];
+          const double s = c * Y.dot(AY);
+          const double weight = c * c / (1. + (s / a) * (s / a));
+          const Eigen::Matrix<double, N, 3> JtA = J.transpose() * this->A[k];
+          partial.Cost += 0.5 * c * a * std::atan2(s, a);
+          partial.g.noalias() += weight * (JtA * Y);
+          partial.H.noalias() += weight * (JtA * J);
+        }
+      }
+    }, this->NumberOfThreads, MinimumBlocksPerThread);
+
+    result.SetZero();
+    for (const NormalEquations<N>& partial : partials)
+    {
+      result.Add(partial);
+    }
+  };
+
+  Vector w = Eigen::Map<Vector>(parameters);
+  NormalEquations<N> current, candidate;
+  evaluate(w, current);
+  summary.InitialCost = current.Cost;
+  summary.NumberOfSuccessfulSteps = 1;
+
+  // Levenberg-Marquardt with the same trust region strategy as ceres
+  double radius = InitialTrustRegionRadius;
+  double decreaseFactor = 2.;
+  for (unsigned int iteration = 0; iteration < this->MaxIterations; ++iteration)
+  {
+    summary.NumberOfIterations = iteration + 1;
+    if (current.g.template lpNorm<Eigen::Infinity>() <= GradientTolerance)
+    {
+      summary.Converged = true;
+      break;
+    }
+
+    Matrix H = current.H;
+    H.diagonal() += current.H.diagonal().cwiseMax(MinLMDiagonal).cwiseMin(MaxLMDiagonal) / radius;
+    const Vector step = -H.ldlt().solve(current.g);
+    if (step.norm() <= ParameterTolerance * (w.norm() + ParameterTolerance))
+    {
+      summary.Converged = true;
+      break;
+    }
+
+    const Vector wCandidate = w + step;
+    evaluate(wCandidate, candidate);
+    const double modelDecrease = -(current.g.dot(step) + 0.5 * step.dot(current.H * step));
+    const double costDecrease = current.Cost - candidate.Cost;
+    const double relativeDecrease = costDecrease / modelDecrease;
+    if (modelDecrease > 0. && std::isfinite(candidate.Cost) && relativeDecrease > MinRelativeDecrease)
+    {
+      w = wCandidate;
+      std::swap(current, candidate);
+      ++summary.NumberOfSuccessfulSteps;
+      radius = std::min(MaxTrustRegionRadius,
+                        radius / std::max(1. / 3., 1. - std::pow(2. * relativeDecrease - 1., 3)));
+      decreaseFactor = 2.;
+      if (costDecrease <= FunctionTolerance * (current.Cost + costDecrease))
+      {
+        summary.Converged = true;
+        break;
+      }
+    }
+    else
+    {
+      radius /= decreaseFactor;
+      decreaseFactor *= 2.;
+      if (radius < MinTrustRegionRadius)
+      {
+        summary.Converged = true;
+        break;
+      }
+    }
+  }
+
+  summary.FinalCost = current.Cost;
+  this->InformationMatrix = current.H;
+  Eigen::Map<Vector> result(parameters);
+  result = w;
+  return summary;
+}
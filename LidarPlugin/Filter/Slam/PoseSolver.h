@@ -0,0 +1,122 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef POSE_SOLVER_H
+#define POSE_SOLVER_H
+
+// EIGEN
+#include <Eigen/Dense>
+
+// STD
+#include <string>
+#include <vector>
+
+/**
+ * @brief Robust Levenberg-Marquardt solver dedicated to the SLAM ICP problem.
+ *
+ * It minimizes the same cost as the ceres problems built from
+ * MahalanobisDistanceAffineIsometryResidual and
+ * MahalanobisDistanceInterpolatedMotionResidual wrapped in
+ * ScaledLoss(ArctanLoss(lossScale), coefficient):
+ *   cost = 1/2 * sum(c_k * rho(c_k * Y_k^t * A_k * Y_k))
+ * with Y_k = R * X_k + T - P_k and rho(s) = a * atan(s / a).
+ *
+ * The Jacobians are analytic and the normal equations are accumulated
+ * directly, in parallel over the residuals, the robust loss being handled
+ * with iteratively reweighted least squares. Nothing is allocated per residual.
+ */
+class PoseSolver
+{
+public:
+  struct Summary
+  {
+    //! Number of accepted steps. As in ceres::Solver::Summary, the initial
+    //! evaluation is counted, so 1 means that no step has been accepted
+    unsigned int NumberOfSuccessfulSteps = 0;
+    unsigned int NumberOfIterations = 0;
+    double InitialCost = 0.;
+    double FinalCost = 0.;
+    bool Converged = false;
+
+    std::string BriefReport() const;
+  };
+
+  /**
+   * @brief The matches are not copied: they must outlive the solver.
+   * @param A variance covariance matrix of the neighborhood of each match
+   * @param P point of the line / plane matched
+   * @param X keypoint to register
+   * @param coefficients weight of each residual (and scale of its loss)
+   */
+  PoseSolver(const std::vector<Eigen::Matrix3d>& A, const std::vector<Eigen::Vector3d>& P,
+             const std::vector<Eigen::Vector3d>& X, const std::vector<double>& coefficients);
+
+  void SetLossScale(double scale) { this->LossScale = scale; }
+  double GetLossScale() const { return this->LossScale; }
+
+  void SetMaxIterations(unsigned int iterations) { this->MaxIterations = iterations; }
+  unsigned int GetMaxIterations() const { return this->MaxIterations; }
+
+  //! 0 means one thread per hardware core
+  void SetNumberOfThreads(unsigned int threads) { this->NumberOfThreads = threads; }
+  unsigned int GetNumberOfThreads() const { return this->NumberOfThreads; }
+
+  /**
+   * @brief Estimate the isometry applied to all the keypoints
+   * @param parameters (rx, ry, rz, tx, ty, tz), R = Rz * Ry * Rx,
+   *        initial guess updated in place
+   */
+  Summary SolveIsometry(double* parameters);
+
+  /**
+   * @brief Estimate the poses at the beginning and at the end of the frame,
+   *        the pose of a keypoint acquired at time t in [0, 1] being
+   *        interpolated as in LinearTransformInterpolation
+   * @param times acquisition time of each keypoint
+   * @param parameters (rx0, ry0, rz0, tx0, ty0, tz0, rx1, ry1, rz1, tx1, ty1, tz1),
+   *        initial guess updated in place
+   */
+  Summary SolveInterpolatedMotion(const std::vector<double>& times, double* parameters);
+
+  /**
+   * @brief Normal matrix J^t * W * J of the robust problem at the solution
+   *        of the last Solve call. With a maximum number of iterations of 0,
+   *        Solve only evaluates it at the given parameters.
+   */
+  const Eigen::MatrixXd& GetInformationMatrix() const { return this->InformationMatrix; }
+
+  /**
+   * @brief Covariance of the parameters estimated by the last Solve call,
+   *        inverse of the information matrix. The directions that are not
+   *        constrained by the matches get a huge variance.
+   */
+  Eigen::MatrixXd GetCovariance() const;
+
+private:
+  template <int N, typename Model>
+  Summary Solve(Model& model, double* parameters);
+
+  const std::vector<Eigen::Matrix3d>& A;
+  const std::vector<Eigen::Vector3d>& P;
+  const std::vector<Eigen::Vector3d>& X;
+  const std::vector<double>& Coefficients;
+
+  double LossScale = 1.0;
+  unsigned int MaxIterations = 15;
+  unsigned int NumberOfThreads = 0;
+
+  Eigen::MatrixXd InformationMatrix;
+};
+
+#endif // POSE_SOLVER_H
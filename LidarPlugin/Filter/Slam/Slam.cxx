@@ -71,12 +71,18 @@
 // LOCAL
 #include "Slam.h"
 #include "CeresCostFunctions.h"
+#include "PoseSolver.h"
+#include "SlamMapFile.h"
 #include "vtkEigenTools.h"
 // STD
 #include <sstream>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
-#include <ctime>
+#include <cstring>
+#include <fstream>
+// BOOST
+#include <boost/iostreams/device/mapped_file.hpp>
 // EIGEN
 #include <Eigen/Dense>
 // PCL
@@ -97,20 +103,21 @@ Eigen::Matrix3d GetRotationMatrix(Eigen::Matrix<double, 6, 1> T)
 }
 
 //-----------------------------------------------------------------------------
-std::clock_t startTime;
+std::chrono::steady_clock::time_point startTime;
 
 //-----------------------------------------------------------------------------
 void InitTime()
 {
-  startTime = std::clock();
+  startTime = std::chrono::steady_clock::now();
 }
 
 //-----------------------------------------------------------------------------
-void StopTimeAndDisplay(std::string functionName)
+double StopTimeAndDisplay(std::string functionName)
 {
-  std::clock_t endTime = std::clock();
-  double dt = static_cast<double>(endTime - startTime) / CLOCKS_PER_SEC;
-  std::cout << "  -time elapsed in function <" << functionName << "> : " << dt << " sec" << std::endl;
+  // wall-clock time, as the CPU time would sum up the threads of ceres
+  std::chrono::duration<double> dt = std::chrono::steady_clock::now() - startTime;
+  std::cout << "  -time elapsed in function <" << functionName << "> : " << dt.count() << " sec" << std::endl;
+  return dt.count();
 }
 
 //-----------------------------------------------------------------------------
@@ -118,6 +125,34 @@ double Rad2Deg(double val)
 {
   return val / M_PI * 180;
 }
+
+//-----------------------------------------------------------------------------
+// Build the ceres problem equivalent to the one solved by PoseSolver.
+// Used by the ceres reference solver and to compute the covariance
+void AddICPResiduals(ceres::Problem& problem,
+                     const std::vector<Eigen::Matrix3d>& Avalues, const std::vector<Eigen::Vector3d>& Pvalues,
+                     const std::vector<Eigen::Vector3d>& Xvalues, const std::vector<double>& residualCoefficient,
+                     const std::vector<double>& TimeValues, bool undistortion, double lossScale, double* parameters)
+{
+  for (unsigned int k = 0; k < Xvalues.size(); ++k)
+  {
+    if (undistortion)
+    {
+      ceres::CostFunction* cost_function = new ceres::AutoDiffCostFunction<CostFunctions::MahalanobisDistanceInterpolatedMotionResidual, 1, 12>(
+                                           new CostFunctions::MahalanobisDistanceInterpolatedMotionResidual(
+                                              Avalues[k], Pvalues[k], Xvalues[k], TimeValues[k], residualCoefficient[k]));
+      problem.AddResidualBlock(cost_function, new ceres::ScaledLoss(new ceres::ArctanLoss(lossScale), residualCoefficient[k],
+                                                                    ceres::TAKE_OWNERSHIP), parameters);
+    }
+    else
+    {
+      ceres::CostFunction* cost_function = new ceres::AutoDiffCostFunction<CostFunctions::MahalanobisDistanceAffineIsometryResidual, 1, 6>(
+                                           new CostFunctions::MahalanobisDistanceAffineIsometryResidual(Avalues[k], Pvalues[k],
+                                                                                                        Xvalues[k], residualCoefficient[k]));
+      problem.AddResidualBlock(cost_function, new ceres::ScaledLoss(new ceres::ArctanLoss(lossScale), residualCoefficient[k], ceres::TAKE_OWNERSHIP), parameters);
+    }
+  }
+}
 }
 
 // The map reconstructed from the slam algorithm is stored in a voxel grid
@@ -374,6 +409,87 @@ public:
     }
   }
 
+  // save the parameters, the position and the points of the grid,
+  // the points being sorted by voxel
+  void Save(SlamMapFile::GridHeader& header, std::vector<SlamMapFile::VoxelRecord>& voxels,
+            std::vector<SlamMapFile::PointRecord>& points) const
+  {
+    header.VoxelSize = this->VoxelSize;
+    header.PointCloudSize = this->PointCloudSize;
+    std::copy(this->VoxelGridPosition, this->VoxelGridPosition + 3, header.VoxelGridPosition);
+    header.VoxelResolution = this->VoxelResolution;
+    header.LeafSize = this->LeafSize;
+
+    voxels.clear();
+    points.clear();
+    for (int i = 0; i < this->VoxelSize; i++)
+    {
+      for (int j = 0; j < this->VoxelSize; j++)
+      {
+        for (int k = 0; k < this->VoxelSize; k++)
+        {
+          const pcl::PointCloud<Slam::Point>& voxel = *this->grid[i][j][k];
+          if (voxel.empty())
+          {
+            continue;
+          }
+          voxels.push_back({ static_cast<uint32_t>((i * this->VoxelSize + j) * this->VoxelSize + k),
+                             static_cast<uint32_t>(voxel.size()) });
+          for (const Slam::Point& p : voxel.points)
+          {
+            points.push_back({ p.x, p.y, p.z, p.intensity, p.laserId, 0, p.time });
+          }
+        }
+      }
+    }
+    header.NumberOfVoxels = voxels.size();
+    header.NumberOfPoints = points.size();
+  }
+
+  // restore a grid saved with Save, return false if the data are not consistent
+  bool Load(const SlamMapFile::GridHeader& header, const SlamMapFile::VoxelRecord* voxels,
+            const SlamMapFile::PointRecord* points)
+  {
+    if (header.VoxelSize <= 0 || header.VoxelSize > 1024)
+    {
+      return false;
+    }
+    this->SetResolution(header.VoxelResolution);
+    this->SetLeafSize(header.LeafSize);
+    this->SetSize(header.VoxelSize);
+    this->PointCloudSize = header.PointCloudSize;
+    std::copy(header.VoxelGridPosition, header.VoxelGridPosition + 3, this->VoxelGridPosition);
+
+    const uint64_t nbVoxels = static_cast<uint64_t>(this->VoxelSize) * this->VoxelSize * this->VoxelSize;
+    uint64_t offset = 0;
+    for (uint32_t v = 0; v < header.NumberOfVoxels; ++v)
+    {
+      const SlamMapFile::VoxelRecord& record = voxels[v];
+      if (record.Index >= nbVoxels || offset + record.NumberOfPoints > header.NumberOfPoints)
+      {
+        return false;
+      }
+      const int k = record.Index % this->VoxelSize;
+      const int j = (record.Index / this->VoxelSize) % this->VoxelSize;
+      const int i = record.Index / (this->VoxelSize * this->VoxelSize);
+      pcl::PointCloud<Slam::Point>& voxel = *this->grid[i][j][k];
+      voxel.reserve(voxel.size() + record.NumberOfPoints);
+      for (uint32_t l = 0; l < record.NumberOfPoints; ++l)
+      {
+        const SlamMapFile::PointRecord& point = points[offset + l];
+        Slam::Point p;
+        p.x = point.X;
+        p.y = point.Y;
+        p.z = point.Z;
+        p.intensity = point.Intensity;
+        p.laserId = point.LaserId;
+        p.time = point.Time;
+        voxel.push_back(p);
+      }
+      offset += record.NumberOfPoints;
+    }
+    return offset == header.NumberOfPoints;
+  }
 
   void SetPointCoudMaxRange(const double maxdist)
   {
@@ -444,6 +560,7 @@ void Slam::Reset()
   this->BlobsPointsLocalMap->SetSize(50);
 
   this->NbrFrameProcessed = 0;
+  this->MapLoaded = false;
 
   // n-DoF parameters
   this->Tworld = Eigen::Matrix<double, 6, 1>::Zero();
@@ -491,9 +608,159 @@ std::unordered_map<std::string, double> Slam::GetDebugInformation()
   map["Mapping: planes used"] = this->MappingPlanesPointsUsed;
   map["Mapping: blobs used"] = this->MappingBlobsPointsUsed;
   map["Mapping: variance error"] = this->MappingVarianceError;
+  map["Mapping: matches used"] = this->MappingMatchesUsed;
+  for (int i = 0; i < 6; ++i)
+  {
+    map["Mapping: variance eigen value " + std::to_string(i)] = this->MappingVarianceEigenValues(i);
+    map["Mapping: max variance direction " + std::to_string(i)] = this->MappingMaxVarianceDirection(i);
+  }
   return map;
 }
 
+//-----------------------------------------------------------------------------
+std::unordered_map<std::string, double> Slam::GetStageTimings()
+{
+  return this->StageTimings;
+}
+
+//-----------------------------------------------------------------------------
+bool Slam::SaveMap(const std::string& filename) const
+{
+  SlamMapFile::FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::copy(SlamMapFile::Magic, SlamMapFile::Magic + 8, header.Magic);
+  header.Version = SlamMapFile::Version;
+  header.NumberOfGrids = SlamMapFile::NumberOfGrids;
+  header.NumberOfPoses = this->Trajectory.size();
+  std::copy(this->Tworld.data(), this->Tworld.data() + 6, header.Tworld);
+  std::copy(this->MotionParametersMapping.data(), this->MotionParametersMapping.data() + 12,
+            header.MotionParametersMapping);
+
+  const RollingGrid* grids[SlamMapFile::NumberOfGrids] = {
+    this->EdgesPointsLocalMap.get(), this->PlanarPointsLocalMap.get(), this->BlobsPointsLocalMap.get() };
+  std::vector<SlamMapFile::VoxelRecord> voxels[SlamMapFile::NumberOfGrids];
+  std::vector<SlamMapFile::PointRecord> points[SlamMapFile::NumberOfGrids];
+  for (unsigned int g = 0; g < SlamMapFile::NumberOfGrids; ++g)
+  {
+    grids[g]->Save(header.Grids[g], voxels[g], points[g]);
+  }
+
+  std::vector<SlamMapFile::PoseRecord> poses;
+  poses.reserve(this->Trajectory.size());
+  for (const Transform& transform : this->Trajectory)
+  {
+    poses.push_back({ transform.time,
+                      { transform.position[0], transform.position[1], transform.position[2] },
+                      { transform.orientation[0], transform.orientation[1], transform.orientation[2] } });
+  }
+
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  file.write(reinterpret_cast<const char*>(poses.data()), poses.size() * sizeof(SlamMapFile::PoseRecord));
+  for (unsigned int g = 0; g < SlamMapFile::NumberOfGrids; ++g)
+  {
+    file.write(reinterpret_cast<const char*>(voxels[g].data()), voxels[g].size() * sizeof(SlamMapFile::VoxelRecord));
+    file.write(reinterpret_cast<const char*>(points[g].data()), points[g].size() * sizeof(SlamMapFile::PointRecord));
+  }
+  if (!file)
+  {
+    std::cerr << "Could not write the SLAM map to " << filename << std::endl;
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool Slam::LoadMap(const std::string& filename, bool resume)
+{
+  boost::iostreams::mapped_file_source file;
+  try
+  {
+    file.open(filename);
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "Could not open the SLAM map " << filename << ": " << e.what() << std::endl;
+    return false;
+  }
+
+  // Check the layout before reading anything in place
+  const char* data = file.data();
+  const size_t size = file.size();
+  SlamMapFile::FileHeader header;
+  if (size < sizeof(header))
+  {
+    std::cerr << filename << " is not a SLAM map" << std::endl;
+    return false;
+  }
+  std::memcpy(&header, data, sizeof(header));
+  if (!std::equal(SlamMapFile::Magic, SlamMapFile::Magic + 8, header.Magic) ||
+      header.Version != SlamMapFile::Version || header.NumberOfGrids != SlamMapFile::NumberOfGrids)
+  {
+    std::cerr << filename << " is not a SLAM map, or was written by an incompatible version" << std::endl;
+    return false;
+  }
+  uint64_t expectedSize = sizeof(header) + header.NumberOfPoses * sizeof(SlamMapFile::PoseRecord);
+  for (const SlamMapFile::GridHeader& grid : header.Grids)
+  {
+    expectedSize += grid.NumberOfVoxels * sizeof(SlamMapFile::VoxelRecord)
+                    + grid.NumberOfPoints * sizeof(SlamMapFile::PointRecord);
+  }
+  if (expectedSize != size)
+  {
+    std::cerr << "The SLAM map " << filename << " is truncated or corrupted" << std::endl;
+    return false;
+  }
+
+  // The mapping is page aligned and all records are multiples of 8 bytes
+  const char* cursor = data + sizeof(header);
+  auto poses = reinterpret_cast<const SlamMapFile::PoseRecord*>(cursor);
+  cursor += header.NumberOfPoses * sizeof(SlamMapFile::PoseRecord);
+  std::shared_ptr<RollingGrid> grids[SlamMapFile::NumberOfGrids];
+  for (unsigned int g = 0; g < SlamMapFile::NumberOfGrids; ++g)
+  {
+    const SlamMapFile::GridHeader& gridHeader = header.Grids[g];
+    auto voxels = reinterpret_cast<const SlamMapFile::VoxelRecord*>(cursor);
+    cursor += gridHeader.NumberOfVoxels * sizeof(SlamMapFile::VoxelRecord);
+    auto points = reinterpret_cast<const SlamMapFile::PointRecord*>(cursor);
+    cursor += gridHeader.NumberOfPoints * sizeof(SlamMapFile::PointRecord);
+    grids[g] = std::make_shared<RollingGrid>();
+    if (!grids[g]->Load(gridHeader, voxels, points))
+    {
+      std::cerr << "The SLAM map " << filename << " is corrupted" << std::endl;
+      return false;
+    }
+  }
+
+  this->EdgesPointsLocalMap = grids[0];
+  this->PlanarPointsLocalMap = grids[1];
+  this->BlobsPointsLocalMap = grids[2];
+  this->Trajectory.clear();
+  this->TworldList.clear();
+  this->Tworld = Eigen::Matrix<double, 6, 1>::Zero();
+  this->MotionParametersMapping = Eigen::VectorXd::Zero(12, 1);
+  if (resume)
+  {
+    for (uint64_t i = 0; i < header.NumberOfPoses; ++i)
+    {
+      Transform transform;
+      transform.time = poses[i].Time;
+      std::copy(poses[i].Position, poses[i].Position + 3, transform.position);
+      std::copy(poses[i].Orientation, poses[i].Orientation + 3, transform.orientation);
+      this->Trajectory.push_back(transform);
+    }
+    std::copy(header.Tworld, header.Tworld + 6, this->Tworld.data());
+    std::copy(header.MotionParametersMapping, header.MotionParametersMapping + 12,
+              this->MotionParametersMapping.data());
+  }
+  this->PreviousTworld = this->Tworld;
+  this->Trelative = Eigen::Matrix<double, 6, 1>::Zero();
+  this->MotionParametersEgoMotion = Eigen::VectorXd::Zero(12, 1);
+  this->NbrFrameProcessed = 0;
+  this->MapLoaded = true;
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 pcl::PointCloud<PointXYZTIId>::Ptr Slam::GetEdgesMap()
 {
@@ -521,24 +788,53 @@ void Slam::AddFrame(pcl::PointCloud<Slam::Point>::Ptr pc, std::vector<size_t> la
     return;
   }
 
+  // Compute the edges and planars keypoints
+  InitTime();
+  FrameKeypoints keypoints = ExtractKeypoints(*this->KeyPointsExtractor, pc, laserIdMapping);
+  double extractionTime = StopTimeAndDisplay("Keypoints extraction");
+
+  this->AddKeypoints(keypoints);
+  this->StageTimings["Keypoints extraction"] = extractionTime;
+}
+
+//-----------------------------------------------------------------------------
+Slam::FrameKeypoints Slam::ExtractKeypoints(SpinningSensorKeypointExtractor& extractor,
+                                            pcl::PointCloud<Point>::Ptr pc,
+                                            const std::vector<size_t>& laserIdMapping)
+{
+  extractor.ComputeKeyPoints(pc, laserIdMapping);
+  FrameKeypoints keypoints;
+  keypoints.Time = pc->points[0].time;
+  keypoints.Edges = extractor.GetEdgePoints();
+  keypoints.Planars = extractor.GetPlanarPoints();
+  keypoints.Blobs = extractor.GetBlobPoints();
+  keypoints.NLasers = extractor.GetNLasers();
+  keypoints.FarestKeypointDist = extractor.GetFarestKeypointDist();
+  return keypoints;
+}
+
+//-----------------------------------------------------------------------------
+void Slam::AddKeypoints(const FrameKeypoints& keypoints)
+{
+  this->StageTimings.clear();
   std::cout << "#########################################################" << std::endl
             << "Processing frame : " << this->NbrFrameProcessed << std:: endl
             << "#########################################################" << std::endl
             << std::endl;
 
-  double time = pc->points[0].time;
+  double time = keypoints.Time;
+  this->CurrentEdgesPoints = keypoints.Edges;
+  this->CurrentPlanarsPoints = keypoints.Planars;
+  this->CurrentBlobsPoints = keypoints.Blobs;
+  this->NLasers = keypoints.NLasers;
+  this->FarestKeypointDist = keypoints.FarestKeypointDist;
 
   // If the new frame is the first one we just add the
   // extracted keypoints into the map without running
-  // odometry and mapping steps
-  if (this->NbrFrameProcessed == 0)
+  // odometry and mapping steps. If a map has been loaded,
+  // the first frame is directly matched against it
+  if (this->NbrFrameProcessed == 0 && !this->MapLoaded)
   {
-    // Compute the edges and planars keypoints
-    this->KeyPointsExtractor->ComputeKeyPoints(pc, laserIdMapping);
-    this->CurrentEdgesPoints = this->KeyPointsExtractor->GetEdgePoints();
-    this->CurrentPlanarsPoints = this->KeyPointsExtractor->GetPlanarPoints();
-    this->CurrentBlobsPoints = this->KeyPointsExtractor->GetBlobPoints();
-
     // update map using tworld
     this->UpdateMapsUsingTworld();
 
@@ -550,30 +846,26 @@ void Slam::AddFrame(pcl::PointCloud<Slam::Point>::Ptr pc, std::vector<size_t> la
     return;
   }
 
-  // Compute the edges and planars keypoints
-  InitTime();
-  this->KeyPointsExtractor->ComputeKeyPoints(pc, laserIdMapping);
-  this->CurrentEdgesPoints = this->KeyPointsExtractor->GetEdgePoints();
-  this->CurrentPlanarsPoints = this->KeyPointsExtractor->GetPlanarPoints();
-  this->CurrentBlobsPoints = this->KeyPointsExtractor->GetBlobPoints();
-  StopTimeAndDisplay("Keypoints extraction");
-
-  // Perfom EgoMotion
-  InitTime();
-  this->ComputeEgoMotion();
-  StopTimeAndDisplay("Ego-Motion");
+  // Perfom EgoMotion. There is no previous frame to match
+  // the first frame with, when a map has been loaded
+  if (this->NbrFrameProcessed > 0)
+  {
+    InitTime();
+    this->ComputeEgoMotion();
+    this->StageTimings["Ego-Motion"] = StopTimeAndDisplay("Ego-Motion");
+  }
 
   // Transform the current keypoints to the
   // referential of the sensor at the end of
   // frame acquisition
   InitTime();
   //this->TransformCurrentKeypointsToEnd();
-  StopTimeAndDisplay("Undistortion");
+  this->StageTimings["Undistortion"] = StopTimeAndDisplay("Undistortion");
 
   // Perform Mapping
   InitTime();
   this->Mapping();
-  StopTimeAndDisplay("Mapping");
+  this->StageTimings["Mapping"] = StopTimeAndDisplay("Mapping");
 
   // Current keypoints become previous ones
   this->PreviousEdgesPoints = this->CurrentEdgesPoints;
@@ -1036,7 +1328,7 @@ void Slam::GetEgoMotionLineSpecificNeighbor(std::vector<int>& nearestValid, std:
   kdtreePreviousEdges.query(p, nearestSearch, nearestIndex.data(), nearestDist.data());
 
   // take the closest point
-  std::vector<int> idAlreadyTook(this->KeyPointsExtractor->GetNLasers(), 0);
+  std::vector<int> idAlreadyTook(this->NLasers, 0);
   Point closest = kdtreePreviousEdges.getInputCloud()->points[nearestIndex[0]];
   nearestValid.push_back(nearestIndex[0]);
   nearestValidDist.push_back(nearestDist[0]);
@@ -1048,7 +1340,7 @@ void Slam::GetEgoMotionLineSpecificNeighbor(std::vector<int>& nearestValid, std:
 
   // invalid all possible points from scan
   // lines that are too far from the closest one
-  for (int k = 0; k < this->KeyPointsExtractor->GetNLasers(); ++k)
+  for (int k = 0; k < this->NLasers; ++k)
   {
     if (std::abs(int(closest.laserId) - k) > 4.0)
     {
@@ -1259,42 +1551,41 @@ void Slam::ComputeEgoMotion()
     // We want to estimate our 6-DOF parameters using a non
     // linear least square minimization. The non linear part
     // comes from the Euler Angle parametrization of the rotation
-    // endomorphism of SO(3). To minimize it, we use CERES to perform
-    // the Levenberg-Marquardt algorithm.
-    ceres::Problem problem;
-    for (unsigned int k = 0; k < Xvalues.size(); ++k)
+    // endomorphism of SO(3). To minimize it, we use the
+    // Levenberg-Marquardt algorithm, with ceres as reference.
+    double* parameters = this->Undistortion ? this->MotionParametersEgoMotion.data() : this->Trelative.data();
+    unsigned int nbSuccessfulSteps = 0;
+    if (this->UseCeresSolver)
     {
-      if (this->Undistortion)
-      {
-        ceres::CostFunction* cost_function = new ceres::AutoDiffCostFunction<CostFunctions::MahalanobisDistanceInterpolatedMotionResidual, 1, 12>(
-                                             new CostFunctions::MahalanobisDistanceInterpolatedMotionResidual(
-                                                this->Avalues[k], this->Pvalues[k], this->Xvalues[k],
-                                                this->TimeValues[k], this->residualCoefficient[k]));
-        problem.AddResidualBlock(cost_function, new ceres::ScaledLoss(new ceres::ArctanLoss(lossScale), this->residualCoefficient[k],
-                                                                      ceres::TAKE_OWNERSHIP), this->MotionParametersEgoMotion.data());
-      }
-      else
-      {
-        ceres::CostFunction* cost_function = new ceres::AutoDiffCostFunction<CostFunctions::MahalanobisDistanceAffineIsometryResidual, 1, 6>(
-                                             new CostFunctions::MahalanobisDistanceAffineIsometryResidual(this->Avalues[k], this->Pvalues[k],
-                                                                                                          this->Xvalues[k], this->residualCoefficient[k]));
-        problem.AddResidualBlock(cost_function, new ceres::ScaledLoss(new ceres::ArctanLoss(lossScale), this->residualCoefficient[k], ceres::TAKE_OWNERSHIP), this->Trelative.data());
-      }
+      ceres::Problem problem;
+      AddICPResiduals(problem, this->Avalues, this->Pvalues, this->Xvalues, this->residualCoefficient,
+                      this->TimeValues, this->Undistortion, lossScale, parameters);
+
+      ceres::Solver::Options options;
+      options.max_num_iterations = this->EgoMotionLMMaxIter;
+      options.linear_solver_type = ceres::DENSE_QR;
+      options.minimizer_progress_to_stdout = false;
+
+      ceres::Solver::Summary summary;
+      ceres::Solve(options, &problem, &summary);
+      std::cout << summary.BriefReport() << std::endl;
+      nbSuccessfulSteps = summary.num_successful_steps;
+    }
+    else
+    {
+      PoseSolver solver(this->Avalues, this->Pvalues, this->Xvalues, this->residualCoefficient);
+      solver.SetLossScale(lossScale);
+      solver.SetMaxIterations(this->EgoMotionLMMaxIter);
+      PoseSolver::Summary summary = this->Undistortion ? solver.SolveInterpolatedMotion(this->TimeValues, parameters)
+                                                       : solver.SolveIsometry(parameters);
+      std::cout << summary.BriefReport() << std::endl;
+      nbSuccessfulSteps = summary.NumberOfSuccessfulSteps;
     }
-
-    ceres::Solver::Options options;
-    options.max_num_iterations = this->EgoMotionLMMaxIter;
-    options.linear_solver_type = ceres::DENSE_QR;
-    options.minimizer_progress_to_stdout = false;
-
-    ceres::Solver::Summary summary;
-    ceres::Solve(options, &problem, &summary);
-    std::cout << summary.BriefReport() << std::endl;
 
     // If no L-M iteration has been made since the
     // last ICP matching it means we reached a local
     // minimum for the ICP-LM algorithm
-    if (summary.num_successful_steps == 1)
+    if (nbSuccessfulSteps == 1)
     {
       break;
     }
@@ -1320,6 +1611,7 @@ void Slam::Mapping()
     this->MappingEdgesPointsUsed = 0;
     this->MappingPlanesPointsUsed = 0;
     this->MappingBlobsPointsUsed = 0;
+    this->MappingMatchesUsed = 0;
     // update maps
     this->UpdateMapsUsingTworld();
     std::cout << "Not enought keypoints, Mapping skipped for this frame" << std::endl;
@@ -1329,7 +1621,7 @@ void Slam::Mapping()
     this->PlanarPointRejectionMapping.clear(); this->PlanarPointRejectionMapping.resize(this->CurrentPlanarsPoints->size());
 
   // Set the FarestPoint to reduce the map to the minimum size
-  this->SetLidarMaximunRange(this->KeyPointsExtractor->GetFarestKeypointDist());
+  this->SetLidarMaximunRange(this->FarestKeypointDist);
 
   // Update motion model parameters
   if (this->Undistortion)
@@ -1448,63 +1740,82 @@ void Slam::Mapping()
     // We want to estimate our 6-DOF parameters using a non
     // linear least square minimization. The non linear part
     // comes from the Euler Angle parametrization of the rotation
-    // endomorphism SO(3). To minimize it we use CERES to perform
-    // the Levenberg-Marquardt algorithm.
+    // endomorphism SO(3). To minimize it we use the
+    // Levenberg-Marquardt algorithm, with ceres as reference.
+    double* parameters = this->Undistortion ? this->MotionParametersMapping.data() : this->Tworld.data();
+    unsigned int nbSuccessfulSteps = 0;
     ceres::Problem problem;
-    for (unsigned int k = 0; k < Xvalues.size(); ++k)
+    PoseSolver solver(this->Avalues, this->Pvalues, this->Xvalues, this->residualCoefficient);
+    solver.SetLossScale(lossScale);
+    solver.SetMaxIterations(this->MappingLMMaxIter);
+    if (this->UseCeresSolver)
     {
-      if (this->Undistortion)
-      {
-        ceres::CostFunction* cost_function = new ceres::AutoDiffCostFunction<CostFunctions::MahalanobisDistanceInterpolatedMotionResidual, 1, 12>(
-                                                     new CostFunctions::MahalanobisDistanceInterpolatedMotionResidual(
-                                                     this->Avalues[k], this->Pvalues[k], this->Xvalues[k],
-                                                     this->TimeValues[k], this->residualCoefficient[k]));
-        problem.AddResidualBlock(cost_function, new ceres::ScaledLoss(new ceres::ArctanLoss(lossScale), this->residualCoefficient[k],
-                                                                      ceres::TAKE_OWNERSHIP), this->MotionParametersMapping.data());
-      }
-      else
-      {
-        ceres::CostFunction* cost_function = new ceres::AutoDiffCostFunction<CostFunctions::MahalanobisDistanceAffineIsometryResidual, 1, 6>(
-                                             new CostFunctions::MahalanobisDistanceAffineIsometryResidual(this->Avalues[k], this->Pvalues[k],
-                                                                                                          this->Xvalues[k], this->residualCoefficient[k]));
-        problem.AddResidualBlock(cost_function, new ceres::ScaledLoss(new ceres::ArctanLoss(lossScale), this->residualCoefficient[k], ceres::TAKE_OWNERSHIP), this->Tworld.data());
-      }
+      AddICPResiduals(problem, this->Avalues, this->Pvalues, this->Xvalues, this->residualCoefficient,
+                      this->TimeValues, this->Undistortion, lossScale, parameters);
+
+      ceres::Solver::Options options;
+      options.max_num_iterations = this->MappingLMMaxIter;
+      options.linear_solver_type = ceres::DENSE_QR;
+      options.minimizer_progress_to_stdout = false;
+
+      ceres::Solver::Summary summary;
+      ceres::Solve(options, &problem, &summary);
+      std::cout << summary.BriefReport() << std::endl;
+      nbSuccessfulSteps = summary.num_successful_steps;
+    }
+    else
+    {
+      PoseSolver::Summary summary = this->Undistortion ? solver.SolveInterpolatedMotion(this->TimeValues, parameters)
+                                                       : solver.SolveIsometry(parameters);
+      std::cout << summary.BriefReport() << std::endl;
+      nbSuccessfulSteps = summary.NumberOfSuccessfulSteps;
     }
-
-    ceres::Solver::Options options;
-    options.max_num_iterations = this->MappingLMMaxIter;
-    options.linear_solver_type = ceres::DENSE_QR;
-    options.minimizer_progress_to_stdout = false;
-
-    ceres::Solver::Summary summary;
-    ceres::Solve(options, &problem, &summary);
-    std::cout << summary.BriefReport() << std::endl;
 
     // If no L-M iteration has been made since the
     // last ICP matching it means we reached a local
     // minimum for the ICP-LM algorithm
-    if (((summary.num_successful_steps == 1) ||
+    if (((nbSuccessfulSteps == 1) ||
         (icpCount == (this->MappingICPMaxIter - 1))) &&
         !this->Undistortion)
     {
       // Now evaluate the quality of the parameters
       // estimated using an approximate computation
       // of the variance covariance matrix
-      // Covariance computation options
-      ceres::Covariance::Options covOptions;
-      covOptions.apply_loss_function = true;
-      covOptions.algorithm_type = ceres::CovarianceAlgorithmType::DENSE_SVD;
-
-      // Computation of the variance-covariance matrix
-      ceres::Covariance covariance(covOptions);
-      std::vector<std::pair<const double*, const double* > > covariance_blocks;
-      covariance_blocks.push_back(std::make_pair(this->Tworld.data(), this->Tworld.data()));
-      covariance.Compute(covariance_blocks, &problem);
-      double covarianceMat[6 * 6];
-      covariance.GetCovarianceBlock(this->Tworld.data(), this->Tworld.data(), covarianceMat);
-      for (int i = 0; i < 6; ++i)
-        for (int j = 0; j < 6; ++j)
-          this->TworldCovariance(i, j) = covarianceMat[i + 6 * j];
+      if (this->UseCeresCovariance)
+      {
+        // Full ceres covariance, as a diagnostic. It evaluates
+        // again the Jacobian of the whole problem
+        if (!this->UseCeresSolver)
+        {
+          AddICPResiduals(problem, this->Avalues, this->Pvalues, this->Xvalues, this->residualCoefficient,
+                          this->TimeValues, this->Undistortion, lossScale, parameters);
+        }
+        ceres::Covariance::Options covOptions;
+        covOptions.apply_loss_function = true;
+        covOptions.algorithm_type = ceres::CovarianceAlgorithmType::DENSE_SVD;
+
+        // Computation of the variance-covariance matrix
+        ceres::Covariance covariance(covOptions);
+        std::vector<std::pair<const double*, const double* > > covariance_blocks;
+        covariance_blocks.push_back(std::make_pair(this->Tworld.data(), this->Tworld.data()));
+        covariance.Compute(covariance_blocks, &problem);
+        double covarianceMat[6 * 6];
+        covariance.GetCovarianceBlock(this->Tworld.data(), this->Tworld.data(), covarianceMat);
+        for (int i = 0; i < 6; ++i)
+          for (int j = 0; j < 6; ++j)
+            this->TworldCovariance(i, j) = covarianceMat[i + 6 * j];
+      }
+      else
+      {
+        // Inverse of the information matrix of the last step.
+        // ceres does not provide it: evaluate it once at the solution
+        if (this->UseCeresSolver)
+        {
+          solver.SetMaxIterations(0);
+          solver.SolveIsometry(parameters);
+        }
+        this->TworldCovariance = solver.GetCovariance();
+      }
       break;
     }
   }
@@ -1513,17 +1824,13 @@ void Slam::Mapping()
   Eigen::MatrixXd D = eig.eigenvalues();
 
   this->MappingVarianceError = D(5);
+  this->MappingVarianceEigenValues = D;
+  this->MappingMaxVarianceDirection = eig.eigenvectors().col(5);
+  this->MappingMatchesUsed = this->Xvalues.size();
   this->MappingEdgesPointsUsed = usedEdges;
   this->MappingPlanesPointsUsed = usedPlanes;
   this->MappingBlobsPointsUsed = usedBlobs;
 
-  std::cout << "Matches used: Total: " << this->Xvalues.size()
-            << " edges: " << usedEdges << " planes: " << usedPlanes << " blobs: " << usedBlobs << std::endl;
-
-  std::cout << "Covariance Eigen values: " << D.transpose() << std::endl;
-  std::cout << "Maximum variance eigen vector: " << eig.eigenvectors().col(5).transpose() << std::endl;
-  std::cout << "Maximum variance: " << D(5) << std::endl;
-
   if (this->Undistortion)
   {
     for (int i = 0; i < 6; ++i)
@@ -1574,6 +1881,12 @@ void Slam::UpdateMapsUsingTworld()
     this->CreateWithinFrameTrajectory(this->WithinFrameTrajectory, WithinFrameTrajMode::MappingTraj);
   }
 
+  // In relocalization mode the loaded map is only used as reference
+  if (this->Relocalization && this->MapLoaded)
+  {
+    return;
+  }
+
   // it would nice to add the point frome the frame directly to the map
   auto updateMap = [this] (std::shared_ptr<RollingGrid> map, pcl::PointCloud<Slam::Point>::Ptr frame) {
     pcl::PointCloud<Slam::Point>::Ptr temporaryMap(new pcl::PointCloud<Slam::Point>());
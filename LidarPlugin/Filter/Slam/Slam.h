@@ -137,6 +137,19 @@ class Slam
 {
 public:
   using Point = SpinningSensorKeypointExtractor::Point;
+
+  // Keypoints extracted from a frame, with the information
+  // of the extractor needed to register them
+  struct FrameKeypoints
+  {
+    double Time = 0;
+    pcl::PointCloud<Point>::Ptr Edges;
+    pcl::PointCloud<Point>::Ptr Planars;
+    pcl::PointCloud<Point>::Ptr Blobs;
+    int NLasers = 0;
+    double FarestKeypointDist = 0;
+  };
+
   Slam();
   void Reset();
 
@@ -146,12 +159,36 @@ public:
   // and to update the map using keypoints and ego-motion
   void AddFrame(pcl::PointCloud<Point>::Ptr pc, std::vector<size_t> laserIdMapping);
 
+  // Extract the keypoints of a frame with the given extractor. This does
+  // not touch the state of the slam, so the keypoints of the next frames
+  // can be extracted in other threads, with copies of the extractor,
+  // while the current frame is registered
+  static FrameKeypoints ExtractKeypoints(SpinningSensorKeypointExtractor& extractor,
+                                         pcl::PointCloud<Point>::Ptr pc,
+                                         const std::vector<size_t>& laserIdMapping);
+
+  // Same as AddFrame, with keypoints already extracted
+  void AddKeypoints(const FrameKeypoints& keypoints);
+
   // Get the computed world transform so far
   Transform GetWorldTransform();
   std::vector<double> GetTransformCovariance();
 
   std::unordered_map<std::string, double> GetDebugInformation();
 
+  // Get the wall-clock duration in seconds of each stage of the last AddFrame
+  std::unordered_map<std::string, double> GetStageTimings();
+
+  // Save the keypoints maps, the state of their voxel grids and the
+  // trajectory in a binary file, see SlamMapFile.h for the layout
+  bool SaveMap(const std::string& filename) const;
+
+  // Load a map saved with SaveMap. The first frame added afterwards is
+  // directly matched against the map. If resume is true the SLAM continues
+  // from the last saved pose, as if the run had not been interrupted.
+  // Otherwise the sensor is expected to start close to the origin of the map
+  bool LoadMap(const std::string& filename, bool resume);
+
   pcl::PointCloud<Point>::Ptr GetEdgesMap();
   pcl::PointCloud<Point>::Ptr GetPlanarsMap();
   pcl::PointCloud<Point>::Ptr GetBlobsMap();
@@ -168,6 +205,15 @@ public:
   SetMacro(Undistortion, bool)
   GetMacro(Undistortion, bool)
 
+  GetMacro(UseCeresSolver, bool)
+  SetMacro(UseCeresSolver, bool)
+
+  GetMacro(UseCeresCovariance, bool)
+  SetMacro(UseCeresCovariance, bool)
+
+  GetMacro(Relocalization, bool)
+  SetMacro(Relocalization, bool)
+
   // Set RollingGrid Parameters
   void SetVoxelGridLeafSizeEdges(double size);
   void SetVoxelGridLeafSizePlanes(double size);
@@ -265,6 +311,12 @@ private:
   double MappingPlanesPointsUsed;
   double MappingBlobsPointsUsed;
   double MappingVarianceError;
+  double MappingMatchesUsed = 0;
+  Eigen::Matrix<double, 6, 1> MappingVarianceEigenValues = Eigen::Matrix<double, 6, 1>::Ones();
+  Eigen::Matrix<double, 6, 1> MappingMaxVarianceDirection = Eigen::Matrix<double, 6, 1>::Zero();
+
+  // Duration of each stage of the last processed frame
+  std::unordered_map<std::string, double> StageTimings;
 
   // Mapping between keypoints and their corresponding
   // index in the vtk input frame
@@ -284,6 +336,17 @@ private:
   // the computation speed will decrease
   bool Undistortion = false;
 
+  // If set to true the poses are optimized by ceres instead
+  // of PoseSolver. It minimizes the same cost but is slower,
+  // it is kept as a reference
+  bool UseCeresSolver = false;
+
+  // If set to true the covariance of the mapping pose is computed
+  // by ceres::Covariance, which evaluates again the Jacobian of the
+  // whole problem. Otherwise it is the inverse of the information
+  // matrix of the last Levenberg-Marquardt step
+  bool UseCeresCovariance = false;
+
   // Represents estimated samples of the trajectory
   // of the sensor within a lidar frame. The orientation
   // and position of the sensor at a random time t can then
@@ -306,6 +369,18 @@ private:
   // Number of frame that have been processed
   unsigned int NbrFrameProcessed = 0;
 
+  // Number of lasers and norm of the farest keypoint of the current frame
+  int NLasers = 0;
+  double FarestKeypointDist = 0;
+
+  // True if the maps have been loaded with LoadMap
+  bool MapLoaded = false;
+
+  // If set to true and a map has been loaded, the keypoints of the
+  // new frames are not added to the map: the mapping step only matches
+  // them against the loaded map to relocalize the sensor
+  bool Relocalization = false;
+
   // The max distance allowed between two frames
   // If the distance is over this limit, the ICP
   // matching will not match point and the odometry
@@ -0,0 +1,96 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef SLAM_MAP_FILE_H
+#define SLAM_MAP_FILE_H
+
+#include <cstdint>
+
+/**
+ * @brief Binary layout of the files written by Slam::SaveMap.
+ *
+ * All the records are plain structures whose size is a multiple of 8 bytes,
+ * written in the native byte order (little endian on all supported platforms),
+ * so that a memory mapped file can be read in place:
+ * - FileHeader
+ * - PoseRecord[NumberOfPoses]: the trajectory
+ * - for each of the NumberOfGrids grids (edges, planars, blobs):
+ *   - VoxelRecord[NumberOfVoxels]: the non empty voxels
+ *   - PointRecord[NumberOfPoints]: their points, voxel after voxel
+ */
+namespace SlamMapFile
+{
+constexpr char Magic[8] = { 'L', 'V', 'S', 'L', 'A', 'M', 'M', 'P' };
+constexpr uint32_t Version = 1;
+constexpr uint32_t NumberOfGrids = 3;
+
+//! State of a RollingGrid
+struct GridHeader
+{
+  int32_t VoxelSize;
+  int32_t PointCloudSize;
+  int32_t VoxelGridPosition[3];
+  uint32_t NumberOfVoxels;
+  double VoxelResolution;
+  double LeafSize;
+  uint64_t NumberOfPoints;
+};
+
+struct FileHeader
+{
+  char Magic[8];
+  uint32_t Version;
+  uint32_t NumberOfGrids;
+  uint64_t NumberOfPoses;
+  //! Last pose of the SLAM, (rx, ry, rz, tx, ty, tz)
+  double Tworld[6];
+  //! Last motion parameters of the mapping, used with undistortion
+  double MotionParametersMapping[12];
+  GridHeader Grids[NumberOfGrids];
+};
+
+//! Transform of the trajectory
+struct PoseRecord
+{
+  double Time;
+  double Position[3];
+  double Orientation[3];
+};
+
+//! Non empty voxel, its index is (i * VoxelSize + j) * VoxelSize + k
+struct VoxelRecord
+{
+  uint32_t Index;
+  uint32_t NumberOfPoints;
+};
+
+struct PointRecord
+{
+  float X;
+  float Y;
+  float Z;
+  uint8_t Intensity;
+  uint8_t LaserId;
+  uint16_t Padding;
+  double Time;
+};
+
+static_assert(sizeof(GridHeader) == 48, "unexpected padding in SlamMapFile::GridHeader");
+static_assert(sizeof(FileHeader) % 8 == 0, "unexpected padding in SlamMapFile::FileHeader");
+static_assert(sizeof(PoseRecord) == 56, "unexpected padding in SlamMapFile::PoseRecord");
+static_assert(sizeof(VoxelRecord) == 8, "unexpected padding in SlamMapFile::VoxelRecord");
+static_assert(sizeof(PointRecord) == 24, "unexpected padding in SlamMapFile::PointRecord");
+}
+
+#endif // SLAM_MAP_FILE_H
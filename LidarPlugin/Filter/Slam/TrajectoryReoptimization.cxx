@@ -36,6 +36,7 @@
 #include "CeresCostFunctions.h"
 #include "RegistrationTools.h"
 #include "CeresTools.h"
+#include "SolverConfiguration.h"
 
 //-----------------------------------------------------------------------------
 PoseEstimationVector RelativePosesFromAbsolutePoses(const PoseEstimationVector& absolutePoses)
@@ -117,14 +118,13 @@ PoseEstimationVector TrajectoryReoptimization(const PoseEstimationVector& absolu
   problem.AddResidualBlock(regFunction, new ceres::ScaledLoss(nullptr, 1.0 / static_cast<double>(relativePoses.size()), ceres::TAKE_OWNERSHIP), parameterBlocks);
 
   ceres::Solver::Options options;
-  options.num_threads = 8;
-  options.num_linear_solver_threads = 8;
   options.minimizer_type = ceres::LINE_SEARCH;
   //options.line_search_direction_type = ceres::STEEPEST_DESCENT;
   //options.line_search_type = ceres::ARMIJO;
   options.max_num_iterations = maxIteration;
   options.linear_solver_type = ceres::DENSE_QR;
   options.minimizer_progress_to_stdout = true;
+  GetCalibrationSolverConfiguration().Apply(options);
 
   ceres::Solver::Summary summary;
   ceres::Solve(options, &problem, &summary);
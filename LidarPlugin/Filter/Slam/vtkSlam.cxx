@@ -116,6 +116,8 @@ double Rad2Deg(double val)
   return val / vtkMath::Pi() * 180;
 }
 
+}
+
 //-----------------------------------------------------------------------------
 void PolyDataFromPointCloud(pcl::PointCloud<Slam::Point>::Ptr pc, vtkPolyData* poly)
 {
@@ -141,7 +143,6 @@ void PolyDataFromPointCloud(pcl::PointCloud<Slam::Point>::Ptr pc, vtkPolyData* p
   cellArray->SetCells(pc->size(), cells.GetPointer());
   poly->SetVerts(cellArray);
 }
-}
 
 //-----------------------------------------------------------------------------
 void PointCloudFromPolyData(vtkPolyData* poly, pcl::PointCloud<Slam::Point>::Ptr pc)
@@ -329,6 +330,11 @@ vtkSlam::vtkSlam()
 void vtkSlam::Reset()
 {
   this->SlamAlgo.Reset();
+  if (!this->InitialMapFileName.empty() &&
+      !this->SlamAlgo.LoadMap(this->InitialMapFileName, !this->SlamAlgo.GetRelocalization()))
+  {
+    vtkErrorMacro("Could not load the SLAM map " << this->InitialMapFileName);
+  }
 
   // output of the vtk filter
   this->Trajectory = vtkSmartPointer<vtkTemporalTransforms>::New();
@@ -338,12 +344,10 @@ void vtkSlam::Reset()
   // add the required array in the trajectory
   if (this->DisplayMode)
   {
-      this->Trajectory->GetPointData()->AddArray(createArray<vtkDoubleArray>("EgoMotion: edges used"));
-      this->Trajectory->GetPointData()->AddArray(createArray<vtkDoubleArray>("EgoMotion: planes used"));
-      this->Trajectory->GetPointData()->AddArray(createArray<vtkDoubleArray>("Mapping: edges used"));
-      this->Trajectory->GetPointData()->AddArray(createArray<vtkDoubleArray>("Mapping: planes used"));
-      this->Trajectory->GetPointData()->AddArray(createArray<vtkDoubleArray>("Mapping: blobs used"));
-      this->Trajectory->GetPointData()->AddArray(createArray<vtkDoubleArray>("Mapping: variance error"));
+    for (const auto& it : this->SlamAlgo.GetDebugInformation())
+    {
+      this->Trajectory->GetPointData()->AddArray(createArray<vtkDoubleArray>(it.first.c_str()));
+    }
   }
 }
 
@@ -363,6 +367,45 @@ int vtkSlam::FillInputPortInformation(int port, vtkInformation *info)
   return 0;
 }
 
+//-----------------------------------------------------------------------------
+void vtkSlam::SetInitialMapFileName(const std::string& filename)
+{
+  if (this->InitialMapFileName != filename)
+  {
+    this->InitialMapFileName = filename;
+    this->Modified();
+    this->ParametersModificationTime.Modified();
+    this->Reset();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlam::SetRelocalization(bool relocalization)
+{
+  if (this->SlamAlgo.GetRelocalization() != relocalization)
+  {
+    this->SlamAlgo.SetRelocalization(relocalization);
+    this->Modified();
+    this->ParametersModificationTime.Modified();
+    // the initial map has been loaded for the previous mode
+    if (!this->InitialMapFileName.empty())
+    {
+      this->Reset();
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlam::SaveMap(const std::string& filename)
+{
+  if (!this->SlamAlgo.SaveMap(filename))
+  {
+    vtkErrorMacro("Could not save the SLAM map to " << filename);
+    return false;
+  }
+  return true;
+}
+
 //-----------------------------------------------------------------------------
 void vtkSlam::SetVoxelGridLeafSizeEdges(double size)
 {
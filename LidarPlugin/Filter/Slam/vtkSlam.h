@@ -134,6 +134,23 @@ public:
   vtkCustomGetMacro(Undistortion, bool)
   vtkCustomSetMacro(Undistortion, bool)
 
+  vtkCustomGetMacro(UseCeresSolver, bool)
+  vtkCustomSetMacro(UseCeresSolver, bool)
+
+  vtkCustomGetMacro(UseCeresCovariance, bool)
+  vtkCustomSetMacro(UseCeresCovariance, bool)
+
+  // Map loaded at the beginning of the SLAM, saved by SaveMap
+  vtkGetMacro(InitialMapFileName, std::string)
+  virtual void SetInitialMapFileName(const std::string& filename);
+
+  // Changing it reloads the initial map, which is loaded differently
+  vtkCustomGetMacro(Relocalization, bool)
+  virtual void SetRelocalization(bool relocalization);
+
+  // Save the current maps and trajectory, to relocalize or resume a SLAM later
+  bool SaveMap(const std::string& filename);
+
   vtkGetObjectMacro(KeyPointsExtractor, vtkSpinningSensorKeypointExtractor)
   virtual void SetKeyPointsExtractor(vtkSpinningSensorKeypointExtractor *);
 
@@ -236,6 +253,11 @@ protected:
   Slam SlamAlgo;
   vtkSpinningSensorKeypointExtractor* KeyPointsExtractor = nullptr;
 
+  // Map loaded by Reset, if not empty. The SLAM resumes from the saved
+  // trajectory, unless Relocalization is set: in that case the map is
+  // left untouched and the sensor starts close to its origin
+  std::string InitialMapFileName;
+
 private:
   vtkSlam(const vtkSlam&) = delete;
   void operator = (const vtkSlam&) = delete;
@@ -256,4 +278,6 @@ std::vector<size_t> sortIdx(const std::vector<T> &v);
 
 void PointCloudFromPolyData(vtkPolyData* poly, pcl::PointCloud<Slam::Point>::Ptr pc);
 
+void PolyDataFromPointCloud(pcl::PointCloud<Slam::Point>::Ptr pc, vtkPolyData* poly);
+
 #endif // VTK_SLAM_H
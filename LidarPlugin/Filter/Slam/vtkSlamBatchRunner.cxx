@@ -0,0 +1,343 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vtkSlamBatchRunner.h"
+
+#include "SynchronizedQueue.h"
+#include "vtkEigenTools.h"
+#include "vtkLidarReader.h"
+#include "vtkSlam.h"
+#include "vtkTemporalTransforms.h"
+
+#include <vtkDataArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkPolyData.h>
+#include <vtkTable.h>
+
+#include <algorithm>
+#include <map>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+//! Same laser ordering as vtkSlam, by decreasing vertical angle
+std::vector<size_t> ComputeLaserIdMapping(vtkTable* calib)
+{
+  std::vector<size_t> laserIdMapping;
+  auto array = calib ? vtkDataArray::SafeDownCast(calib->GetColumnByName("verticalCorrection")) : nullptr;
+  if (array)
+  {
+    std::vector<double> verticalCorrection(array->GetNumberOfTuples());
+    for (vtkIdType i = 0; i < array->GetNumberOfTuples(); ++i)
+    {
+      verticalCorrection[i] = array->GetTuple1(i);
+    }
+    laserIdMapping = sortIdx(verticalCorrection);
+  }
+  return laserIdMapping;
+}
+}
+
+//-----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkSlamBatchRunner)
+
+//-----------------------------------------------------------------------------
+vtkCxxSetObjectMacro(vtkSlamBatchRunner, Reader, vtkLidarReader)
+
+//-----------------------------------------------------------------------------
+vtkSlamBatchRunner::vtkSlamBatchRunner()
+  : Trajectory(vtkSmartPointer<vtkTemporalTransforms>::New())
+  , Running(false)
+  , Cancelled(false)
+  , Succeeded(false)
+  , NumberOfProcessedFrames(0)
+  , NumberOfRequestedFrames(0)
+{
+}
+
+//-----------------------------------------------------------------------------
+vtkSlamBatchRunner::~vtkSlamBatchRunner()
+{
+  this->Cancel();
+  this->Wait();
+  this->SetReader(nullptr);
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlamBatchRunner::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "FirstFrame: " << this->FirstFrame << endl;
+  os << indent << "LastFrame: " << this->LastFrame << endl;
+  os << indent << "FrameStride: " << this->FrameStride << endl;
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
+  os << indent << "MaxFramesAhead: " << this->MaxFramesAhead << endl;
+  os << indent << "OutputMapFileName: " << this->OutputMapFileName << endl;
+  os << indent << "Running: " << this->Running << endl;
+  os << indent << "NumberOfProcessedFrames: " << this->NumberOfProcessedFrames << endl;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlamBatchRunner::Start()
+{
+  if (this->Running)
+  {
+    vtkErrorMacro("A run is already in progress");
+    return false;
+  }
+  if (this->Thread.joinable())
+  {
+    this->Thread.join();
+  }
+  if (!this->Reader)
+  {
+    vtkErrorMacro("No reader has been set");
+    return false;
+  }
+
+  // The frame index and the calibration are only known once the reader has been updated
+  if (this->Reader->GetNumberOfFrames() == 0)
+  {
+    this->Reader->Update();
+  }
+  std::vector<size_t> laserIdMapping = ComputeLaserIdMapping(
+    vtkTable::SafeDownCast(this->Reader->GetOutputDataObject(1)));
+  if (laserIdMapping.empty())
+  {
+    vtkErrorMacro(<< "The calibration data has no column named 'verticalCorrection'");
+    return false;
+  }
+
+  // Same convention as vtkLidarReader::SaveFrame, the first and last frames
+  // are hidden from the user most of the time.
+  int numberOfFrames = this->Reader->GetNumberOfFrames();
+  int offset = 0;
+  if (!this->Reader->GetShowFirstAndLastFrame() && numberOfFrames >= 3)
+  {
+    offset = 1;
+    numberOfFrames -= 2;
+  }
+  int first = std::max(this->FirstFrame, 0);
+  int last = this->LastFrame < 0 ? numberOfFrames - 1 : std::min(this->LastFrame, numberOfFrames - 1);
+  std::vector<int> frameIndices;
+  for (int frameIndex = first; frameIndex <= last; frameIndex += this->FrameStride)
+  {
+    frameIndices.push_back(frameIndex + offset);
+  }
+  if (frameIndices.empty())
+  {
+    vtkWarningMacro("No frame to process in [" << this->FirstFrame << ", " << this->LastFrame << "]");
+    return false;
+  }
+
+  this->SlamAlgo.Reset();
+  this->Trajectory = vtkSmartPointer<vtkTemporalTransforms>::New();
+  this->Cancelled = false;
+  this->Succeeded = false;
+  this->NumberOfProcessedFrames = 0;
+  this->NumberOfRequestedFrames = static_cast<int>(frameIndices.size());
+  this->Running = true;
+  this->Thread = boost::thread(&vtkSlamBatchRunner::Run, this, frameIndices, laserIdMapping);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlamBatchRunner::Cancel()
+{
+  this->Cancelled = true;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlamBatchRunner::Wait()
+{
+  if (this->Thread.joinable())
+  {
+    this->Thread.join();
+  }
+  return this->Succeeded;
+}
+
+//-----------------------------------------------------------------------------
+double vtkSlamBatchRunner::GetProgress() const
+{
+  int nbRequested = this->NumberOfRequestedFrames;
+  return nbRequested > 0 ? static_cast<double>(this->NumberOfProcessedFrames) / nbRequested : 0.;
+}
+
+//-----------------------------------------------------------------------------
+vtkTemporalTransforms* vtkSlamBatchRunner::GetTrajectory()
+{
+  return this->Trajectory;
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> vtkSlamBatchRunner::GetEdgesMap()
+{
+  auto map = vtkSmartPointer<vtkPolyData>::New();
+  PolyDataFromPointCloud(this->SlamAlgo.GetEdgesMap(), map);
+  return map;
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> vtkSlamBatchRunner::GetPlanarsMap()
+{
+  auto map = vtkSmartPointer<vtkPolyData>::New();
+  PolyDataFromPointCloud(this->SlamAlgo.GetPlanarsMap(), map);
+  return map;
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> vtkSlamBatchRunner::GetBlobsMap()
+{
+  auto map = vtkSmartPointer<vtkPolyData>::New();
+  PolyDataFromPointCloud(this->SlamAlgo.GetBlobsMap(), map);
+  return map;
+}
+
+//-----------------------------------------------------------------------------
+void vtkSlamBatchRunner::Run(std::vector<int> frameIndices, std::vector<size_t> laserIdMapping)
+{
+  const int nbFrames = static_cast<int>(frameIndices.size());
+  const int maxAhead = this->MaxFramesAhead;
+  unsigned int nbThreads = this->NumberOfThreads > 0 ? this->NumberOfThreads
+                                                     : boost::thread::hardware_concurrency();
+  nbThreads = std::max(nbThreads, 1u);
+
+  // Decoded frames, with their rank in the run. The queue is bounded so that the
+  // decoding stops when the registration is late.
+  using RankedFrame = std::pair<int, vtkSmartPointer<vtkPolyData>>;
+  SynchronizedQueue<RankedFrame> frames(maxAhead);
+
+  // Keypoints extracted, by rank, waiting to be registered. They are extracted
+  // in any order but registered in order. A keypoint cloud left null marks an
+  // empty frame, which is skipped.
+  std::map<int, Slam::FrameKeypoints> keypoints;
+  int nextRank = 0;
+  bool failed = false;
+  boost::mutex mutex;
+  boost::condition_variable condition;
+  auto stopped = [&]() { return failed || this->Cancelled; };
+
+  boost::thread decoder([&]()
+  {
+    this->Reader->Open();
+    for (int rank = 0; rank < nbFrames && !this->Cancelled; ++rank)
+    {
+      vtkSmartPointer<vtkPolyData> frame = this->Reader->GetFrame(frameIndices[rank]);
+      if (!frame)
+      {
+        boost::unique_lock<boost::mutex> lock(mutex);
+        failed = true;
+        condition.notify_all();
+        break;
+      }
+      frames.enqueue(RankedFrame(rank, frame));
+    }
+    frames.finishQueue();
+    this->Reader->Close();
+  });
+
+  // Each extraction thread has its own extractor, with the parameters of the SLAM one
+  std::vector<boost::thread> extractors;
+  for (unsigned int i = 0; i < nbThreads; ++i)
+  {
+    extractors.emplace_back([&]()
+    {
+      SpinningSensorKeypointExtractor extractor = *this->SlamAlgo.GetKeyPointsExtractor();
+      RankedFrame frame;
+      while (frames.dequeue(frame))
+      {
+        Slam::FrameKeypoints frameKeypoints;
+        pcl::PointCloud<Slam::Point>::Ptr pc(new pcl::PointCloud<Slam::Point>);
+        PointCloudFromPolyData(frame.second, pc);
+        if (!pc->empty())
+        {
+          frameKeypoints = Slam::ExtractKeypoints(extractor, pc, laserIdMapping);
+        }
+
+        // Do not get more than maxAhead frames ahead of the registration
+        boost::unique_lock<boost::mutex> lock(mutex);
+        while (frame.first >= nextRank + maxAhead && !stopped())
+        {
+          condition.wait(lock);
+        }
+        if (stopped())
+        {
+          break;
+        }
+        keypoints[frame.first] = frameKeypoints;
+        condition.notify_all();
+      }
+    });
+  }
+
+  // Register the frames in order
+  for (int rank = 0; rank < nbFrames; ++rank)
+  {
+    Slam::FrameKeypoints frameKeypoints;
+    {
+      boost::unique_lock<boost::mutex> lock(mutex);
+      // Cancel() does not notify, so the wait is bounded to check it regularly
+      while (!keypoints.count(rank) && !stopped())
+      {
+        condition.wait_for(lock, boost::chrono::milliseconds(100));
+      }
+      if (stopped())
+      {
+        condition.notify_all();
+        break;
+      }
+      frameKeypoints = keypoints[rank];
+      keypoints.erase(rank);
+      nextRank = rank + 1;
+      condition.notify_all();
+    }
+
+    if (frameKeypoints.Edges)
+    {
+      this->SlamAlgo.AddKeypoints(frameKeypoints);
+      Transform Tworld = this->SlamAlgo.GetWorldTransform();
+      Eigen::AngleAxisd m(RollPitchYawToMatrix(Tworld.rx, Tworld.ry, Tworld.rz));
+      this->Trajectory->PushBack(frameKeypoints.Time, m, Eigen::Vector3d(Tworld.position));
+    }
+
+    this->NumberOfProcessedFrames = rank + 1;
+    if (this->ProgressCallback)
+    {
+      this->ProgressCallback(rank + 1, nbFrames);
+    }
+  }
+
+  // Unblock the other stages if the run has been interrupted
+  frames.stopQueue();
+  decoder.join();
+  for (auto& extractor : extractors)
+  {
+    extractor.join();
+  }
+
+  if (failed)
+  {
+    vtkErrorMacro("Failed to decode some frames, the SLAM has been stopped");
+  }
+  else if (!this->Cancelled)
+  {
+    this->Succeeded = true;
+    if (!this->OutputMapFileName.empty() && !this->SlamAlgo.SaveMap(this->OutputMapFileName))
+    {
+      vtkErrorMacro("Could not save the SLAM map to " << this->OutputMapFileName);
+    }
+  }
+  this->Running = false;
+}
@@ -0,0 +1,160 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VTK_SLAM_BATCH_RUNNER_H
+#define VTK_SLAM_BATCH_RUNNER_H
+
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+#include "Slam.h"
+
+#include <boost/thread.hpp>
+
+#include <atomic>
+#include <functional>
+#include <string>
+
+class vtkLidarReader;
+class vtkPolyData;
+class vtkTemporalTransforms;
+
+/**
+ * @brief vtkSlamBatchRunner runs the SLAM on a range of frames of a vtkLidarReader
+ * in the background, without going through the pipeline for each frame.
+ *
+ * The processing is split in stages connected by bounded queues:
+ * - decode: the frames are decoded sequentially by the reader (the interpreter is stateful)
+ * - extract: a pool of threads converts the frames to PCL and extracts their keypoints,
+ *   each thread with its own copy of the keypoints extractor of the SLAM
+ * - register: the keypoints are registered in order by the SLAM
+ * So the frames N+1..N+k are decoded and their keypoints extracted while the frame N
+ * is registered, k being MaxFramesAhead.
+ *
+ * Start() returns immediately. The progress can be polled from any thread, or a
+ * callback can be set, and the run can be cancelled at any time. The results must
+ * only be read once the run is over (Wait() returned or IsRunning() is false).
+ */
+class VTK_EXPORT vtkSlamBatchRunner : public vtkObject
+{
+public:
+  static vtkSlamBatchRunner* New();
+  vtkTypeMacro(vtkSlamBatchRunner, vtkObject)
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  vtkGetObjectMacro(Reader, vtkLidarReader)
+  virtual void SetReader(vtkLidarReader* reader);
+
+  vtkGetMacro(FirstFrame, int)
+  vtkSetMacro(FirstFrame, int)
+
+  //! Last frame to process, included. A negative value means the last frame available.
+  vtkGetMacro(LastFrame, int)
+  vtkSetMacro(LastFrame, int)
+
+  vtkGetMacro(FrameStride, int)
+  vtkSetClampMacro(FrameStride, int, 1, VTK_INT_MAX)
+
+  //! Number of keypoints extraction threads, 0 means one per hardware core
+  vtkGetMacro(NumberOfThreads, int)
+  vtkSetClampMacro(NumberOfThreads, int, 0, VTK_INT_MAX)
+
+  //! Maximum number of frames decoded or extracted ahead of the registration
+  vtkGetMacro(MaxFramesAhead, int)
+  vtkSetClampMacro(MaxFramesAhead, int, 1, VTK_INT_MAX)
+
+  //! If not empty, the maps are saved to this file at the end of a complete run
+  vtkGetMacro(OutputMapFileName, std::string)
+  vtkSetMacro(OutputMapFileName, std::string)
+
+#ifndef __VTK_WRAP__
+  //! SLAM used for the run, to be configured before Start()
+  Slam& GetSlam() { return this->SlamAlgo; }
+
+  /**
+   * @brief SetProgressCallback set a function called by the registration thread after
+   * each frame with the number of frames registered and the number of frames requested.
+   * It must be set before Start() and be cheap and thread safe, typically posting an
+   * event to another thread.
+   */
+  void SetProgressCallback(std::function<void(int, int)> callback) { this->ProgressCallback = callback; }
+#endif
+
+  /**
+   * @brief Start reset the SLAM and launch the run in the background
+   * @return false if the run could not be started
+   */
+  bool Start();
+
+  //! Ask the run to stop as soon as possible, the frames already registered are kept
+  void Cancel();
+
+  //! Block until the run is over, return true if all the frames have been registered
+  bool Wait();
+
+  bool IsRunning() const { return this->Running; }
+  bool IsCancelled() const { return this->Cancelled; }
+
+  //! Number of frames registered so far, can be called from any thread
+  int GetNumberOfProcessedFrames() const { return this->NumberOfProcessedFrames; }
+
+  //! Number of frames requested by the last call to Start()
+  int GetNumberOfRequestedFrames() const { return this->NumberOfRequestedFrames; }
+
+  //! Fraction of the requested frames registered so far, can be called from any thread
+  double GetProgress() const;
+
+  //! Pose of the sensor at each registered frame, only valid once the run is over
+  vtkTemporalTransforms* GetTrajectory();
+
+  //! Keypoints maps, only valid once the run is over
+  vtkSmartPointer<vtkPolyData> GetEdgesMap();
+  vtkSmartPointer<vtkPolyData> GetPlanarsMap();
+  vtkSmartPointer<vtkPolyData> GetBlobsMap();
+
+protected:
+  vtkSlamBatchRunner();
+  ~vtkSlamBatchRunner();
+
+  //! Body of the registration thread
+  void Run(std::vector<int> frameIndices, std::vector<size_t> laserIdMapping);
+
+  //! Reader providing the frames
+  vtkLidarReader* Reader = nullptr;
+
+  int FirstFrame = 0;
+  int LastFrame = -1;
+  int FrameStride = 1;
+  int NumberOfThreads = 0;
+  int MaxFramesAhead = 4;
+  std::string OutputMapFileName = "";
+
+  Slam SlamAlgo;
+  vtkSmartPointer<vtkTemporalTransforms> Trajectory;
+
+  std::function<void(int, int)> ProgressCallback;
+
+  boost::thread Thread;
+  std::atomic<bool> Running;
+  std::atomic<bool> Cancelled;
+  std::atomic<bool> Succeeded;
+  std::atomic<int> NumberOfProcessedFrames;
+  std::atomic<int> NumberOfRequestedFrames;
+
+private:
+  vtkSlamBatchRunner(const vtkSlamBatchRunner&) = delete;
+  void operator=(const vtkSlamBatchRunner&) = delete;
+};
+
+#endif // VTK_SLAM_BATCH_RUNNER_H
@@ -34,6 +34,7 @@ void vtkSlamManager::PrintSelf(std::ostream &os, vtkIndent indent)
   PrintParameter(FirstFrame)
   PrintParameter(LastFrame)
   PrintParameter(StepSize)
+  PrintParameter(OutputMapFileName)
   vtkIndent paramIndent = indent.GetNextIndent();
   this->Superclass::PrintSelf(os, paramIndent);
 }
@@ -136,6 +137,10 @@ int vtkSlamManager::RequestData(vtkInformation *request, vtkInformationVector **
       output->DeepCopy(vtkPolyData::GetData(outputVector->GetInformationObject(i)));
       this->Cache.push_back(output);
     }
+    if (!this->OutputMapFileName.empty())
+    {
+      this->SaveMap(this->OutputMapFileName);
+    }
   }
 
   return 1;
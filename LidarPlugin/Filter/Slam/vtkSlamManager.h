@@ -66,6 +66,11 @@ public:
   vtkCustomSetMacro(AllFrame, bool)
   //! @}
 
+  //! @{ @copydoc OutputMapFileName
+  vtkGetMacro(OutputMapFileName, std::string)
+  vtkSetMacro(OutputMapFileName, std::string)
+  //! @}
+
 protected:
   vtkSlamManager();
   int RequestUpdateExtent(vtkInformation*,
@@ -88,6 +93,9 @@ protected:
   //! Process one frame every StepSize frames (ex: every frame, every 2 frame, 3 frame, ...)
   int StepSize = 1;
 
+  //! If not empty, the maps are saved to this file once the last frame is processed
+  std::string OutputMapFileName;
+
 private:
   vtkSlamManager(const vtkSlamManager&) = delete;
   void operator = (const vtkSlamManager&) = delete;
@@ -25,6 +25,8 @@
 #include <vtkTransform.h>
 
 #include "vtkTemporalTransforms.h"
+#include "ParallelFor.h"
+#include "TrajectoryInterpolator.h"
 
 //-----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkTemporalTransformsApplier)
@@ -105,6 +107,35 @@ int vtkTemporalTransformsApplier::RequestData(vtkInformation* vtkNotUsed(request
       vtkErrorMacro(<<"No TimeStamp array selected.")
       return 1;
     }
+
+    // The points of a frame are sorted by time most of the time, so a cursor
+    // finds the segment of the next point in constant time
+    if (this->Interpolator->GetInterpolationType() == vtkCustomTransformInterpolator::INTERPOLATION_TYPE_LINEAR)
+    {
+      // GetTuple1 is not thread safe, the times are read first
+      std::vector<double> times(pointcloud->GetNumberOfPoints());
+      for (vtkIdType i = 0; i < pointcloud->GetNumberOfPoints(); i++)
+      {
+        times[i] = timestamp->GetTuple1(i) * 1e-6;
+      }
+      const TrajectoryInterpolator& trajectory = this->Interpolator->GetTrajectoryInterpolator();
+      const float* inputPoints = reinterpret_cast<float*>(pointcloud->GetPoints()->GetData()->GetVoidPointer(0));
+      float* outputPoints = reinterpret_cast<float*>(output->GetPoints()->GetData()->GetVoidPointer(0));
+      ParallelFor(0, pointcloud->GetNumberOfPoints(), [&](int begin, int end)
+      {
+        TrajectoryInterpolator::Cursor cursor(trajectory);
+        Eigen::Vector3d position;
+        Eigen::Quaterniond orientation;
+        for (int i = begin; i < end; ++i)
+        {
+          cursor.Interpolate(times[i], position, orientation);
+          Eigen::Vector3d point = Eigen::Vector3f(inputPoints + 3 * i).cast<double>();
+          Eigen::Map<Eigen::Vector3f>(outputPoints + 3 * i) = (orientation * point + position).cast<float>();
+        }
+      }, 0, 4096);
+      return 1;
+    }
+
     for (vtkIdType i = 0; i < pointcloud->GetNumberOfPoints(); i++)
     {
       // get timestamp in seconds
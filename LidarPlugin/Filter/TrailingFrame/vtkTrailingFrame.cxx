@@ -1,5 +1,8 @@
 #include "vtkTrailingFrame.h"
 
+#include "vtkLidarReader.h"
+
+#include <vtkAlgorithmOutput.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkInformationVector.h>
 #include <vtkInformation.h>
@@ -19,6 +22,53 @@ void vtkTrailingFrame::SetNumberOfTrailingFrames(const unsigned int value)
   }
 }
 
+//----------------------------------------------------------------------------
+void vtkTrailingFrame::SetBatchRequest(bool value)
+{
+  if (this->BatchRequest != value)
+  {
+    this->BatchRequest = value;
+    this->CacheTimeRange[0] = -1;
+    this->CacheTimeRange[1] = -1;
+    this->BatchCache.clear();
+    this->Modified();
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkTrailingFrame::GetClosestTimeStepIndex(double time)
+{
+  // find the index of the first time step that is not less than time
+  int index = std::distance(this->TimeSteps.begin(),
+                            std::lower_bound(this->TimeSteps.begin(),
+                                             this->TimeSteps.end(),
+                                             time));
+  // check if the previous index is closer
+  if (index > 0)
+  {
+    if (index == static_cast<int>(this->TimeSteps.size()) ||
+        this->TimeSteps[index] - time > time - this->TimeSteps[index - 1])
+      index -= 1;
+  }
+  return index;
+}
+
+//----------------------------------------------------------------------------
+vtkLidarReader* vtkTrailingFrame::GetFrameProvider()
+{
+  if (!this->BatchRequest || this->TimeSteps.empty() || this->GetNumberOfInputConnections(0) == 0)
+  {
+    return nullptr;
+  }
+  // only the frames of the reader first output can be provided
+  vtkAlgorithmOutput* connection = this->GetInputConnection(0, 0);
+  if (connection->GetIndex() != 0)
+  {
+    return nullptr;
+  }
+  return vtkLidarReader::SafeDownCast(connection->GetProducer());
+}
+
 //----------------------------------------------------------------------------
 int vtkTrailingFrame::FillOutputPortInformation(int port, vtkInformation *info)
 {
@@ -53,6 +103,14 @@ int vtkTrailingFrame::RequestUpdateExtent(vtkInformation* vtkNotUsed(request),
     return 1;
   }
 
+  // batch mode, the pipeline only provides the current frame
+  if (this->GetFrameProvider())
+  {
+    this->PipelineTime = inInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEP());
+    this->PipelineIndex = this->GetClosestTimeStepIndex(this->PipelineTime);
+    return 1;
+  }
+
   // first loop
   if (this->FirstFilterIteration)
   {
@@ -67,17 +125,7 @@ int vtkTrailingFrame::RequestUpdateExtent(vtkInformation* vtkNotUsed(request),
     this->PipelineTime = inInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEP());
 
     // get the index corresponding to the requested pipeline time
-    // find the index of the first time step that is not less than pipeline time
-    this->PipelineIndex = std::distance(this->TimeSteps.begin(),
-                                        std::lower_bound(this->TimeSteps.begin(),
-                                                         this->TimeSteps.end(),
-                                                         this->PipelineTime));
-    // check if the previous index is closer
-    if (this->PipelineIndex > 0)
-    {
-      if (this->TimeSteps[this->PipelineIndex] - this->PipelineTime > this->PipelineTime - this->TimeSteps[this->PipelineIndex - 1])
-        this->PipelineIndex -= 1;
-    }
+    this->PipelineIndex = this->GetClosestTimeStepIndex(this->PipelineTime);
     // save old TimeRange and update new one
     int previousCacheTimeRange[2] = {this->CacheTimeRange[0], this->CacheTimeRange[1]};
     this->CacheTimeRange[0] = std::max(this->PipelineIndex - static_cast<int>(this->NumberOfTrailingFrames), 0);
@@ -137,6 +185,13 @@ int vtkTrailingFrame::RequestData(vtkInformation* request,
   vtkInformation *inInfo = inputVector[0]->GetInformationObject(0);
   vtkMultiBlockDataSet* output = vtkMultiBlockDataSet::GetData(outputVector);
 
+  vtkLidarReader* reader = this->GetFrameProvider();
+  if (reader)
+  {
+    this->RequestDataFromFrameProvider(reader, input, output);
+    return 1;
+  }
+
   // If the TimeSteps size is still zero, it means
   // that we are in the presence of a live source
   if (!this->TimeSteps.empty())
@@ -198,3 +253,65 @@ int vtkTrailingFrame::RequestData(vtkInformation* request,
   }
   return 1;
 }
+
+//----------------------------------------------------------------------------
+void vtkTrailingFrame::RequestDataFromFrameProvider(vtkLidarReader* reader,
+                                                    vtkPolyData* input,
+                                                    vtkMultiBlockDataSet* output)
+{
+  // the cached frames are outdated as soon as the reader or its interpreter changes
+  if (!this->UseCache || reader->GetMTime() != this->BatchCacheTime)
+  {
+    this->BatchCache.clear();
+    this->BatchCacheTime = reader->GetMTime();
+  }
+
+  // forget the frames which are outside of the trailing window
+  int firstIndex = std::max(this->PipelineIndex - static_cast<int>(this->NumberOfTrailingFrames), 0);
+  for (auto it = this->BatchCache.begin(); it != this->BatchCache.end();)
+  {
+    if (it->first < firstIndex || it->first > this->PipelineIndex)
+    {
+      it = this->BatchCache.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+
+  // the current frame is given by the pipeline
+  vtkNew<vtkPolyData> currentFrame;
+  currentFrame->ShallowCopy(input);
+  this->BatchCache[this->PipelineIndex] = currentFrame.GetPointer();
+
+  // ask all the missing frames at once, each block is filled as soon as it is decoded
+  std::vector<int> missingIndices;
+  for (int index = firstIndex; index < this->PipelineIndex; ++index)
+  {
+    if (!this->BatchCache.count(index))
+    {
+      missingIndices.push_back(index);
+    }
+  }
+  if (!missingIndices.empty())
+  {
+    size_t received = 0;
+    reader->GetTimeStepFrames(missingIndices,
+      [this, &received, &missingIndices](int index, vtkSmartPointer<vtkPolyData> frame)
+      {
+        this->BatchCache[index] = frame;
+        this->UpdateProgress(static_cast<double>(++received) / missingIndices.size());
+      });
+  }
+
+  // same layout as the pipeline mode: current frame => 0, current frame - 1 => 1, ...
+  unsigned int n = this->NumberOfTrailingFrames + 1;
+  output->SetNumberOfBlocks(n);
+  for (unsigned int i = 0; i < n; ++i)
+  {
+    int index = this->PipelineIndex - static_cast<int>(i);
+    auto it = this->BatchCache.find(index);
+    output->SetBlock(i, it != this->BatchCache.end() ? it->second.GetPointer() : nullptr);
+  }
+}
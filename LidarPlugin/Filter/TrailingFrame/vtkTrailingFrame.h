@@ -1,16 +1,25 @@
 #ifndef VTKTRAILINGFRAME_H
 #define VTKTRAILINGFRAME_H
 
+#include <map>
 #include <queue>
 
 #include "vtkPolyDataAlgorithm.h"
 #include <vtkNew.h>
 #include <vtkMultiBlockDataSet.h>
+#include <vtkSmartPointer.h>
+
+class vtkLidarReader;
 
 /**
  * @brief The vtkTrailingFrame class is a filter that combine consecutive timestep
  * of its input to produce a multiblock.
  * The input of this filter must produce only consecutive interger timestep.
+ *
+ * When the input is directly a vtkLidarReader and BatchRequest is enabled, the
+ * previous frames are not obtained by re-executing the pipeline once per timestep,
+ * but asked to the reader in a single batch, and only those which are not cached yet.
+ * The reader decodes them on several threads when its interpreter can be duplicated.
  */
 class VTK_EXPORT vtkTrailingFrame : public vtkPolyDataAlgorithm
 {
@@ -30,6 +39,12 @@ public:
   vtkSetMacro(UseCache, bool)
   //! @}
 
+  //! @{
+  //! @copydoc BatchRequest
+  vtkGetMacro(BatchRequest, bool)
+  void SetBatchRequest(bool value);
+  //! @}
+
 protected:
   vtkTrailingFrame() = default;
 
@@ -42,10 +57,22 @@ protected:
                   vtkInformationVector* outputVector) override;
 
 private:
+  //! Return the index of the time step closest to time
+  int GetClosestTimeStepIndex(double time);
+
+  //! Return the reader able to provide a batch of frames, nullptr if not available
+  vtkLidarReader* GetFrameProvider();
+
+  //! Fill the output using the frames cached or provided by the reader
+  void RequestDataFromFrameProvider(vtkLidarReader* reader, vtkPolyData* input,
+                                    vtkMultiBlockDataSet* output);
+
   //! Number of previous timestep to display
   unsigned int NumberOfTrailingFrames = 0;
   //! Should the internal cache be used for speed
   bool UseCache = true;
+  //! Ask the previous frames to the reader in one batch instead of through the pipeline
+  bool BatchRequest = false;
 
   //! Original pipeline time which must be restored after modifying the input filter time
   double PipelineTime = 0;
@@ -65,6 +92,11 @@ private:
   //! Help variable
   bool FirstFilterIteration = true;
 
+  //! Frames obtained in batch mode, by time step index
+  std::map<int, vtkSmartPointer<vtkPolyData>> BatchCache;
+  //! Modification time of the reader when BatchCache has been filled
+  vtkMTimeType BatchCacheTime = 0;
+
   vtkTrailingFrame(const vtkTrailingFrame&); // not implemented
   void operator=(const vtkTrailingFrame&); // not implemented
 };
@@ -0,0 +1,227 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vtkVoxelGridAccumulation.h"
+
+#include <vtkCellArray.h>
+#include <vtkDemandDrivenPipeline.h>
+#include <vtkFloatArray.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkUnsignedIntArray.h>
+
+#include <cmath>
+
+//-----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkVoxelGridAccumulation)
+
+//-----------------------------------------------------------------------------
+vtkVoxelGridAccumulation::vtkVoxelGridAccumulation()
+{
+  this->SetNumberOfInputPorts(1);
+  this->SetNumberOfOutputPorts(1);
+  // intensity array, optional
+  this->SetInputArrayToProcess(0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS, "intensity");
+  this->ResetAccumulation();
+}
+
+//-----------------------------------------------------------------------------
+void vtkVoxelGridAccumulation::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "LeafSize: " << this->LeafSize << std::endl;
+  os << indent << "ReductionMode: " << this->ReductionMode << std::endl;
+  os << indent << "NumberOfVoxels: " << this->GetNumberOfVoxels() << std::endl;
+  os << indent << "NumberOfAccumulatedFrames: " << this->NumberOfAccumulatedFrames << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+void vtkVoxelGridAccumulation::SetLeafSize(double value)
+{
+  value = std::max(value, 1e-6);
+  if (this->LeafSize != value)
+  {
+    this->LeafSize = value;
+    this->ResetAccumulation();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkVoxelGridAccumulation::SetReductionMode(int value)
+{
+  if (value != CENTROID && value != MAX_INTENSITY)
+  {
+    vtkErrorMacro("Unknown reduction mode " << value);
+    return;
+  }
+  if (this->ReductionMode != value)
+  {
+    this->ReductionMode = value;
+    this->ResetAccumulation();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkVoxelGridAccumulation::ResetAccumulation()
+{
+  this->ClearAccumulation();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkVoxelGridAccumulation::ClearAccumulation()
+{
+  this->VoxelIndices.clear();
+  this->CoordinatesSum.clear();
+  this->IntensitySum.clear();
+  this->AccumulatedTimes.clear();
+  this->LastInputTime = 0;
+  this->NumberOfAccumulatedFrames = 0;
+
+  this->Points = vtkSmartPointer<vtkPoints>::New();
+  this->Points->SetDataTypeToDouble();
+  this->Vertices = vtkSmartPointer<vtkCellArray>::New();
+  this->Intensity = vtkSmartPointer<vtkFloatArray>::New();
+  this->Intensity->SetName("intensity");
+  this->Count = vtkSmartPointer<vtkUnsignedIntArray>::New();
+  this->Count->SetName("voxel_count");
+}
+
+//-----------------------------------------------------------------------------
+size_t vtkVoxelGridAccumulation::VoxelKeyHash::operator()(const VoxelKey& key) const
+{
+  // large primes spread the neighbouring voxels over the buckets
+  return static_cast<size_t>(static_cast<uint64_t>(key[0]) * 73856093u ^
+                             static_cast<uint64_t>(key[1]) * 19349663u ^
+                             static_cast<uint64_t>(key[2]) * 83492791u);
+}
+
+//-----------------------------------------------------------------------------
+vtkVoxelGridAccumulation::VoxelKey vtkVoxelGridAccumulation::GetVoxelKey(const double point[3]) const
+{
+  VoxelKey key;
+  for (int i = 0; i < 3; ++i)
+  {
+    key[i] = static_cast<int64_t>(std::floor(point[i] / this->LeafSize));
+  }
+  return key;
+}
+
+//-----------------------------------------------------------------------------
+void vtkVoxelGridAccumulation::AddFrame(vtkPolyData* frame, vtkDataArray* intensity)
+{
+  const vtkIdType numberOfPoints = frame->GetNumberOfPoints();
+
+  double point[3];
+  for (vtkIdType i = 0; i < numberOfPoints; ++i)
+  {
+    frame->GetPoint(i, point);
+    const double value = intensity ? intensity->GetTuple1(i) : 0.;
+
+    auto inserted = this->VoxelIndices.emplace(this->GetVoxelKey(point),
+                                               this->Points->GetNumberOfPoints());
+    const vtkIdType voxel = inserted.first->second;
+    if (inserted.second)
+    {
+      // new voxel
+      this->Points->InsertNextPoint(point);
+      this->Vertices->InsertNextCell(1, &voxel);
+      this->Intensity->InsertNextValue(static_cast<float>(value));
+      this->Count->InsertNextValue(1);
+      this->CoordinatesSum.insert(this->CoordinatesSum.end(), point, point + 3);
+      this->IntensitySum.push_back(value);
+      continue;
+    }
+
+    const unsigned int count = this->Count->GetValue(voxel) + 1;
+    this->Count->SetValue(voxel, count);
+    if (this->ReductionMode == CENTROID)
+    {
+      double* sum = &this->CoordinatesSum[3 * voxel];
+      for (int k = 0; k < 3; ++k)
+      {
+        sum[k] += point[k];
+      }
+      this->Points->SetPoint(voxel, sum[0] / count, sum[1] / count, sum[2] / count);
+      this->IntensitySum[voxel] += value;
+      this->Intensity->SetValue(voxel, static_cast<float>(this->IntensitySum[voxel] / count));
+    }
+    else if (value > this->Intensity->GetValue(voxel))
+    {
+      this->Points->SetPoint(voxel, point);
+      this->Intensity->SetValue(voxel, static_cast<float>(value));
+    }
+  }
+  this->NumberOfAccumulatedFrames++;
+}
+
+//-----------------------------------------------------------------------------
+int vtkVoxelGridAccumulation::RequestData(vtkInformation* vtkNotUsed(request),
+                                          vtkInformationVector** inputVector,
+                                          vtkInformationVector* outputVector)
+{
+  vtkInformation* inInfo = inputVector[0]->GetInformationObject(0);
+  vtkPolyData* input = vtkPolyData::GetData(inInfo);
+  vtkPolyData* output = vtkPolyData::GetData(outputVector->GetInformationObject(0));
+
+  // Only add a frame once, identified by its time when available
+  bool isNewFrame = false;
+  vtkInformation* dataInfo = input->GetInformation();
+  if (dataInfo->Has(vtkDataObject::DATA_TIME_STEP()))
+  {
+    // the frames already accumulated are outdated when a filter or a source
+    // upstream is modified, changing the requested time does not modify them
+    const vtkMTimeType pipelineTime = inInfo->Get(vtkDemandDrivenPipeline::PIPELINE_MODIFIED_TIME());
+    if (pipelineTime != this->LastPipelineTime)
+    {
+      this->ClearAccumulation();
+      this->LastPipelineTime = pipelineTime;
+    }
+    isNewFrame = this->AccumulatedTimes.insert(dataInfo->Get(vtkDataObject::DATA_TIME_STEP())).second;
+  }
+  else if (input->GetMTime() != this->LastInputTime)
+  {
+    this->LastInputTime = input->GetMTime();
+    isNewFrame = true;
+  }
+
+  if (isNewFrame && input->GetNumberOfPoints() > 0)
+  {
+    this->AddFrame(input, this->GetInputArrayToProcess(0, inputVector));
+  }
+
+  // The accumulated cloud is updated in place by the next frames, the output
+  // gets its own copy so that the downstream filters and the previous outputs
+  // are not modified behind their back
+  vtkNew<vtkPoints> points;
+  points->DeepCopy(this->Points);
+  vtkNew<vtkCellArray> vertices;
+  vertices->DeepCopy(this->Vertices);
+  vtkNew<vtkFloatArray> intensity;
+  intensity->DeepCopy(this->Intensity);
+  vtkNew<vtkUnsignedIntArray> count;
+  count->DeepCopy(this->Count);
+
+  output->SetPoints(points);
+  output->SetVerts(vertices);
+  output->GetPointData()->AddArray(intensity);
+  output->GetPointData()->AddArray(count);
+  output->GetPointData()->SetActiveScalars(intensity->GetName());
+  return 1;
+}
@@ -0,0 +1,142 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VTKVOXELGRIDACCUMULATION_H
+#define VTKVOXELGRIDACCUMULATION_H
+
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkSmartPointer.h>
+
+#include <array>
+#include <cstdint>
+#include <set>
+#include <unordered_map>
+#include <vector>
+
+class vtkCellArray;
+class vtkFloatArray;
+class vtkPoints;
+class vtkUnsignedIntArray;
+
+/**
+ * @brief The vtkVoxelGridAccumulation class accumulates georeferenced frames
+ * (for example the output of vtkTemporalTransformsApplier) in a persistent voxel grid,
+ * and outputs a single point cloud with one point per occupied voxel.
+ *
+ * Each time the filter is executed with a new frame, the points of this frame are
+ * inserted in a hash map indexed by voxel; the frames already accumulated are not
+ * processed again. The memory and rendering cost therefore grow with the covered
+ * area instead of the number of frames. Modifying a filter or a source upstream
+ * clears the accumulation.
+ *
+ * The point representing a voxel is either the centroid of all the points that
+ * fell in it, or the point with the highest intensity. The intensity array is
+ * selected with SetInputArrayToProcess(0, ...), the output intensity is the mean
+ * or the maximum intensity depending on the reduction mode.
+ */
+class VTK_EXPORT vtkVoxelGridAccumulation : public vtkPolyDataAlgorithm
+{
+public:
+  static vtkVoxelGridAccumulation* New();
+  vtkTypeMacro(vtkVoxelGridAccumulation, vtkPolyDataAlgorithm)
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum ReductionModes
+  {
+    CENTROID = 0,      /*!< centroid of the points of the voxel */
+    MAX_INTENSITY = 1, /*!< point of the voxel with the highest intensity */
+  };
+
+  //! Size of a voxel edge, changing it resets the accumulation
+  vtkGetMacro(LeafSize, double)
+  void SetLeafSize(double value);
+
+  //! Changing the reduction mode resets the accumulation
+  vtkGetMacro(ReductionMode, int)
+  void SetReductionMode(int value);
+
+  //! Remove all the accumulated points
+  void ResetAccumulation();
+
+  //! Number of occupied voxels
+  vtkIdType GetNumberOfVoxels() const { return static_cast<vtkIdType>(this->VoxelIndices.size()); }
+
+  //! Number of frames accumulated since the last reset
+  vtkGetMacro(NumberOfAccumulatedFrames, int)
+
+protected:
+  vtkVoxelGridAccumulation();
+  ~vtkVoxelGridAccumulation() = default;
+
+  int RequestData(vtkInformation* request,
+                  vtkInformationVector** inputVector,
+                  vtkInformationVector* outputVector) override;
+
+  //! Insert the points of a frame in the voxel grid
+  void AddFrame(vtkPolyData* frame, vtkDataArray* intensity);
+
+  //! Edge of a voxel, in the unit of the input points
+  double LeafSize = 0.2;
+
+  int ReductionMode = CENTROID;
+
+private:
+  //! Indices of a voxel along each axis
+  using VoxelKey = std::array<int64_t, 3>;
+
+  struct VoxelKeyHash
+  {
+    size_t operator()(const VoxelKey& key) const;
+  };
+
+  //! Remove all the accumulated points without modifying the filter
+  void ClearAccumulation();
+
+  //! Key of the voxel containing a point
+  VoxelKey GetVoxelKey(const double point[3]) const;
+
+  //! Voxel index by key, the index is also the id of the output point
+  std::unordered_map<VoxelKey, vtkIdType, VoxelKeyHash> VoxelIndices;
+
+  //! Sum of the coordinates of the points of each voxel, used for the centroid
+  std::vector<double> CoordinatesSum;
+
+  //! Sum of the intensities of each voxel, used for the mean intensity
+  std::vector<double> IntensitySum;
+
+  //! Accumulated cloud, updated in place when new frames are added and copied
+  //! to the output. The points are stored in double as georeferenced
+  //! coordinates do not fit in a float
+  vtkSmartPointer<vtkPoints> Points;
+  vtkSmartPointer<vtkCellArray> Vertices;
+  vtkSmartPointer<vtkFloatArray> Intensity;
+  vtkSmartPointer<vtkUnsignedIntArray> Count;
+
+  //! Time of the frames already accumulated, to not add the same frame twice
+  std::set<double> AccumulatedTimes;
+
+  //! Modification time of the pipeline upstream when the accumulated frames
+  //! have a time, the accumulation is cleared when it changes
+  vtkMTimeType LastPipelineTime = 0;
+
+  //! Modification time of the last frame accumulated when no time is available (live)
+  vtkMTimeType LastInputTime = 0;
+
+  int NumberOfAccumulatedFrames = 0;
+
+  vtkVoxelGridAccumulation(const vtkVoxelGridAccumulation&) = delete;
+  void operator=(const vtkVoxelGridAccumulation&) = delete;
+};
+
+#endif // VTKVOXELGRIDACCUMULATION_H
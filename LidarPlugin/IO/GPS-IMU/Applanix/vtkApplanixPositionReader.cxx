@@ -29,10 +29,12 @@
 #include "vtkApplanixPositionReader.h"
 
 #include "vtkCustomTransformInterpolator.h"
+#include "MappedTextFile.h"
 
 #include <vtkCellArray.h>
 #include <vtkDoubleArray.h>
 #include <vtkInformationVector.h>
+#include <vtkIntArray.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
@@ -43,40 +45,155 @@
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 
-#include <map>
-
-#define DATA_ARRAY(name)                                                                           \
-  vtkNew<vtkDoubleArray> name##Data;                                                               \
-  name##Data->SetName(#name)
+#include <algorithm>
+#include <array>
+#include <utility>
 
 namespace
 {
-typedef std::map<std::string, size_t> FieldIndexMap;
-typedef std::map<size_t, vtkDoubleArray*> FieldDataMap;
+//! Identifies the cached columns, to change when the parsing changes
+const char* CacheFormat = "vtkApplanixPositionReader 1";
+
+//! Fields of the file header that are read, and the arrays they are read in
+const std::pair<const char*, const char*> ApplanixFields[] = {
+  { "TIME", "time" },
+  { "DISTANCE", "distance" },
+  { "EASTING", "easting" },
+  { "NORTHING", "northing" },
+  { "ELLIPSOID HEIGHT", "height" },
+  { "LATITUDE", "lat" },
+  { "LONGITUDE", "lon" },
+  { "ROLL", "roll" },
+  { "PITCH", "pitch" },
+  { "HEADING", "heading" }
+};
+const size_t NumberOfApplanixFields = sizeof(ApplanixFields) / sizeof(ApplanixFields[0]);
+
+//! Arrays that must have a value for each record
+const char* PositionArrays[] = { "time", "easting", "northing", "height", "roll", "pitch", "heading" };
 }
 
 //-----------------------------------------------------------------------------
 class vtkApplanixPositionReader::vtkInternal
 {
 public:
-  void SetMapping(const std::string& fieldName, vtkNew<vtkDoubleArray>& array);
+  //! Fill the "zone" column and the columns of the fields present in the file
+  bool ReadColumns(const char* filename, ColumnStore& columns, size_t& numberOfMalformedLines);
 
   vtkNew<vtkCustomTransformInterpolator> Interpolator;
   vtkNew<vtkTransform> CalibrationTransform;
-
-  FieldIndexMap Fields;
-  FieldDataMap FieldMapping;
 };
 
 //-----------------------------------------------------------------------------
-void vtkApplanixPositionReader::vtkInternal::SetMapping(
-  const std::string& fieldName, vtkNew<vtkDoubleArray>& array)
+bool vtkApplanixPositionReader::vtkInternal::ReadColumns(
+  const char* filename, ColumnStore& columns, size_t& numberOfMalformedLines)
 {
-  FieldIndexMap::iterator field = this->Fields.find(fieldName);
-  if (field != this->Fields.end())
+  MappedTextFile text;
+  if (!text.Open(filename))
   {
-    this->FieldMapping.insert(std::make_pair(field->second, array.GetPointer()));
+    return false;
   }
+  const char* data = text.GetData();
+  const char* end = data + text.GetSize();
+
+  columns = ColumnStore();
+  size_t zoneColumn = columns.AddColumn("zone");
+
+  // Read header
+  std::string lastLine;
+  std::vector<std::string> fields;
+  size_t dataOffset = text.GetSize();
+  for (const char* line = data; line < end;)
+  {
+    const char* nextLine = MappedTextFile::NextLine(line, end);
+    const char* lineEnd = nextLine;
+    MappedTextFile::Trim(line, lineEnd);
+    std::string headerLine(line, lineEnd);
+    line = nextLine;
+    if (headerLine.empty())
+    {
+      continue;
+    }
+
+    if (boost::starts_with(headerLine, "central meridian"))
+    {
+      std::vector<std::string> parts;
+      boost::algorithm::split(
+        parts, headerLine, boost::is_any_of(" "), boost::algorithm::token_compress_on);
+
+      columns.Columns[zoneColumn].push_back(
+        static_cast<int>(186 + boost::lexical_cast<double>(parts[3])) / 6);
+    }
+
+    if (headerLine[0] == '(')
+    {
+      // Fields names are on the previous line
+      boost::algorithm::split(
+        fields, lastLine, boost::is_any_of(","), boost::algorithm::token_compress_on);
+      for (std::string& field : fields)
+      {
+        boost::algorithm::trim(field);
+      }
+
+      // Done with header
+      dataOffset = nextLine - data;
+      break;
+    }
+
+    lastLine = headerLine;
+  }
+
+  // Set up field index to column mapping, in the order of the fields
+  std::vector<std::pair<size_t, const char*>> fieldArrays;
+  for (const auto& field : ApplanixFields)
+  {
+    auto index = std::find(fields.begin(), fields.end(), field.first);
+    if (index != fields.end())
+    {
+      fieldArrays.emplace_back(index - fields.begin(), field.second);
+    }
+  }
+  std::sort(fieldArrays.begin(), fieldArrays.end());
+  for (const auto& fieldArray : fieldArrays)
+  {
+    columns.AddColumn(fieldArray.second);
+  }
+
+  // Read data, in parallel
+  const size_t numFields = fields.size();
+  auto parseLine = [numFields, &fieldArrays](const char* begin, const char* lineEnd, ColumnStore& chunk)
+  {
+    // Split into fields separated by spaces, and only parse the mapped ones
+    std::array<double, NumberOfApplanixFields> values;
+    size_t numberOfWords = 0;
+    size_t mapped = 0;
+    for (const char* word = begin; word != lineEnd; ++numberOfWords)
+    {
+      const char* wordEnd = std::find(word, lineEnd, ' ');
+      if (mapped < fieldArrays.size() && fieldArrays[mapped].first == numberOfWords)
+      {
+        if (!MappedTextFile::ParseDouble(word, wordEnd, values[mapped]))
+        {
+          return false;
+        }
+        mapped++;
+      }
+      word = std::find_if(wordEnd, lineEnd, [](char c) { return c != ' '; });
+    }
+    if (numberOfWords < numFields)
+    {
+      return false;
+    }
+
+    // Assign values to data columns, the first one is the zone
+    for (size_t i = 0; i < fieldArrays.size(); ++i)
+    {
+      chunk.Columns[i + 1].push_back(values[i]);
+    }
+    return true;
+  };
+  numberOfMalformedLines = text.ParseLines(dataOffset, parseLine, columns);
+  return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -91,6 +208,7 @@ vtkApplanixPositionReader::vtkApplanixPositionReader()
   this->BaseRoll = 0.0;
   this->BasePitch = 0.0;
   this->TimeOffset = 16.0; // correct for at least 2012-Jul - 2015-May
+  this->CacheColumns = false;
   this->Internal->CalibrationTransform->Identity();
 
   this->SetNumberOfInputPorts(0);
@@ -122,131 +240,66 @@ int vtkApplanixPositionReader::RequestData(
     return VTK_ERROR;
   }
 
-  vtkNew<vtkPoints> points;
-  vtkNew<vtkCellArray> cells;
-  vtkNew<vtkPolyLine> polyLine;
-  vtkIdList* polyIds = polyLine->GetPointIds();
-
-  // Data arrays
-  DATA_ARRAY(time);
-  DATA_ARRAY(distance);
-  DATA_ARRAY(easting);
-  DATA_ARRAY(northing);
-  DATA_ARRAY(height);
-  DATA_ARRAY(lat);
-  DATA_ARRAY(lon);
-  DATA_ARRAY(roll);
-  DATA_ARRAY(pitch);
-  DATA_ARRAY(heading);
-  vtkNew<vtkIntArray> zoneData;
-  zoneData->SetName("zone");
-
-  // Open data file
-  std::ifstream f(this->FileName);
-  if (!f.good())
+  // Read the columns of the records, from the cache when it is up to date
+  ColumnStore columns;
+  const std::string cacheFileName = std::string(this->FileName) + ".columns";
+  if (!this->CacheColumns || !columns.Load(cacheFileName, this->FileName, CacheFormat))
   {
-    vtkErrorMacro("Failed to open input file \"" << this->FileName << "\"");
-    return VTK_ERROR;
-  }
-
-  std::string line;
-  std::string lastLine;
-
-  // Read header
-  size_t numFields = 0;
-  while (std::getline(f, line))
-  {
-    boost::algorithm::trim(line);
-    if (line.empty())
+    size_t numberOfMalformedLines = 0;
+    if (!this->Internal->ReadColumns(this->FileName, columns, numberOfMalformedLines))
     {
-      continue;
+      vtkErrorMacro("Failed to open input file \"" << this->FileName << "\"");
+      return VTK_ERROR;
     }
-
-    if (boost::starts_with(line, "central meridian"))
+    if (numberOfMalformedLines > 0)
     {
-      std::vector<std::string> parts;
-      boost::algorithm::split(
-        parts, line, boost::is_any_of(" "), boost::algorithm::token_compress_on);
-
-      zoneData->InsertNextValue(static_cast<int>(186 + boost::lexical_cast<double>(parts[3])) / 6);
+      vtkWarningMacro(<< numberOfMalformedLines << " lines of \"" << this->FileName
+                      << "\" do not have the expected fields and were skipped");
     }
-
-    if (line[0] == '(')
+    if (this->CacheColumns && !columns.Save(cacheFileName, this->FileName, CacheFormat))
     {
-      // Set up field index mapping
-      std::vector<std::string> fields;
-      boost::algorithm::split(
-        fields, lastLine, boost::is_any_of(","), boost::algorithm::token_compress_on);
-
-      numFields = fields.size();
-      for (size_t n = 0; n < numFields; ++n)
-      {
-        boost::algorithm::trim(fields[n]);
-        this->Internal->Fields.insert(std::make_pair(fields[n], n));
-      }
-
-      // Done with header
-      break;
+      vtkWarningMacro("Could not write the cache file \"" << cacheFileName << "\"");
     }
-
-    lastLine = line;
   }
 
-  // Set up data array mapping
-  this->Internal->SetMapping("TIME", timeData);
-  this->Internal->SetMapping("DISTANCE", distanceData);
-  this->Internal->SetMapping("EASTING", eastingData);
-  this->Internal->SetMapping("NORTHING", northingData);
-  this->Internal->SetMapping("ELLIPSOID HEIGHT", heightData);
-  this->Internal->SetMapping("LATITUDE", latData);
-  this->Internal->SetMapping("LONGITUDE", lonData);
-  this->Internal->SetMapping("ROLL", rollData);
-  this->Internal->SetMapping("PITCH", pitchData);
-  this->Internal->SetMapping("HEADING", headingData);
-
-  // Read data
-  vtkIdType count = 0;
-  while (std::getline(f, line))
+  vtkNew<vtkIntArray> zoneData;
+  zoneData->SetName("zone");
+  for (double zone : columns.Columns[0])
   {
-    boost::algorithm::trim(line);
-    if (line.empty())
-    {
-      continue;
-    }
-
-    // Split into fields
-    std::vector<std::string> fields;
-    boost::algorithm::split(
-      fields, line, boost::is_any_of(" "), boost::algorithm::token_compress_on);
-
-    if (fields.size() < numFields)
-    {
-      vtkWarningMacro("Line '" << line << "' has only " << fields.size() << "fields "
-                               << "(expected " << numFields << ")");
-      continue;
-    }
-
-    // Assign values to data arrays
-    for (FieldDataMap::iterator iter = this->Internal->FieldMapping.begin();
-         iter != this->Internal->FieldMapping.end(); ++iter)
-    {
-      const double value = boost::lexical_cast<double>(fields[iter->first]);
-      iter->second->InsertNextValue(value);
-    }
-
-    ++count;
+    zoneData->InsertNextValue(static_cast<int>(zone));
   }
 
   // Verify position information
-  if (timeData->GetNumberOfTuples() != count || eastingData->GetNumberOfTuples() != count ||
-    northingData->GetNumberOfTuples() != count || heightData->GetNumberOfTuples() != count ||
-    rollData->GetNumberOfTuples() != count || pitchData->GetNumberOfTuples() != count ||
-    headingData->GetNumberOfTuples() != count)
+  const vtkIdType count = columns.Columns.size() > 1 ? columns.Columns[1].size() : 0;
+  for (const char* name : PositionArrays)
   {
-    vtkErrorMacro("Failed to extract points: one or more position fields has fewer values"
-                  " than the number of readable records in the input file");
-    return VTK_ERROR;
+    int column = columns.FindColumn(name);
+    if ((column < 0 && count > 0) ||
+        (column >= 0 && static_cast<vtkIdType>(columns.Columns[column].size()) != count))
+    {
+      vtkErrorMacro("Failed to extract points: one or more position fields has fewer values"
+                    " than the number of readable records in the input file");
+      return VTK_ERROR;
+    }
   }
+  static const std::vector<double> noValues;
+  auto getColumn = [&columns](const char* name) -> const std::vector<double>&
+  {
+    int column = columns.FindColumn(name);
+    return column >= 0 ? columns.Columns[column] : noValues;
+  };
+  const std::vector<double>& timeData = getColumn("time");
+  const std::vector<double>& eastingData = getColumn("easting");
+  const std::vector<double>& northingData = getColumn("northing");
+  const std::vector<double>& heightData = getColumn("height");
+  const std::vector<double>& rollData = getColumn("roll");
+  const std::vector<double>& pitchData = getColumn("pitch");
+  const std::vector<double>& headingData = getColumn("heading");
+
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkCellArray> cells;
+  vtkNew<vtkPolyLine> polyLine;
+  vtkIdList* polyIds = polyLine->GetPointIds();
 
   // Build polyline and transform interpolator
   points->Allocate(count);
@@ -261,15 +314,15 @@ int vtkApplanixPositionReader::RequestData(
   {
     if (n == 0)
     {
-      firstPos[0] = eastingData->GetValue(n);
-      firstPos[1] = northingData->GetValue(n);
-      firstPos[2] = heightData->GetValue(n);
+      firstPos[0] = eastingData[n];
+      firstPos[1] = northingData[n];
+      firstPos[2] = heightData[n];
     }
     else
     {
-      pos[0] = eastingData->GetValue(n) - firstPos[0];
-      pos[1] = northingData->GetValue(n) - firstPos[1];
-      pos[2] = heightData->GetValue(n) - firstPos[2];
+      pos[0] = eastingData[n] - firstPos[0];
+      pos[1] = northingData[n] - firstPos[1];
+      pos[2] = heightData[n] - firstPos[2];
     }
 
     points->InsertNextPoint(pos);
@@ -285,9 +338,9 @@ int vtkApplanixPositionReader::RequestData(
     // from the GPS to the world georeferenced frame
     vtkNew<vtkTransform> transformGpsWorld, transformVehiculeWorld;
     transformGpsWorld->PostMultiply();
-    transformGpsWorld->RotateX(rollData->GetValue(n));
-    transformGpsWorld->RotateY(pitchData->GetValue(n));
-    transformGpsWorld->RotateZ(headingData->GetValue(n));
+    transformGpsWorld->RotateX(rollData[n]);
+    transformGpsWorld->RotateY(pitchData[n]);
+    transformGpsWorld->RotateZ(headingData[n]);
     transformGpsWorld->Translate(pos);
 
     // Compute transform from vehicule to GPS
@@ -301,7 +354,7 @@ int vtkApplanixPositionReader::RequestData(
     transformVehiculeWorld->Modified();
 
     // Add the transform to the interpolator
-    const double timestamp = timeData->GetValue(n) - this->TimeOffset;
+    const double timestamp = timeData[n] - this->TimeOffset;
     this->Internal->Interpolator->AddTransform(timestamp, transformVehiculeWorld.GetPointer());
   }
 
@@ -312,10 +365,13 @@ int vtkApplanixPositionReader::RequestData(
   output->SetLines(cells.GetPointer());
 
   output->GetFieldData()->AddArray(zoneData.GetPointer());
-  for (FieldDataMap::iterator iter = this->Internal->FieldMapping.begin();
-       iter != this->Internal->FieldMapping.end(); ++iter)
+  for (size_t column = 1; column < columns.Columns.size(); ++column)
   {
-    output->GetPointData()->AddArray(iter->second);
+    vtkNew<vtkDoubleArray> array;
+    array->SetName(columns.Names[column].c_str());
+    array->SetNumberOfTuples(static_cast<vtkIdType>(columns.Columns[column].size()));
+    std::copy(columns.Columns[column].begin(), columns.Columns[column].end(), array->GetPointer(0));
+    output->GetPointData()->AddArray(array.GetPointer());
   }
 
   return VTK_OK;
@@ -73,6 +73,14 @@ public:
   vtkSetMacro(TimeOffset, double);
   vtkGetMacro(TimeOffset, double);
 
+  // Description:
+  // Set/Get whether the records are saved in a binary cache next to the file
+  // (FileName + ".columns"), so that the next readings of an unchanged file
+  // do not parse the text again.
+  vtkSetMacro(CacheColumns, bool);
+  vtkGetMacro(CacheColumns, bool);
+  vtkBooleanMacro(CacheColumns, bool);
+
   void SetCalibrationTransform(vtkTransform* transform);
 
   // Description:
@@ -92,6 +100,8 @@ protected:
 
   double TimeOffset;
 
+  bool CacheColumns;
+
   class vtkInternal;
   vtkInternal* Internal;
 
@@ -2,14 +2,85 @@
 
 #include <stdio.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include <vtkObjectFactory.h>
 #include <vtkInformationVector.h>
 
-#include <boost/algorithm/string.hpp>
-
 #include <Eigen/Geometry>
 
 #include "GPSProjectionUtils.h"
+#include "MappedTextFile.h"
+
+namespace
+{
+//! Identifies the cached columns, to change when the parsing changes
+const char* CacheFormat = "vtkArduPilotDataFlashLogReader 1";
+
+enum GPSColumns
+{
+  GMS_COLUMN = 0,
+  LAT_COLUMN,
+  LNG_COLUMN,
+  ALT_COLUMN
+};
+
+//-----------------------------------------------------------------------------
+bool ParseGPS2Line(const char* begin, const char* end, ColumnStore& columns)
+{
+  if (end - begin < 4 || std::strncmp(begin, "GPS2", 4) != 0)
+  {
+    // other messages are not read
+    return true;
+  }
+
+  // GPS2 lines contain fields:
+  // TimeUS,Status,GMS,GWk,NSats,HDop,Lat,Lng,Alt,Spd,GCrs,VZ,U
+  // Useful: https://groups.google.com/forum/#!topic/swiftnav-discuss/XOr7WQto9ZI
+  // quoting from: https://discuss.ardupilot.org/t/correct-gps-time-stamp/14329
+  // "GMS and GWK would be the best way to get the current gps time yes.
+  // the tick with that though is there is latency vs the measurement data.
+  // so correlating that data could be interesting."
+  // GMS = GPS ms since beginning of week
+  // GWk = None # GPS week (a GPS week is 7*24h afaik)
+  // Status: 0 = no GPS, 1 = GPS but no fix, 2 = GPS with 2D fix, 3 = GPS with 3D fix
+  // I beleive "Alt" is altitude over ellipsoid (WGS84, standard for GPS)
+  // but it could be height above geoid.
+  const size_t elementColumns[][2] = {
+    { 3, GMS_COLUMN }, // ms since beginning of GPS week
+    { 7, LAT_COLUMN }, // latitude in degrees
+    { 8, LNG_COLUMN }, // longitude in degrees
+    { 9, ALT_COLUMN }  // in meters
+  };
+  auto isSeparator = [](char c) { return c == ',' || c == ' '; };
+  double values[4];
+  size_t parsed = 0;
+  size_t element = 0;
+  for (const char* word = begin; word != end && parsed < 4; ++element)
+  {
+    const char* wordEnd = std::find_if(word, end, isSeparator);
+    if (element == elementColumns[parsed][0])
+    {
+      if (!MappedTextFile::ParseDouble(word, wordEnd, values[parsed]))
+      {
+        return false;
+      }
+      parsed++;
+    }
+    word = std::find_if_not(wordEnd, end, isSeparator);
+  }
+  if (parsed < 4)
+  {
+    return false;
+  }
+  for (size_t i = 0; i < 4; ++i)
+  {
+    columns.Columns[elementColumns[i][1]].push_back(values[i]);
+  }
+  return true;
+}
+}
 
 //-----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkArduPilotDataFlashLogReader)
@@ -25,74 +96,72 @@ vtkArduPilotDataFlashLogReader::vtkArduPilotDataFlashLogReader()
 //-----------------------------------------------------------------------------
 int vtkArduPilotDataFlashLogReader::RequestData(vtkInformation *, vtkInformationVector **, vtkInformationVector *outputVector)
 {
-  std::ifstream f(this->FileName);
-  if (!f.good())
+  if (!this->FileName || !*this->FileName)
   {
-    vtkErrorMacro("Failed to open input file \"" << this->FileName << "\"");
+    vtkErrorMacro("FileName has not been set");
     return VTK_ERROR;
   }
 
+  // Read the GPS messages, in parallel or from the cache when it is up to date
+  ColumnStore columns;
+  const std::string cacheFileName = std::string(this->FileName) + ".columns";
+  if (!this->CacheColumns || !columns.Load(cacheFileName, this->FileName, CacheFormat))
+  {
+    MappedTextFile text;
+    if (!text.Open(this->FileName))
+    {
+      vtkErrorMacro("Failed to open input file \"" << this->FileName << "\"");
+      return VTK_ERROR;
+    }
+    columns.AddColumn("GMS");
+    columns.AddColumn("Lat");
+    columns.AddColumn("Lng");
+    columns.AddColumn("Alt");
+    size_t numberOfMalformedLines = text.ParseLines(0, ParseGPS2Line, columns);
+    if (numberOfMalformedLines > 0)
+    {
+      vtkWarningMacro(<< numberOfMalformedLines << " GPS2 messages of \"" << this->FileName
+                      << "\" could not be parsed and were skipped");
+    }
+    if (this->CacheColumns && !columns.Save(cacheFileName, this->FileName, CacheFormat))
+    {
+      vtkWarningMacro("Could not write the cache file \"" << cacheFileName << "\"");
+    }
+  }
+
   bool offsetFound = false;
   Eigen::Vector3d offset;
-  std::string line;
-  while (std::getline(f, line))
+  UTMProjector proj;
+  for (size_t i = 0; i < columns.Columns[GMS_COLUMN].size(); ++i)
   {
-    boost::algorithm::trim(line);
-    if (line.empty())
+    double GMS = columns.Columns[GMS_COLUMN][i];
+    double lat = columns.Columns[LAT_COLUMN][i];
+    double lng = columns.Columns[LNG_COLUMN][i];
+    double alt = columns.Columns[ALT_COLUMN][i];
+
+    double Time = GMS / 1e3;
+
+    double z = alt;
+    double easting, northing;
+    proj.Project(lat, lng, easting, northing);
+    Eigen::Vector3d  position;
+    position << easting, northing, z; // ENU referential (right hand oriented)
+    if (offsetFound)
     {
-      continue;
+      position = position - offset;
     }
-
-    if (boost::starts_with(line, "GPS2"))
+    else
     {
-      // GPS2 lines contain fields:
-      // TimeUS,Status,GMS,GWk,NSats,HDop,Lat,Lng,Alt,Spd,GCrs,VZ,U
-      // Useful: https://groups.google.com/forum/#!topic/swiftnav-discuss/XOr7WQto9ZI
-      // quoting from: https://discuss.ardupilot.org/t/correct-gps-time-stamp/14329
-      // "GMS and GWK would be the best way to get the current gps time yes.
-      // the tick with that though is there is latency vs the measurement data.
-      // so correlating that data could be interesting."
-      // GMS = GPS ms since beginning of week
-      // GWk = None # GPS week (a GPS week is 7*24h afaik)
-      // Status: 0 = no GPS, 1 = GPS but no fix, 2 = GPS with 2D fix, 3 = GPS with 3D fix
-
-
-      std::vector<std::string> elements;
-      boost::algorithm::split(
-        elements, line, boost::is_any_of(", "), boost::token_compress_on);
-
-      double GMS = std::stod(elements[3]); // ms since beginning of GPS week
-      double lat = std::stod(elements[7]); // latitude in degrees
-      double lng = std::stod(elements[8]); // longitude in degrees
-      // I beleive "Alt" is altitude over ellipsoid (WGS84, standard for GPS)
-      // but it could be height above geoid.
-      double alt = std::stod(elements[9]); // in meters
-
-      double Time = GMS / 1e3;
-
-      double z = alt;
-      double easting, northing;
-      UTMProjector proj;
-      proj.Project(lat, lng, easting, northing);
-      Eigen::Vector3d  position;
-      position << easting, northing, z; // ENU referential (right hand oriented)
-      if (offsetFound)
-      {
-        position = position - offset;
-      }
-      else
-      {
-        this->SignedUTMZone = proj.SignedUTMZone;
-        offset = position;
-        position = Eigen::Vector3d::Zero();
-        this->Offset[0] = offset[0];
-        this->Offset[1] = offset[1];
-        this->Offset[2] = offset[2];
-        offsetFound = true;
-      }
-
-      GPSTrajectory->PushBack(Time + TimeOffset, Eigen::AngleAxisd(0.0, Eigen::Vector3d::UnitX()), position);
+      this->SignedUTMZone = proj.SignedUTMZone;
+      offset = position;
+      position = Eigen::Vector3d::Zero();
+      this->Offset[0] = offset[0];
+      this->Offset[1] = offset[1];
+      this->Offset[2] = offset[2];
+      offsetFound = true;
     }
+
+    GPSTrajectory->PushBack(Time + TimeOffset, Eigen::AngleAxisd(0.0, Eigen::Vector3d::UnitX()), position);
   }
 
   auto *output = vtkPolyData::GetData(outputVector->GetInformationObject(0));
@@ -40,6 +40,10 @@ public:
   vtkGetMacro(TimeOffset, double)
   vtkSetMacro(TimeOffset, double)
 
+  //! Save the GPS messages in a binary cache next to the file (FileName + ".columns")
+  vtkGetMacro(CacheColumns, bool)
+  vtkSetMacro(CacheColumns, bool)
+
   vtkGetMacro(SignedUTMZone, int)
 
   vtkGetVector3Macro(Offset, double)
@@ -52,6 +56,7 @@ protected:
 
   char* FileName = nullptr;
   double TimeOffset = 0.0; // in seconds, used as input to allow timeshifting
+  bool CacheColumns = false;
   int SignedUTMZone; // UTM zone used. +N means "UTM zone N North" (South if -N)
   // Offset is the (easting, northing, altitude) that is used as an offset for
   // the whole trajectory, in order to work with reasonably big coordinates.
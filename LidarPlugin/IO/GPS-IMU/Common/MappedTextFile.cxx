@@ -0,0 +1,358 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "MappedTextFile.h"
+#include "NumberParsing.h"
+
+#include <boost/filesystem.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/stat.h>
+#endif
+
+namespace
+{
+//! Chunks smaller than this are not worth a thread
+const size_t MinimumChunkSize = 1 << 20;
+
+const char CacheMagic[8] = { 'L', 'V', 'C', 'O', 'L', 'U', 'M', 'N' };
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief GetSourceStamp get the size and the modification time of a file, with
+ * the finest resolution available: a log rewritten within the same second
+ * with the same size must not match the cache.
+ * @param time modification time, in units specific to the platform
+ */
+bool GetSourceStamp(const std::string& sourceFilename, uint64_t& size, int64_t& time)
+{
+#if defined(_WIN32)
+  WIN32_FILE_ATTRIBUTE_DATA attributes;
+  if (!GetFileAttributesExA(sourceFilename.c_str(), GetFileExInfoStandard, &attributes))
+  {
+    return false;
+  }
+  size = (static_cast<uint64_t>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow;
+  // 100 ns ticks
+  time = static_cast<int64_t>((static_cast<uint64_t>(attributes.ftLastWriteTime.dwHighDateTime) << 32) |
+                              attributes.ftLastWriteTime.dwLowDateTime);
+#else
+  struct stat status;
+  if (stat(sourceFilename.c_str(), &status) != 0)
+  {
+    return false;
+  }
+  size = static_cast<uint64_t>(status.st_size);
+  // nanoseconds
+#if defined(__APPLE__)
+  const struct timespec& modification = status.st_mtimespec;
+#else
+  const struct timespec& modification = status.st_mtim;
+#endif
+  time = static_cast<int64_t>(modification.tv_sec) * 1000000000 + modification.tv_nsec;
+#endif
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+void Write(std::ofstream& file, const T& value)
+{
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+bool Read(std::ifstream& file, T& value)
+{
+  return static_cast<bool>(file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+//-----------------------------------------------------------------------------
+void WriteString(std::ofstream& file, const std::string& str)
+{
+  Write(file, static_cast<uint32_t>(str.size()));
+  file.write(str.data(), str.size());
+}
+
+//-----------------------------------------------------------------------------
+bool ReadString(std::ifstream& file, std::string& str)
+{
+  uint32_t size;
+  if (!Read(file, size) || size > 4096)
+  {
+    return false;
+  }
+  str.resize(size);
+  return size == 0 || static_cast<bool>(file.read(&str[0], size));
+}
+}
+
+//-----------------------------------------------------------------------------
+size_t ColumnStore::AddColumn(const std::string& name)
+{
+  this->Names.push_back(name);
+  this->Columns.emplace_back();
+  return this->Columns.size() - 1;
+}
+
+//-----------------------------------------------------------------------------
+int ColumnStore::FindColumn(const std::string& name) const
+{
+  auto it = std::find(this->Names.begin(), this->Names.end(), name);
+  return it != this->Names.end() ? static_cast<int>(it - this->Names.begin()) : -1;
+}
+
+//-----------------------------------------------------------------------------
+ColumnStore ColumnStore::EmptyCopy() const
+{
+  ColumnStore copy;
+  copy.Names = this->Names;
+  copy.Columns.resize(this->Columns.size());
+  return copy;
+}
+
+//-----------------------------------------------------------------------------
+void ColumnStore::Append(const ColumnStore& other)
+{
+  for (size_t i = 0; i < this->Columns.size() && i < other.Columns.size(); ++i)
+  {
+    this->Columns[i].insert(this->Columns[i].end(), other.Columns[i].begin(), other.Columns[i].end());
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool ColumnStore::Save(const std::string& filename, const std::string& sourceFilename,
+                       const std::string& format) const
+{
+  uint64_t sourceSize;
+  int64_t sourceTime;
+  if (!GetSourceStamp(sourceFilename, sourceSize, sourceTime))
+  {
+    return false;
+  }
+
+  std::ofstream file(filename, std::ios::binary);
+  if (!file)
+  {
+    return false;
+  }
+  file.write(CacheMagic, sizeof(CacheMagic));
+  WriteString(file, format);
+  Write(file, sourceSize);
+  Write(file, sourceTime);
+  Write(file, static_cast<uint32_t>(this->Columns.size()));
+  for (size_t i = 0; i < this->Columns.size(); ++i)
+  {
+    WriteString(file, this->Names[i]);
+    Write(file, static_cast<uint64_t>(this->Columns[i].size()));
+    file.write(reinterpret_cast<const char*>(this->Columns[i].data()),
+               this->Columns[i].size() * sizeof(double));
+  }
+  file.close();
+  if (!file)
+  {
+    // do not leave a truncated cache behind
+    boost::system::error_code error;
+    boost::filesystem::remove(filename, error);
+    return false;
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool ColumnStore::Load(const std::string& filename, const std::string& sourceFilename,
+                       const std::string& format)
+{
+  uint64_t sourceSize, cachedSourceSize;
+  int64_t sourceTime, cachedSourceTime;
+  if (!GetSourceStamp(sourceFilename, sourceSize, sourceTime))
+  {
+    return false;
+  }
+
+  std::ifstream file(filename, std::ios::binary);
+  char magic[sizeof(CacheMagic)];
+  std::string cachedFormat;
+  uint32_t numberOfColumns;
+  if (!file || !file.read(magic, sizeof(magic)) ||
+      !std::equal(magic, magic + sizeof(magic), CacheMagic) ||
+      !ReadString(file, cachedFormat) || cachedFormat != format ||
+      !Read(file, cachedSourceSize) || cachedSourceSize != sourceSize ||
+      !Read(file, cachedSourceTime) || cachedSourceTime != sourceTime ||
+      !Read(file, numberOfColumns))
+  {
+    return false;
+  }
+
+  ColumnStore loaded;
+  for (uint32_t i = 0; i < numberOfColumns; ++i)
+  {
+    std::string name;
+    uint64_t size;
+    if (!ReadString(file, name) || !Read(file, size) || size > sourceSize)
+    {
+      return false;
+    }
+    std::vector<double>& column = loaded.Columns[loaded.AddColumn(name)];
+    column.resize(size);
+    if (!file.read(reinterpret_cast<char*>(column.data()), size * sizeof(double)))
+    {
+      return false;
+    }
+  }
+  *this = std::move(loaded);
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+bool MappedTextFile::Open(const std::string& filename)
+{
+  this->Close();
+  boost::system::error_code error;
+  if (boost::filesystem::file_size(filename, error) == 0 && !error)
+  {
+    // an empty file cannot be mapped, but has no line to parse either
+    return true;
+  }
+  try
+  {
+    this->File.open(filename);
+  }
+  catch (std::exception&)
+  {
+    // reported by the caller
+    return false;
+  }
+  return this->File.is_open();
+}
+
+//-----------------------------------------------------------------------------
+void MappedTextFile::Close()
+{
+  if (this->File.is_open())
+  {
+    this->File.close();
+  }
+}
+
+//-----------------------------------------------------------------------------
+size_t MappedTextFile::ParseLines(size_t offset, const LineParser& parser, ColumnStore& columns,
+                                  unsigned int numberOfThreads) const
+{
+  const char* begin = this->GetData() + std::min(offset, this->GetSize());
+  const char* end = this->GetData() + this->GetSize();
+  const size_t size = end - begin;
+
+  size_t numberOfChunks = numberOfThreads > 0 ? numberOfThreads : boost::thread::hardware_concurrency();
+  numberOfChunks = std::max<size_t>(1, std::min(numberOfChunks, size / MinimumChunkSize));
+
+  // cut the text after the end of line following each even split
+  std::vector<const char*> bounds(1, begin);
+  for (size_t i = 1; i < numberOfChunks; ++i)
+  {
+    bounds.push_back(NextLine(std::max(begin + i * (size / numberOfChunks), bounds.back()), end));
+  }
+  bounds.push_back(end);
+
+  std::vector<ColumnStore> chunkColumns(numberOfChunks, columns.EmptyCopy());
+  std::vector<size_t> malformedLines(numberOfChunks, 0);
+  auto parseChunk = [&](size_t chunk)
+  {
+    const char* line = bounds[chunk];
+    while (line < bounds[chunk + 1])
+    {
+      const char* nextLine = NextLine(line, bounds[chunk + 1]);
+      const char* lineEnd = nextLine;
+      Trim(line, lineEnd);
+      if (line != lineEnd && !parser(line, lineEnd, chunkColumns[chunk]))
+      {
+        malformedLines[chunk]++;
+      }
+      line = nextLine;
+    }
+  };
+
+  if (numberOfChunks == 1)
+  {
+    parseChunk(0);
+  }
+  else
+  {
+    boost::thread_group threads;
+    for (size_t chunk = 0; chunk < numberOfChunks; ++chunk)
+    {
+      threads.create_thread(std::bind(parseChunk, chunk));
+    }
+    threads.join_all();
+  }
+
+  size_t numberOfMalformedLines = 0;
+  for (size_t chunk = 0; chunk < numberOfChunks; ++chunk)
+  {
+    columns.Append(chunkColumns[chunk]);
+    numberOfMalformedLines += malformedLines[chunk];
+  }
+  return numberOfMalformedLines;
+}
+
+//-----------------------------------------------------------------------------
+const char* MappedTextFile::NextLine(const char* position, const char* end)
+{
+  if (position >= end)
+  {
+    return end;
+  }
+  const char* endOfLine = static_cast<const char*>(std::memchr(position, '\n', end - position));
+  return endOfLine ? endOfLine + 1 : end;
+}
+
+//-----------------------------------------------------------------------------
+void MappedTextFile::Trim(const char*& begin, const char*& end)
+{
+  while (begin != end && std::isspace(static_cast<unsigned char>(*begin)))
+  {
+    ++begin;
+  }
+  while (begin != end && std::isspace(static_cast<unsigned char>(*(end - 1))))
+  {
+    --end;
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool MappedTextFile::ParseDouble(const char* begin, const char* end, double& value)
+{
+  // the whole word must be the number, without leading spaces
+  double parsed;
+  if (begin == end || std::isspace(static_cast<unsigned char>(*begin)) ||
+      ParseDoublePrefix(begin, end, parsed) != end)
+  {
+    return false;
+  }
+  value = parsed;
+  return true;
+}
@@ -0,0 +1,120 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef MAPPEDTEXTFILE_H
+#define MAPPEDTEXTFILE_H
+
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <vvConfigure.h>
+
+/**
+ * @brief ColumnStore holds named columns of values read from a log file.
+ * The columns do not need to have the same number of values.
+ *
+ * It can be saved next to the log file, so that the next reading of the log
+ * only has to load the columns back.
+ */
+struct LidarPlugin_EXPORT ColumnStore
+{
+  std::vector<std::string> Names;
+  std::vector<std::vector<double>> Columns;
+
+  //! Add an empty column and return its index
+  size_t AddColumn(const std::string& name);
+
+  //! Index of a column, -1 if there is none with this name
+  int FindColumn(const std::string& name) const;
+
+  //! Copy of the store without any value
+  ColumnStore EmptyCopy() const;
+
+  //! Append the values of a store having the same columns
+  void Append(const ColumnStore& other);
+
+  /**
+   * @brief Save write the columns in a binary cache file
+   * @param filename cache file to write
+   * @param sourceFilename log file the columns were read from, its size and
+   * modification time are stored to detect when the cache is outdated
+   * @param format identifies the reader and its version, a cache written by
+   * another reader or an older version is ignored
+   */
+  bool Save(const std::string& filename, const std::string& sourceFilename,
+            const std::string& format) const;
+
+  //! Load columns saved with the same format from a cache of the current source file
+  bool Load(const std::string& filename, const std::string& sourceFilename,
+            const std::string& format);
+};
+
+/**
+ * @brief MappedTextFile maps a text log file in memory and parses its lines
+ * in parallel.
+ *
+ * The text is split in chunks ending at line boundaries, each chunk is parsed
+ * by its own thread in its own ColumnStore, and the stores are concatenated in
+ * the order of the file. The line parser must therefore only rely on the line
+ * it gets, not on the previous ones.
+ */
+class LidarPlugin_EXPORT MappedTextFile
+{
+public:
+  /**
+   * @brief Parse a line, without its end of line and surrounding spaces,
+   * appending its values to the columns of the chunk it belongs to.
+   * Called concurrently on different chunks.
+   * @return false if the line is malformed, lines ignored on purpose are not errors
+   */
+  using LineParser = std::function<bool(const char* begin, const char* end, ColumnStore& columns)>;
+
+  bool Open(const std::string& filename);
+  void Close();
+
+  const char* GetData() const { return this->File.data(); }
+  size_t GetSize() const { return this->File.is_open() ? this->File.size() : 0; }
+
+  /**
+   * @brief ParseLines parse the lines after an offset, in parallel
+   * @param offset start of the first line to parse, for example after a header
+   * @param parser function called on each non empty line
+   * @param columns columns to fill, the values are appended to the existing ones
+   * @param numberOfThreads maximum number of threads, 0 to use all the cores
+   * @return number of malformed lines
+   */
+  size_t ParseLines(size_t offset, const LineParser& parser, ColumnStore& columns,
+                    unsigned int numberOfThreads = 0) const;
+
+  //! Beginning of the line following the one containing position, or end
+  static const char* NextLine(const char* position, const char* end);
+
+  //! Remove the leading and trailing spaces of [begin, end[
+  static void Trim(const char*& begin, const char*& end);
+
+  /**
+   * @brief ParseDouble parse a whole word as a double, like boost::lexical_cast.
+   * See ParseDoublePrefix() for the conversion itself.
+   */
+  static bool ParseDouble(const char* begin, const char* end, double& value);
+
+private:
+  boost::iostreams::mapped_file_source File;
+};
+
+#endif // MAPPEDTEXTFILE_H
@@ -1,9 +1,12 @@
 #include "NMEAParser.h"
+#include "NumberParsing.h"
 
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <cmath>
-#include <sstream>
-#include <stdexcept>
 #include <limits>
 
 #include <vtkMath.h>
@@ -12,13 +15,92 @@
 #define UNUSED(expr) do { (void)(expr); } while (0)
 
 namespace {
+  /* Copy a word in a null terminated buffer for the C conversion functions */
+  template <typename Conversion>
+  bool ConvertWord(const NMEAWords::Word& word, Conversion convert)
+  {
+    char buffer[64];
+    std::string longWord;
+    const char* str = buffer;
+    if (word.Size < sizeof(buffer))
+    {
+      std::memcpy(buffer, word.Data, word.Size);
+      buffer[word.Size] = '\0';
+    }
+    else
+    {
+      longWord = word.ToString();
+      str = longWord.c_str();
+    }
+    char* end = nullptr;
+    errno = 0;
+    convert(str, &end);
+    // same failures as std::stod and std::stoul
+    return end != str && errno != ERANGE;
+  }
+
+  /* Same result as std::stod, without exceptions nor allocation */
+  bool ParseDouble(const NMEAWords::Word& word, double& value)
+  {
+    return ParseDoublePrefix(word.Data, word.Data + word.Size, value) != nullptr;
+  }
+
+  /* Same result as std::stoul, without exceptions nor allocation */
+  bool ParseUnsigned(const NMEAWords::Word& word, unsigned long& value)
+  {
+    if (word.Size > 0 && word.Size < 10 &&
+        std::all_of(word.Data, word.Data + word.Size, [](char c) { return c >= '0' && c <= '9'; }))
+    {
+      value = 0;
+      for (size_t i = 0; i < word.Size; ++i)
+      {
+        value = 10 * value + static_cast<unsigned long>(word.Data[i] - '0');
+      }
+      return true;
+    }
+    unsigned long converted = 0;
+    if (!ConvertWord(word, [&converted](const char* str, char** strEnd)
+        {
+          converted = std::strtoul(str, strEnd, 10);
+        }))
+    {
+      return false;
+    }
+    value = converted;
+    return true;
+  }
+
+  /* Call append(begin, size) on each comma separated word of a sentence.
+   * A trailing comma does not add an empty word, like std::getline */
+  template <typename Append>
+  void ForEachWord(const char* sentence, size_t length, Append append)
+  {
+    const char* begin = sentence;
+    const char* end = sentence + length;
+    while (begin != end)
+    {
+      const char* comma = static_cast<const char*>(std::memchr(begin, ',', end - begin));
+      if (!comma)
+      {
+        append(begin, static_cast<size_t>(end - begin));
+        break;
+      }
+      append(begin, static_cast<size_t>(comma - begin));
+      begin = comma + 1;
+    }
+  }
+
   /* parse in format HHMMSS.SS (.SS optional) */
-  bool ParseUTCSecondsOfDay(const std::vector<std::string>& w,
+  bool ParseUTCSecondsOfDay(const NMEAWords& w,
                     unsigned int pos,
                     NMEALocation& location)
   {
-    try {
-      double read = std::stod(w[pos]);
+    double read;
+    if (!ParseDouble(w[pos], read))
+    {
+      return false;
+    }
+    {
       double integral_part;
       std::modf(read, &integral_part);
       double fractional_part = read - integral_part;
@@ -32,17 +114,14 @@ namespace {
           + 60.0 * static_cast<double>(MM)
           + 3600.0 * static_cast<double>(HH);
     }
-    catch (const std::logic_error&) {
-      return false;
-    }
     return true;
   }
 
-  bool ParseFAA(const std::vector<std::string>& w,
+  bool ParseFAA(const NMEAWords& w,
                     unsigned int pos,
                     NMEALocation& location)
   {
-    if (w[pos] == "")
+    if (w[pos].empty())
     {
       location.HasFAA = false;
       location.FAA = NMEALocation::UNDEFINED_FAA;
@@ -86,7 +165,7 @@ namespace {
     return true;
   }
 
-  bool ParseLatLong(const std::vector<std::string>& w,
+  bool ParseLatLong(const NMEAWords& w,
                     unsigned int uLat,
                     unsigned int latNS,
                     unsigned int uLong,
@@ -97,11 +176,8 @@ namespace {
     // We make the fields ULAT, ULONG, LATNS and LONGEW mandatory
     double latDec = 0.0;
     double lonDec = 0.0;
-    try {
-      latDec = std::stod(w[uLat]);
-      lonDec = std::stod(w[uLong]);
-    }
-    catch (const std::logic_error&) {
+    if (!ParseDouble(w[uLat], latDec) || !ParseDouble(w[uLong], lonDec))
+    {
       return false;
     }
     double latDeg = std::floor(latDec / 100.0);
@@ -167,43 +243,80 @@ void NMEALocation::Init()
 //------------------------------------------------------------------------------
 bool NMEAParser::ChecksumValid(const std::string& sentence)
 {
-  unsigned int computed = ComputeChecksum(sentence);
-  unsigned int read = ReadChecksum(sentence);
+  return this->ChecksumValid(sentence.c_str(), std::strlen(sentence.c_str()));
+}
+
+
+//------------------------------------------------------------------------------
+unsigned int NMEAParser::ReadChecksum(const std::string& sentence)
+{
+  return this->ReadChecksum(sentence.c_str(), sentence.size());
+}
+
+
+//------------------------------------------------------------------------------
+unsigned int NMEAParser::ComputeChecksum(const std::string& sentence)
+{
+  return this->ComputeChecksum(sentence.c_str(), std::strlen(sentence.c_str()));
+}
+
+
+//------------------------------------------------------------------------------
+bool NMEAParser::ChecksumValid(const char* sentence, size_t length)
+{
+  unsigned int computed = ComputeChecksum(sentence, length);
+  unsigned int read = ReadChecksum(sentence, length);
   // (checks that we do not have a return corresponding to an error)
   return read == computed && read != std::numeric_limits<unsigned int>::max();
 }
 
 
 //------------------------------------------------------------------------------
-unsigned int NMEAParser::ReadChecksum(const std::string& sentence)
+unsigned int NMEAParser::ReadChecksum(const char* sentence, size_t length)
 {
-  if (sentence.size() < 2)
+  if (length < 2)
   {
     // returns a value that does not fit in a byte,
     // can be used to detect that Checksum is not readable
     return std::numeric_limits<unsigned int>::max();
   }
 
-  std::string checksumString = sentence.substr(sentence.size() - 2, 2);
-  unsigned int checksumByte; // does not seem to work with unsigned char
-  std::stringstream ss;
-  ss << std::hex << checksumString;
-  ss >> checksumByte;
-  return checksumByte;
+  // read the last two characters as hexadecimal, like an input stream would:
+  // leading spaces and a sign are accepted, the reading stops on an invalid
+  // digit, and 0 is read if there is none
+  const char* c = sentence + length - 2;
+  const char* end = sentence + length;
+  while (c != end && std::isspace(static_cast<unsigned char>(*c)))
+  {
+    ++c;
+  }
+  bool negative = false;
+  if (c != end && (*c == '-' || *c == '+'))
+  {
+    negative = *c == '-';
+    ++c;
+  }
+  unsigned int checksumByte = 0;
+  for (; c != end && std::isxdigit(static_cast<unsigned char>(*c)); ++c)
+  {
+    unsigned int digit = std::isdigit(static_cast<unsigned char>(*c)) ?
+      *c - '0' : std::toupper(static_cast<unsigned char>(*c)) - 'A' + 10;
+    checksumByte = 16 * checksumByte + digit;
+  }
+  return negative ? 0u - checksumByte : checksumByte;
 }
 
 
 //------------------------------------------------------------------------------
-unsigned int NMEAParser::ComputeChecksum(const std::string& sentence)
+unsigned int NMEAParser::ComputeChecksum(const char* str, size_t length)
 {
-  const char* str = sentence.c_str();
-  if (strlen(str) < 1 + 1 + 2) /* at least: $, *, checksum */
+  if (length < 1 + 1 + 2) /* at least: $, *, checksum */
   {
     return std::numeric_limits<unsigned int>::max();
   }
 
   unsigned int computed = 0;
-  for (int i = 1; i < static_cast<int>(strlen(str)) - 3; i++)
+  for (size_t i = 1; i < length - 3; i++)
   {
     computed ^= static_cast<unsigned int>(str[i]);
   }
@@ -215,6 +328,15 @@ unsigned int NMEAParser::ComputeChecksum(const std::string& sentence)
 //------------------------------------------------------------------------------
 bool NMEAParser::ParseGPRMC(const std::vector<std::string>& w,
                             NMEALocation& location)
+{
+  NMEAWords words;
+  return words.Assign(w) && this->ParseGPRMC(words, location);
+}
+
+
+//------------------------------------------------------------------------------
+bool NMEAParser::ParseGPRMC(const NMEAWords& w,
+                            NMEALocation& location)
 {
   const unsigned int RMC_UTC_TIME = 1;
   const unsigned int RMC_STATUS = 2;
@@ -230,7 +352,7 @@ bool NMEAParser::ParseGPRMC(const std::vector<std::string>& w,
   const unsigned int RMC_FAA = 12; // ! warning: present only if version >= 2.3
   /* UTC seconds of day */
   // We make the field mandatory
-  if (w[RMC_UTC_TIME] == "")
+  if (w[RMC_UTC_TIME].empty())
   {
     return false;
   }
@@ -265,13 +387,11 @@ bool NMEAParser::ParseGPRMC(const std::vector<std::string>& w,
 
 
   /* Speed */
-  if (w[RMC_SPEED] != "")
+  if (!w[RMC_SPEED].empty())
   {
     location.HasSpeed = true;
-    try {
-      location.Speed = std::stod(w[RMC_SPEED]);
-    }
-    catch (const std::logic_error&) {
+    if (!ParseDouble(w[RMC_SPEED], location.Speed))
+    {
       return false;
     }
   }
@@ -283,13 +403,11 @@ bool NMEAParser::ParseGPRMC(const std::vector<std::string>& w,
 
 
   /* Angle */
-  if (w[RMC_ANGLE] != "")
+  if (!w[RMC_ANGLE].empty())
   {
     location.HasTrackAngle = true;
-    try {
-      location.TrackAngle = std::stod(w[RMC_ANGLE]);
-    }
-    catch (const std::logic_error&) {
+    if (!ParseDouble(w[RMC_ANGLE], location.TrackAngle))
+    {
       return false;
     }
   }
@@ -301,23 +419,24 @@ bool NMEAParser::ParseGPRMC(const std::vector<std::string>& w,
 
 
   /* Date */
-  if (w[RMC_DATE] != "")
+  if (!w[RMC_DATE].empty())
   {
-    if (w[RMC_DATE].size() != 6)
+    if (w[RMC_DATE].Size != 6)
     {
       return false;
     }
     location.HasDate = true;
-    try {
-      location.DateDay = static_cast<int>(
-                              std::stoul(w[RMC_DATE].substr(0, 2)));
-      location.DateMonth = static_cast<int>(
-                              std::stoul(w[RMC_DATE].substr(2,2)));
-      location.DateYear = static_cast<int>(
-                              std::stoul(w[RMC_DATE].substr(4,2)));
-    }
-    catch (const std::logic_error&) {
-      return false;
+    // DDMMYY
+    int* dateFields[3] = { &location.DateDay, &location.DateMonth, &location.DateYear };
+    for (int i = 0; i < 3; ++i)
+    {
+      NMEAWords::Word field = { w[RMC_DATE].Data + 2 * i, 2 };
+      unsigned long value;
+      if (!ParseUnsigned(field, value))
+      {
+        return false;
+      }
+      *dateFields[i] = static_cast<int>(value);
     }
   }
   else
@@ -344,6 +463,15 @@ bool NMEAParser::ParseGPRMC(const std::vector<std::string>& w,
 //------------------------------------------------------------------------------
 bool NMEAParser::ParseGPGGA(const std::vector<std::string>& w,
                             NMEALocation& location)
+{
+  NMEAWords words;
+  return words.Assign(w) && this->ParseGPGGA(words, location);
+}
+
+
+//------------------------------------------------------------------------------
+bool NMEAParser::ParseGPGGA(const NMEAWords& w,
+                            NMEALocation& location)
 {
   const unsigned int GGA_UTC_TIME = 1;
   const unsigned int GGA_ULAT = 2;
@@ -361,7 +489,7 @@ bool NMEAParser::ParseGPGGA(const std::vector<std::string>& w,
   const unsigned int GGA_DIF_STATION = 14;
   /* UTC seconds of day */
   // We make the field mandatory
-  if (w[GGA_UTC_TIME] == "")
+  if (w[GGA_UTC_TIME].empty())
   {
     return false;
   }
@@ -379,15 +507,20 @@ bool NMEAParser::ParseGPGGA(const std::vector<std::string>& w,
 
 
   /* "Quality" (it is more about the type of fix) */
-  if (w[GGA_QUALITY] == "")
+  if (w[GGA_QUALITY].empty())
   {
     location.HasTypeOfFix = false;
   }
   else
   {
     location.HasTypeOfFix = true;
-    try {
-      int quality = static_cast<int>(std::stoul(w[GGA_QUALITY]));
+    unsigned long parsedQuality;
+    if (!ParseUnsigned(w[GGA_QUALITY], parsedQuality))
+    {
+      return false;
+    }
+    {
+      int quality = static_cast<int>(parsedQuality);
       switch (quality) {
         case 0:
           location.TypeOfFix = NMEALocation::NO_FIX;
@@ -421,9 +554,6 @@ bool NMEAParser::ParseGPGGA(const std::vector<std::string>& w,
           return false;
       }
     }
-    catch (const std::logic_error&) {
-      return false;
-    }
   }
 
 
@@ -432,13 +562,11 @@ bool NMEAParser::ParseGPGGA(const std::vector<std::string>& w,
 
 
   /* Horizontal dilution of precision */
-  if (w[GGA_HDOP] != "")
+  if (!w[GGA_HDOP].empty())
   {
     location.HasHorizontalDOP = true;
-    try {
-      location.HorizontalDOP = std::stod(w[GGA_HDOP]);
-    }
-    catch (const std::logic_error&) {
+    if (!ParseDouble(w[GGA_HDOP], location.HorizontalDOP))
+    {
       return false;
     }
   }
@@ -450,16 +578,14 @@ bool NMEAParser::ParseGPGGA(const std::vector<std::string>& w,
 
 
   /* Antenna Altitude above/below sea level */
-  if (w[GGA_ALT] != "")
+  if (!w[GGA_ALT].empty())
   {
     // makes the unit field mandatory
     if (w[GGA_ALTUNIT] == "M")
     {
       location.HasAltitude = true;
-      try {
-        location.Altitude = std::stod(w[GGA_ALT]);
-      }
-      catch (const std::logic_error&) {
+      if (!ParseDouble(w[GGA_ALT], location.Altitude))
+      {
         return false;
       }
     }
@@ -476,16 +602,14 @@ bool NMEAParser::ParseGPGGA(const std::vector<std::string>& w,
 
 
   /* Geoidal separation */
-  if (w[GGA_GEOSEP] != "")
+  if (!w[GGA_GEOSEP].empty())
   {
     // makes the unit field mandatory
     if (w[GGA_GEOSEPUNIT] == "M")
     {
       location.HasGeoidalSeparation = true;
-      try {
-        location.GeoidalSeparation = std::stod(w[GGA_GEOSEP]);
-      }
-      catch (const std::logic_error&) {
+      if (!ParseDouble(w[GGA_GEOSEP], location.GeoidalSeparation))
+      {
         return false;
       }
     }
@@ -518,6 +642,15 @@ bool NMEAParser::ParseGPGGA(const std::vector<std::string>& w,
 //------------------------------------------------------------------------------
 bool NMEAParser::ParseGPGLL(const std::vector<std::string>& w,
                             NMEALocation& location)
+{
+  NMEAWords words;
+  return words.Assign(w) && this->ParseGPGLL(words, location);
+}
+
+
+//------------------------------------------------------------------------------
+bool NMEAParser::ParseGPGLL(const NMEAWords& w,
+                            NMEALocation& location)
 {
   const unsigned int GLL_ULAT = 1;
   const unsigned int GLL_LATNS = 2;
@@ -536,7 +669,7 @@ bool NMEAParser::ParseGPGLL(const std::vector<std::string>& w,
 
   /* UTC seconds of day */
   // We make the field mandatory
-  if (w[GLL_UTC_TIME] == "")
+  if (w[GLL_UTC_TIME].empty())
   {
     return false;
   }
@@ -574,6 +707,14 @@ bool NMEAParser::ParseGPGLL(const std::vector<std::string>& w,
 
 //------------------------------------------------------------------------------
 bool NMEAParser::IsGPRMC(const std::vector<std::string>& w)
+{
+  NMEAWords words;
+  return words.Assign(w) && this->IsGPRMC(words);
+}
+
+
+//------------------------------------------------------------------------------
+bool NMEAParser::IsGPRMC(const NMEAWords& w)
 {
   const unsigned int NAME = 0;
   return w.size() > 0
@@ -584,6 +725,14 @@ bool NMEAParser::IsGPRMC(const std::vector<std::string>& w)
 
 //------------------------------------------------------------------------------
 bool NMEAParser::IsGPGGA(const std::vector<std::string>& w)
+{
+  NMEAWords words;
+  return words.Assign(w) && this->IsGPGGA(words);
+}
+
+
+//------------------------------------------------------------------------------
+bool NMEAParser::IsGPGGA(const NMEAWords& w)
 {
   const unsigned int NAME = 0;
   return w.size() > 0
@@ -594,6 +743,14 @@ bool NMEAParser::IsGPGGA(const std::vector<std::string>& w)
 
 //------------------------------------------------------------------------------
 bool NMEAParser::IsGPGLL(const std::vector<std::string>& w)
+{
+  NMEAWords words;
+  return words.Assign(w) && this->IsGPGLL(words);
+}
+
+
+//------------------------------------------------------------------------------
+bool NMEAParser::IsGPGLL(const NMEAWords& w)
 {
   const unsigned int NAME = 0;
   return w.size() > 0
@@ -604,18 +761,37 @@ bool NMEAParser::IsGPGLL(const std::vector<std::string>& w)
 
 //------------------------------------------------------------------------------
 bool NMEAParser::ParseLocation(const std::string& sentence, NMEALocation& location)
+{
+  return this->ParseLocation(sentence.c_str(), sentence.size(), location);
+}
+
+
+//------------------------------------------------------------------------------
+bool NMEAParser::ParseLocation(const char* sentence, NMEALocation& location)
+{
+  return this->ParseLocation(sentence, std::strlen(sentence), location);
+}
+
+
+//------------------------------------------------------------------------------
+bool NMEAParser::ParseLocation(const char* sentence, size_t length, NMEALocation& location)
 {
   // reset location. This is important to do because no sentence can fill
   // all NMEALocation fields.
   location.Init();
-  std::vector<std::string> w = SplitWords(sentence);
+  NMEAWords w;
+  if (!SplitWords(sentence, length, w))
+  {
+    // too many words for a location sentence
+    return false;
+  }
   if (w.size() < 1)
   {
     // the sequence is empty, so it contains no location
     return false;
   }
 
-  if (!ChecksumValid(sentence))
+  if (!ChecksumValid(sentence, length))
   {
     return false;
   }
@@ -645,24 +821,67 @@ bool NMEAParser::ParseLocation(const std::string& sentence, NMEALocation& locati
 
 
 //------------------------------------------------------------------------------
-bool NMEAParser::ParseLocation(const char* sentence, NMEALocation& location)
+std::vector<std::string> NMEAParser::SplitWords(const std::string& sentence)
 {
-  return this->ParseLocation(std::string(sentence), location);
+  std::vector<std::string> result;
+  ForEachWord(sentence.c_str(), sentence.size(), [&result](const char* data, size_t size)
+  {
+    result.emplace_back(data, size);
+  });
+
+  return result;
 }
 
 
 //------------------------------------------------------------------------------
-std::vector<std::string> NMEAParser::SplitWords(const std::string& sentence)
+bool NMEAParser::SplitWords(const char* sentence, size_t length, NMEAWords& words)
 {
-  std::stringstream sstr(sentence);
-  std::string token;
+  return words.Split(sentence, length);
+}
 
-  std::vector<std::string> result;
 
-  while (std::getline(sstr, token, ','))
+//------------------------------------------------------------------------------
+bool NMEAWords::Word::operator==(const char* other) const
+{
+  return std::strlen(other) == this->Size && std::memcmp(this->Data, other, this->Size) == 0;
+}
+
+
+//------------------------------------------------------------------------------
+bool NMEAWords::Split(const char* sentence, size_t length)
+{
+  this->NumberOfWords = 0;
+  bool complete = true;
+  ForEachWord(sentence, length, [this, &complete](const char* data, size_t size)
+  {
+    complete &= this->Append(data, size);
+  });
+  return complete;
+}
+
+
+//------------------------------------------------------------------------------
+bool NMEAWords::Assign(const std::vector<std::string>& words)
+{
+  this->NumberOfWords = 0;
+  bool complete = true;
+  for (const std::string& word : words)
   {
-    result.push_back(token);
+    complete &= this->Append(word.data(), word.size());
   }
+  return complete;
+}
 
-  return result;
+
+//------------------------------------------------------------------------------
+bool NMEAWords::Append(const char* data, size_t size)
+{
+  if (this->NumberOfWords == MaximumNumberOfWords)
+  {
+    return false;
+  }
+  this->Words[this->NumberOfWords].Data = data;
+  this->Words[this->NumberOfWords].Size = size;
+  this->NumberOfWords++;
+  return true;
 }
@@ -1,26 +1,78 @@
 #ifndef NMEAPARSER_H
 #define NMEAPARSER_H
 
+#include <array>
+#include <cstddef>
 #include <string>
 #include <vector>
 #include <vvConfigure.h>
 
 struct NMEALocation;
 
+/**
+ * @brief NMEAWords holds the comma separated words of a NMEA sentence, as
+ * pointers inside the sentence which must outlive them. Splitting a sentence
+ * does not allocate any memory, which matters when parsing hours of 10 Hz records.
+ *
+ * The words are the same as the ones of NMEAParser::SplitWords(): the
+ * checksum is part of the last word, and a trailing comma does not add an
+ * empty word.
+ */
+class LidarPlugin_EXPORT NMEAWords
+{
+public:
+  struct Word
+  {
+    const char* Data = nullptr;
+    size_t Size = 0;
+
+    bool empty() const { return this->Size == 0; }
+    bool operator==(const char* other) const;
+    bool operator!=(const char* other) const { return !(*this == other); }
+    std::string ToString() const { return std::string(this->Data, this->Size); }
+  };
+
+  //! Location sentences have at most 15 words, there is no room for more than these
+  static constexpr size_t MaximumNumberOfWords = 32;
+
+  //! Split a sentence, replacing the previous words. Return false if the
+  //! sentence has too many words, only the first ones are kept
+  bool Split(const char* sentence, size_t length);
+
+  //! Use existing strings as words, return false if there are too many
+  bool Assign(const std::vector<std::string>& words);
+
+  size_t size() const { return this->NumberOfWords; }
+  const Word& operator[](size_t index) const { return this->Words[index]; }
+
+private:
+  bool Append(const char* data, size_t size);
+
+  std::array<Word, MaximumNumberOfWords> Words;
+  size_t NumberOfWords = 0;
+};
+
 /**
  * @brief NMEAParser parses a NMEA 0183 sentence that provides location data
  * (GPRMC, GPGGA or GPGLL sequence).
  *
  * If the sentence can be parsed, the result is stored inside a NMEALocation
  * structure.
+ *
+ * The std::string based functions are kept for convenience, the NMEAWords
+ * ones parse the sentence in place.
  */
 class LidarPlugin_EXPORT NMEAParser
 {
 public:
   std::vector<std::string> SplitWords(const std::string& sentence);
+  bool SplitWords(const char* sentence, size_t length, NMEAWords& words);
   bool IsGPGLL(const std::vector<std::string>& w);
   bool IsGPGGA(const std::vector<std::string>& w);
   bool IsGPRMC(const std::vector<std::string>& w);
+  bool IsGPGLL(const NMEAWords& w);
+  bool IsGPGGA(const NMEAWords& w);
+  bool IsGPRMC(const NMEAWords& w);
   /** @name ParseLocation functions
    * @brief Parse a NMEA 0183 sentence that provides a location
    * @param sentence must be a string starting with $GP{RMC,GGA,GLL}
@@ -35,7 +87,11 @@ public:
   bool ParseGPRMC(const std::vector<std::string>& w, NMEALocation& location);
   bool ParseGPGGA(const std::vector<std::string>& w, NMEALocation& location);
   bool ParseGPGLL(const std::vector<std::string>& w, NMEALocation& location);
+  bool ParseGPRMC(const NMEAWords& w, NMEALocation& location);
+  bool ParseGPGGA(const NMEAWords& w, NMEALocation& location);
+  bool ParseGPGLL(const NMEAWords& w, NMEALocation& location);
   bool ParseLocation(const char* sentence, NMEALocation& location);
+  bool ParseLocation(const char* sentence, size_t length, NMEALocation& location);
   bool ParseLocation(const std::string& sentence, NMEALocation& location);
   ///@}
 
@@ -52,6 +108,9 @@ public:
   bool ChecksumValid(const std::string& sentence);
   unsigned int ReadChecksum(const std::string& sentence);
   unsigned int ComputeChecksum(const std::string& sentence);
+  bool ChecksumValid(const char* sentence, size_t length);
+  unsigned int ReadChecksum(const char* sentence, size_t length);
+  unsigned int ComputeChecksum(const char* sentence, size_t length);
 };
 
 /**
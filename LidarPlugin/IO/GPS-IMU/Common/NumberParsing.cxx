@@ -0,0 +1,92 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "NumberParsing.h"
+
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+//-----------------------------------------------------------------------------
+const char* ParseDoublePrefix(const char* begin, const char* end, double& value)
+{
+  // integers of up to 15 digits and the powers of ten up to 10^15 are exact
+  // doubles, so their quotient is correctly rounded, as strtod would do
+  static const double PowersOfTen[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+    1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15 };
+  const char* c = begin;
+  bool negative = false;
+  if (c != end && (*c == '-' || *c == '+'))
+  {
+    negative = *c == '-';
+    ++c;
+  }
+  long long mantissa = 0;
+  int numberOfDigits = 0;
+  int numberOfDecimals = 0;
+  bool hasPoint = false;
+  for (; c != end; ++c)
+  {
+    if (*c >= '0' && *c <= '9')
+    {
+      mantissa = 10 * mantissa + (*c - '0');
+      numberOfDigits++;
+      numberOfDecimals += hasPoint;
+    }
+    else if (*c == '.' && !hasPoint)
+    {
+      hasPoint = true;
+    }
+    else
+    {
+      break;
+    }
+  }
+  // a letter may continue the number (exponent, hexadecimal, ...)
+  if (numberOfDigits > 0 && numberOfDigits <= 15 &&
+      (c == end || !std::isalpha(static_cast<unsigned char>(*c))))
+  {
+    value = static_cast<double>(mantissa) / PowersOfTen[numberOfDecimals];
+    value = negative ? -value : value;
+    return c;
+  }
+
+  // strtod needs a null terminated string
+  char buffer[64];
+  std::string longText;
+  const size_t length = end - begin;
+  const char* str = buffer;
+  if (length < sizeof(buffer))
+  {
+    std::memcpy(buffer, begin, length);
+    buffer[length] = '\0';
+  }
+  else
+  {
+    longText.assign(begin, end);
+    str = longText.c_str();
+  }
+  char* parsedEnd = nullptr;
+  errno = 0;
+  const double parsed = std::strtod(str, &parsedEnd);
+  // same failures as std::stod
+  if (parsedEnd == str || errno == ERANGE)
+  {
+    return nullptr;
+  }
+  value = parsed;
+  return begin + (parsedEnd - str);
+}
@@ -0,0 +1,35 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef NUMBERPARSING_H
+#define NUMBERPARSING_H
+
+#include <vvConfigure.h>
+
+/**
+ * @brief ParseDoublePrefix parse the number at the beginning of [begin, end[,
+ * with the same result as std::stod but without exceptions nor allocation.
+ * The text does not need to be null terminated.
+ *
+ * Decimal numbers with up to 15 digits, which is what the GPS logs contain,
+ * are parsed directly, the other ones (exponent, leading spaces, nan, ...)
+ * with strtod.
+ *
+ * @param value set only if a number is parsed
+ * @return the end of the number, nullptr if there is no number or if it is
+ * out of the range of a double
+ */
+LidarPlugin_EXPORT const char* ParseDoublePrefix(const char* begin, const char* end, double& value);
+
+#endif // NUMBERPARSING_H
@@ -60,14 +60,15 @@
 #include <boost/foreach.hpp>
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/xml_parser.hpp>
-#include <boost/algorithm/string.hpp>
 
 #include <iomanip>
 #include <algorithm>
-#include <map>
 #include <sstream>
+#include <vector>
 
+#include <cctype>
 #include <cmath>
+#include <cstring>
 
 #ifdef _MSC_VER
 #include <boost/cstdint.hpp>
@@ -141,6 +142,56 @@ const double GYRO_SCALE = 0.09766;   // deg / s
 const double TEMP_SCALE = 0.1453;    // C
 const double TEMP_OFFSET = 25.0;     // C
 const double ACCEL_SCALE = 0.001221; // G
+
+//-----------------------------------------------------------------------------
+/**
+ * @brief PositionColumns accumulates the decoded position packets column by
+ * column, the vtk arrays are then created once the number of points is known
+ * instead of growing them value by value.
+ */
+struct PositionColumns
+{
+  std::vector<double> X, Y, Z;
+  std::vector<double> Lat, Lon, GpsTime, Time, Heading;
+  std::vector<double> Gyro[3], Temp[3], AccelX[3], AccelY[3];
+
+  void Reserve(size_t size)
+  {
+    for (std::vector<double>* column : { &X, &Y, &Z, &Lat, &Lon, &GpsTime, &Time, &Heading })
+    {
+      column->reserve(size);
+    }
+    for (int i = 0; i < 3; ++i)
+    {
+      Gyro[i].reserve(size);
+      Temp[i].reserve(size);
+      AccelX[i].reserve(size);
+      AccelY[i].reserve(size);
+    }
+  }
+
+  size_t Size() const { return X.size(); }
+
+  static vtkSmartPointer<vtkDoubleArray> ToArray(const std::vector<double>& column, const char* name)
+  {
+    auto array = vtkSmartPointer<vtkDoubleArray>::New();
+    array->SetName(name);
+    array->SetNumberOfTuples(static_cast<vtkIdType>(column.size()));
+    std::copy(column.begin(), column.end(), array->GetPointer(0));
+    return array;
+  }
+
+  vtkSmartPointer<vtkPoints> ToPoints() const
+  {
+    auto points = vtkSmartPointer<vtkPoints>::New();
+    points->SetNumberOfPoints(static_cast<vtkIdType>(this->Size()));
+    for (size_t i = 0; i < this->Size(); ++i)
+    {
+      points->SetPoint(static_cast<vtkIdType>(i), X[i], Y[i], Z[i]);
+    }
+    return points;
+  }
+};
 }
 
 //-----------------------------------------------------------------------------
@@ -366,48 +417,8 @@ int vtkVelodyneHDLPositionReader::RequestData(vtkInformation* vtkNotUsed(request
   }
 
 
-  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
-  vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
-  vtkSmartPointer<vtkPolyLine> polyLine = vtkSmartPointer<vtkPolyLine>::New();
-  vtkSmartPointer<vtkIdList> polyIds = polyLine->GetPointIds();
-
-  // Data arrays
-  vtkSmartPointer<vtkDoubleArray> lats = vtkSmartPointer<vtkDoubleArray>::New();
-  lats->SetName("lat");
-  vtkSmartPointer<vtkDoubleArray> lons = vtkSmartPointer<vtkDoubleArray>::New();
-  lons->SetName("lon");
-
-  vtkSmartPointer<vtkDoubleArray> times = vtkSmartPointer<vtkDoubleArray>::New();
-  times->SetName("time");
-
-  vtkSmartPointer<vtkDoubleArray> gpsTime = vtkSmartPointer<vtkDoubleArray>::New();
-  gpsTime->SetName("gpstime");
-
-  typedef std::map<std::string, vtkSmartPointer<vtkDoubleArray> > VecMap;
-  VecMap dataVectors;
-  dataVectors.insert(std::make_pair("gyro1", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("gyro2", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("gyro3", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("temp1", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("temp2", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("temp3", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("accel1x", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("accel1y", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("accel2x", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("accel2y", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("accel3x", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("accel3y", vtkSmartPointer<vtkDoubleArray>::New()));
-  dataVectors.insert(std::make_pair("heading", vtkSmartPointer<vtkDoubleArray>::New()));
-  for (VecMap::iterator it = dataVectors.begin(); it != dataVectors.end(); ++it)
-  {
-    it->second->SetName(it->first.c_str());
-  }
-
-  points->Allocate(5000, 5000);
-  cells->Allocate(5000, 5000);
-  lats->Allocate(5000, 5000);
-  lons->Allocate(5000, 5000);
-  gpsTime->Allocate(5000, 5000);
+  PositionColumns columns;
+  columns.Reserve(5000);
 
   const unsigned char* data;
   unsigned int dataLength;
@@ -418,6 +429,9 @@ int vtkVelodyneHDLPositionReader::RequestData(vtkInformation* vtkNotUsed(request
   this->Open();
   vtkIdType pointcount = 0;
 
+  NMEAParser parser;
+  NMEAWords NMEAwords;
+
   bool hasLastGPSUpdateTime = false;
   double lastGPSUpdateTime = 0.0;
   double GPSTimeOffset = 0.0;
@@ -453,8 +467,16 @@ int vtkVelodyneHDLPositionReader::RequestData(vtkInformation* vtkNotUsed(request
     double convertedLidarUpdateTime = position.tohTimestamp + lidarTimeOffset;
 
 
+    // the sentence is parsed in place, trailing spaces and line breaks excluded
+    size_t sentenceLength = strlen(position.sentance);
+    while (sentenceLength > 0 &&
+           std::isspace(static_cast<unsigned char>(position.sentance[sentenceLength - 1])))
+    {
+      sentenceLength--;
+    }
+
     double x, y, z, lat, lon, heading, gpsUpdateTime;
-    if (std::string(position.sentance).size() == 0)
+    if (position.sentance[0] == '\0')
     {
       // If there is no sentence to parse (no gps connected),
       // we use the following:
@@ -471,21 +493,20 @@ int vtkVelodyneHDLPositionReader::RequestData(vtkInformation* vtkNotUsed(request
     }
     else
     {
-      NMEAParser parser;
       NMEALocation parsedNMEA;
       parsedNMEA.Init();
-      std::string NMEASentence = std::string(position.sentance);
-      boost::trim_right(NMEASentence);
-      std::vector<std::string> NMEAwords = parser.SplitWords(NMEASentence);
-      if (!parser.ChecksumValid(NMEASentence))
+      // a sentence with too many words cannot be a location one
+      const bool isSplit = parser.SplitWords(position.sentance, sentenceLength, NMEAwords);
+      if (!parser.ChecksumValid(position.sentance, sentenceLength))
       {
         vtkGenericWarningMacro("NMEA sentence: "
-                               << "<" << NMEASentence << ">"
+                               << "<" << std::string(position.sentance, sentenceLength) << ">"
                                << "has invalid checksum");
         // TODO: should we skip or should we expect lazy NMEA implementers ?
       }
 
-      if ((this->UseGPGGASentences && !parser.IsGPGGA(NMEAwords))
+      if (!isSplit
+          || (this->UseGPGGASentences && !parser.IsGPGGA(NMEAwords))
           || (!this->UseGPGGASentences && !parser.IsGPRMC(NMEAwords)))
       {
         continue; // not the NMEA sentence we are interested in, skipping
@@ -495,7 +516,7 @@ int vtkVelodyneHDLPositionReader::RequestData(vtkInformation* vtkNotUsed(request
            || (parser.IsGPRMC(NMEAwords) && parser.ParseGPRMC(NMEAwords, parsedNMEA)) ))
       {
         vtkGenericWarningMacro("Failed to parse NMEA sentence: "
-                               << "<" << NMEASentence << ">");
+                               << "<" << std::string(position.sentance, sentenceLength) << ">");
         continue; // skipping this PositionPacket
       }
 
@@ -603,32 +624,40 @@ int vtkVelodyneHDLPositionReader::RequestData(vtkInformation* vtkNotUsed(request
     x -= this->Internal->Offset[0];
     y -= this->Internal->Offset[1];
 
-    points->InsertNextPoint(x, y, z);
-    lats->InsertNextValue(lat);
-    lons->InsertNextValue(lon);
-    gpsTime->InsertNextValue(convertedGPSUpdateTime);
-    polyIds->InsertNextId(pointcount);
-
-    times->InsertNextValue(convertedLidarUpdateTime);
-
-    dataVectors["gyro1"]->InsertNextValue(position.gyro[0] * GYRO_SCALE);
-    dataVectors["gyro2"]->InsertNextValue(position.gyro[1] * GYRO_SCALE);
-    dataVectors["gyro3"]->InsertNextValue(position.gyro[2] * GYRO_SCALE);
-    dataVectors["temp1"]->InsertNextValue(position.temp[0] * TEMP_SCALE + TEMP_OFFSET);
-    dataVectors["temp2"]->InsertNextValue(position.temp[1] * TEMP_SCALE + TEMP_OFFSET);
-    dataVectors["temp3"]->InsertNextValue(position.temp[2] * TEMP_SCALE + TEMP_OFFSET);
-    dataVectors["accel1x"]->InsertNextValue(position.accelx[0] * ACCEL_SCALE);
-    dataVectors["accel2x"]->InsertNextValue(position.accelx[1] * ACCEL_SCALE);
-    dataVectors["accel3x"]->InsertNextValue(position.accelx[2] * ACCEL_SCALE);
-    dataVectors["accel1y"]->InsertNextValue(position.accely[0] * ACCEL_SCALE);
-    dataVectors["accel2y"]->InsertNextValue(position.accely[1] * ACCEL_SCALE);
-    dataVectors["accel3y"]->InsertNextValue(position.accely[2] * ACCEL_SCALE);
-    dataVectors["heading"]->InsertNextValue(heading);
+    columns.X.push_back(x);
+    columns.Y.push_back(y);
+    columns.Z.push_back(z);
+    columns.Lat.push_back(lat);
+    columns.Lon.push_back(lon);
+    columns.GpsTime.push_back(convertedGPSUpdateTime);
+    columns.Time.push_back(convertedLidarUpdateTime);
+    columns.Heading.push_back(heading);
+    for (int i = 0; i < 3; ++i)
+    {
+      columns.Gyro[i].push_back(position.gyro[i] * GYRO_SCALE);
+      columns.Temp[i].push_back(position.temp[i] * TEMP_SCALE + TEMP_OFFSET);
+      columns.AccelX[i].push_back(position.accelx[i] * ACCEL_SCALE);
+      columns.AccelY[i].push_back(position.accely[i] * ACCEL_SCALE);
+    }
 
     pointcount++;
   }
   this->Close();
 
+  vtkSmartPointer<vtkPoints> points = columns.ToPoints();
+  vtkSmartPointer<vtkDoubleArray> lats = PositionColumns::ToArray(columns.Lat, "lat");
+  vtkSmartPointer<vtkDoubleArray> lons = PositionColumns::ToArray(columns.Lon, "lon");
+  vtkSmartPointer<vtkDoubleArray> gpsTime = PositionColumns::ToArray(columns.GpsTime, "gpstime");
+  vtkSmartPointer<vtkDoubleArray> times = PositionColumns::ToArray(columns.Time, "time");
+  vtkSmartPointer<vtkDoubleArray> headings = PositionColumns::ToArray(columns.Heading, "heading");
+
+  vtkSmartPointer<vtkCellArray> cells = vtkSmartPointer<vtkCellArray>::New();
+  vtkSmartPointer<vtkPolyLine> polyLine = vtkSmartPointer<vtkPolyLine>::New();
+  polyLine->GetPointIds()->SetNumberOfIds(pointcount);
+  for (vtkIdType i = 0; i < pointcount; ++i)
+  {
+    polyLine->GetPointIds()->SetId(i, i);
+  }
   cells->InsertNextCell(polyLine);
 
   // Optionally interpolate the GPS values... note that we assume that the
@@ -637,7 +666,7 @@ int vtkVelodyneHDLPositionReader::RequestData(vtkInformation* vtkNotUsed(request
   if (lats->GetNumberOfTuples() && lons->GetNumberOfTuples() &&
     (lats->GetValue(0) != 0.0 || lons->GetValue(0) != 0.0))
   {
-    this->Internal->InterpolateGPS(points, gpsTime, times, dataVectors["heading"]);
+    this->Internal->InterpolateGPS(points, gpsTime, times, headings);
   }
 
   output->SetPoints(points);
@@ -646,9 +675,24 @@ int vtkVelodyneHDLPositionReader::RequestData(vtkInformation* vtkNotUsed(request
   output->GetPointData()->AddArray(lons);
   output->GetPointData()->AddArray(gpsTime);
   output->GetPointData()->AddArray(times);
-  for (VecMap::iterator it = dataVectors.begin(); it != dataVectors.end(); ++it)
+  // sorted by name, as they used to be
+  const char* accelXNames[3] = { "accel1x", "accel2x", "accel3x" };
+  const char* accelYNames[3] = { "accel1y", "accel2y", "accel3y" };
+  const char* gyroNames[3] = { "gyro1", "gyro2", "gyro3" };
+  const char* tempNames[3] = { "temp1", "temp2", "temp3" };
+  for (int i = 0; i < 3; ++i)
+  {
+    output->GetPointData()->AddArray(PositionColumns::ToArray(columns.AccelX[i], accelXNames[i]));
+    output->GetPointData()->AddArray(PositionColumns::ToArray(columns.AccelY[i], accelYNames[i]));
+  }
+  for (int i = 0; i < 3; ++i)
+  {
+    output->GetPointData()->AddArray(PositionColumns::ToArray(columns.Gyro[i], gyroNames[i]));
+  }
+  output->GetPointData()->AddArray(headings);
+  for (int i = 0; i < 3; ++i)
   {
-    output->GetPointData()->AddArray(it->second);
+    output->GetPointData()->AddArray(PositionColumns::ToArray(columns.Temp[i], tempNames[i]));
   }
 
   return 1;
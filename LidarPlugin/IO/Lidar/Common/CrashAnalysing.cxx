@@ -29,6 +29,16 @@
 
 //-----------------------------------------------------------------------------
 void CrashAnalysisWriter::AddPacket(const NetworkPacket& packet)
+{
+  if (!this->Writer.IsOpen() && !this->StartWriter())
+  {
+    return;
+  }
+  this->Writer.Enqueue(packet);
+}
+
+//-----------------------------------------------------------------------------
+bool CrashAnalysisWriter::StartWriter()
 {
   // The idea is to store 2 .pcap files. One corresponding
   // to the last N packets received and one corresponding to
@@ -38,51 +48,32 @@ void CrashAnalysisWriter::AddPacket(const NetworkPacket& packet)
   // When switching to file 0 or 1, the existing content of the
   // file is discarded resulting in a storage of a number of packets
   // between N and 2*N
-  if (this->PacketCount % this->NbrPacketsToStore == 0)
-  {
-    // Close the writer if it is already opened
-    if (this->Writer.IsOpen())
-    {
-      this->Writer.Close();
-    }
-
-    // Switch the filename and open the writer
-    this->FileToStore++;
-    unsigned int nbrFile = this->FileToStore % 2; // file name: 0 or 1
+  std::string filename = this->Filename;
+  this->Writer.FileNameGenerator = [filename](int fileIndex) {
     std::stringstream ss;
-    ss << this->Filename << nbrFile << ".bin";
-    if (!this->Writer.Open(ss.str()))
-    {
-      vtkGenericWarningMacro("Crash analysis failed to open the log file.");
-      return;
-    }
-  }
+    ss << filename << (fileIndex + 1) % 2 << ".bin";
+    return ss.str();
+  };
+  this->Writer.MaxPacketsPerFile = this->NbrPacketsToStore;
+  // The log is only useful if it is on disk when the application crashes,
+  // so small buffers are flushed often
+  this->Writer.BufferSize = 256 << 10;
+  this->Writer.NumberOfBuffers = 8;
+  this->Writer.MaxBufferAge = 0.1;
 
-  this->WriteLastPacket(packet);
-  this->PacketCount++;
-}
-
-//-----------------------------------------------------------------------------
-void CrashAnalysisWriter::WriteLastPacket(const NetworkPacket& packet)
-{
-  // check that the writer is opened
+  this->Writer.Start(this->Writer.FileNameGenerator(0));
   if (!this->Writer.IsOpen())
   {
-    vtkGenericWarningMacro("Crash analysis couldn't save last packet received since the writer is not opened");
-    return;
+    vtkGenericWarningMacro("Crash analysis failed to open the log file.");
+    return false;
   }
-
-  this->Writer.WritePacket(packet);
+  return true;
 }
 
 //-----------------------------------------------------------------------------
 void CrashAnalysisWriter::CloseAnalyzer()
 {
-  if (this->Writer.IsOpen())
-  {
-    this->Writer.Close();
-    return;
-  }
+  this->Writer.Close();
 }
 
 //-----------------------------------------------------------------------------
@@ -19,7 +19,7 @@
 #define CRASH_ANALYSING_H
 
 // LOCAL
-#include "vtkPacketFileWriter.h"
+#include "PacketFileWriter.h"
 #include "NetworkPacket.h"
 
 /**
@@ -27,13 +27,15 @@
  * \brief This class is responsible to save as a .pcap file
  *        the last N packets received and remove the older ones.
  *        The idea is to generate a small .pcap to analyze when
- *        the software crashes in streaming mode
+ *        the software crashes in streaming mode.
+ *        The packets are written by a PacketFileWriter, so the
+ *        receiving thread only copies them in memory.
 */
 class CrashAnalysisWriter
 {
 public:
   // Default constructor
-  CrashAnalysisWriter() {this->PacketCount = 0;}
+  CrashAnalysisWriter() = default;
 
   // Setters
   void SetNbrPacketsToStore(unsigned int arg) {this->NbrPacketsToStore = arg;}
@@ -59,14 +61,11 @@ private:
   unsigned int NbrPacketsToStore = 5000;
   std::string Filename = "";
 
-  // Writer
-  vtkPacketFileWriter Writer;
+  // Writer, which alternates between the two log files
+  PacketFileWriter Writer;
 
-  // Internal parameters
-  unsigned int PacketCount = 0;
-  unsigned int FileToStore = 0;
-
-  void WriteLastPacket(const NetworkPacket& packet);
+  // Configure and start the writer
+  bool StartWriter();
 };
 
 #endif // CRASH_ANALYSING_H
@@ -0,0 +1,256 @@
+#include "FramePrefetcher.h"
+
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+
+namespace
+{
+double Now()
+{
+  auto now = std::chrono::steady_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::duration<double>>(now).count();
+}
+}
+
+//-----------------------------------------------------------------------------
+FramePrefetcher::FramePrefetcher()
+  : DecodeStatistics("Decode ahead")
+  , WaitStatistics("Wait for frame")
+{
+}
+
+//-----------------------------------------------------------------------------
+FramePrefetcher::~FramePrefetcher()
+{
+  this->Stop();
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::Start(const std::vector<DecodeFunction>& decoders, int numberOfFrames)
+{
+  this->Stop();
+  this->NumberOfFrames = numberOfFrames;
+  this->NumberOfHits = 0;
+  this->NumberOfMisses = 0;
+  this->DecodeStatistics.Reset();
+  this->WaitStatistics.Reset();
+  for (const DecodeFunction& decode : decoders)
+  {
+    this->Threads.emplace_back(new boost::thread(&FramePrefetcher::Run, this, decode));
+  }
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::Stop()
+{
+  if (this->Threads.empty())
+  {
+    return;
+  }
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    this->StopRequested = true;
+  }
+  this->Condition.notify_all();
+  for (const auto& thread : this->Threads)
+  {
+    thread->join();
+  }
+  this->Threads.clear();
+
+  this->StopRequested = false;
+  this->Frames.clear();
+  this->FramesInProgress.clear();
+  this->CurrentFrame = -1;
+  this->Stride = 1;
+  this->UrgentFrame = -1;
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::SetWindowSize(int windowSize)
+{
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    this->WindowSize = std::max(windowSize, 1);
+    this->DropFramesOutsideWindow();
+  }
+  this->Condition.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::AddFrameProcessor(std::shared_ptr<LidarFrameProcessor> processor)
+{
+  if (this->IsRunning())
+  {
+    vtkGenericWarningMacro("Cannot add a frame processor while decoding ahead");
+    return;
+  }
+  this->FrameProcessors.push_back(processor);
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::RemoveAllFrameProcessors()
+{
+  if (this->IsRunning())
+  {
+    vtkGenericWarningMacro("Cannot remove the frame processors while decoding ahead");
+    return;
+  }
+  this->FrameProcessors.clear();
+}
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> FramePrefetcher::GetFrame(int frameIndex)
+{
+  vtkSmartPointer<vtkPolyData> frame;
+  {
+    boost::unique_lock<boost::mutex> lock(this->Mutex);
+
+    // predict the next requests from this one, a backward or large jump is a seek
+    int step = frameIndex - this->CurrentFrame;
+    this->Stride = (this->CurrentFrame >= 0 && step > 0 && step <= this->WindowSize) ? step : 1;
+    this->CurrentFrame = frameIndex;
+
+    auto it = this->Frames.find(frameIndex);
+    if (it != this->Frames.end())
+    {
+      this->NumberOfHits++;
+      frame = it->second;
+    }
+    else
+    {
+      this->NumberOfMisses++;
+      double start = Now();
+      this->UrgentFrame = frameIndex;
+      this->Condition.notify_all();
+      this->Condition.wait(lock, [this, frameIndex]()
+      {
+        return this->StopRequested || this->Frames.count(frameIndex);
+      });
+      this->UrgentFrame = -1;
+      this->WaitStatistics.AddSample(Now() - start);
+      it = this->Frames.find(frameIndex);
+      if (it != this->Frames.end())
+      {
+        frame = it->second;
+      }
+    }
+    this->DropFramesOutsideWindow();
+  }
+  // the window moved, there are new frames to decode
+  this->Condition.notify_all();
+  return frame;
+}
+
+//-----------------------------------------------------------------------------
+bool FramePrefetcher::IsFrameReady(int frameIndex) const
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->Frames.count(frameIndex) > 0;
+}
+
+//-----------------------------------------------------------------------------
+std::string FramePrefetcher::GetStatisticsReport() const
+{
+  std::stringstream report;
+  report << this->DecodeStatistics.GetReport() << std::endl
+         << this->WaitStatistics.GetReport() << std::endl
+         << "Frames decoded ahead: " << this->NumberOfHits
+         << ", waited for: " << this->NumberOfMisses << std::endl;
+  return report.str();
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::Run(DecodeFunction decode)
+{
+  boost::unique_lock<boost::mutex> lock(this->Mutex);
+  while (true)
+  {
+    int frameIndex = -1;
+    this->Condition.wait(lock, [this, &frameIndex]()
+    {
+      frameIndex = this->GetNextFrameToDecode();
+      return this->StopRequested || frameIndex >= 0;
+    });
+    if (this->StopRequested)
+    {
+      return;
+    }
+
+    // decode without holding the lock, so that the decoded frames can be obtained
+    // and the other threads can decode meanwhile
+    this->FramesInProgress.insert(frameIndex);
+    lock.unlock();
+    double start = Now();
+    vtkSmartPointer<vtkPolyData> frame = decode(frameIndex);
+    if (frame && !this->FrameProcessors.empty())
+    {
+      boost::lock_guard<boost::mutex> processorsLock(this->ProcessorsMutex);
+      for (const auto& processor : this->FrameProcessors)
+      {
+        if (!frame)
+        {
+          break;
+        }
+        frame = processor->Process(frame);
+      }
+    }
+    double duration = Now() - start;
+    lock.lock();
+
+    this->DecodeStatistics.AddSample(duration);
+    this->FramesInProgress.erase(frameIndex);
+    this->Frames[frameIndex] = frame;
+    this->DropFramesOutsideWindow();
+    this->Condition.notify_all();
+  }
+}
+
+//-----------------------------------------------------------------------------
+int FramePrefetcher::GetNextFrameToDecode() const
+{
+  auto isToDecode = [this](int frameIndex)
+  {
+    return !this->Frames.count(frameIndex) && !this->FramesInProgress.count(frameIndex);
+  };
+  if (this->UrgentFrame >= 0 && isToDecode(this->UrgentFrame))
+  {
+    return this->UrgentFrame;
+  }
+  if (this->CurrentFrame < 0)
+  {
+    return -1;
+  }
+  for (int k = 1; k <= this->WindowSize; ++k)
+  {
+    int frameIndex = this->CurrentFrame + k * this->Stride;
+    if (frameIndex >= this->NumberOfFrames)
+    {
+      break;
+    }
+    if (isToDecode(frameIndex))
+    {
+      return frameIndex;
+    }
+  }
+  return -1;
+}
+
+//-----------------------------------------------------------------------------
+void FramePrefetcher::DropFramesOutsideWindow()
+{
+  int last = this->CurrentFrame + this->WindowSize * this->Stride;
+  for (auto it = this->Frames.begin(); it != this->Frames.end();)
+  {
+    bool inWindow = it->first >= this->CurrentFrame && it->first <= last;
+    if (!inWindow && it->first != this->UrgentFrame)
+    {
+      it = this->Frames.erase(it);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+}
@@ -0,0 +1,152 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef FRAMEPREFETCHER_H
+#define FRAMEPREFETCHER_H
+
+#include <boost/thread.hpp>
+
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "LidarFrameProcessor.h"
+#include "PacketConsumer.h"
+
+/**
+ * @brief The FramePrefetcher class keeps a window of upcoming frames of a
+ * recording decoded, and optionally processed, by one or several dedicated threads.
+ *
+ * Each time a frame is requested, the window moves: the next frames expected are
+ * predicted from the step between the last two requests, so that a playback
+ * which skips frames to keep up with the clock only decodes the frames it will
+ * display. A frame requested outside of the window is decoded before the others
+ * and the caller waits for it.
+ *
+ * The packet interpreters are stateful, so each decoding thread has its own decode
+ * function, and a frame is only decoded by one thread at a time. The frame
+ * processors are not thread safe: they are applied by one thread at a time.
+ * All the methods must be called from the same thread, except IsFrameReady().
+ */
+class FramePrefetcher
+{
+public:
+  //! Decode a frame from its index, only called by one decoding thread
+  using DecodeFunction = std::function<vtkSmartPointer<vtkPolyData>(int)>;
+
+  FramePrefetcher();
+  ~FramePrefetcher();
+
+  /**
+   * @brief Start launch the decoding threads. Nothing is decoded before the first
+   * frame is requested.
+   * @param decoders one function decoding a frame per decoding thread, the
+   * functions are called concurrently and must not share any state
+   * @param numberOfFrames frames that can be decoded are in [0, numberOfFrames[
+   */
+  void Start(const std::vector<DecodeFunction>& decoders, int numberOfFrames);
+
+  //! Stop the decoding threads, once the current frames are decoded, and drop the decoded frames
+  void Stop();
+
+  bool IsRunning() const { return !this->Threads.empty(); }
+
+  //! Number of frames decoded ahead of the last requested one
+  void SetWindowSize(int windowSize);
+  int GetWindowSize() const { return this->WindowSize; }
+
+  /**
+   * @brief AddFrameProcessor add a processing stage applied on every decoded frame,
+   * by the decoding threads. Must be called while the prefetcher is stopped.
+   */
+  void AddFrameProcessor(std::shared_ptr<LidarFrameProcessor> processor);
+  void RemoveAllFrameProcessors();
+
+  /**
+   * @brief GetFrame return a frame and move the window after it
+   * @param frameIndex index of the frame, waits for it if it is not decoded yet
+   * @return the decoded and processed frame, nullptr if it could not be decoded
+   */
+  vtkSmartPointer<vtkPolyData> GetFrame(int frameIndex);
+
+  //! True if the frame is decoded and can be obtained without waiting. Thread safe.
+  bool IsFrameReady(int frameIndex) const;
+
+  //! Frames requested which were already decoded since the last Start()
+  uint64_t GetNumberOfHits() const { return this->NumberOfHits; }
+
+  //! Frames requested which had to be waited for since the last Start()
+  uint64_t GetNumberOfMisses() const { return this->NumberOfMisses; }
+
+  //! Human readable summary of the hits, misses, decoding and waiting times
+  std::string GetStatisticsReport() const;
+
+private:
+  FramePrefetcher(const FramePrefetcher&) = delete;
+  void operator=(const FramePrefetcher&) = delete;
+
+  //! Main loop of a decoding thread
+  void Run(DecodeFunction decode);
+
+  //! Next frame to decode, -1 if the window is already decoded or being decoded.
+  //! Mutex must be locked.
+  int GetNextFrameToDecode() const;
+
+  //! Drop the decoded frames which are behind the window. Mutex must be locked.
+  void DropFramesOutsideWindow();
+
+  int NumberOfFrames = 0;
+  int WindowSize = 8;
+  std::vector<std::shared_ptr<LidarFrameProcessor>> FrameProcessors;
+
+  //! Serialize the frame processors between the decoding threads
+  boost::mutex ProcessorsMutex;
+
+  //! Protect all the members below
+  mutable boost::mutex Mutex;
+  boost::condition_variable Condition;
+  bool StopRequested = false;
+
+  //! Decoded frames, by index. A frame which could not be decoded is stored as nullptr.
+  std::map<int, vtkSmartPointer<vtkPolyData>> Frames;
+
+  //! Frames being decoded by a thread
+  std::set<int> FramesInProgress;
+
+  //! Last frame requested, the window starts after it
+  int CurrentFrame = -1;
+
+  //! Predicted step between two requested frames
+  int Stride = 1;
+
+  //! Frame requested and waited for, decoded before the window
+  int UrgentFrame = -1;
+
+  std::vector<std::unique_ptr<boost::thread>> Threads;
+
+  std::atomic<uint64_t> NumberOfHits{0};
+  std::atomic<uint64_t> NumberOfMisses{0};
+  //! Written with the mutex locked, as there are several decoding threads
+  StageStatistics DecodeStatistics;
+  StageStatistics WaitStatistics;
+};
+
+#endif // FRAMEPREFETCHER_H
@@ -0,0 +1,15 @@
+#include "LidarFrameProcessor.h"
+
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> AlgorithmFrameProcessor::Process(vtkSmartPointer<vtkPolyData> frame)
+{
+  this->Algorithm->SetInputData(frame);
+  this->Algorithm->Update();
+
+  // copy the output so that the next update of the algorithm
+  // does not modify a frame which is already displayed
+  auto output = vtkSmartPointer<vtkPolyData>::New();
+  output->ShallowCopy(this->Algorithm->GetOutput());
+  this->Algorithm->SetInputData(nullptr);
+  return output;
+}
@@ -0,0 +1,65 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIDARFRAMEPROCESSOR_H
+#define LIDARFRAMEPROCESSOR_H
+
+#include <vtkPolyData.h>
+#include <vtkPolyDataAlgorithm.h>
+#include <vtkSmartPointer.h>
+
+#include <string>
+
+/**
+ * @brief The LidarFrameProcessor class is the interface of the per-frame processing
+ * stages that can be registered on a live stream (see PacketConsumer::AddFrameProcessor).
+ *
+ * The processors run on a dedicated thread, one frame at a time and in the
+ * order they have been added, before the frame is handed over to the pipeline.
+ */
+class LidarFrameProcessor
+{
+public:
+  virtual ~LidarFrameProcessor() = default;
+
+  //! Name used to report the latency of this stage
+  virtual std::string GetName() const = 0;
+
+  /**
+   * @brief Process process a frame
+   * @param frame the frame to process, it can be modified in place
+   * @return the processed frame, nullptr to drop the frame
+   */
+  virtual vtkSmartPointer<vtkPolyData> Process(vtkSmartPointer<vtkPolyData> frame) = 0;
+};
+
+/**
+ * @brief The AlgorithmFrameProcessor class run any vtkPolyDataAlgorithm
+ * (cropping, downsampling, SLAM, ...) as a live frame processor.
+ * The algorithm must not be used elsewhere while the stream is running.
+ */
+class AlgorithmFrameProcessor : public LidarFrameProcessor
+{
+public:
+  AlgorithmFrameProcessor(vtkPolyDataAlgorithm* algorithm) : Algorithm(algorithm) {}
+
+  std::string GetName() const override { return this->Algorithm->GetClassName(); }
+
+  vtkSmartPointer<vtkPolyData> Process(vtkSmartPointer<vtkPolyData> frame) override;
+
+private:
+  vtkSmartPointer<vtkPolyDataAlgorithm> Algorithm;
+};
+
+#endif // LIDARFRAMEPROCESSOR_H
@@ -41,20 +41,34 @@ NetworkSource::~NetworkSource()
 //-----------------------------------------------------------------------------
 void NetworkSource::QueuePackets(NetworkPacket* packet)
 {
-  NetworkPacket* packet2 = nullptr;
+  // the writer copies the packet in its own buffers, this must be done before
+  // handing the packet over to its consumer which owns it afterward
   if (this->Writer)
   {
-    packet2 = new NetworkPacket(*packet);
+    this->Writer->Enqueue(*packet);
   }
 
-  if (this->Consumer)
+  // dispatch the packet according to the port it has been received on
+  std::shared_ptr<PacketConsumer> consumer = this->Consumer;
+  if (!this->AdditionalConsumers.empty())
   {
-    this->Consumer->Enqueue(packet);
+    const unsigned char* header = packet->GetPacketData();
+    int destinationPort = (header[NetworkPacket::EthIPUDPHeader_DESTPORT] << 8)
+                          | header[NetworkPacket::EthIPUDPHeader_DESTPORT + 1];
+    auto it = this->AdditionalConsumers.find(destinationPort);
+    if (it != this->AdditionalConsumers.end())
+    {
+      consumer = it->second;
+    }
   }
 
-  if (this->Writer)
+  if (consumer)
+  {
+    consumer->Enqueue(packet);
+  }
+  else
   {
-    this->Writer->Enqueue(packet2);
+    delete packet;
   }
 }
 
@@ -122,6 +136,17 @@ void NetworkSource::Start()
   {
       this->PositionPortReceiver->StartReceive();
   }
+
+  for (const auto& portAndConsumer : this->AdditionalConsumers)
+  {
+    auto forwardedPort = this->AdditionalForwardedPorts.find(portAndConsumer.first);
+    bool isForwarding = this->IsForwarding && forwardedPort != this->AdditionalForwardedPorts.end();
+    boost::shared_ptr<PacketReceiver> receiver(new PacketReceiver(this->IOService,
+      portAndConsumer.first, isForwarding ? forwardedPort->second : ForwardedLidarPort,
+      ForwardedIpAddress, isForwarding, this));
+    receiver->StartReceive();
+    this->AdditionalLidarPortReceivers.push_back(receiver);
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -133,4 +158,26 @@ void NetworkSource::Stop()
   {
     this->PositionPortReceiver.reset();
   }
+  this->AdditionalLidarPortReceivers.clear();
+}
+
+//-----------------------------------------------------------------------------
+void NetworkSource::AddLidarPort(int port, std::shared_ptr<PacketConsumer> consumer, int forwardedPort)
+{
+  this->AdditionalConsumers[port] = consumer;
+  if (forwardedPort >= 0)
+  {
+    this->AdditionalForwardedPorts[port] = forwardedPort;
+  }
+  else
+  {
+    this->AdditionalForwardedPorts.erase(port);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void NetworkSource::RemoveAdditionalLidarPorts()
+{
+  this->AdditionalConsumers.clear();
+  this->AdditionalForwardedPorts.clear();
 }
@@ -22,7 +22,9 @@
 #include "NetworkPacket.h"
 
 #include <deque>
+#include <map>
 #include <queue>
+#include <vector>
 
 class PacketConsumer;
 class PacketReceiver;
@@ -65,6 +67,22 @@ public:
 
   void Stop();
 
+  /**
+   * @brief AddLidarPort listen to another lidar port with the same IOService and thread.
+   * The packets received on this port are given to their own consumer instead of Consumer.
+   * Must be called while the source is stopped.
+   * @param port The port to receive the LIDAR information
+   * @param consumer The consumer decoding the packets received on this port
+   * @param forwardedPort The port to send the forwarded packets of this port, if
+   * IsForwarding is set. A negative value disables the forwarding of this port.
+   */
+  void AddLidarPort(int port, std::shared_ptr<PacketConsumer> consumer, int forwardedPort = -1);
+
+  /**
+   * @brief RemoveAdditionalLidarPorts remove all ports added with AddLidarPort()
+   */
+  void RemoveAdditionalLidarPorts();
+
   //! @todo currently evrything is public, but it should be private
   int LidarPort;                  /*!< The port to receive LIDAR information. Default is 2368 */
   bool ListenGPS;
@@ -84,7 +102,12 @@ public:
   boost::shared_ptr<PacketReceiver>
     PositionPortReceiver; /*!< The PacketReceiver configured to receive GPS information */
 
+  std::vector<boost::shared_ptr<PacketReceiver>>
+    AdditionalLidarPortReceivers; /*!< The PacketReceiver of the ports added with AddLidarPort */
+
   std::shared_ptr<PacketConsumer> Consumer;
+  std::map<int, std::shared_ptr<PacketConsumer>> AdditionalConsumers; /*!< Consumer by lidar port */
+  std::map<int, int> AdditionalForwardedPorts; /*!< Forwarded port by lidar port */
   std::shared_ptr<PacketFileWriter> Writer;
 
   boost::asio::io_service::work* DummyWork;
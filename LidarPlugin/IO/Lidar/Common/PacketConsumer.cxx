@@ -2,36 +2,216 @@
 
 #include "SynchronizedQueue.h"
 
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+//----------------------------------------------------------------------------
+// Wall clock time, same reference as NetworkPacket::ReceptionTime
+double GetTimeInSeconds()
+{
+  auto now = std::chrono::system_clock::now().time_since_epoch();
+  return std::chrono::duration_cast<std::chrono::duration<double>>(now).count();
+}
+}
+
+//----------------------------------------------------------------------------
+void StageStatistics::AddSample(double latencyInSeconds)
+{
+  uint64_t latency = static_cast<uint64_t>(std::max(latencyInSeconds, 0.) * 1e6);
+  this->Count++;
+  this->TotalLatencyUs += latency;
+  // only the stage thread writes, so there is no race on the max
+  if (latency > this->MaxLatencyUs)
+  {
+    this->MaxLatencyUs = latency;
+  }
+}
+
+//----------------------------------------------------------------------------
+void StageStatistics::Reset()
+{
+  this->Count = 0;
+  this->TotalLatencyUs = 0;
+  this->MaxLatencyUs = 0;
+}
+
+//----------------------------------------------------------------------------
+std::string StageStatistics::GetReport() const
+{
+  uint64_t count = this->Count;
+  double mean = count ? this->TotalLatencyUs / (1e3 * count) : 0.;
+  std::stringstream report;
+  report << std::left << std::setw(24) << this->Name
+         << " count: " << std::setw(10) << count
+         << " mean: " << std::fixed << std::setprecision(3) << mean << " ms"
+         << " max: " << this->MaxLatencyUs / 1e3 << " ms";
+  return report.str();
+}
+
 //----------------------------------------------------------------------------
 PacketConsumer::PacketConsumer()
+  : LatestFrame(nullptr)
+  , NumberOfFrames(0)
+  , NumberOfDroppedFrames(0)
+  , NumberOfDroppedPackets(0)
+  , PacketQueueStatistics("Packet queue")
+  , DecodeStatistics("Decode")
+  , FrameLatencyStatistics("Frame to handoff")
 {
   this->Packets.reset(new SynchronizedQueue<NetworkPacket*>);
 }
 
+//----------------------------------------------------------------------------
+PacketConsumer::~PacketConsumer()
+{
+  this->Stop();
+  this->ClearAllFrames();
+}
+
 //----------------------------------------------------------------------------
 void PacketConsumer::HandleSensorData(const unsigned char *data, unsigned int length)
 {
   this->Interpreter->ProcessPacket(data, length);
   if (this->Interpreter->IsNewFrameReady())
   {
-    {
-      boost::lock_guard<boost::mutex> lock(this->ConsumerMutex);
-      this->Frames.push_back(this->Interpreter->GetLastFrameAvailable());
-    }
+    this->HandleNewFrame(this->Interpreter->GetLastFrameAvailable());
     this->Interpreter->ClearAllFramesAvailable();
   }
 }
 
 //----------------------------------------------------------------------------
-vtkSmartPointer<vtkPolyData> PacketConsumer::GetLastAvailableFrame()
+void PacketConsumer::HandleNewFrame(vtkSmartPointer<vtkPolyData> polyData)
+{
+  if (!this->FramesToProcess)
+  {
+    this->FrameLatencyStatistics.AddSample(0.);
+    this->HandleNewData(polyData);
+    return;
+  }
+
+  // Never wait for the processing stage, it is better to skip a frame
+  // than to delay the decoding of all the following ones
+  if (!this->FramesToProcess->tryEnqueue(TimedFrame(polyData, GetTimeInSeconds())))
+  {
+    this->NumberOfFrames++;
+    this->NumberOfDroppedFrames++;
+  }
+}
+
+//----------------------------------------------------------------------------
+void PacketConsumer::HandleNewData(vtkSmartPointer<vtkPolyData> polyData)
+{
+  // The slot owns a reference on the frame it holds
+  polyData->Register(nullptr);
+  vtkPolyData* previous = this->LatestFrame.exchange(polyData.GetPointer());
+  this->NumberOfFrames++;
+  if (previous)
+  {
+    // the previous frame has never been taken
+    previous->UnRegister(nullptr);
+    this->NumberOfDroppedFrames++;
+  }
+
+  {
+    boost::lock_guard<boost::mutex> lock(this->WaitMutex);
+  }
+  this->WaitCondition.notify_all();
+
+  if (this->NewFrameCallback)
+  {
+    this->NewFrameCallback();
+  }
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> PacketConsumer::TakeLastAvailableFrame()
+{
+  vtkSmartPointer<vtkPolyData> frame;
+  // steal the reference held by the slot
+  frame.TakeReference(this->LatestFrame.exchange(nullptr));
+  return frame;
+}
+
+//----------------------------------------------------------------------------
+bool PacketConsumer::WaitForNewFrame(double timeout)
+{
+  boost::unique_lock<boost::mutex> lock(this->WaitMutex);
+  return this->WaitCondition.wait_for(lock,
+                                      boost::chrono::duration<double>(timeout),
+                                      [this]() { return this->HasNewFrame(); });
+}
+
+//----------------------------------------------------------------------------
+void PacketConsumer::ClearAllFrames()
+{
+  vtkPolyData* frame = this->LatestFrame.exchange(nullptr);
+  if (frame)
+  {
+    frame->UnRegister(nullptr);
+  }
+}
+
+//----------------------------------------------------------------------------
+void PacketConsumer::AddFrameProcessor(std::shared_ptr<LidarFrameProcessor> processor)
 {
-  return this->Frames.back();
+  if (this->Thread)
+  {
+    vtkGenericWarningMacro("Frame processors cannot be added while the stream is running");
+    return;
+  }
+  this->FrameProcessors.push_back(processor);
+  this->ProcessorsStatistics.emplace_back(new StageStatistics(processor->GetName()));
+}
+
+//----------------------------------------------------------------------------
+void PacketConsumer::RemoveAllFrameProcessors()
+{
+  if (this->Thread)
+  {
+    vtkGenericWarningMacro("Frame processors cannot be removed while the stream is running");
+    return;
+  }
+  this->FrameProcessors.clear();
+  this->ProcessorsStatistics.clear();
+}
+
+//----------------------------------------------------------------------------
+std::string PacketConsumer::GetStatisticsReport() const
+{
+  std::stringstream report;
+  report << this->PacketQueueStatistics.GetReport() << std::endl
+         << this->DecodeStatistics.GetReport() << std::endl;
+  for (const auto& statistics : this->ProcessorsStatistics)
+  {
+    report << statistics->GetReport() << std::endl;
+  }
+  report << this->FrameLatencyStatistics.GetReport() << std::endl;
+
+  // the queues only exist while running
+  boost::shared_ptr<SynchronizedQueue<NetworkPacket*>> packets = this->Packets;
+  boost::shared_ptr<SynchronizedQueue<TimedFrame>> frames = this->FramesToProcess;
+  report << "Packets waiting: " << (packets ? packets->size() : 0)
+         << ", dropped: " << this->NumberOfDroppedPackets << std::endl
+         << "Frames waiting: " << (frames ? frames->size() : 0)
+         << ", produced: " << this->NumberOfFrames
+         << ", dropped: " << this->NumberOfDroppedFrames << std::endl;
+  return report.str();
 }
 
 //----------------------------------------------------------------------------
-int PacketConsumer::CheckForNewData()
+void PacketConsumer::ResetStatistics()
 {
-  return this->Frames.size();
+  this->PacketQueueStatistics.Reset();
+  this->DecodeStatistics.Reset();
+  for (auto& statistics : this->ProcessorsStatistics)
+  {
+    statistics->Reset();
+  }
+  this->FrameLatencyStatistics.Reset();
 }
 
 //----------------------------------------------------------------------------
@@ -41,8 +221,36 @@ void PacketConsumer::ThreadLoop()
   this->Interpreter->ResetCurrentFrame();
   while (this->Packets->dequeue(packet))
   {
+    double start = GetTimeInSeconds();
+    double receptionTime = packet->ReceptionTime.tv_sec + 1e-6 * packet->ReceptionTime.tv_usec;
+    this->PacketQueueStatistics.AddSample(start - receptionTime);
+
     this->HandleSensorData(packet->GetPayloadData(), packet->GetPayloadSize());
     delete packet;
+
+    this->DecodeStatistics.AddSample(GetTimeInSeconds() - start);
+  }
+}
+
+//----------------------------------------------------------------------------
+void PacketConsumer::ProcessingThreadLoop()
+{
+  TimedFrame frame;
+  while (this->FramesToProcess->dequeue(frame))
+  {
+    vtkSmartPointer<vtkPolyData> polyData = frame.first;
+    for (size_t i = 0; i < this->FrameProcessors.size() && polyData; ++i)
+    {
+      double start = GetTimeInSeconds();
+      polyData = this->FrameProcessors[i]->Process(polyData);
+      this->ProcessorsStatistics[i]->AddSample(GetTimeInSeconds() - start);
+    }
+
+    if (polyData)
+    {
+      this->FrameLatencyStatistics.AddSample(GetTimeInSeconds() - frame.second);
+      this->HandleNewData(polyData);
+    }
   }
 }
 
@@ -54,7 +262,17 @@ void PacketConsumer::Start()
     return;
   }
 
-  this->Packets.reset(new SynchronizedQueue<NetworkPacket*>);
+  this->NumberOfFrames = 0;
+  this->NumberOfDroppedFrames = 0;
+  this->NumberOfDroppedPackets = 0;
+  this->ResetStatistics();
+  this->Packets.reset(new SynchronizedQueue<NetworkPacket*>(this->MaxPacketQueueSize));
+  if (!this->FrameProcessors.empty())
+  {
+    this->FramesToProcess.reset(new SynchronizedQueue<TimedFrame>(this->MaxFrameQueueSize));
+    this->ProcessingThread = boost::shared_ptr<boost::thread>(
+          new boost::thread(boost::bind(&PacketConsumer::ProcessingThreadLoop, this)));
+  }
   this->Thread = boost::shared_ptr<boost::thread>(
         new boost::thread(boost::bind(&PacketConsumer::ThreadLoop, this)));
 }
@@ -68,11 +286,32 @@ void PacketConsumer::Stop()
     this->Thread->join();
     this->Thread.reset();
     this->Packets.reset();
+    if (this->NumberOfDroppedPackets > 0)
+    {
+      vtkGenericWarningMacro(<< this->NumberOfDroppedPackets
+                             << " packets have been dropped because the decoding was late");
+    }
+  }
+  if (this->ProcessingThread)
+  {
+    this->FramesToProcess->stopQueue();
+    this->ProcessingThread->join();
+    this->ProcessingThread.reset();
+    this->FramesToProcess.reset();
   }
 }
 
 //----------------------------------------------------------------------------
 void PacketConsumer::Enqueue(NetworkPacket* packet)
 {
-  this->Packets->enqueue(packet);
+  if (!this->Packets->tryEnqueue(packet))
+  {
+    delete packet;
+    // warn once per Start(), the total is reported by Stop()
+    if (this->NumberOfDroppedPackets++ == 0)
+    {
+      vtkGenericWarningMacro("The packet queue is full (" << this->MaxPacketQueueSize
+                             << " packets), packets are dropped until the decoding catches up");
+    }
+  }
 }
@@ -17,51 +17,188 @@
 
 #include <boost/shared_ptr.hpp>
 #include <boost/thread.hpp>
-#include <deque>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "vtkSmartPointer.h"
 #include "vtkLidarPacketInterpreter.h"
+#include "LidarFrameProcessor.h"
 #include "NetworkPacket.h"
 
 
 template<typename T>
 class SynchronizedQueue;
 
+/**
+ * @brief StageStatistics accumulates the latency of one stage of the live pipeline.
+ * Samples are added by the stage thread and read from any thread.
+ */
+struct StageStatistics
+{
+  StageStatistics(const std::string& name) : Name(name) {}
+
+  void AddSample(double latencyInSeconds);
+  void Reset();
+
+  //! Human readable summary: count, mean and max latency in ms
+  std::string GetReport() const;
+
+  const std::string Name;
+  std::atomic<uint64_t> Count{0};
+  std::atomic<uint64_t> TotalLatencyUs{0};
+  std::atomic<uint64_t> MaxLatencyUs{0};
+};
+
+/**
+ * @brief The PacketConsumer class decodes the packets received from the network
+ * and hands the frames over to the pipeline.
+ *
+ * The live processing is split in stages, each one running on its own thread and
+ * connected to the next one by a bounded queue:
+ * - receive: NetworkSource, which enqueues the packets without ever blocking,
+ *   the packets are dropped (and counted) when the packet queue is full
+ * - decode: the interpreter decodes the packets and assembles the frames.
+ *   Both are done by the same thread as the frame splitting depends on
+ *   the content of each packet, and the interpreters keep a rolling state
+ *   (timestamp rollovers, framing state, live calibration) from one packet
+ *   to the next, so the packets of a frame cannot be decoded out of order.
+ * - process: the registered LidarFrameProcessor are applied on each frame. This stage
+ *   only exists if at least one processor has been added. When it is late, the
+ *   decoded frames are dropped instead of delaying the decoding.
+ *
+ * The handoff to the pipeline is a single slot where the latest frame wins: if the
+ * pipeline does not take a frame before the next one is ready, the older frame is
+ * dropped and counted in NumberOfDroppedFrames. Publishing and taking a frame are
+ * lock free.
+ */
 class PacketConsumer
 {
 public:
   PacketConsumer();
+  ~PacketConsumer();
 
   void HandleSensorData(const unsigned char* data, unsigned int length);
 
-  vtkSmartPointer<vtkPolyData> GetLastAvailableFrame();
-
-  int CheckForNewData();
-
-  void ClearAllFrames() { this->Frames.clear();}
+  /**
+   * @brief TakeLastAvailableFrame return the latest frame and empty the slot
+   * @return nullptr if no frame has been produced since the last call
+   */
+  vtkSmartPointer<vtkPolyData> TakeLastAvailableFrame();
+
+  /**
+   * @brief HasNewFrame return true if a frame is waiting in the slot. This is
+   * a single atomic load so it can be polled as often as needed.
+   */
+  bool HasNewFrame() const { return this->LatestFrame.load() != nullptr; }
+
+  /**
+   * @brief WaitForNewFrame block until a frame is available or the timeout is reached
+   * @param timeout in seconds
+   * @return true if a frame is available
+   */
+  bool WaitForNewFrame(double timeout);
+
+  /**
+   * @brief SetNewFrameCallback set a function called by the consumer thread each
+   * time a new frame is available. It must be set before Start() and be cheap and
+   * thread safe, typically posting an event to another thread.
+   */
+  void SetNewFrameCallback(std::function<void()> callback) { this->NewFrameCallback = callback; }
+
+  //! Number of frames produced since the last call to Start()
+  uint64_t GetNumberOfFrames() const { return this->NumberOfFrames; }
+
+  //! Number of frames overwritten before being taken since the last call to Start()
+  uint64_t GetNumberOfDroppedFrames() const { return this->NumberOfDroppedFrames; }
+
+  //! Number of packets dropped because the decoding stage was late
+  uint64_t GetNumberOfDroppedPackets() const { return this->NumberOfDroppedPackets; }
+
+  /**
+   * @brief AddFrameProcessor add a processing stage applied on every frame. Must be
+   * called while the consumer is stopped.
+   */
+  void AddFrameProcessor(std::shared_ptr<LidarFrameProcessor> processor);
+  void RemoveAllFrameProcessors();
+
+  /**
+   * @brief GetStatisticsReport return the latency of each stage and the queues depth.
+   * Must not be called concurrently with Start() or Stop().
+   */
+  std::string GetStatisticsReport() const;
+  void ResetStatistics();
+
+  void ClearAllFrames();
 
   void Start();
 
   void Stop();
 
+  /**
+   * @brief Enqueue give a packet to the decoding stage, the consumer takes the
+   * ownership of the packet. This never blocks: when MaxPacketQueueSize packets
+   * are already waiting, the packet is dropped, counted and a warning is issued.
+   */
   void Enqueue(NetworkPacket* packet);
 
-  void SetInterpreter(vtkLidarPacketInterpreter* inter) { this->Interpreter = inter;}
+  //! Maximum number of packets waiting to be decoded, must be set before Start()
+  size_t MaxPacketQueueSize = 100000;
 
-  // Hold this when modifying internals of reader
-  boost::mutex ConsumerMutex;
+  //! Maximum number of frames waiting to be processed, must be set before Start()
+  size_t MaxFrameQueueSize = 2;
+
+  void SetInterpreter(vtkLidarPacketInterpreter* inter) { this->Interpreter = inter;}
 
 protected:
   void ThreadLoop();
 
+  void ProcessingThreadLoop();
+
+  //! Publish a frame in the handoff slot
   void HandleNewData(vtkSmartPointer<vtkPolyData> polyData);
 
-  std::deque<vtkSmartPointer<vtkPolyData> > Frames;
+  //! Give a frame assembled by the decoding stage to the next stage
+  void HandleNewFrame(vtkSmartPointer<vtkPolyData> polyData);
+
+  //! Single slot holding a reference on the latest frame, nullptr when empty
+  std::atomic<vtkPolyData*> LatestFrame;
+
+  std::atomic<uint64_t> NumberOfFrames;
+  std::atomic<uint64_t> NumberOfDroppedFrames;
+  std::atomic<uint64_t> NumberOfDroppedPackets;
+
+  std::vector<std::shared_ptr<LidarFrameProcessor>> FrameProcessors;
+
+  //! Time between the reception of a packet and its decoding
+  StageStatistics PacketQueueStatistics;
+  //! Time to decode one packet
+  StageStatistics DecodeStatistics;
+  //! Time spent by each frame processor, in the same order as FrameProcessors
+  std::vector<std::unique_ptr<StageStatistics>> ProcessorsStatistics;
+  //! Time between the end of the frame assembly and the handoff to the pipeline
+  StageStatistics FrameLatencyStatistics;
+
+  std::function<void()> NewFrameCallback;
+
+  //! Only used to wake up the threads waiting in WaitForNewFrame()
+  boost::mutex WaitMutex;
+  boost::condition_variable WaitCondition;
+
   vtkLidarPacketInterpreter* Interpreter;
 
   boost::shared_ptr<SynchronizedQueue<NetworkPacket*>> Packets;
 
+  //! Frames assembled and their assembly time, waiting to be processed
+  using TimedFrame = std::pair<vtkSmartPointer<vtkPolyData>, double>;
+  boost::shared_ptr<SynchronizedQueue<TimedFrame>> FramesToProcess;
+
   boost::shared_ptr<boost::thread> Thread;
+
+  boost::shared_ptr<boost::thread> ProcessingThread;
 };
 
 #endif // PACKETCONSUMER_H
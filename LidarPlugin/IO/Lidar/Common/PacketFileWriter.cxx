@@ -3,15 +3,152 @@
 //! @todo this include is only for vtkGenericWarningMacro which is strange
 #include <vtkMath.h>
 
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+//! pcap file global header, written in the native byte order as pcap_dump does
+struct PcapFileHeader
+{
+  uint32_t Magic = 0xa1b2c3d4;
+  uint16_t VersionMajor = 2;
+  uint16_t VersionMinor = 4;
+  int32_t ThisZone = 0;
+  uint32_t SigFigs = 0;
+  uint32_t SnapLen = 65535;
+  uint32_t LinkType = 1; // DLT_EN10MB
+};
+
+//! pcap record header, the timestamps are 32 bits in the file whatever the platform
+struct PcapRecordHeader
+{
+  uint32_t Seconds;
+  uint32_t MicroSeconds;
+  uint32_t CapturedLength;
+  uint32_t Length;
+};
+
+//-----------------------------------------------------------------------------
+double GetSteadyTimeInSeconds()
+{
+  return std::chrono::duration<double>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+}
+
+//-----------------------------------------------------------------------------
+PacketFileWriter::~PacketFileWriter()
+{
+  this->Stop();
+  this->Close();
+}
+
 //-----------------------------------------------------------------------------
 void PacketFileWriter::ThreadLoop()
 {
-  NetworkPacket* packet = nullptr;
-  while (this->Packets->dequeue(packet))
+  while (true)
+  {
+    std::unique_ptr<RecordBuffer> buffer;
+    {
+      boost::unique_lock<boost::mutex> lock(this->Mutex);
+      while (this->FullBuffers.empty() && !this->ShouldStop)
+      {
+        if (this->MaxBufferAge <= 0.)
+        {
+          this->FullBuffersCondition.wait(lock);
+        }
+        else if (this->FullBuffersCondition.wait_for(lock,
+                   boost::chrono::duration<double>(this->MaxBufferAge)) == boost::cv_status::timeout)
+        {
+          // no buffer has been sealed for MaxBufferAge, the packets stopped arriving
+          lock.unlock();
+          this->SealPendingData();
+          lock.lock();
+        }
+      }
+      if (this->FullBuffers.empty())
+      {
+        break;
+      }
+      buffer = std::move(this->FullBuffers.front());
+      this->FullBuffers.pop_front();
+    }
+
+    if (buffer->StartsNewFile)
+    {
+      // rotation, done here so that the receiving thread never waits for the file system
+      this->FileIndex++;
+      std::string filename = this->FileNameGenerator ? this->FileNameGenerator(this->FileIndex)
+                                                     : this->GetRotatedFileName(this->FileIndex);
+      if (!this->OpenFile(filename))
+      {
+        vtkGenericWarningMacro("Failed to open packet file: " << filename);
+      }
+    }
+
+    if (this->File && buffer->Size > 0)
+    {
+      double start = GetSteadyTimeInSeconds();
+      size_t written = std::fwrite(buffer->Data.data(), 1, buffer->Size, this->File);
+      this->TimeSpentWriting = this->TimeSpentWriting + (GetSteadyTimeInSeconds() - start);
+      this->NumberOfWrittenBytes += written;
+      if (written != buffer->Size)
+      {
+        vtkGenericWarningMacro("Failed to write packets to " << this->FileName);
+      }
+    }
+
+    buffer->Size = 0;
+    buffer->StartsNewFile = false;
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    this->FreeBuffers.push_back(std::move(buffer));
+  }
+
+  if (this->File)
+  {
+    std::fflush(this->File);
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool PacketFileWriter::OpenFile(const std::string& filename)
+{
+  if (this->File)
+  {
+    std::fclose(this->File);
+    this->File = nullptr;
+  }
+
+  this->File = std::fopen(filename.c_str(), "wb");
+  if (!this->File)
+  {
+    return false;
+  }
+  // the data is already written by big chunks, the stdio buffer would only add a copy
+  std::setvbuf(this->File, nullptr, _IONBF, 0);
+  this->FileName = filename;
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+std::string PacketFileWriter::GetRotatedFileName(int index) const
+{
+  if (index == 0)
   {
-    this->PacketWriter.WritePacket(*packet);
-    delete packet;
+    return this->BaseFileName;
   }
+  boost::filesystem::path path(this->BaseFileName);
+  std::ostringstream name;
+  name << path.stem().string() << "_" << std::setfill('0') << std::setw(3) << index
+       << path.extension().string();
+  return (path.parent_path() / name.str()).string();
 }
 
 //-----------------------------------------------------------------------------
@@ -22,21 +159,52 @@ void PacketFileWriter::Start(const std::string &filename)
     return;
   }
 
-  if (this->PacketWriter.GetFileName() != filename)
+  if (this->BaseFileName != filename)
   {
-    this->PacketWriter.Close();
+    this->Close();
   }
 
-  if (!this->PacketWriter.IsOpen())
+  // if the same recording is still open, the packets are appended to its last file,
+  // otherwise a new recording replaces any existing file
+  const bool newFile = !this->IsOpen();
+  if (newFile)
   {
-    if (!this->PacketWriter.Open(filename))
+    if (!this->OpenFile(filename))
     {
       vtkGenericWarningMacro("Failed to open packet file: " << filename);
       return;
     }
+    this->BaseFileName = filename;
+    this->FileIndex = 0;
   }
 
-  this->Packets.reset(new SynchronizedQueue<NetworkPacket*>);
+  this->FreeBuffers.clear();
+  this->FullBuffers.clear();
+  for (size_t i = 0; i < this->NumberOfBuffers; ++i)
+  {
+    std::unique_ptr<RecordBuffer> buffer(new RecordBuffer);
+    buffer->Data.resize(this->BufferSize);
+    this->FreeBuffers.push_back(std::move(buffer));
+  }
+  this->CurrentBuffer.reset();
+  this->CurrentBufferStartTime = -1.;
+  this->NextBufferStartsNewFile = false;
+  this->CurrentFileSize = static_cast<uint64_t>(std::ftell(this->File));
+  if (newFile)
+  {
+    PcapFileHeader fileHeader;
+    this->Append(&fileHeader, sizeof(fileHeader));
+  }
+  this->CurrentFilePackets = 0;
+  this->CurrentFileStartTime = -1.;
+  this->NumberOfRecordedPackets = 0;
+  this->NumberOfDroppedPackets = 0;
+  this->NumberOfWrittenBytes = 0;
+  this->TimeSpentWriting = 0.;
+  this->MaxQueueDepth = 0;
+  this->StartTime = GetSteadyTimeInSeconds();
+
+  this->ShouldStop = false;
   this->Thread = boost::shared_ptr<boost::thread>(
         new boost::thread(boost::bind(&PacketFileWriter::ThreadLoop, this)));
 }
@@ -46,25 +214,213 @@ void PacketFileWriter::Stop()
 {
   if (this->Thread)
   {
-    this->Packets->stopQueue();
+    {
+      boost::lock_guard<boost::mutex> lock(this->CurrentBufferMutex);
+      this->SealCurrentBuffer();
+    }
+    {
+      boost::lock_guard<boost::mutex> lock(this->Mutex);
+      this->ShouldStop = true;
+    }
+    this->FullBuffersCondition.notify_one();
     this->Thread->join();
     this->Thread.reset();
-    this->Packets.reset();
+    this->FreeBuffers.clear();
   }
 }
 
 //-----------------------------------------------------------------------------
-void PacketFileWriter::Enqueue(NetworkPacket* packet)
+void PacketFileWriter::Close()
 {
-  // TODO
-  // After capturing a stream and stoping the recording, Packets is NULL
-  // and this loop continues until a new reader or stream is selected.
-  if (this->Packets != NULL)
+  this->Stop();
+  if (this->File)
   {
-    this->Packets->enqueue(packet);
+    std::fclose(this->File);
+    this->File = nullptr;
+    this->FileName.clear();
+    this->BaseFileName.clear();
   }
-  else
+}
+
+//-----------------------------------------------------------------------------
+void PacketFileWriter::SealCurrentBuffer()
+{
+  if (!this->CurrentBuffer)
+  {
+    return;
+  }
+  size_t depth;
   {
-    this->Stop();
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    this->FullBuffers.push_back(std::move(this->CurrentBuffer));
+    depth = this->FullBuffers.size();
+    this->MaxQueueDepth = std::max(this->MaxQueueDepth, depth);
   }
+  this->FullBuffersCondition.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+void PacketFileWriter::SealPendingData()
+{
+  boost::lock_guard<boost::mutex> lock(this->CurrentBufferMutex);
+  if (this->CurrentBuffer && this->CurrentBuffer->Size > 0)
+  {
+    this->SealCurrentBuffer();
+  }
+}
+
+//-----------------------------------------------------------------------------
+size_t PacketFileWriter::GetNextBufferCapacity() const
+{
+  // end the buffer on a multiple of BufferSize in the file, so that the next
+  // ones are aligned again after a partial flush or an append
+  return this->BufferSize - static_cast<size_t>(this->CurrentFileSize % this->BufferSize);
+}
+
+//-----------------------------------------------------------------------------
+void PacketFileWriter::Append(const void* data, size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  while (size > 0)
+  {
+    if (!this->CurrentBuffer)
+    {
+      {
+        boost::lock_guard<boost::mutex> lock(this->Mutex);
+        this->CurrentBuffer = std::move(this->FreeBuffers.back());
+        this->FreeBuffers.pop_back();
+      }
+      this->CurrentBuffer->StartsNewFile = this->NextBufferStartsNewFile;
+      this->CurrentBuffer->Capacity = this->GetNextBufferCapacity();
+      this->CurrentBufferStartTime = -1.;
+      this->NextBufferStartsNewFile = false;
+    }
+
+    // a record can span two buffers, so that all the writes have the size of a buffer
+    RecordBuffer& buffer = *this->CurrentBuffer;
+    size_t chunk = std::min(size, buffer.Capacity - buffer.Size);
+    std::memcpy(buffer.Data.data() + buffer.Size, bytes, chunk);
+    buffer.Size += chunk;
+    this->CurrentFileSize += chunk;
+    bytes += chunk;
+    size -= chunk;
+
+    if (buffer.Size == buffer.Capacity)
+    {
+      this->SealCurrentBuffer();
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+void PacketFileWriter::Enqueue(const NetworkPacket& packet)
+{
+  if (!this->Thread)
+  {
+    return;
+  }
+  boost::lock_guard<boost::mutex> currentBufferLock(this->CurrentBufferMutex);
+
+  const size_t recordSize = sizeof(PcapRecordHeader) + packet.GetPacketSize();
+  const double packetTime = packet.ReceptionTime.tv_sec + 1e-6 * packet.ReceptionTime.tv_usec;
+
+  // split the recording if needed
+  if (this->CurrentFileStartTime < 0.)
+  {
+    this->CurrentFileStartTime = packetTime;
+  }
+  bool rotate = this->CurrentFilePackets > 0 &&
+    ((this->MaxFileSize > 0 && this->CurrentFileSize + recordSize > this->MaxFileSize) ||
+     (this->MaxFileDuration > 0. && packetTime - this->CurrentFileStartTime >= this->MaxFileDuration) ||
+     (this->MaxPacketsPerFile > 0 && this->CurrentFilePackets >= this->MaxPacketsPerFile));
+
+  // check that the record fits in the available memory, otherwise drop it
+  // as a whole so that the file is never corrupted
+  const size_t requiredSize = recordSize + (rotate ? sizeof(PcapFileHeader) : 0);
+  size_t available = 0;
+  if (this->CurrentBuffer && !rotate)
+  {
+    available = this->CurrentBuffer->Capacity - this->CurrentBuffer->Size;
+  }
+  if (available < requiredSize)
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    if (!this->FreeBuffers.empty())
+    {
+      // only a buffer started at an unaligned offset is shorter
+      bool aligned = rotate || this->CurrentBuffer;
+      available += (aligned ? this->BufferSize : this->GetNextBufferCapacity()) +
+                   (this->FreeBuffers.size() - 1) * this->BufferSize;
+    }
+  }
+  if (available < requiredSize)
+  {
+    this->NumberOfDroppedPackets++;
+    return;
+  }
+
+  if (rotate)
+  {
+    this->SealCurrentBuffer();
+    this->NextBufferStartsNewFile = true;
+    this->CurrentFileSize = 0;
+    this->CurrentFilePackets = 0;
+    this->CurrentFileStartTime = packetTime;
+    PcapFileHeader fileHeader;
+    this->Append(&fileHeader, sizeof(fileHeader));
+  }
+
+  PcapRecordHeader header;
+  header.Seconds = static_cast<uint32_t>(packet.ReceptionTime.tv_sec);
+  header.MicroSeconds = static_cast<uint32_t>(packet.ReceptionTime.tv_usec);
+  header.CapturedLength = packet.GetPacketSize();
+  header.Length = packet.GetPacketSize();
+  this->Append(&header, sizeof(header));
+  this->Append(packet.GetPacketData(), packet.GetPacketSize());
+  if (this->CurrentBufferStartTime < 0.)
+  {
+    this->CurrentBufferStartTime = packetTime;
+  }
+
+  this->CurrentFilePackets++;
+  this->NumberOfRecordedPackets++;
+
+  if (this->MaxBufferAge > 0. && this->CurrentBuffer &&
+      packetTime - this->CurrentBufferStartTime >= this->MaxBufferAge)
+  {
+    this->SealCurrentBuffer();
+  }
+}
+
+//-----------------------------------------------------------------------------
+size_t PacketFileWriter::GetQueueDepth()
+{
+  boost::lock_guard<boost::mutex> lock(this->Mutex);
+  return this->FullBuffers.size();
+}
+
+//-----------------------------------------------------------------------------
+std::string PacketFileWriter::GetStatisticsReport()
+{
+  const double megaBytes = this->NumberOfWrittenBytes / (1024. * 1024.);
+  const double elapsed = GetSteadyTimeInSeconds() - this->StartTime;
+  const double writing = this->TimeSpentWriting;
+  size_t depth, maxDepth;
+  {
+    boost::lock_guard<boost::mutex> lock(this->Mutex);
+    depth = this->FullBuffers.size();
+    maxDepth = this->MaxQueueDepth;
+  }
+
+  std::ostringstream report;
+  report << std::fixed << std::setprecision(2);
+  report << "Recording: " << this->BaseFileName << std::endl;
+  report << "  written: " << megaBytes << " MiB, "
+         << (elapsed > 0. ? megaBytes / elapsed : 0.) << " MiB/s average, "
+         << (writing > 0. ? megaBytes / writing : 0.) << " MiB/s disk" << std::endl;
+  report << "  queue depth: " << depth << " / " << this->NumberOfBuffers
+         << " buffers (max " << maxDepth << ")" << std::endl;
+  report << "  packets: " << this->NumberOfRecordedPackets << " recorded, "
+         << this->NumberOfDroppedPackets << " dropped" << std::endl;
+  return report.str();
 }
@@ -15,33 +15,177 @@
 #ifndef PACKETWRITER_H
 #define PACKETWRITER_H
 
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <string>
-#include <queue>
+#include <vector>
 #include <boost/thread/thread.hpp>
-#include <boost/asio.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition_variable.hpp>
 
-#include "vtkPacketFileWriter.h"
-#include "SynchronizedQueue.h"
+#include "NetworkPacket.h"
 
+/**
+ * @brief The PacketFileWriter class record the packets received on the network in
+ * pcap files without slowing down the reception.
+ *
+ * The packets are serialized (pcap record header + data) by the receiving thread in a
+ * large preallocated buffer, which is handed over to a dedicated flush thread once full.
+ * The flush thread writes each buffer with a single unbuffered write, so the disk sees
+ * big writes of BufferSize bytes. The pcap global header is serialized in the same
+ * stream, and a buffer flushed before being full (see MaxBufferAge) is followed by a
+ * shorter one, so that the writes of full buffers start on a multiple of BufferSize
+ * in the file. When all the buffers are waiting to be written the incoming packets are
+ * dropped and counted, the receiving thread never waits for the disk.
+ *
+ * The recording can be split in several files, by size, by duration or by number of
+ * packets. The files are opened by the flush thread. By default the first file is
+ * the one given to Start(), the next ones are suffixed by "_001", "_002", ...
+ *
+ * Enqueue() must always be called from the same thread (the network thread).
+ */
 class PacketFileWriter
 {
 public:
-  void ThreadLoop();
+  PacketFileWriter() = default;
+  ~PacketFileWriter();
 
+  /**
+   * @brief Start open the file and start the flush thread. If the file given is
+   * the one of the recording still open, the packets are appended to it, otherwise
+   * the file is overwritten.
+   */
   void Start(const std::string& filename);
 
+  /**
+   * @brief Stop write all pending packets and stop the flush thread.
+   * The current file stays open until Close() or a Start() with another file name.
+   */
   void Stop();
 
-  void Enqueue(NetworkPacket* packet);
+  //! Serialize a packet, the packet is not kept and stays owned by the caller
+  void Enqueue(const NetworkPacket& packet);
+
+  bool IsOpen() const { return this->File != nullptr; }
+
+  void Close();
+
+  //! Size of each buffer in bytes, must be set before Start()
+  size_t BufferSize = 4 << 20;
+
+  //! Number of buffers allocated by Start(), must be set before Start()
+  size_t NumberOfBuffers = 16;
+
+  //! Start a new file when the current one would exceed this size in bytes, 0 to disable
+  uint64_t MaxFileSize = 0;
+
+  //! Start a new file when the current one spans more than this duration in seconds, 0 to disable
+  double MaxFileDuration = 0.;
+
+  //! Start a new file after this number of packets, 0 to disable
+  uint64_t MaxPacketsPerFile = 0;
+
+  /**
+   * @brief Maximum time in seconds a packet stays in memory before being given to
+   * the flush thread, 0 to only flush full buffers. A low value lowers the amount
+   * of data lost if the application crashes, at the expense of smaller writes.
+   * The age is checked when a packet arrives, and by the flush thread when no
+   * packet arrives.
+   */
+  double MaxBufferAge = 0.;
+
+  /**
+   * @brief FileNameGenerator give the name of the i-th file (i > 0) of the recording.
+   * Must be set before Start(). If not set, see class documentation.
+   */
+  std::function<std::string(int)> FileNameGenerator;
+
+  //! Number of packets serialized since the last Start()
+  uint64_t GetNumberOfRecordedPackets() const { return this->NumberOfRecordedPackets; }
+
+  //! Number of packets dropped since the last Start() because the disk was too slow
+  uint64_t GetNumberOfDroppedPackets() const { return this->NumberOfDroppedPackets; }
+
+  //! Number of bytes written on disk since the last Start()
+  uint64_t GetNumberOfWrittenBytes() const { return this->NumberOfWrittenBytes; }
 
-  bool IsOpen() { return this->PacketWriter.IsOpen(); }
+  //! Number of buffers waiting to be written
+  size_t GetQueueDepth();
 
-  void Close() { this->PacketWriter.Close(); }
+  /**
+   * @brief GetStatisticsReport return the write throughput, the queue depth and
+   * the number of dropped packets
+   */
+  std::string GetStatisticsReport();
 
 private:
-  vtkPacketFileWriter PacketWriter;
+  struct RecordBuffer
+  {
+    std::vector<unsigned char> Data;
+    size_t Size = 0;
+    //! Number of bytes that can be used, lower than the size of Data when the
+    //! buffer realigns the stream after a partial flush
+    size_t Capacity = 0;
+    //! The file must be rotated before writing this buffer
+    bool StartsNewFile = false;
+  };
+
+  void ThreadLoop();
+
+  //! Create or overwrite a file, the pcap global header is serialized by
+  //! the producer side. Called by the flush thread for the rotated files.
+  bool OpenFile(const std::string& filename);
+
+  //! Give the current buffer to the flush thread, CurrentBufferMutex must be locked
+  void SealCurrentBuffer();
+
+  //! Give the current buffer to the flush thread if it holds data, called by
+  //! the flush thread when no packet arrived for MaxBufferAge
+  void SealPendingData();
+
+  //! Number of bytes that can be appended to a buffer started at the current file offset
+  size_t GetNextBufferCapacity() const;
+
+  //! Copy data to the current buffers, the caller must have checked that
+  //! enough free buffers are available
+  void Append(const void* data, size_t size);
+
+  std::string GetRotatedFileName(int index) const;
+
+  std::FILE* File = nullptr;
+  //! File given to Start()
+  std::string BaseFileName;
+  //! File currently written
+  std::string FileName;
+  int FileIndex = 0;
+
   boost::shared_ptr<boost::thread> Thread;
-  boost::shared_ptr<SynchronizedQueue<NetworkPacket*>> Packets;
+  boost::mutex Mutex;
+  boost::condition_variable FullBuffersCondition;
+  std::deque<std::unique_ptr<RecordBuffer>> FullBuffers;
+  std::vector<std::unique_ptr<RecordBuffer>> FreeBuffers;
+  bool ShouldStop = false;
+  size_t MaxQueueDepth = 0;
+
+  // Producer side, accessed by the thread calling Enqueue(), and by the flush
+  // thread to seal the buffer when no packet arrives, both with CurrentBufferMutex
+  boost::mutex CurrentBufferMutex;
+  std::unique_ptr<RecordBuffer> CurrentBuffer;
+  double CurrentBufferStartTime = 0.;
+  bool NextBufferStartsNewFile = false;
+  //! Size of the current file once all the serialized data is written
+  uint64_t CurrentFileSize = 0;
+  uint64_t CurrentFilePackets = 0;
+  double CurrentFileStartTime = 0.;
+
+  std::atomic<uint64_t> NumberOfRecordedPackets{ 0 };
+  std::atomic<uint64_t> NumberOfDroppedPackets{ 0 };
+  std::atomic<uint64_t> NumberOfWrittenBytes{ 0 };
+  std::atomic<double> TimeSpentWriting{ 0. };
+  double StartTime = 0.;
 };
 
 
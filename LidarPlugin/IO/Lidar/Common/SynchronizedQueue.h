@@ -21,16 +21,23 @@
 /**
  * @brief The SynchronizedQueue class is a FIFO structure whith some mutex to allow acces
  * from multiple thread.
+ *
+ * By default the queue is unbounded. When a maximum size is given, enqueue() blocks
+ * the producer until a consumer made some room, which gives back-pressure between
+ * the stages of a pipeline.
  */
 template<typename T>
 class SynchronizedQueue
 {
 public:
-  SynchronizedQueue()
+  SynchronizedQueue(size_t maxSize = 0)
     : queue_()
     , mutex_()
     , cond_()
+    , not_full_cond_()
+    , max_size_(maxSize)
     , request_to_end_(false)
+    , request_to_finish_(false)
     , enqueue_data_(true)
   {
   }
@@ -39,23 +46,45 @@ public:
   {
     boost::unique_lock<boost::mutex> lock(mutex_);
 
-    if (enqueue_data_)
+    while (max_size_ > 0 && queue_.size() >= max_size_ && enqueue_data_ && !request_to_end_)
+    {
+      not_full_cond_.wait(lock);
+    }
+
+    if (enqueue_data_ && !request_to_end_)
     {
       queue_.push(data);
       cond_.notify_one();
     }
   }
 
+  /**
+   * @brief tryEnqueue same as enqueue but never block
+   * @return false if the data could not be added because the queue is full or stopped
+   */
+  bool tryEnqueue(const T &data)
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+
+    if (!enqueue_data_ || request_to_end_ || (max_size_ > 0 && queue_.size() >= max_size_))
+    {
+      return false;
+    }
+    queue_.push(data);
+    cond_.notify_one();
+    return true;
+  }
+
   bool dequeue(T &result)
   {
     boost::unique_lock<boost::mutex> lock(mutex_);
 
-    while (queue_.empty() && (!request_to_end_))
+    while (queue_.empty() && (!request_to_end_) && (!request_to_finish_))
     {
       cond_.wait(lock);
     }
 
-    if (request_to_end_)
+    if (request_to_end_ || queue_.empty())
     {
       doEndActions();
       return false;
@@ -63,15 +92,33 @@ public:
 
     result = queue_.front();
     queue_.pop();
+    not_full_cond_.notify_one();
 
     return true;
   }
 
+  /**
+   * @brief stopQueue stop the queue right away, the data still in the queue are dropped
+   */
   void stopQueue()
   {
     boost::unique_lock<boost::mutex> lock(mutex_);
     request_to_end_ = true;
-    cond_.notify_one();
+    cond_.notify_all();
+    not_full_cond_.notify_all();
+  }
+
+  /**
+   * @brief finishQueue refuse any new data but let the consumers dequeue the data
+   * still in the queue. dequeue() returns false once the queue has been drained.
+   */
+  void finishQueue()
+  {
+    boost::unique_lock<boost::mutex> lock(mutex_);
+    request_to_finish_ = true;
+    enqueue_data_ = false;
+    cond_.notify_all();
+    not_full_cond_.notify_all();
   }
 
   unsigned int size()
@@ -100,8 +147,11 @@ private:
   std::queue<T> queue_;            // Use STL queue to store data
   mutable boost::mutex mutex_;     // The mutex to synchronise on
   boost::condition_variable cond_; // The condition to wait for
+  boost::condition_variable not_full_cond_; // The condition a producer wait for when the queue is full
+  size_t max_size_;                // 0 means unbounded
 
   bool request_to_end_;
+  bool request_to_finish_;
   bool enqueue_data_;
 };
 
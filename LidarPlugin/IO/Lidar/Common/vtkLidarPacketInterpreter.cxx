@@ -113,6 +113,32 @@ bool vtkLidarPacketInterpreter::shouldBeCroppedOut(double pos[3])
 //-----------------------------------------------------------------------------
 vtkCxxSetObjectMacro(vtkLidarPacketInterpreter, SensorTransform, vtkTransform)
 
+//-----------------------------------------------------------------------------
+void vtkLidarPacketInterpreter::CopyParametersTo(vtkLidarPacketInterpreter* other) const
+{
+  other->CalibrationFileName = this->CalibrationFileName;
+  other->TimeOffset = this->TimeOffset;
+  other->LaserSelection = this->LaserSelection;
+  other->DistanceResolutionM = this->DistanceResolutionM;
+  other->IgnoreZeroDistances = this->IgnoreZeroDistances;
+  other->IgnoreEmptyFrames = this->IgnoreEmptyFrames;
+  other->ApplyTransform = this->ApplyTransform;
+  other->CropMode = this->CropMode;
+  other->CropOutside = this->CropOutside;
+  std::copy(this->CropRegion, this->CropRegion + 6, other->CropRegion);
+  // the transform is updated while decoding, so each interpreter needs its own
+  if (this->SensorTransform)
+  {
+    vtkNew<vtkTransform> transform;
+    transform->DeepCopy(this->SensorTransform);
+    other->SetSensorTransform(transform);
+  }
+  else
+  {
+    other->SetSensorTransform(nullptr);
+  }
+}
+
 //-----------------------------------------------------------------------------
 vtkMTimeType vtkLidarPacketInterpreter::GetMTime()
 {
@@ -107,6 +107,16 @@ public:
    */
   virtual void ResetCurrentFrame() { this->CurrentFrame = this->CreateNewEmptyFrame(0); }
 
+  /**
+   * @brief NewDecodingInstance create an interpreter with the same calibration and
+   * parameters, so that several frames of a recording can be decoded at the same
+   * time, each thread with its own interpreter. The frame catalog must still be
+   * built by this interpreter.
+   * @return nullptr if the interpreter cannot be duplicated, for example when the
+   * calibration comes from the stream
+   */
+  virtual vtkSmartPointer<vtkLidarPacketInterpreter> NewDecodingInstance() { return nullptr; }
+
   /**
    * @brief isNewFrameReady check if a new frame is ready
    */
@@ -218,6 +228,12 @@ protected:
    */
   bool shouldBeCroppedOut(double pos[3]);
 
+  /**
+   * @brief CopyParametersTo copy the parameters common to all the interpreters,
+   * used by NewDecodingInstance(). The calibration must be loaded beforehand.
+   */
+  void CopyParametersTo(vtkLidarPacketInterpreter* other) const;
+
   //! Buffer to store the frame once they are ready
   std::vector<vtkSmartPointer<vtkPolyData> > Frames;
 
@@ -1,19 +1,27 @@
 #include "vtkLidarReader.h"
 
+#include <algorithm>
+#include <atomic>
 #include <sstream>
 
 #include "vtkLidarPacketInterpreter.h"
 #include "vtkPacketFileWriter.h"
 #include "vtkPacketFileReader.h"
+#include "FramePrefetcher.h"
+#include "LidarFrameProcessor.h"
 #include "statistics.h"
 
 #include <vtkInformationVector.h>
 #include <vtkInformation.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 
+#include <boost/thread.hpp>
+
 //-----------------------------------------------------------------------------
 int vtkLidarReader::ReadFrameInformation()
 {
+  // the decoding thread uses the frame catalog
+  this->StopDecodeAhead();
   this->Open();
   const unsigned char* data = 0;
   unsigned int dataLength = 0;
@@ -128,6 +136,19 @@ void vtkLidarReader::SetTimestepInformation(vtkInformation *info)
 //-----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkLidarReader)
 
+//-----------------------------------------------------------------------------
+vtkLidarReader::vtkLidarReader()
+  : Prefetcher(new FramePrefetcher)
+{
+}
+
+//-----------------------------------------------------------------------------
+vtkLidarReader::~vtkLidarReader()
+{
+  // the decoding thread uses the reader
+  this->StopDecodeAhead();
+}
+
 //-----------------------------------------------------------------------------
 void vtkLidarReader::SetFileName(const std::string &filename)
 {
@@ -136,6 +157,7 @@ void vtkLidarReader::SetFileName(const std::string &filename)
     return;
   }
 
+  this->StopDecodeAhead();
   this->FileName = filename;
   this->FrameCatalog.clear();
   this->Modified();
@@ -144,15 +166,23 @@ void vtkLidarReader::SetFileName(const std::string &filename)
 //-----------------------------------------------------------------------------
 vtkSmartPointer<vtkPolyData> vtkLidarReader::GetFrame(int frameNumber)
 {
-  this->Interpreter->ResetCurrentFrame();
-  this->Interpreter->ClearAllFramesAvailable();
+  boost::lock_guard<boost::mutex> lock(this->InterpreterMutex);
+  return this->DecodeFrame(this->Interpreter, this->Reader, frameNumber);
+}
 
-  if (!this->Reader)
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> vtkLidarReader::DecodeFrame(vtkLidarPacketInterpreter* interpreter,
+                                                       vtkPacketFileReader* reader, int frameNumber)
+{
+  interpreter->ResetCurrentFrame();
+  interpreter->ClearAllFramesAvailable();
+
+  if (!reader)
   {
     vtkErrorMacro("GetFrame() called but packet file reader is not open.");
     return 0;
   }
-  if (!this->Interpreter->GetIsCalibrated())
+  if (!interpreter->GetIsCalibrated())
   {
     vtkErrorMacro("Calibration data has not been loaded.");
     return 0;
@@ -164,29 +194,190 @@ vtkSmartPointer<vtkPolyData> vtkLidarReader::GetFrame(int frameNumber)
 
   // Update the interpreter meta data according to the requested frame
   FrameInformation currInfo= this->FrameCatalog[frameNumber];
-  this->Interpreter->SetParserMetaData(this->FrameCatalog[frameNumber]);
-  this->Reader->SetFilePosition(&currInfo.FilePosition);
+  interpreter->SetParserMetaData(this->FrameCatalog[frameNumber]);
+  reader->SetFilePosition(&currInfo.FilePosition);
 
-  while (this->Reader->NextPacket(data, dataLength, timeSinceStart))
+  while (reader->NextPacket(data, dataLength, timeSinceStart))
   {
     // If the current packet is not a lidar packet,
     // skip it and update the file position
-    if (!this->Interpreter->IsLidarPacket(data, dataLength))
+    if (!interpreter->IsLidarPacket(data, dataLength))
     {
       continue;
     }
 
     // Process the lidar packet and check
     // if the required frame is ready
-    this->Interpreter->ProcessPacket(data, dataLength);
-    if (this->Interpreter->IsNewFrameReady())
+    interpreter->ProcessPacket(data, dataLength);
+    if (interpreter->IsNewFrameReady())
+    {
+      return interpreter->GetLastFrameAvailable();
+    }
+  }
+
+  interpreter->SplitFrame(true);
+  return interpreter->GetLastFrameAvailable();
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarReader::GetTimeStepFrames(const std::vector<int>& timeStepIndices,
+  std::function<void(int, vtkSmartPointer<vtkPolyData>)> callback)
+{
+  // same offset as in SetTimestepInformation()
+  int offset = (!this->ShowFirstAndLastFrame && this->FrameCatalog.size() >= 3) ? 1 : 0;
+
+  bool wasOpen = this->Reader != nullptr;
+  if (!wasOpen)
+  {
+    this->Open();
+    if (!this->Reader)
+    {
+      return;
+    }
+  }
+
+  std::vector<int> validIndices, frameNumbers;
+  for (int timeStepIndex : timeStepIndices)
+  {
+    int frameNumber = timeStepIndex + offset;
+    if (frameNumber < 0 || frameNumber >= this->GetNumberOfFrames())
+    {
+      vtkErrorMacro("Cannot meet timestep request: " << timeStepIndex);
+      continue;
+    }
+    validIndices.push_back(timeStepIndex);
+    frameNumbers.push_back(frameNumber);
+  }
+
+  int numberOfThreads = std::min(this->GetNumberOfDecodeThreadsToUse(),
+                                 static_cast<int>(frameNumbers.size()));
+  std::vector<vtkSmartPointer<vtkLidarPacketInterpreter>> interpreters;
+  if (numberOfThreads > 1)
+  {
+    interpreters = this->NewDecodingInterpreters(numberOfThreads);
+  }
+  if (!interpreters.empty())
+  {
+    this->DecodeFramesConcurrently(validIndices, frameNumbers, interpreters, callback);
+  }
+  else
+  {
+    for (size_t i = 0; i < frameNumbers.size(); ++i)
     {
-      return this->Interpreter->GetLastFrameAvailable();
+      callback(validIndices[i], this->GetFrame(frameNumbers[i]));
     }
   }
 
-  this->Interpreter->SplitFrame(true);
-  return this->Interpreter->GetLastFrameAvailable();
+  if (!wasOpen)
+  {
+    this->Close();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarReader::DecodeFramesConcurrently(const std::vector<int>& timeStepIndices,
+  const std::vector<int>& frameNumbers,
+  const std::vector<vtkSmartPointer<vtkLidarPacketInterpreter>>& interpreters,
+  std::function<void(int, vtkSmartPointer<vtkPolyData>)> callback)
+{
+  // each thread reads the pcap file on its own, the files are opened here
+  // as compiling the packet filter is not thread safe with old libpcap
+  std::vector<std::unique_ptr<vtkPacketFileReader>> readers;
+  for (size_t i = 0; i < interpreters.size(); ++i)
+  {
+    std::unique_ptr<vtkPacketFileReader> reader(new vtkPacketFileReader);
+    if (!this->OpenPacketFile(reader.get()))
+    {
+      return;
+    }
+    readers.push_back(std::move(reader));
+  }
+
+  // the threads take the frames in order, and the callback is called by this
+  // thread as soon as the next frame is decoded
+  std::vector<vtkSmartPointer<vtkPolyData>> frames(frameNumbers.size());
+  std::vector<bool> decoded(frameNumbers.size(), false);
+  std::atomic<size_t> nextFrame(0);
+  boost::mutex mutex;
+  boost::condition_variable condition;
+  boost::thread_group threads;
+  for (size_t t = 0; t < interpreters.size(); ++t)
+  {
+    vtkLidarPacketInterpreter* interpreter = interpreters[t];
+    vtkPacketFileReader* reader = readers[t].get();
+    threads.create_thread([&, interpreter, reader]()
+    {
+      for (size_t i = nextFrame++; i < frameNumbers.size(); i = nextFrame++)
+      {
+        vtkSmartPointer<vtkPolyData> frame = this->DecodeFrame(interpreter, reader, frameNumbers[i]);
+        {
+          boost::lock_guard<boost::mutex> lock(mutex);
+          frames[i] = frame;
+          decoded[i] = true;
+        }
+        condition.notify_one();
+      }
+    });
+  }
+
+  for (size_t i = 0; i < frameNumbers.size(); ++i)
+  {
+    vtkSmartPointer<vtkPolyData> frame;
+    {
+      boost::unique_lock<boost::mutex> lock(mutex);
+      condition.wait(lock, [&decoded, i]() { return decoded[i]; });
+      frame = frames[i];
+      frames[i] = nullptr;
+    }
+    callback(timeStepIndices[i], frame);
+  }
+  threads.join_all();
+}
+
+//-----------------------------------------------------------------------------
+int vtkLidarReader::GetNumberOfDecodeThreadsToUse() const
+{
+  if (this->NumberOfDecodeThreads > 0)
+  {
+    return this->NumberOfDecodeThreads;
+  }
+  return static_cast<int>(std::max(1u, std::min(boost::thread::hardware_concurrency(), 4u)));
+}
+
+//-----------------------------------------------------------------------------
+std::vector<vtkSmartPointer<vtkLidarPacketInterpreter>>
+vtkLidarReader::NewDecodingInterpreters(int count)
+{
+  std::vector<vtkSmartPointer<vtkLidarPacketInterpreter>> interpreters;
+  if (!this->Interpreter)
+  {
+    return interpreters;
+  }
+  boost::lock_guard<boost::mutex> lock(this->InterpreterMutex);
+  for (int i = 0; i < count; ++i)
+  {
+    vtkSmartPointer<vtkLidarPacketInterpreter> interpreter = this->Interpreter->NewDecodingInstance();
+    if (!interpreter)
+    {
+      interpreters.clear();
+      break;
+    }
+    interpreters.push_back(interpreter);
+  }
+  return interpreters;
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarReader::SetNumberOfDecodeThreads(int numberOfThreads)
+{
+  // No call to Modified(): this only changes how the frames are decoded, not the output
+  numberOfThreads = std::max(numberOfThreads, 0);
+  if (numberOfThreads != this->NumberOfDecodeThreads)
+  {
+    // decoding ahead restarts with the new number of threads on the next request
+    this->StopDecodeAhead();
+    this->NumberOfDecodeThreads = numberOfThreads;
+  }
 }
 
 //-----------------------------------------------------------------------------
@@ -232,18 +423,27 @@ void vtkLidarReader::Open()
 {
   this->Close();
   this->Reader = new vtkPacketFileReader;
+  if (!this->OpenPacketFile(this->Reader))
+  {
+    this->Close();
+  }
+}
 
+//-----------------------------------------------------------------------------
+bool vtkLidarReader::OpenPacketFile(vtkPacketFileReader* reader)
+{
   std::string filterPCAP = "udp";
   if (this->LidarPort != -1)
   {
     filterPCAP += " port " + std::to_string(this->LidarPort);
   }
-  if (!this->Reader->Open(this->FileName, filterPCAP.c_str()))
+  if (!reader->Open(this->FileName, filterPCAP.c_str()))
   {
     vtkErrorMacro(<< "Failed to open packet file: " << this->FileName << "!\n"
-                                                 << this->Reader->GetLastError())
-    this->Close();
+                                                 << reader->GetLastError())
+    return false;
   }
+  return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -314,6 +514,7 @@ void vtkLidarReader::SaveFrame(int startFrame, int endFrame, const std::string &
   // Since the PreProcessPacket method of the interpreter can change
   // its internal state, we store and then restore the contained meta
   // data
+  boost::lock_guard<boost::mutex> lock(this->InterpreterMutex);
   FrameInformation storedMetaData = this->Interpreter->GetParserMetaData();
 
   while (this->Reader->NextPacket(
@@ -341,6 +542,7 @@ void vtkLidarReader::SetLidarPort(int _arg)
 {
   if (this->LidarPort != _arg)
   {
+    this->StopDecodeAhead();
     this->LidarPort = _arg;
     this->FrameCatalog.clear();
     this->Modified();
@@ -419,14 +621,152 @@ int vtkLidarReader::RequestData(vtkInformation *vtkNotUsed(request),
   }
   this->LastFrameProcessed = frameRequested;
 
+  // frames decoded ahead with previous settings are outdated
+  if (this->Prefetcher->IsRunning() && this->GetMTime() > this->DecodeAheadMTime)
+  {
+    this->StopDecodeAhead();
+  }
+  if (this->DecodeAheadWindow > 0 && (this->Prefetcher->IsRunning() || this->StartDecodeAhead()))
+  {
+    vtkSmartPointer<vtkPolyData> frame = this->Prefetcher->GetFrame(frameRequested);
+    if (frame)
+    {
+      output->ShallowCopy(frame);
+    }
+    return 1;
+  }
+
   //! @todo we should no open the pcap file everytime a frame is requested !!!
   this->Open();
-  output->ShallowCopy(this->GetFrame(frameRequested));
+  vtkSmartPointer<vtkPolyData> frame = this->GetFrame(frameRequested);
   this->Close();
+  for (const auto& processor : this->FrameProcessors)
+  {
+    if (!frame)
+    {
+      break;
+    }
+    frame = processor->Process(frame);
+  }
+  if (frame)
+  {
+    output->ShallowCopy(frame);
+  }
 
   return 1;
 }
 
+//-----------------------------------------------------------------------------
+void vtkLidarReader::SetDecodeAheadWindow(int window)
+{
+  // No call to Modified(): this only changes when the frames are decoded, not the output
+  this->DecodeAheadWindow = std::max(window, 0);
+  if (this->DecodeAheadWindow > 0)
+  {
+    this->Prefetcher->SetWindowSize(this->DecodeAheadWindow);
+  }
+  else
+  {
+    this->StopDecodeAhead();
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool vtkLidarReader::IsFrameDecodedForTime(double time)
+{
+  if (!this->Prefetcher->IsRunning())
+  {
+    return true;
+  }
+  return this->Prefetcher->IsFrameReady(this->GetFrameIndexForPacketTime(time));
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarReader::AddFrameProcessor(vtkPolyDataAlgorithm* algorithm)
+{
+  if (!algorithm)
+  {
+    return;
+  }
+  this->StopDecodeAhead();
+  this->FrameProcessors.push_back(std::make_shared<AlgorithmFrameProcessor>(algorithm));
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarReader::RemoveAllFrameProcessors()
+{
+  this->StopDecodeAhead();
+  this->FrameProcessors.clear();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+std::string vtkLidarReader::GetDecodeAheadStatistics()
+{
+  return this->Prefetcher->GetStatisticsReport();
+}
+
+//-----------------------------------------------------------------------------
+bool vtkLidarReader::StartDecodeAhead()
+{
+  // each decoding thread reads the pcap file on its own, not to interfere
+  // with the reader used by GetFrame() or SaveFrame()
+  int numberOfThreads = this->GetNumberOfDecodeThreadsToUse();
+  std::vector<vtkSmartPointer<vtkLidarPacketInterpreter>> interpreters;
+  if (numberOfThreads > 1)
+  {
+    interpreters = this->NewDecodingInterpreters(numberOfThreads);
+  }
+  std::vector<std::shared_ptr<vtkPacketFileReader>> readers;
+  for (size_t i = 0; i < std::max(interpreters.size(), size_t(1)); ++i)
+  {
+    auto reader = std::make_shared<vtkPacketFileReader>();
+    if (!this->OpenPacketFile(reader.get()))
+    {
+      return false;
+    }
+    readers.push_back(reader);
+  }
+
+  std::vector<FramePrefetcher::DecodeFunction> decoders;
+  if (interpreters.empty())
+  {
+    // the interpreter cannot be duplicated, a single thread shares it with GetFrame()
+    auto reader = readers[0];
+    decoders.push_back([this, reader](int frameNumber)
+    {
+      boost::lock_guard<boost::mutex> lock(this->InterpreterMutex);
+      return this->DecodeFrame(this->Interpreter, reader.get(), frameNumber);
+    });
+  }
+  for (size_t i = 0; i < interpreters.size(); ++i)
+  {
+    vtkSmartPointer<vtkLidarPacketInterpreter> interpreter = interpreters[i];
+    auto reader = readers[i];
+    decoders.push_back([this, interpreter, reader](int frameNumber)
+    {
+      return this->DecodeFrame(interpreter, reader.get(), frameNumber);
+    });
+  }
+
+  this->Prefetcher->RemoveAllFrameProcessors();
+  for (const auto& processor : this->FrameProcessors)
+  {
+    this->Prefetcher->AddFrameProcessor(processor);
+  }
+  this->Prefetcher->SetWindowSize(this->DecodeAheadWindow);
+  this->Prefetcher->Start(decoders, this->GetNumberOfFrames());
+  this->DecodeAheadMTime = this->GetMTime();
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarReader::StopDecodeAhead()
+{
+  this->Prefetcher->Stop();
+}
+
 //-----------------------------------------------------------------------------
 int vtkLidarReader::RequestInformation(vtkInformation* request,
                                        vtkInformationVector** inputVector,
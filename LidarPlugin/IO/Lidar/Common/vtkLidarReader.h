@@ -18,7 +18,16 @@
 
 #include "vtkLidarProvider.h"
 
+#include <boost/thread/mutex.hpp>
+
+#include <functional>
+#include <memory>
+#include <vector>
+
 class vtkPacketFileReader;
+class vtkPolyDataAlgorithm;
+class FramePrefetcher;
+class LidarFrameProcessor;
 
 //! @todo a decition should be made if the opening/closing of the pcap should be handle by
 //! the class itself of the class user. Currently this is not clear
@@ -47,6 +56,21 @@ public:
    */
   virtual vtkSmartPointer<vtkPolyData> GetFrame(int frameNumber);
 
+#ifndef __VTK_WRAP__
+  /**
+   * @brief GetTimeStepFrames decode several frames at once, the pcap file is opened
+   * only once for the whole batch. This is much cheaper than requesting the frames
+   * one by one through the pipeline. The frames are decoded by NumberOfDecodeThreads
+   * threads when the interpreter can be duplicated.
+   * @param timeStepIndices indices in the TIME_STEPS announced by the reader, which
+   * differ from the frame numbers when the first frame is hidden
+   * @param callback called by the calling thread with each frame as soon as it and
+   * the previous ones are decoded, in the order of timeStepIndices
+   */
+  virtual void GetTimeStepFrames(const std::vector<int>& timeStepIndices,
+    std::function<void(int, vtkSmartPointer<vtkPolyData>)> callback);
+#endif
+
   /**
    * @brief GetFrameForPacketTime returns the requested frame
    * @param packetTime udp packet time requested
@@ -102,9 +126,56 @@ public:
   int GetLidarPort() override { return this->LidarPort; }
   void SetLidarPort(int _arg) override;
 
+  /**
+   * @brief Number of frames decoded ahead of the one requested by the pipeline,
+   * by NumberOfDecodeThreads dedicated threads, so that a playback does not wait
+   * for the decoding.
+   * 0 disables it and the frames are decoded when requested.
+   */
+  vtkGetMacro(DecodeAheadWindow, int)
+  virtual void SetDecodeAheadWindow(int window);
+
+  /**
+   * @brief Number of threads decoding the frames requested by GetTimeStepFrames(),
+   * and the frames decoded ahead, 0 to use one per core, up to 4. Several threads are only used if the interpreter
+   * can be duplicated, see vtkLidarPacketInterpreter::NewDecodingInstance().
+   */
+  vtkGetMacro(NumberOfDecodeThreads, int)
+  virtual void SetNumberOfDecodeThreads(int numberOfThreads);
+
+  /**
+   * @brief IsFrameDecodedForTime check if the frame displayed at a pipeline time
+   * can be produced without waiting for its decoding. Always true when the
+   * frames are not decoded ahead.
+   */
+  bool IsFrameDecodedForTime(double time);
+
+  /**
+   * @brief IsFrameDecodedForTime() exposed to the proxy: the time is set first,
+   * without Modified() as it does not change the output, then the result is
+   * pulled as an information property.
+   */
+  void SetDecodedFrameQueryTime(double time) { this->DecodedFrameQueryTime = time; }
+  int GetIsQueriedFrameDecoded() { return this->IsFrameDecodedForTime(this->DecodedFrameQueryTime); }
+
+  /**
+   * @brief AddFrameProcessor run an algorithm on every frame before it is output.
+   * When the frames are decoded ahead, the algorithms run on the decoding threads,
+   * one frame at a time, and must not be used elsewhere. The algorithms are chained in the order they
+   * are added.
+   */
+  void AddFrameProcessor(vtkPolyDataAlgorithm* algorithm);
+  void RemoveAllFrameProcessors();
+
+  /**
+   * @brief GetDecodeAheadStatistics return the decoding time and how many frames
+   * were already decoded when requested
+   */
+  std::string GetDecodeAheadStatistics();
+
 protected:
-  vtkLidarReader() = default;
-  ~vtkLidarReader() = default;
+  vtkLidarReader();
+  ~vtkLidarReader();
 
   int RequestData(vtkInformation* request,
                   vtkInformationVector** inputVector,
@@ -131,7 +202,60 @@ protected:
   //! To read all packet use -1
   int LidarPort = -1;
 
+  //! @copydoc DecodeAheadWindow
+  int DecodeAheadWindow = 0;
+
+  //! @copydoc NumberOfDecodeThreads
+  int NumberOfDecodeThreads = 0;
+
+  //! Time checked by GetIsQueriedFrameDecoded()
+  double DecodedFrameQueryTime = 0.;
+
 private:
+  /**
+   * @brief DecodeFrame decode a frame, InterpreterMutex must be locked if the
+   * interpreter is the one of the reader
+   * @param interpreter interpreter used only by the calling thread
+   * @param reader packet file reader to read the frame from
+   * @param frameNumber beteween 0 and vtkLidarReader::GetNumberOfFrames()
+   */
+  vtkSmartPointer<vtkPolyData> DecodeFrame(vtkLidarPacketInterpreter* interpreter,
+                                           vtkPacketFileReader* reader, int frameNumber);
+
+  //! Number of threads to use, NumberOfDecodeThreads resolved
+  int GetNumberOfDecodeThreadsToUse() const;
+
+  /**
+   * @brief NewDecodingInterpreters duplicate the interpreter for concurrent decoding
+   * @return count interpreters, or none if the interpreter cannot be duplicated
+   */
+  std::vector<vtkSmartPointer<vtkLidarPacketInterpreter>> NewDecodingInterpreters(int count);
+
+  //! Decode frames with one thread per interpreter, see GetTimeStepFrames()
+  void DecodeFramesConcurrently(const std::vector<int>& timeStepIndices,
+    const std::vector<int>& frameNumbers,
+    const std::vector<vtkSmartPointer<vtkLidarPacketInterpreter>>& interpreters,
+    std::function<void(int, vtkSmartPointer<vtkPolyData>)> callback);
+
+  //! Open the pcap file with a reader, filtering the packets on LidarPort
+  bool OpenPacketFile(vtkPacketFileReader* reader);
+
+  //! Start decoding ahead, each thread with its own packet file reader and interpreter
+  bool StartDecodeAhead();
+  void StopDecodeAhead();
+
+  //! Decode the frames ahead of the pipeline requests
+  std::unique_ptr<FramePrefetcher> Prefetcher;
+
+  //! Applied on every frame, by the prefetcher when decoding ahead
+  std::vector<std::shared_ptr<LidarFrameProcessor>> FrameProcessors;
+
+  //! Time of the settings the frames have been decoded ahead with
+  vtkMTimeType DecodeAheadMTime = 0;
+
+  //! The interpreter is stateful, only one frame can be decoded at a time
+  boost::mutex InterpreterMutex;
+
   /**
    * @brief ReadFrameInformation read the whole pcap and create a frame index.
    * In case the calibration is contained in the pcap file, this will also read it
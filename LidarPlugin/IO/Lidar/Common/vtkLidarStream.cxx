@@ -17,8 +17,6 @@
 
 #include "vtkLidarStream.h"
 
-#include <sstream>
-
 #include "NetworkSource.h"
 #include "PacketConsumer.h"
 #include "PacketFileWriter.h"
@@ -26,6 +24,8 @@
 #include <vtkInformationVector.h>
 #include <vtkInformation.h>
 
+#include <algorithm>
+
 //-----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkLidarStream)
 
@@ -62,6 +62,28 @@ void vtkLidarStream::SetOutputFile(const std::string &filename)
   this->OutputFileName  = filename;
 }
 
+//-----------------------------------------------------------------------------
+void vtkLidarStream::SetRecordingMaxFileSize(double megaBytes)
+{
+  this->Writer->MaxFileSize = static_cast<uint64_t>(std::max(0., megaBytes) * 1024. * 1024.);
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarStream::SetRecordingMaxFileDuration(double seconds)
+{
+  this->Writer->MaxFileDuration = std::max(0., seconds);
+}
+
+//-----------------------------------------------------------------------------
+std::string vtkLidarStream::GetRecordingStatistics()
+{
+  if (!this->Writer->IsOpen())
+  {
+    return "Not recording\n";
+  }
+  return this->Writer->GetStatisticsReport();
+}
+
 //-----------------------------------------------------------------------------
 std::string vtkLidarStream::GetForwardedIpAddress()
 {
@@ -167,8 +189,7 @@ void vtkLidarStream::SetIsCrashAnalysing(bool value)
 //-----------------------------------------------------------------------------
 bool vtkLidarStream::GetNeedsUpdate()
 {
-  boost::lock_guard<boost::mutex> lock(this->Consumer->ConsumerMutex);
-  if (this->Consumer->CheckForNewData())
+  if (this->Consumer->HasNewFrame())
   {
     this->Modified();
     return true;
@@ -176,6 +197,58 @@ bool vtkLidarStream::GetNeedsUpdate()
   return false;
 }
 
+//-----------------------------------------------------------------------------
+bool vtkLidarStream::WaitForNewFrame(double timeout)
+{
+  return this->Consumer->WaitForNewFrame(timeout);
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarStream::SetNewFrameCallback(std::function<void()> callback)
+{
+  this->Consumer->SetNewFrameCallback(callback);
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkLidarStream::GetNumberOfReceivedFrames()
+{
+  return static_cast<vtkIdType>(this->Consumer->GetNumberOfFrames());
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkLidarStream::GetNumberOfDroppedFrames()
+{
+  return static_cast<vtkIdType>(this->Consumer->GetNumberOfDroppedFrames());
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkLidarStream::GetNumberOfDroppedPackets()
+{
+  return static_cast<vtkIdType>(this->Consumer->GetNumberOfDroppedPackets());
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarStream::AddFrameProcessor(vtkPolyDataAlgorithm* algorithm)
+{
+  if (!algorithm)
+  {
+    return;
+  }
+  this->Consumer->AddFrameProcessor(std::make_shared<AlgorithmFrameProcessor>(algorithm));
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarStream::RemoveAllFrameProcessors()
+{
+  this->Consumer->RemoveAllFrameProcessors();
+}
+
+//-----------------------------------------------------------------------------
+std::string vtkLidarStream::GetPipelineStatistics()
+{
+  return this->Consumer->GetStatisticsReport();
+}
+
 //----------------------------------------------------------------------------
 void vtkLidarStream::Start()
 {
@@ -207,6 +280,7 @@ void vtkLidarStream::Stop()
   this->Network->Stop();
   this->Consumer->Stop();
   this->Writer->Stop();
+  this->Consumer->ClearAllFrames();
 }
 
 //----------------------------------------------------------------------------
@@ -216,28 +290,17 @@ int vtkLidarStream::RequestData(vtkInformation* vtkNotUsed(request),
 {
   vtkPolyData* output = vtkPolyData::GetData(outputVector);
 
-  int numberOfFrameAvailable = 0;
+  // The frames which have been skipped are counted by the consumer,
+  // see GetNumberOfDroppedFrames()
+  vtkSmartPointer<vtkPolyData> polyData = this->Consumer->TakeLastAvailableFrame();
+  if (polyData)
   {
-    boost::lock_guard<boost::mutex> lock(this->Consumer->ConsumerMutex);
-    numberOfFrameAvailable = this->Consumer->CheckForNewData();
-    if (numberOfFrameAvailable != 0)
-    {
-      vtkSmartPointer<vtkPolyData> polyData = this->Consumer->GetLastAvailableFrame();
-      output->ShallowCopy(polyData);
-      this->Consumer->ClearAllFrames();
-      this->LastFrameProcessed += numberOfFrameAvailable;
-    }
+    this->LastFrame = polyData;
+    this->LastFrameProcessed++;
   }
-
-  if (this->DetectFrameDropping)
+  if (this->LastFrame)
   {
-    if (numberOfFrameAvailable > 1)
-    {
-      std::stringstream text;
-      text << "WARNING : At frame " << std::right << std::setw(6) << this->LastFrameProcessed
-           << " Drop " << std::right << std::setw(2) << numberOfFrameAvailable-1 << " frame(s)\n";
-      vtkWarningMacro( << text.str() )
-    }
+    output->ShallowCopy(this->LastFrame);
   }
 
   vtkTable* calibration = vtkTable::GetData(outputVector,1);
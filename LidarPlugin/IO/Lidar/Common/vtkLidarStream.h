@@ -16,6 +16,7 @@
 #ifndef VTKLIDARSTREAM_H
 #define VTKLIDARSTREAM_H
 
+#include <functional>
 #include <memory>
 #include "vtkLidarProvider.h"
 
@@ -40,6 +41,24 @@ public:
   std::string GetOutputFile();
   void SetOutputFile(const std::string& filename);
 
+  /**
+   * @brief SetRecordingMaxFileSize split the recording in several files of at most
+   * this size in MB, 0 to disable. Must be set before Start().
+   */
+  void SetRecordingMaxFileSize(double megaBytes);
+
+  /**
+   * @brief SetRecordingMaxFileDuration split the recording in several files of at most
+   * this duration in seconds, 0 to disable. Must be set before Start().
+   */
+  void SetRecordingMaxFileDuration(double seconds);
+
+  /**
+   * @brief GetRecordingStatistics return the write throughput, the number of buffers
+   * waiting to be written and the number of packets that could not be recorded
+   */
+  std::string GetRecordingStatistics();
+
   /**
    * @copydoc NetworkSource::LidarPort
    */
@@ -85,11 +104,60 @@ public:
   void SetIsCrashAnalysing(bool value);
 
   /**
-   * @brief GetNeedsUpdate
+   * @brief GetNeedsUpdate used by the LiveSource behavior to know if the pipeline
+   * should be updated. This does not lock anything, it only checks the frame handoff slot.
    * @return true if a new frame is ready
    */
   bool GetNeedsUpdate();
 
+  /**
+   * @brief WaitForNewFrame block the calling thread until a new frame is ready,
+   * this avoid polling GetNeedsUpdate() when the stream is used outside of the GUI
+   * @param timeout maximum time to wait in seconds
+   * @return true if a new frame is ready
+   */
+  bool WaitForNewFrame(double timeout);
+
+#ifndef __VTK_WRAP__
+  /**
+   * @brief SetNewFrameCallback set a function called from the decoding thread each
+   * time a new frame is ready. Must be set while the stream is stopped.
+   * @copydetails PacketConsumer::SetNewFrameCallback
+   */
+  void SetNewFrameCallback(std::function<void()> callback);
+#endif
+
+  /**
+   * @brief GetNumberOfReceivedFrames number of frames decoded since the last Start()
+   */
+  vtkIdType GetNumberOfReceivedFrames();
+
+  /**
+   * @brief GetNumberOfDroppedFrames number of frames decoded since the last Start()
+   * that have been replaced by a newer one before the pipeline could display them
+   */
+  vtkIdType GetNumberOfDroppedFrames();
+
+  /**
+   * @brief GetNumberOfDroppedPackets number of packets received since the last Start()
+   * that have been dropped because the decoding was late
+   */
+  vtkIdType GetNumberOfDroppedPackets();
+
+  /**
+   * @brief AddFrameProcessor run an algorithm on every frame on a dedicated
+   * thread, before the frame is handed over to the pipeline. The algorithms are
+   * chained in the order they are added. The stream must be stopped.
+   */
+  void AddFrameProcessor(vtkPolyDataAlgorithm* algorithm);
+  void RemoveAllFrameProcessors();
+
+  /**
+   * @brief GetPipelineStatistics return the latency of each stage of the live
+   * processing (packet queue, decoding, processors) and the queues depth
+   */
+  std::string GetPipelineStatistics();
+
 protected:
   vtkLidarStream();
   ~vtkLidarStream();
@@ -103,6 +171,10 @@ protected:
   std::shared_ptr<PacketConsumer> Consumer;
   std::shared_ptr<PacketFileWriter> Writer;
   std::unique_ptr<NetworkSource> Network;
+
+  //! Last frame produced, kept to have a valid output if the pipeline
+  //! is updated while no new frame is available
+  vtkSmartPointer<vtkPolyData> LastFrame;
 private:
   vtkLidarStream(const vtkLidarStream&) = delete;
   void operator=(const vtkLidarStream&) = delete;
@@ -0,0 +1,450 @@
+//=========================================================================
+//
+// Copyright 2019 Kitware, Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//=========================================================================
+
+#include "vtkMultiLidarStream.h"
+
+#include "NetworkSource.h"
+#include "PacketConsumer.h"
+#include "vtkLidarPacketInterpreter.h"
+
+#include <vtkAppendPolyData.h>
+#include <vtkDoubleArray.h>
+#include <vtkFieldData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkMultiBlockDataSet.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkTransform.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <sstream>
+
+namespace
+{
+//-----------------------------------------------------------------------------
+// Acquisition time in seconds of the last point of a frame, from the
+// "adjustedtime" array (in microseconds) filled by the interpreters
+bool GetSensorTime(vtkPolyData* frame, double& time)
+{
+  vtkDataArray* times = frame->GetPointData()->GetArray("adjustedtime");
+  if (!times || times->GetNumberOfTuples() == 0)
+  {
+    return false;
+  }
+  time = times->GetRange(0)[1] * 1e-6;
+  return true;
+}
+}
+
+//-----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkMultiLidarStream)
+
+//-----------------------------------------------------------------------------
+vtkMultiLidarStream::vtkMultiLidarStream()
+{
+  this->SetNumberOfInputPorts(0);
+  this->SetNumberOfOutputPorts(2);
+}
+
+//-----------------------------------------------------------------------------
+vtkMultiLidarStream::~vtkMultiLidarStream()
+{
+  this->Stop();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "NumberOfSensors: " << this->Sensors.size() << std::endl;
+  os << indent << "MergeFrames: " << this->MergeFrames << std::endl;
+  os << indent << "MaxTimeDifference: " << this->MaxTimeDifference << std::endl;
+  os << indent << "IsForwarding: " << this->IsForwarding << std::endl;
+  os << indent << "ForwardedIpAddress: " << this->ForwardedIpAddress << std::endl;
+  os << indent << "ListenGPS: " << this->ListenGPS << std::endl;
+  os << indent << "GPSPort: " << this->GPSPort << std::endl;
+  os << indent << "ForwardedGPSPort: " << this->ForwardedGPSPort << std::endl;
+}
+
+//-----------------------------------------------------------------------------
+int vtkMultiLidarStream::FillOutputPortInformation(int port, vtkInformation* info)
+{
+  if (port == 0)
+  {
+    info->Set(vtkDataObject::DATA_TYPE_NAME(), "vtkMultiBlockDataSet");
+    return 1;
+  }
+  if (port == 1)
+  {
+    info->Set(vtkDataObject::DATA_TYPE_NAME(), "vtkPolyData");
+    return 1;
+  }
+  return 0;
+}
+
+//-----------------------------------------------------------------------------
+int vtkMultiLidarStream::AddSensor(int port, vtkLidarPacketInterpreter* interpreter,
+                                   const std::string& calibrationFileName,
+                                   vtkTransform* sensorToVehicle)
+{
+  if (this->Network)
+  {
+    vtkErrorMacro("The stream must be stopped to add a sensor");
+    return -1;
+  }
+  if (!interpreter)
+  {
+    vtkErrorMacro("No interpreter given for the sensor on port " << port);
+    return -1;
+  }
+  for (const Sensor& sensor : this->Sensors)
+  {
+    if (sensor.Port == port)
+    {
+      vtkErrorMacro("A sensor is already listening on port " << port);
+      return -1;
+    }
+    if (sensor.Interpreter == interpreter)
+    {
+      vtkErrorMacro("Each sensor must have its own interpreter");
+      return -1;
+    }
+  }
+
+  if (!calibrationFileName.empty())
+  {
+    if (!boost::filesystem::exists(calibrationFileName) ||
+        boost::filesystem::is_directory(calibrationFileName))
+    {
+      vtkErrorMacro("Invalid sensor configuration file " << calibrationFileName);
+      return -1;
+    }
+    interpreter->SetCalibrationFileName(calibrationFileName);
+    interpreter->LoadCalibration(calibrationFileName);
+  }
+
+  if (sensorToVehicle)
+  {
+    interpreter->SetSensorTransform(sensorToVehicle);
+    interpreter->SetApplyTransform(true);
+  }
+
+  Sensor sensor;
+  sensor.Port = port;
+  sensor.Interpreter = interpreter;
+  sensor.Consumer = std::make_shared<PacketConsumer>();
+  sensor.Consumer->SetInterpreter(interpreter);
+  this->Sensors.push_back(sensor);
+  this->Modified();
+  return static_cast<int>(this->Sensors.size()) - 1;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::RemoveAllSensors()
+{
+  this->Stop();
+  this->Sensors.clear();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::AddInterpreter(vtkLidarPacketInterpreter* interpreter)
+{
+  this->Interpreters.push_back(interpreter);
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::RemoveAllInterpreters()
+{
+  this->Interpreters.clear();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::AddLidarPort(int port)
+{
+  this->LidarPorts.push_back(port);
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::RemoveAllLidarPorts()
+{
+  this->LidarPorts.clear();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::AddCalibrationFileName(const char* filename)
+{
+  this->CalibrationFileNames.push_back(filename ? filename : "");
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::RemoveAllCalibrationFileNames()
+{
+  this->CalibrationFileNames.clear();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::AddSensorToVehiclePose(double x, double y, double z,
+                                                 double rx, double ry, double rz)
+{
+  this->SensorToVehiclePoses.push_back({ { x, y, z, rx, ry, rz } });
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::RemoveAllSensorToVehiclePoses()
+{
+  this->SensorToVehiclePoses.clear();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::AddForwardedLidarPort(int port)
+{
+  this->ForwardedLidarPorts.push_back(port);
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::RemoveAllForwardedLidarPorts()
+{
+  this->ForwardedLidarPorts.clear();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+bool vtkMultiLidarStream::CreateSensorsFromProperties()
+{
+  if (this->Interpreters.size() != this->LidarPorts.size())
+  {
+    vtkErrorMacro("Each interpreter needs a lidar port, got " << this->Interpreters.size()
+                  << " interpreters and " << this->LidarPorts.size() << " ports");
+    return false;
+  }
+  this->RemoveAllSensors();
+  for (size_t i = 0; i < this->Interpreters.size(); ++i)
+  {
+    std::string calibrationFileName =
+      i < this->CalibrationFileNames.size() ? this->CalibrationFileNames[i] : "";
+    vtkSmartPointer<vtkTransform> sensorToVehicle;
+    if (i < this->SensorToVehiclePoses.size())
+    {
+      const std::array<double, 6>& pose = this->SensorToVehiclePoses[i];
+      sensorToVehicle = vtkSmartPointer<vtkTransform>::New();
+      sensorToVehicle->Translate(pose[0], pose[1], pose[2]);
+      sensorToVehicle->RotateZ(pose[5]);
+      sensorToVehicle->RotateX(pose[3]);
+      sensorToVehicle->RotateY(pose[4]);
+    }
+    if (this->AddSensor(this->LidarPorts[i], this->Interpreters[i], calibrationFileName,
+                        sensorToVehicle) < 0)
+    {
+      this->RemoveAllSensors();
+      return false;
+    }
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::Start()
+{
+  if (!this->Interpreters.empty() && !this->CreateSensorsFromProperties())
+  {
+    return;
+  }
+  if (this->Sensors.empty())
+  {
+    vtkErrorMacro("No sensor has been added");
+    return;
+  }
+  if (this->IsForwarding && this->ForwardedLidarPorts.size() != this->Sensors.size())
+  {
+    vtkErrorMacro("Each sensor needs a forwarded port, got " << this->ForwardedLidarPorts.size()
+                  << " forwarded ports and " << this->Sensors.size() << " sensors");
+    return;
+  }
+  this->Stop();
+
+  // The first sensor is received by the main port of the network source,
+  // the others are dispatched by port on the same network thread
+  this->Network = std::make_unique<NetworkSource>(this->Sensors[0].Consumer,
+    this->Sensors[0].Port, this->IsForwarding ? this->ForwardedLidarPorts[0] : -1,
+    this->ForwardedIpAddress, this->IsForwarding, false);
+  this->Network->ListenGPS = this->ListenGPS;
+  this->Network->GPSPort = this->GPSPort;
+  this->Network->ForwardedGPSPort = this->ForwardedGPSPort;
+  for (size_t i = 1; i < this->Sensors.size(); ++i)
+  {
+    this->Network->AddLidarPort(this->Sensors[i].Port, this->Sensors[i].Consumer,
+                                this->IsForwarding ? this->ForwardedLidarPorts[i] : -1);
+  }
+
+  for (Sensor& sensor : this->Sensors)
+  {
+    sensor.Consumer->Start();
+  }
+  this->Network->Start();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMultiLidarStream::Stop()
+{
+  if (this->Network)
+  {
+    this->Network->Stop();
+    this->Network.reset();
+  }
+  for (Sensor& sensor : this->Sensors)
+  {
+    sensor.Consumer->Stop();
+    sensor.Consumer->ClearAllFrames();
+    sensor.LastFrame = nullptr;
+    sensor.HasLastFrameTime = false;
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool vtkMultiLidarStream::GetNeedsUpdate()
+{
+  for (const Sensor& sensor : this->Sensors)
+  {
+    if (sensor.Consumer->HasNewFrame())
+    {
+      this->Modified();
+      return true;
+    }
+  }
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkMultiLidarStream::GetNumberOfDroppedFrames(int sensor)
+{
+  if (sensor < 0 || sensor >= this->GetNumberOfSensors())
+  {
+    vtkErrorMacro("Invalid sensor index " << sensor);
+    return 0;
+  }
+  return static_cast<vtkIdType>(this->Sensors[sensor].Consumer->GetNumberOfDroppedFrames());
+}
+
+//-----------------------------------------------------------------------------
+vtkIdType vtkMultiLidarStream::GetNumberOfDroppedPackets(int sensor)
+{
+  if (sensor < 0 || sensor >= this->GetNumberOfSensors())
+  {
+    vtkErrorMacro("Invalid sensor index " << sensor);
+    return 0;
+  }
+  return static_cast<vtkIdType>(this->Sensors[sensor].Consumer->GetNumberOfDroppedPackets());
+}
+
+//-----------------------------------------------------------------------------
+std::string vtkMultiLidarStream::GetPipelineStatistics()
+{
+  std::ostringstream report;
+  for (const Sensor& sensor : this->Sensors)
+  {
+    report << "Sensor on port " << sensor.Port << ":" << std::endl
+           << sensor.Consumer->GetStatisticsReport();
+  }
+  return report.str();
+}
+
+//-----------------------------------------------------------------------------
+int vtkMultiLidarStream::RequestData(vtkInformation* vtkNotUsed(request),
+                                     vtkInformationVector** vtkNotUsed(inputVector),
+                                     vtkInformationVector* outputVector)
+{
+  vtkMultiBlockDataSet* blocks = vtkMultiBlockDataSet::GetData(outputVector, 0);
+  vtkPolyData* merged = vtkPolyData::GetData(outputVector, 1);
+
+  blocks->SetNumberOfBlocks(static_cast<unsigned int>(this->Sensors.size()));
+  bool hasTime = false;
+  double newestTime = 0.;
+  for (size_t i = 0; i < this->Sensors.size(); ++i)
+  {
+    Sensor& sensor = this->Sensors[i];
+    vtkSmartPointer<vtkPolyData> frame = sensor.Consumer->TakeLastAvailableFrame();
+    if (frame)
+    {
+      sensor.LastFrame = frame;
+      sensor.HasLastFrameTime = GetSensorTime(frame, sensor.LastFrameTime);
+      if (!sensor.HasLastFrameTime && frame->GetNumberOfPoints() > 0 && !sensor.MissingTimeReported)
+      {
+        vtkWarningMacro("The frames of the sensor on port " << sensor.Port
+                        << " have no \"adjustedtime\" array, they are not merged");
+        sensor.MissingTimeReported = true;
+      }
+    }
+    if (sensor.LastFrame && sensor.HasLastFrameTime)
+    {
+      newestTime = hasTime ? std::max(newestTime, sensor.LastFrameTime) : sensor.LastFrameTime;
+      hasTime = true;
+    }
+    blocks->SetBlock(static_cast<unsigned int>(i), sensor.LastFrame);
+  }
+
+  if (!this->MergeFrames || !hasTime)
+  {
+    return 1;
+  }
+
+  vtkNew<vtkAppendPolyData> append;
+  for (size_t i = 0; i < this->Sensors.size(); ++i)
+  {
+    const Sensor& sensor = this->Sensors[i];
+    if (!sensor.LastFrame || !sensor.HasLastFrameTime ||
+        newestTime - sensor.LastFrameTime > this->MaxTimeDifference)
+    {
+      continue;
+    }
+
+    // Tag the points with their sensor, on a shallow copy to leave the block untouched
+    vtkNew<vtkPolyData> tagged;
+    tagged->ShallowCopy(sensor.LastFrame);
+    vtkNew<vtkUnsignedCharArray> sensorId;
+    sensorId->SetName("sensor_id");
+    sensorId->SetNumberOfTuples(tagged->GetNumberOfPoints());
+    sensorId->FillComponent(0, static_cast<double>(i));
+    tagged->GetPointData()->AddArray(sensorId);
+    append->AddInputData(tagged);
+  }
+  append->Update();
+  merged->ShallowCopy(append->GetOutput());
+
+  // Reference sensor time of the merged frame
+  vtkNew<vtkDoubleArray> time;
+  time->SetName("frame_time");
+  time->InsertNextValue(newestTime);
+  merged->GetFieldData()->AddArray(time);
+
+  return 1;
+}
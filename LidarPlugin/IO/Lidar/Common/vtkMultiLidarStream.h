@@ -0,0 +1,221 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VTKMULTILIDARSTREAM_H
+#define VTKMULTILIDARSTREAM_H
+
+#include <vtkMultiBlockDataSetAlgorithm.h>
+#include <vtkSmartPointer.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+class NetworkSource;
+class PacketConsumer;
+class vtkLidarPacketInterpreter;
+class vtkPolyData;
+class vtkTransform;
+
+/**
+ * @brief vtkMultiLidarStream receive and decode several lidars at once.
+ *
+ * All the sensors share a single network thread, which dispatches the packets by
+ * destination port. Each sensor has its own interpreter, and its own decoding
+ * thread, so that a slow sensor does not delay the others.
+ *
+ * Output 0 is a vtkMultiBlockDataSet with the last frame of each sensor, one block
+ * per sensor in the order they have been added.
+ * Output 1 is the merge of the latest frames of all sensors, expressed in the vehicle
+ * frame (each sensor's SensorToVehicle transform is applied by its interpreter).
+ * The frames are aligned on the sensor time, read from their "adjustedtime" point
+ * array: only the frames acquired within MaxTimeDifference of the most recent one are
+ * merged, so that a sensor which stopped sending does not pollute the merged frame.
+ * The sensors must therefore share a clock (GPS or PTP synchronization), and the
+ * frames without time are not merged.
+ * A "sensor_id" point array indicates from which sensor each point comes.
+ *
+ * The sensors are either added with AddSensor(), or described by the indexed
+ * interpreters, ports, calibration files and poses set through the server manager
+ * proxy, in which case they are (re)created by Start().
+ *
+ * Like vtkLidarStream, the stream can listen to a GPS port, whose packets are given
+ * to the interpreter of the first sensor, and forward the packets it receives.
+ */
+class VTK_EXPORT vtkMultiLidarStream : public vtkMultiBlockDataSetAlgorithm
+{
+public:
+  static vtkMultiLidarStream* New();
+  vtkTypeMacro(vtkMultiLidarStream, vtkMultiBlockDataSetAlgorithm)
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /**
+   * @brief AddSensor add a sensor to the stream. The stream must be stopped.
+   * @param port The port on which the sensor sends its lidar packets
+   * @param interpreter The interpreter decoding the packets of this sensor only
+   * @param calibrationFileName The calibration of the sensor, may be empty if the
+   * interpreter does not need one
+   * @param sensorToVehicle Pose of the sensor in the vehicle frame, may be null if
+   * the frames must stay in the sensor frame
+   * @return the index of the sensor, -1 in case of error
+   */
+  int AddSensor(int port, vtkLidarPacketInterpreter* interpreter,
+                const std::string& calibrationFileName, vtkTransform* sensorToVehicle);
+  void RemoveAllSensors();
+
+  int GetNumberOfSensors() const { return static_cast<int>(this->Sensors.size()); }
+
+  //@{
+  /**
+   * @brief Sensors description used by the server manager proxy, the i-th sensor
+   * uses the i-th interpreter, port and calibration file. An empty calibration file
+   * name means the interpreter does not need one.
+   */
+  void AddInterpreter(vtkLidarPacketInterpreter* interpreter);
+  void RemoveAllInterpreters();
+  void AddLidarPort(int port);
+  void RemoveAllLidarPorts();
+  void AddCalibrationFileName(const char* filename);
+  void RemoveAllCalibrationFileNames();
+  //@}
+
+  //@{
+  /**
+   * @brief Pose of the i-th sensor in the vehicle frame: a translation in meters,
+   * then rotations in degrees around z, x and y applied in this order, as the
+   * ParaView transforms do. A sensor without pose keeps the transform of its
+   * interpreter.
+   */
+  void AddSensorToVehiclePose(double x, double y, double z, double rx, double ry, double rz);
+  void RemoveAllSensorToVehiclePoses();
+  //@}
+
+  //@{
+  /**
+   * @brief Port to which the packets of the i-th sensor are forwarded, one per
+   * sensor is required when IsForwarding is set.
+   */
+  void AddForwardedLidarPort(int port);
+  void RemoveAllForwardedLidarPorts();
+  //@}
+
+  //! @copydoc NetworkSource::IsForwarding
+  vtkGetMacro(IsForwarding, bool)
+  vtkSetMacro(IsForwarding, bool)
+
+  //! @copydoc NetworkSource::ForwardedIpAddress
+  vtkGetMacro(ForwardedIpAddress, std::string)
+  vtkSetMacro(ForwardedIpAddress, std::string)
+
+  //! Listen to the GPS port, its packets are given to the first sensor
+  vtkGetMacro(ListenGPS, bool)
+  vtkSetMacro(ListenGPS, bool)
+
+  //! @copydoc NetworkSource::GPSPort
+  vtkGetMacro(GPSPort, int)
+  vtkSetMacro(GPSPort, int)
+
+  //! @copydoc NetworkSource::ForwardedGPSPort
+  vtkGetMacro(ForwardedGPSPort, int)
+  vtkSetMacro(ForwardedGPSPort, int)
+
+  void Start();
+  void Stop();
+
+  /**
+   * @brief GetNeedsUpdate used by the LiveSource behavior to know if the pipeline
+   * should be updated.
+   * @return true if at least one sensor has a new frame
+   */
+  bool GetNeedsUpdate();
+
+  //! Merge the sensors' frames on the second output
+  vtkGetMacro(MergeFrames, bool)
+  vtkSetMacro(MergeFrames, bool)
+  vtkBooleanMacro(MergeFrames, bool)
+
+  //! Maximum sensor time difference in seconds between the merged frames
+  vtkGetMacro(MaxTimeDifference, double)
+  vtkSetClampMacro(MaxTimeDifference, double, 0., VTK_DOUBLE_MAX)
+
+  /**
+   * @brief GetNumberOfDroppedFrames number of frames of a sensor that have been
+   * replaced by a newer one before the pipeline could use them
+   */
+  vtkIdType GetNumberOfDroppedFrames(int sensor);
+
+  /**
+   * @brief GetNumberOfDroppedPackets number of packets of a sensor dropped because
+   * its decoding was late
+   */
+  vtkIdType GetNumberOfDroppedPackets(int sensor);
+
+  /**
+   * @brief GetPipelineStatistics return the latency of each stage, per sensor
+   */
+  std::string GetPipelineStatistics();
+
+protected:
+  vtkMultiLidarStream();
+  ~vtkMultiLidarStream();
+
+  int FillOutputPortInformation(int port, vtkInformation* info) override;
+
+  int RequestData(vtkInformation* request,
+                  vtkInformationVector** inputVector,
+                  vtkInformationVector* outputVector) override;
+
+  struct Sensor
+  {
+    int Port;
+    vtkSmartPointer<vtkLidarPacketInterpreter> Interpreter;
+    std::shared_ptr<PacketConsumer> Consumer;
+    //! Last frame produced and its sensor time, kept to have a valid output
+    //! if the pipeline is updated while no new frame is available
+    vtkSmartPointer<vtkPolyData> LastFrame;
+    double LastFrameTime = 0.;
+    bool HasLastFrameTime = false;
+    //! The frames of this sensor have no time, reported once
+    bool MissingTimeReported = false;
+  };
+
+  //! Create the sensors described by the proxy properties
+  bool CreateSensorsFromProperties();
+
+  std::vector<Sensor> Sensors;
+
+  //! Sensors description set through the proxy
+  std::vector<vtkSmartPointer<vtkLidarPacketInterpreter>> Interpreters;
+  std::vector<int> LidarPorts;
+  std::vector<std::string> CalibrationFileNames;
+  std::vector<std::array<double, 6>> SensorToVehiclePoses;
+  std::vector<int> ForwardedLidarPorts;
+  std::unique_ptr<NetworkSource> Network;
+
+  bool IsForwarding = false;
+  std::string ForwardedIpAddress = "127.0.0.1";
+  bool ListenGPS = false;
+  int GPSPort = 8308;
+  int ForwardedGPSPort = 8309;
+
+  bool MergeFrames = true;
+  double MaxTimeDifference = 0.05;
+
+private:
+  vtkMultiLidarStream(const vtkMultiLidarStream&) = delete;
+  void operator=(const vtkMultiLidarStream&) = delete;
+};
+
+#endif // VTKMULTILIDARSTREAM_H
@@ -479,6 +479,31 @@ vtkVelodynePacketInterpreter::~vtkVelodynePacketInterpreter()
   delete this->CurrentFrameState;
 }
 
+//-----------------------------------------------------------------------------
+vtkSmartPointer<vtkLidarPacketInterpreter> vtkVelodynePacketInterpreter::NewDecodingInstance()
+{
+  // the corrections received in the stream are only known by this interpreter
+  if (this->IsCorrectionFromLiveStream || !this->IsCalibrated)
+  {
+    return nullptr;
+  }
+
+  vtkSmartPointer<vtkVelodynePacketInterpreter> instance =
+    vtkSmartPointer<vtkVelodynePacketInterpreter>::New();
+  instance->LoadCalibration(this->CalibrationFileName);
+  if (!instance->IsCalibrated)
+  {
+    return nullptr;
+  }
+  this->CopyParametersTo(instance);
+  instance->WantIntensityCorrection = this->WantIntensityCorrection;
+  instance->FiringsSkip = this->FiringsSkip;
+  instance->UseIntraFiringAdjustment = this->UseIntraFiringAdjustment;
+  instance->DualReturnFilter = this->DualReturnFilter;
+  instance->OutputPacketProcessingDebugInfo = this->OutputPacketProcessingDebugInfo;
+  return instance;
+}
+
 //-----------------------------------------------------------------------------
 void vtkVelodynePacketInterpreter::LoadCalibration(const std::string& filename)
 {
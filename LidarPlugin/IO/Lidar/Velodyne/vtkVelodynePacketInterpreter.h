@@ -50,6 +50,8 @@ public:
 
   std::string GetSensorInformation() override;
 
+  vtkSmartPointer<vtkLidarPacketInterpreter> NewDecodingInstance() override;
+
   void GetXMLColorTable(double XMLColorTable[]);
 
   void GetLaserCorrections(double verticalCorrection[HDL_MAX_NUM_LASERS],
@@ -0,0 +1,486 @@
+#include "vtkLidarFramesExporter.h"
+
+#include "vtkLidarReader.h"
+#include "SynchronizedQueue.h"
+
+#include <vtkByteSwap.h>
+#include <vtkCommand.h>
+#include <vtkDataArray.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <boost/filesystem.hpp>
+#include <boost/thread.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+//-----------------------------------------------------------------------------
+// A column is one component of an array, this is what is written in a CSV column
+// or in a PLY property.
+struct Column
+{
+  std::string Name;
+  vtkDataArray* Array;
+  int Component;
+};
+
+//-----------------------------------------------------------------------------
+void AppendColumns(vtkDataArray* array, const std::string& name, std::vector<Column>& columns)
+{
+  int nbComponents = array->GetNumberOfComponents();
+  for (int c = 0; c < nbComponents; ++c)
+  {
+    std::string columnName = nbComponents == 1 ? name : name + ":" + std::to_string(c);
+    columns.push_back({columnName, array, c});
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Points coordinates first, then the leading arrays, then all other arrays
+std::vector<Column> GetColumns(vtkPolyData* frame, const std::vector<std::string>& leadingArrays)
+{
+  std::vector<Column> columns;
+  if (frame->GetPoints())
+  {
+    AppendColumns(frame->GetPoints()->GetData(), "Points", columns);
+  }
+
+  vtkPointData* pointData = frame->GetPointData();
+  std::vector<bool> alreadyAdded(pointData->GetNumberOfArrays(), false);
+  for (const std::string& name : leadingArrays)
+  {
+    int index = -1;
+    vtkDataArray* array = pointData->GetArray(name.c_str(), index);
+    if (array && !alreadyAdded[index])
+    {
+      AppendColumns(array, name, columns);
+      alreadyAdded[index] = true;
+    }
+  }
+  for (int i = 0; i < pointData->GetNumberOfArrays(); ++i)
+  {
+    vtkDataArray* array = pointData->GetArray(i);
+    if (array && !alreadyAdded[i] && array->GetName())
+    {
+      AppendColumns(array, array->GetName(), columns);
+    }
+  }
+  return columns;
+}
+
+//-----------------------------------------------------------------------------
+// Append a value to a text buffer, snprintf is way faster than a std::ostream
+template<typename T>
+void AppendValue(std::string& buffer, T value, int precision)
+{
+  char tmp[32];
+  int n = std::snprintf(tmp, sizeof(tmp), "%.*g", precision, static_cast<double>(value));
+  buffer.append(tmp, n);
+}
+void AppendValue(std::string& buffer, long long value, int)
+{
+  char tmp[32];
+  int n = std::snprintf(tmp, sizeof(tmp), "%lld", value);
+  buffer.append(tmp, n);
+}
+void AppendValue(std::string& buffer, unsigned long long value, int)
+{
+  char tmp[32];
+  int n = std::snprintf(tmp, sizeof(tmp), "%llu", value);
+  buffer.append(tmp, n);
+}
+
+//-----------------------------------------------------------------------------
+template<typename T>
+void AppendColumnValue(std::string& buffer, const T* data, vtkIdType index, int precision)
+{
+  // Integer types are written as integers, whatever their size
+  if (std::is_integral<T>::value && std::is_signed<T>::value)
+  {
+    AppendValue(buffer, static_cast<long long>(data[index]), precision);
+  }
+  else if (std::is_integral<T>::value)
+  {
+    AppendValue(buffer, static_cast<unsigned long long>(data[index]), precision);
+  }
+  else
+  {
+    AppendValue(buffer, data[index], precision);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// The binary formats are little endian, convert values from the host byte order in place
+void ToLittleEndian(void* data, size_t count, size_t size)
+{
+#ifdef VTK_WORDS_BIGENDIAN
+  if (size > 1)
+  {
+    vtkByteSwap::SwapVoidRange(data, count, size);
+  }
+#else
+  (void)data;
+  (void)count;
+  (void)size;
+#endif
+}
+
+//-----------------------------------------------------------------------------
+template<typename T>
+void AppendLittleEndian(std::string& buffer, T value)
+{
+  ToLittleEndian(&value, 1, sizeof(T));
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+//-----------------------------------------------------------------------------
+bool WriteBuffer(const std::string& filename, const std::string& header, const std::vector<char>& data)
+{
+  FILE* file = std::fopen(filename.c_str(), "wb");
+  if (!file)
+  {
+    return false;
+  }
+  bool ok = std::fwrite(header.data(), 1, header.size(), file) == header.size();
+  ok = ok && std::fwrite(data.data(), 1, data.size(), file) == data.size();
+  return (std::fclose(file) == 0) && ok;
+}
+
+//-----------------------------------------------------------------------------
+const char* GetPLYTypeName(int vtkType)
+{
+  switch (vtkType)
+  {
+    case VTK_CHAR:
+    case VTK_SIGNED_CHAR:    return "char";
+    case VTK_UNSIGNED_CHAR:  return "uchar";
+    case VTK_SHORT:          return "short";
+    case VTK_UNSIGNED_SHORT: return "ushort";
+    case VTK_INT:            return "int";
+    case VTK_UNSIGNED_INT:   return "uint";
+    case VTK_FLOAT:          return "float";
+    default:                 return "double"; // other types are converted to double
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool IsNativePLYType(int vtkType)
+{
+  return std::string(GetPLYTypeName(vtkType)) != "double" || vtkType == VTK_DOUBLE;
+}
+}
+
+//-----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLidarFramesExporter)
+
+//-----------------------------------------------------------------------------
+vtkCxxSetObjectMacro(vtkLidarFramesExporter, Reader, vtkLidarReader)
+
+//-----------------------------------------------------------------------------
+vtkLidarFramesExporter::vtkLidarFramesExporter() = default;
+
+//-----------------------------------------------------------------------------
+vtkLidarFramesExporter::~vtkLidarFramesExporter()
+{
+  this->SetReader(nullptr);
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarFramesExporter::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "OutputDirectory: " << this->OutputDirectory << endl;
+  os << indent << "FilePrefix: " << this->FilePrefix << endl;
+  os << indent << "FirstFrame: " << this->FirstFrame << endl;
+  os << indent << "LastFrame: " << this->LastFrame << endl;
+  os << indent << "FrameStride: " << this->FrameStride << endl;
+  os << indent << "Format: " << this->Format << endl;
+  os << indent << "Precision: " << this->Precision << endl;
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << endl;
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarFramesExporter::AddLeadingArray(const std::string& arrayName)
+{
+  this->LeadingArrays.push_back(arrayName);
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+void vtkLidarFramesExporter::ClearLeadingArrays()
+{
+  this->LeadingArrays.clear();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+std::string vtkLidarFramesExporter::GetFileName(int frameIndex) const
+{
+  static const char* extensions[] = { "csv", "ply", "bin" };
+  char frameNumber[32];
+  std::snprintf(frameNumber, sizeof(frameNumber), " (Frame %04d).", frameIndex);
+  boost::filesystem::path path(this->OutputDirectory);
+  path /= this->FilePrefix + frameNumber + extensions[this->Format];
+  return path.string();
+}
+
+//-----------------------------------------------------------------------------
+int vtkLidarFramesExporter::Write()
+{
+  if (!this->Reader)
+  {
+    vtkErrorMacro("No reader has been set");
+    return -1;
+  }
+  if (!boost::filesystem::is_directory(this->OutputDirectory))
+  {
+    vtkErrorMacro("Output directory " << this->OutputDirectory << " does not exist");
+    return -1;
+  }
+
+  // Make sure the frame index has been built
+  if (this->Reader->GetNumberOfFrames() == 0)
+  {
+    this->Reader->UpdateInformation();
+  }
+
+  // Same convention as vtkLidarReader::SaveFrame, the first and last frames
+  // are hidden from the user most of the time.
+  int numberOfFrames = this->Reader->GetNumberOfFrames();
+  int offset = 0;
+  if (!this->Reader->GetShowFirstAndLastFrame() && numberOfFrames >= 3)
+  {
+    offset = 1;
+    numberOfFrames -= 2;
+  }
+  int first = std::max(this->FirstFrame, 0);
+  int last = this->LastFrame < 0 ? numberOfFrames - 1 : std::min(this->LastFrame, numberOfFrames - 1);
+  if (first > last)
+  {
+    vtkWarningMacro("No frame to export in [" << this->FirstFrame << ", " << this->LastFrame << "]");
+    return 0;
+  }
+
+  unsigned int nbThreads = this->NumberOfThreads > 0 ? this->NumberOfThreads
+                                                     : boost::thread::hardware_concurrency();
+  nbThreads = std::max(nbThreads, 1u);
+
+  // The queue is bounded to limit the number of decoded frames held in memory
+  // if the encoding is slower than the decoding.
+  using IndexedFrame = std::pair<int, vtkSmartPointer<vtkPolyData>>;
+  SynchronizedQueue<IndexedFrame> frames(2 * nbThreads);
+  std::atomic<int> nbWritten(0);
+  std::atomic<bool> failed(false);
+
+  std::vector<boost::thread> workers;
+  for (unsigned int i = 0; i < nbThreads; ++i)
+  {
+    workers.emplace_back([&]()
+    {
+      IndexedFrame frame;
+      while (frames.dequeue(frame))
+      {
+        if (this->WriteFrame(frame.second, this->GetFileName(frame.first)))
+        {
+          nbWritten++;
+        }
+        else
+        {
+          failed = true;
+        }
+      }
+    });
+  }
+
+  this->Reader->Open();
+  int nbRequested = (last - first) / this->FrameStride + 1;
+  for (int frameIndex = first; frameIndex <= last && !failed; frameIndex += this->FrameStride)
+  {
+    vtkSmartPointer<vtkPolyData> frame = this->Reader->GetFrame(frameIndex + offset);
+    if (!frame)
+    {
+      failed = true;
+      break;
+    }
+    frames.enqueue(IndexedFrame(frameIndex, frame));
+
+    double progress = static_cast<double>((frameIndex - first) / this->FrameStride + 1) / nbRequested;
+    this->InvokeEvent(vtkCommand::ProgressEvent, &progress);
+  }
+  frames.finishQueue();
+  for (auto& worker : workers)
+  {
+    worker.join();
+  }
+  this->Reader->Close();
+
+  if (failed)
+  {
+    vtkErrorMacro("Failed to export some frames in " << this->OutputDirectory);
+    return -1;
+  }
+  return nbWritten;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkLidarFramesExporter::WriteFrame(vtkPolyData* frame, const std::string& filename) const
+{
+  switch (this->Format)
+  {
+    case CSV:    return this->WriteCSV(frame, filename);
+    case PLY:    return this->WritePLY(frame, filename);
+    case BINARY: return this->WriteBinary(frame, filename);
+    default:     return false;
+  }
+}
+
+//-----------------------------------------------------------------------------
+bool vtkLidarFramesExporter::WriteCSV(vtkPolyData* frame, const std::string& filename) const
+{
+  std::vector<Column> columns = GetColumns(frame, this->LeadingArrays);
+
+  std::string header;
+  for (size_t c = 0; c < columns.size(); ++c)
+  {
+    header += (c ? ",\"" : "\"") + columns[c].Name + "\"";
+  }
+  header += "\n";
+
+  // Format everything in memory, then write it in one go
+  std::string text;
+  vtkIdType nbPoints = frame->GetNumberOfPoints();
+  text.reserve(nbPoints * columns.size() * 12);
+  for (vtkIdType i = 0; i < nbPoints; ++i)
+  {
+    for (size_t c = 0; c < columns.size(); ++c)
+    {
+      if (c)
+      {
+        text += ',';
+      }
+      vtkDataArray* array = columns[c].Array;
+      vtkIdType index = i * array->GetNumberOfComponents() + columns[c].Component;
+      switch (array->GetDataType())
+      {
+        vtkTemplateMacro(AppendColumnValue(text,
+                                           static_cast<VTK_TT*>(array->GetVoidPointer(0)),
+                                           index, this->Precision));
+      }
+    }
+    text += '\n';
+  }
+
+  return WriteBuffer(filename, header, std::vector<char>(text.begin(), text.end()));
+}
+
+//-----------------------------------------------------------------------------
+bool vtkLidarFramesExporter::WritePLY(vtkPolyData* frame, const std::string& filename) const
+{
+  std::vector<Column> columns = GetColumns(frame, this->LeadingArrays);
+  vtkIdType nbPoints = frame->GetNumberOfPoints();
+
+  std::string header = "ply\nformat binary_little_endian 1.0\n";
+  header += "element vertex " + std::to_string(nbPoints) + "\n";
+  std::vector<size_t> sizes;
+  size_t recordSize = 0;
+  for (size_t c = 0; c < columns.size(); ++c)
+  {
+    // PLY does not allow ':' in property names, and the usual names for
+    // the coordinates are x, y, z
+    std::string name = columns[c].Name;
+    if (c < 3 && frame->GetPoints())
+    {
+      name = std::string(1, static_cast<char>('x' + c));
+    }
+    std::replace(name.begin(), name.end(), ':', '_');
+    std::replace(name.begin(), name.end(), ' ', '_');
+    int type = columns[c].Array->GetDataType();
+    header += std::string("property ") + GetPLYTypeName(type) + " " + name + "\n";
+    sizes.push_back(IsNativePLYType(type) ? columns[c].Array->GetDataTypeSize() : sizeof(double));
+    recordSize += sizes.back();
+  }
+  header += "end_header\n";
+
+  // PLY is row major
+  std::vector<char> data(nbPoints * recordSize);
+  char* out = data.data();
+  for (vtkIdType i = 0; i < nbPoints; ++i)
+  {
+    for (size_t c = 0; c < columns.size(); ++c)
+    {
+      vtkDataArray* array = columns[c].Array;
+      vtkIdType index = i * array->GetNumberOfComponents() + columns[c].Component;
+      if (IsNativePLYType(array->GetDataType()))
+      {
+        const char* in = static_cast<const char*>(array->GetVoidPointer(0));
+        std::memcpy(out, in + index * sizes[c], sizes[c]);
+      }
+      else
+      {
+        double value = array->GetComponent(i, columns[c].Component);
+        std::memcpy(out, &value, sizeof(double));
+      }
+      ToLittleEndian(out, 1, sizes[c]);
+      out += sizes[c];
+    }
+  }
+
+  return WriteBuffer(filename, header, data);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkLidarFramesExporter::WriteBinary(vtkPolyData* frame, const std::string& filename) const
+{
+  std::vector<Column> columns = GetColumns(frame, this->LeadingArrays);
+  uint64_t nbPoints = frame->GetNumberOfPoints();
+  uint32_t nbColumns = static_cast<uint32_t>(columns.size());
+
+  std::string header("LVFRAME1");
+  AppendLittleEndian(header, nbPoints);
+  AppendLittleEndian(header, nbColumns);
+  size_t dataSize = 0;
+  for (const Column& column : columns)
+  {
+    uint32_t nameLength = static_cast<uint32_t>(column.Name.size());
+    int32_t type = column.Array->GetDataType();
+    AppendLittleEndian(header, nameLength);
+    header.append(column.Name);
+    AppendLittleEndian(header, type);
+    dataSize += nbPoints * column.Array->GetDataTypeSize();
+  }
+
+  // Columnar layout, so that a column can be mapped directly by the reader
+  std::vector<char> data(dataSize);
+  char* out = data.data();
+  for (const Column& column : columns)
+  {
+    const char* in = static_cast<const char*>(column.Array->GetVoidPointer(0));
+    size_t size = column.Array->GetDataTypeSize();
+    int nbComponents = column.Array->GetNumberOfComponents();
+    char* columnStart = out;
+    if (nbComponents == 1)
+    {
+      std::memcpy(out, in, nbPoints * size);
+      out += nbPoints * size;
+    }
+    else
+    {
+      for (uint64_t i = 0; i < nbPoints; ++i)
+      {
+        std::memcpy(out, in + (i * nbComponents + column.Component) * size, size);
+        out += size;
+      }
+    }
+    ToLittleEndian(columnStart, nbPoints, size);
+  }
+
+  return WriteBuffer(filename, header, data);
+}
@@ -0,0 +1,151 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VTKLIDARFRAMESEXPORTER_H
+#define VTKLIDARFRAMESEXPORTER_H
+
+#include <vtkObject.h>
+
+#include <string>
+#include <vector>
+
+class vtkLidarReader;
+class vtkPolyData;
+
+/**
+ * @brief vtkLidarFramesExporter export a range of frames of a vtkLidarReader,
+ * one file per frame, without going through the pipeline for each frame.
+ *
+ * The frames are decoded sequentially by the reader (the interpreter is stateful)
+ * while the formatting and the writing of the files are done by a pool of
+ * worker threads. The decoding thread is throttled by a bounded queue so that
+ * only a few frames are kept in memory at once.
+ *
+ * The columns are always written in the same order: the point coordinates first,
+ * then the arrays added with AddLeadingArray(), then the remaining point data arrays
+ * in their order of appearance.
+ *
+ * Each frame is saved in OutputDirectory as "<FilePrefix> (Frame NNNN).<ext>",
+ * where NNNN is the frame index as displayed to the user.
+ */
+class VTK_EXPORT vtkLidarFramesExporter : public vtkObject
+{
+public:
+  static vtkLidarFramesExporter* New();
+  vtkTypeMacro(vtkLidarFramesExporter, vtkObject)
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  enum FileFormat
+  {
+    CSV = 0,    /*!< text, same layout as the ParaView CSV writer with Precision = 16 */
+    PLY = 1,    /*!< binary little endian PLY */
+    BINARY = 2, /*!< compact columnar binary format, see WriteBinary() */
+  };
+
+  vtkGetObjectMacro(Reader, vtkLidarReader)
+  virtual void SetReader(vtkLidarReader* reader);
+
+  vtkGetMacro(OutputDirectory, std::string)
+  vtkSetMacro(OutputDirectory, std::string)
+
+  vtkGetMacro(FilePrefix, std::string)
+  vtkSetMacro(FilePrefix, std::string)
+
+  vtkGetMacro(FirstFrame, int)
+  vtkSetMacro(FirstFrame, int)
+
+  //! Last frame to export, included. A negative value means the last frame available.
+  vtkGetMacro(LastFrame, int)
+  vtkSetMacro(LastFrame, int)
+
+  vtkGetMacro(FrameStride, int)
+  vtkSetClampMacro(FrameStride, int, 1, VTK_INT_MAX)
+
+  vtkGetMacro(Format, int)
+  vtkSetClampMacro(Format, int, CSV, BINARY)
+
+  //! Number of significant digits used for the CSV format
+  vtkGetMacro(Precision, int)
+  vtkSetClampMacro(Precision, int, 1, 17)
+
+  //! Number of encoding threads, 0 means one per hardware core
+  vtkGetMacro(NumberOfThreads, int)
+  vtkSetClampMacro(NumberOfThreads, int, 0, VTK_INT_MAX)
+
+  /**
+   * @brief AddLeadingArray ask to write the array just after the point coordinates.
+   * The arrays are written in the order they have been added.
+   */
+  void AddLeadingArray(const std::string& arrayName);
+  void ClearLeadingArrays();
+
+  /**
+   * @brief Write export all requested frames
+   * @return the number of frames written, -1 in case of error
+   */
+  int Write();
+
+  /**
+   * @brief GetFileName return the name of the file used for a given frame
+   */
+  std::string GetFileName(int frameIndex) const;
+
+  /**
+   * @brief WriteFrame write a single frame in the selected format. This does not
+   * require a reader and is thread safe as long as the frame is not modified.
+   */
+  bool WriteFrame(vtkPolyData* frame, const std::string& filename) const;
+
+protected:
+  vtkLidarFramesExporter();
+  ~vtkLidarFramesExporter();
+
+  bool WriteCSV(vtkPolyData* frame, const std::string& filename) const;
+  bool WritePLY(vtkPolyData* frame, const std::string& filename) const;
+
+  /**
+   * @brief WriteBinary write the frame in a compact columnar format:
+   * - magic "LVFRAME1" (8 bytes)
+   * - number of points (uint64) and number of columns (uint32)
+   * - for each column: name length (uint32), name, VTK scalar type (int32)
+   * - for each column: the values of all points, contiguous
+   * All the values are little endian, they are swapped on big endian hosts.
+   */
+  bool WriteBinary(vtkPolyData* frame, const std::string& filename) const;
+
+  //! Reader providing the frames
+  vtkLidarReader* Reader = nullptr;
+
+  //! Directory in which the frames are written, must exist
+  std::string OutputDirectory = "";
+
+  //! Prefix of each frame file name
+  std::string FilePrefix = "frame";
+
+  int FirstFrame = 0;
+  int LastFrame = -1;
+  int FrameStride = 1;
+  int Format = CSV;
+  int Precision = 16;
+  int NumberOfThreads = 0;
+
+  //! Arrays to write just after the point coordinates
+  std::vector<std::string> LeadingArrays;
+
+private:
+  vtkLidarFramesExporter(const vtkLidarFramesExporter&) = delete;
+  void operator=(const vtkLidarFramesExporter&) = delete;
+};
+
+#endif // VTKLIDARFRAMESEXPORTER_H
@@ -27,6 +27,8 @@
 #include "CameraProjection.h"
 #include "BoundingBox.h"
 #include "vtkEigenTools.h"
+#include "ParallelFor.h"
+#include "PixelBinning.h"
 
 // STD
 #include <iostream>
@@ -34,6 +36,7 @@
 
 // BOOST
 #include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
 
 // YAML
 #include <yaml-cpp/yaml.h>
@@ -65,23 +68,21 @@ public:
 };
 
 //------------------------------------------------------------------------------
-size_t GetNumberOfClouds(std::string cloudFrameSeries)
-{
-  YAML::Node series = YAML::LoadFile(cloudFrameSeries);
-  return series["files"].size();
-}
-
-void ReadFromSeries(std::string fileSeries, size_t index, std::string& path, double& time)
+void ReadSeries(std::string fileSeries, std::vector<std::string>& paths, std::vector<double>& times)
 {
   YAML::Node series = YAML::LoadFile(fileSeries);
   YAML::Node files = series["files"];
 
   // compute absolute file paths from the relative one present in the .series
   boost::filesystem::path dirname = boost::filesystem::path(fileSeries).parent_path();
-  boost::filesystem::path basename = boost::filesystem::path(files[index]["name"].as<std::string>());
-  path = (dirname / basename).string();
-
-  time = files[index]["time"].as<double>();
+  paths.resize(files.size());
+  times.resize(files.size());
+  for (size_t index = 0; index < files.size(); ++index)
+  {
+    boost::filesystem::path basename = boost::filesystem::path(files[index]["name"].as<std::string>());
+    paths[index] = (dirname / basename).string();
+    times[index] = files[index]["time"].as<double>();
+  }
 }
 
 //------------------------------------------------------------------------------
@@ -191,49 +192,123 @@ std::vector<Eigen::VectorXd> RemovePercentilFarthest(std::vector<Eigen::VectorXd
 }
 
 //------------------------------------------------------------------------------
-bool CheckYoloPspConsistency(std::string type, int r, int g, int b)
+//! Classes of yolo detections which are back projected, with the color of the
+//! corresponding label in the psp-net segmentation
+struct SemanticClass
 {
-  // 4 wheels Vehicle
-  bool carConsistency = (type == "car") && (r == 0) && (g == 0) && (b == 142);
-  bool truckConsistency = (type == "truck") && (r == 0) && (g == 0) && (b == 70);
-  bool busConsistency = (type == "bus") && (r == 0) && (g == 60) && (b == 100);
+  const char* Type;
+  int R, G, B;
+};
 
+const SemanticClass SemanticClasses[] = {
+  // 4 wheels Vehicle
+  {"car", 0, 0, 142},
+  {"truck", 0, 0, 70},
+  {"bus", 0, 60, 100},
   // 2 wheels vehicle
-  bool bicycleConsistence = (type == "bicycle") && (r == 119) && (g == 11) && (b == 32);
-  bool mototbikeConsistence = (type == "motorbike") && (r == 0) && (g == 0) && (b == 230);
-
+  {"bicycle", 119, 11, 32},
+  {"motorbike", 0, 0, 230},
   // signalization
-  bool signConsistency = (type == "stop sign") && (r == 220) && (g == 220) && (b == 0);
-  bool trafficLightConsistency = (type == "traffic light") && (r == 220) && (g == 220) && (b == 0);
-
+  {"stop sign", 220, 220, 0},
+  {"traffic light", 220, 220, 0},
   // persons
-  bool personConsistency = (type == "person") && (r == 220) && (g == 20) && (b == 60);
+  {"person", 220, 20, 60}
+};
+
+//! Pack a color in a single integer, to compare it with the mask in one go
+inline int PackColor(int r, int g, int b)
+{
+  return (r << 16) | (g << 8) | b;
+}
+
+//------------------------------------------------------------------------------
+//! Index of the class in SemanticClasses, -1 for the other kinds of object
+int GetSemanticClassId(const std::string& type)
+{
+  for (size_t classId = 0; classId < sizeof(SemanticClasses) / sizeof(SemanticClasses[0]); ++classId)
+  {
+    if (type == SemanticClasses[classId].Type)
+    {
+      return static_cast<int>(classId);
+    }
+  }
+  return -1;
+}
+
+//------------------------------------------------------------------------------
+//! Packed color of each pixel of the psp-net mask, indexed by col + width * row
+std::vector<int> GetPackedMaskColors(vtkSmartPointer<vtkImageData> pspMsk)
+{
+  const int nbPixels = pspMsk->GetDimensions()[0] * pspMsk->GetDimensions()[1];
+  vtkDataArray* scalars = pspMsk->GetPointData()->GetScalars();
+  const int nbComponents = scalars->GetNumberOfComponents();
+  std::vector<int> colors(nbPixels);
+  if (scalars->GetDataType() == VTK_UNSIGNED_CHAR && nbComponents >= 3)
+  {
+    const unsigned char* rgb = static_cast<unsigned char*>(scalars->GetVoidPointer(0));
+    for (int pixel = 0; pixel < nbPixels; ++pixel)
+    {
+      const unsigned char* value = rgb + nbComponents * pixel;
+      colors[pixel] = PackColor(value[0], value[1], value[2]);
+    }
+  }
+  else
+  {
+    for (int pixel = 0; pixel < nbPixels; ++pixel)
+    {
+      int rgb[3] = {0, 0, 0};
+      for (int k = 0; k < std::min(3, nbComponents); ++k)
+      {
+        rgb[k] = static_cast<int>(std::round(scalars->GetComponent(pixel, k)));
+      }
+      colors[pixel] = PackColor(rgb[0], rgb[1], rgb[2]);
+    }
+  }
+  return colors;
+}
 
-  return carConsistency || truckConsistency || personConsistency || busConsistency ||
-         bicycleConsistence || mototbikeConsistence || signConsistency || trafficLightConsistency;
+//------------------------------------------------------------------------------
+//! Range of pixels [colMin, colMax] x [rowMin, rowMax] covered by a bounding box,
+//! clamped to the image. Returns false if it does not intersect the image.
+bool GetBBPixelRange(const OrientedBoundingBox<2>& bb, int width, int height,
+                     int& colMin, int& colMax, int& rowMin, int& rowMax)
+{
+  Eigen::Vector2d halfExtent = bb.Orientation.cwiseAbs() * bb.Width / 2.0;
+  colMin = std::max(0, static_cast<int>(std::ceil(bb.Center(0) - halfExtent(0))));
+  colMax = std::min(width - 1, static_cast<int>(std::floor(bb.Center(0) + halfExtent(0))));
+  rowMin = std::max(0, static_cast<int>(std::ceil(bb.Center(1) - halfExtent(1))));
+  rowMax = std::min(height - 1, static_cast<int>(std::floor(bb.Center(1) + halfExtent(1))));
+  return colMin <= colMax && rowMin <= rowMax;
 }
 
 //------------------------------------------------------------------------------
-std::vector<bool> ComputeBBPSPNetConsistency(std::vector<OrientedBoundingBox<2>> bbList,
-                                             vtkSmartPointer<vtkImageData> pspMsk)
+std::vector<bool> ComputeBBPSPNetConsistency(std::vector<OrientedBoundingBox<2>>& bbList,
+                                             const std::vector<int>& bbClassId,
+                                             const std::vector<int>& maskColors,
+                                             int width, int height)
 {
   std::vector<bool> isConsistent(bbList.size(), true);
   for (size_t bbIdx = 0; bbIdx < bbList.size(); ++bbIdx)
   {
+    int colMin, colMax, rowMin, rowMax;
+    if (bbClassId[bbIdx] < 0 || !GetBBPixelRange(bbList[bbIdx], width, height, colMin, colMax, rowMin, rowMax))
+    {
+      continue;
+    }
+    const SemanticClass& semanticClass = SemanticClasses[bbClassId[bbIdx]];
+    const int classColor = PackColor(semanticClass.R, semanticClass.G, semanticClass.B);
+
+    // only the pixels of the bounding rectangle of the box can be inside
     double pixelCount = 0;
     double pixelConsistentCount = 0;
-    for (int col = 0; col < pspMsk->GetDimensions()[0]; ++col)
+    for (int row = rowMin; row <= rowMax; ++row)
     {
-      for (int row = 0; row < pspMsk->GetDimensions()[1]; ++row)
+      for (int col = colMin; col <= colMax; ++col)
       {
         if (bbList[bbIdx].IsPointInside(Eigen::Vector2d(col, row)))
         {
           pixelCount += 1.0;
-          int r = static_cast<int>(std::round(pspMsk->GetScalarComponentAsDouble(col, row, 0, 0)));
-          int g = static_cast<int>(std::round(pspMsk->GetScalarComponentAsDouble(col, row, 0, 1)));
-          int b = static_cast<int>(std::round(pspMsk->GetScalarComponentAsDouble(col, row, 0, 2)));
-
-          if (CheckYoloPspConsistency(bbList[bbIdx].Type, r, g, b))
+          if (maskColors[col + width * row] == classColor)
           {
             pixelConsistentCount += 1.0;
           }
@@ -242,8 +317,7 @@ std::vector<bool> ComputeBBPSPNetConsistency(std::vector<OrientedBoundingBox<2>>
     }
 
     // compute area fraction of consistent pixel
-    double consistentFraction = pixelConsistentCount / pixelCount;
-    if (consistentFraction < 0.175)
+    if (pixelCount > 0 && pixelConsistentCount / pixelCount < 0.175)
     {
       isConsistent[bbIdx] = false;
     }
@@ -251,30 +325,129 @@ std::vector<bool> ComputeBBPSPNetConsistency(std::vector<OrientedBoundingBox<2>>
   return isConsistent;
 }
 
+//------------------------------------------------------------------------------
+/**
+ * @brief BBGrid regular grid over the image which lists the bounding boxes
+ *        overlapping each of its cells, so that a projected point is only
+ *        tested against the few boxes around it.
+ */
+class BBGrid
+{
+public:
+  BBGrid(std::vector<OrientedBoundingBox<2>>& bbList, const std::vector<bool>& isCandidate,
+         int width, int height)
+    : BBList(bbList)
+    , NbCols((width + CellSize - 1) / CellSize)
+    , NbRows((height + CellSize - 1) / CellSize)
+  {
+    std::vector<int> cellOfEntry;
+    std::vector<double> bbOfEntry;
+    for (size_t bbIdx = 0; bbIdx < bbList.size(); ++bbIdx)
+    {
+      if (!isCandidate[bbIdx])
+      {
+        continue;
+      }
+      // a point inside the box is rounded to a pixel of this range
+      const OrientedBoundingBox<2>& bb = bbList[bbIdx];
+      Eigen::Vector2d halfExtent = bb.Orientation.cwiseAbs() * bb.Width / 2.0;
+      int colMin = std::max(0, static_cast<int>(std::floor(bb.Center(0) - halfExtent(0))));
+      int colMax = std::min(width - 1, static_cast<int>(std::ceil(bb.Center(0) + halfExtent(0))));
+      int rowMin = std::max(0, static_cast<int>(std::floor(bb.Center(1) - halfExtent(1))));
+      int rowMax = std::min(height - 1, static_cast<int>(std::ceil(bb.Center(1) + halfExtent(1))));
+      if (colMin > colMax || rowMin > rowMax)
+      {
+        continue;
+      }
+      int cellColMin = colMin / CellSize, cellColMax = colMax / CellSize;
+      int cellRowMin = rowMin / CellSize, cellRowMax = rowMax / CellSize;
+      for (int cellRow = cellRowMin; cellRow <= cellRowMax; ++cellRow)
+      {
+        for (int cellCol = cellColMin; cellCol <= cellColMax; ++cellCol)
+        {
+          cellOfEntry.push_back(cellCol + this->NbCols * cellRow);
+          bbOfEntry.push_back(bbIdx);
+        }
+      }
+    }
+    this->Cells.Build(this->NbCols * this->NbRows, cellOfEntry, bbOfEntry);
+  }
+
+  //! Call functor(bbIdx) for each candidate bounding box containing the point
+  template <typename Functor>
+  void ForEachBBContaining(const Eigen::Vector2d& y, int col, int row, Functor functor)
+  {
+    const int cell = col / CellSize + this->NbCols * (row / CellSize);
+    for (double* entry = this->Cells.Begin(cell); entry != this->Cells.End(cell); ++entry)
+    {
+      const int bbIdx = static_cast<int>(*entry);
+      if (this->BBList[bbIdx].IsPointInside(y))
+      {
+        functor(bbIdx);
+      }
+    }
+  }
+
+private:
+  static constexpr int CellSize = 32;
+
+  std::vector<OrientedBoundingBox<2>>& BBList;
+  const int NbCols;
+  const int NbRows;
+  PixelBinning Cells;
+};
+
 //------------------------------------------------------------------------------
 std::vector<SemanticCentroid> DetectAndComputeCentroid(vtkSmartPointer<vtkPolyData> cloud,
                                                        vtkSmartPointer<vtkImageData> pspMsk,
                                                        vtkSmartPointer<vtkImageData> img,
                                                        vtkSmartPointer<vtkMultiBlockDataSet> bbs,
-                                                       Eigen::VectorXd W)
+                                                       const Eigen::VectorXd& W,
+                                                       std::ostream& log)
 {
-  // Convert the polydata to 2D boundingbox structure
+  const int width = img->GetDimensions()[0];
+  const int height = img->GetDimensions()[1];
+
+  // Convert the polydata to 2D boundingbox structure, and reject the
+  // other kinds of object
   std::vector<OrientedBoundingBox<2>> bbList = Create2DBBFromPolyData(bbs);
+  std::vector<int> bbClassId(bbList.size());
+  for (size_t bbIdx = 0; bbIdx < bbList.size(); ++bbIdx)
+  {
+    bbClassId[bbIdx] = GetSemanticClassId(bbList[bbIdx].Type);
+  }
   std::vector<std::vector<Eigen::VectorXd>> pointsInBB(bbList.size());
 
   // Discard a potential bounding box if there is no
   // consistency between psp-net and yolo
-  std::vector<bool> isBBConsistent = ComputeBBPSPNetConsistency(bbList, pspMsk);
-
-  // loop over points of the pointcloud
-  for (unsigned int pointIdx = 0; pointIdx < cloud->GetNumberOfPoints(); ++pointIdx)
+  std::vector<int> maskColors = GetPackedMaskColors(pspMsk);
+  std::vector<bool> isBBConsistent = ComputeBBPSPNetConsistency(bbList, bbClassId, maskColors,
+                                                                pspMsk->GetDimensions()[0],
+                                                                pspMsk->GetDimensions()[1]);
+  std::vector<bool> isCandidate(bbList.size());
+  for (size_t bbIdx = 0; bbIdx < bbList.size(); ++bbIdx)
   {
-    double pt[3];
-    cloud->GetPoint(pointIdx, pt);
-    Eigen::Vector3d X(pt[0], pt[1], pt[2]);
+    isCandidate[bbIdx] = bbClassId[bbIdx] >= 0 && isBBConsistent[bbIdx];
+  }
+  BBGrid grid(bbList, isCandidate, width, height);
 
-    // Project the 3D point onto the image
-    Eigen::Vector2d y = BrownConradyPinholeProjection(W, X, true);
+  // Project all the points onto the image at once
+  const int nbPoints = cloud->GetNumberOfPoints();
+  std::vector<double> xyz(3 * nbPoints);
+  for (int pointIdx = 0; pointIdx < nbPoints; ++pointIdx)
+  {
+    cloud->GetPoint(pointIdx, &xyz[3 * pointIdx]);
+  }
+  // the pixels are rounded, keep the points whose pixel is in the image
+  const double imageBounds[4] = {-0.5, width - 0.5, -0.5, height - 0.5};
+  std::vector<double> pixels(2 * nbPoints);
+  std::vector<int> visible = ProjectPoints(ProjectionType::BrownConradyPinhole, W,
+                                           xyz.data(), nbPoints, imageBounds, pixels.data());
+
+  // loop over points of the pointcloud which are in the image
+  for (int pointIdx : visible)
+  {
+    Eigen::Vector2d y(pixels[2 * pointIdx], pixels[2 * pointIdx + 1]);
 
     // y represents the pixel coordinates using opencv convention, we need to
     // go back to vtkImageData pixel convention
@@ -282,40 +455,25 @@ std::vector<SemanticCentroid> DetectAndComputeCentroid(vtkSmartPointer<vtkPolyDa
     int vtkCol = static_cast<int>(std::round(y(0)));
 
     // Check if the projected point is in the region of interest of the image
-    if ((vtkRaw < 0) || (vtkRaw >= img->GetDimensions()[1]) ||
-        (vtkCol < 0) || (vtkCol >= img->GetDimensions()[0]))
+    if ((vtkRaw < 0) || (vtkRaw >= height) || (vtkCol < 0) || (vtkCol >= width))
     {
       continue;
     }
 
-    // loop over the bounding box
-    for (unsigned int bbIdx = 0; bbIdx < bbList.size(); ++bbIdx)
+    // loop over the candidate bounding boxes which contain the projected point
+    const int maskColor = maskColors[vtkCol + width * vtkRaw];
+    grid.ForEachBBContaining(y, vtkCol, vtkRaw, [&](int bbIdx)
     {
-      OrientedBoundingBox<2> bb = bbList[bbIdx];
-      std::string type = bb.Type;
-
-      // reject over kind of object
-      if (type == "car" || type == "truck" || type == "person" ||
-          type == "bicycle" || type == "motorbike" || type == "bus" ||
-          type == "traffic light" || type == "stop sign")
+      // we still need to check the consistency with
+      // the psp-net semantic segmentation
+      const SemanticClass& semanticClass = SemanticClasses[bbClassId[bbIdx]];
+      if (maskColor == PackColor(semanticClass.R, semanticClass.G, semanticClass.B))
       {
-        // check that the projected point is inside the bounding box
-        if (bb.IsPointInside(y) && isBBConsistent[bbIdx])
-        {
-          // if it is, we still need to check the consistency with
-          // the psp-net semantic segmentation
-          int r = static_cast<int>(std::round(pspMsk->GetScalarComponentAsDouble(vtkCol, vtkRaw, 0, 0)));
-          int g = static_cast<int>(std::round(pspMsk->GetScalarComponentAsDouble(vtkCol, vtkRaw, 0, 1)));
-          int b = static_cast<int>(std::round(pspMsk->GetScalarComponentAsDouble(vtkCol, vtkRaw, 0, 2)));
-
-          if (CheckYoloPspConsistency(type, r, g, b))
-          {
-            // Add the 3D points to the list since it is in the bb frustrum
-            pointsInBB[bbIdx].push_back(X);
-          }
-        }
+        // Add the 3D points to the list since it is in the bb frustrum
+        Eigen::Vector3d X(xyz[3 * pointIdx], xyz[3 * pointIdx + 1], xyz[3 * pointIdx + 2]);
+        pointsInBB[bbIdx].push_back(X);
       }
-    }
+    });
   }
 
   // compute the centroid
@@ -330,44 +488,75 @@ std::vector<SemanticCentroid> DetectAndComputeCentroid(vtkSmartPointer<vtkPolyDa
       // Then compute the centroid of the remaining points
       SemanticCentroid centroid;
       centroid.center = MultivariateMedian(closestPoints, 1e-6);
+      centroid.class_id = bbClassId[objectIdx];
       centroid.type = bbList[objectIdx].Type;
       positions.push_back(centroid);
-      std::cout << "Centroid of " << centroid.type << " is: " << centroid.center.transpose() << std::endl;
+      log << "Centroid of " << centroid.type << " is: " << centroid.center.transpose() << std::endl;
     }
   }
 
   return positions;
 }
 
+//------------------------------------------------------------------------------
+//! Inputs of a camera which do not depend on the lidar frame
+struct CameraInputs
+{
+  std::string ImageFolder;
+  std::string PspnetFolder;
+  std::string YoloFolder;
+  //! time of each image of the image series
+  std::vector<double> ImageTimes;
+  //! parameters of the calibrated camera model
+  Eigen::VectorXd W;
+};
+
+//------------------------------------------------------------------------------
+CameraInputs LoadCameraInputs(std::string imageFolder, std::string pspnetFolder,
+                              std::string yoloFolder, std::string calibFilename)
+{
+  CameraInputs camera;
+  camera.ImageFolder = imageFolder;
+  camera.PspnetFolder = pspnetFolder;
+  camera.YoloFolder = yoloFolder;
+
+  std::string filename = imageFolder + "/image.jpg.series";
+  YAML::Node imageInfo = YAML::LoadFile(filename);
+  for (unsigned int imgIndex = 0; imgIndex < imageInfo["files"].size(); ++imgIndex)
+  {
+    camera.ImageTimes.push_back(imageInfo["files"][imgIndex]["time"].as<double>());
+  }
+
+  // Load the calibration
+  CameraModel Model;
+  Model.LoadParamsFromFile(calibFilename);
+  camera.W = Model.GetParametersVector();
+  return camera;
+}
+
 //------------------------------------------------------------------------------
 std::vector<SemanticCentroid> LaunchDetectionBackProjection(vtkSmartPointer<vtkPolyData> cloud,
                                 vtkSmartPointer<vtkCustomTransformInterpolator> interpolator,
-                                double timeshift, std::string imageFolder,
-                                std::string pspnetFolder, std::string yoloFolder,
-                                std::string calibFilename)
+                                double timeshift, const CameraInputs& camera,
+                                std::ostream& log)
 {
   // Get the time of the cloud
   // Define the time of the cloud as being the middle time
   vtkDataArray* timeArray = cloud->GetPointData()->GetArray("adjustedtime");
   double time = 1e-6 * static_cast<double>((timeArray->GetTuple1(0) + timeArray->GetTuple1(cloud->GetNumberOfPoints() - 1))) / 2.0 - timeshift;
 
-  // Get the name of the temporally closest image
-  std::string filename = imageFolder + "/image.jpg.series";
-  YAML::Node imageInfo = YAML::LoadFile(filename);
-
+  // Get the temporally closest image
   double maxTemporalDist = std::numeric_limits<double>::max();
   double closestImgTime = 0;
   int closestImgIndex = -1;
-  std::string closestImgName;
-  for (unsigned int imgIndex = 0; imgIndex < imageInfo["files"].size(); ++imgIndex)
+  for (unsigned int imgIndex = 0; imgIndex < camera.ImageTimes.size(); ++imgIndex)
   {
-    double imgTime = imageInfo["files"][imgIndex]["time"].as<double>();
+    double imgTime = camera.ImageTimes[imgIndex];
     if (std::abs(imgTime - time) < maxTemporalDist)
     {
       maxTemporalDist = std::abs(imgTime - time);
       closestImgTime = imgTime;
       closestImgIndex = static_cast<int>(imgIndex);
-      closestImgName = imageInfo["files"][imgIndex]["name"].as<std::string>();
     }
   }
 
@@ -383,27 +572,23 @@ std::vector<SemanticCentroid> LaunchDetectionBackProjection(vtkSmartPointer<vtkP
   // to the camera timestamp
   vtkSmartPointer<vtkPolyData> transformedCloud = ReferenceFrameChange(cloud, interpolator, closestImgTime);
 
-  // Load the calibration
-  CameraModel Model;
-  Model.LoadParamsFromFile(calibFilename);
-
   // load the image
   std::stringstream ss; ss << std::setw(4) << std::setfill('0') << closestImgIndex;
-  std::string imgFilename = imageFolder + "/" + ss.str() + ".jpg";
+  std::string imgFilename = camera.ImageFolder + "/" + ss.str() + ".jpg";
   vtkSmartPointer<vtkJPEGReader> imgReader0 = vtkSmartPointer<vtkJPEGReader>::New();
   imgReader0->SetFileName(imgFilename.c_str());
   imgReader0->Update();
   vtkSmartPointer<vtkImageData> img = imgReader0->GetOutput();
 
   // load corresponding pspnet
-  std::string pspNetMaskFilename = pspnetFolder + "/" + ss.str() + ".png";
+  std::string pspNetMaskFilename = camera.PspnetFolder + "/" + ss.str() + ".png";
   vtkSmartPointer<vtkPNGReader> imgReader = vtkSmartPointer<vtkPNGReader>::New();
   imgReader->SetFileName(pspNetMaskFilename.c_str());
   imgReader->Update();
   vtkSmartPointer<vtkImageData> pspMask = imgReader->GetOutput();
 
   // load yolo
-  std::string yoloBBFilename = yoloFolder + "/" + ss.str() + ".yml";
+  std::string yoloBBFilename = camera.YoloFolder + "/" + ss.str() + ".yml";
   vtkSmartPointer<vtkBoundingBoxReader> bbReader = vtkSmartPointer<vtkBoundingBoxReader>::New();
   bbReader->SetFileName(yoloBBFilename);
   bbReader->SetImageHeight(img->GetDimensions()[1]);
@@ -411,8 +596,7 @@ std::vector<SemanticCentroid> LaunchDetectionBackProjection(vtkSmartPointer<vtkP
   vtkSmartPointer<vtkMultiBlockDataSet> bbs = bbReader->GetOutput();
 
   // Launch 3D median center computation
-  Eigen::VectorXd W = Model.GetParametersVector();
-  std::vector<SemanticCentroid> results = DetectAndComputeCentroid(transformedCloud, pspMask, img, bbs, W);
+  std::vector<SemanticCentroid> results = DetectAndComputeCentroid(transformedCloud, pspMask, img, bbs, camera.W, log);
 
   return results;
 }
@@ -511,17 +695,15 @@ int main(int argc, char* argv[])
     return EXIT_FAILURE;
   }
 
-  // Get the folder of the images and detections
-  std::vector<std::string> imageFolders(0);
-  std::vector<std::string> pspnetFolders(0);
-  std::vector<std::string> yoloFolders(0);
-  std::vector<std::string> calibFilenames(0);
+  // Get the folder of the images and detections, and load what does not
+  // depend on the lidar frame once for all
+  std::vector<CameraInputs> cameras(0);
   for (unsigned int cameraIndex = 0; cameraIndex < nbrCameras; ++cameraIndex)
   {
-    imageFolders.push_back(std::string(argv[8 + cameraIndex]));
-    pspnetFolders.push_back(std::string(argv[8 + nbrCameras + cameraIndex]));
-    yoloFolders.push_back(std::string(argv[8 + 2 * nbrCameras + cameraIndex]));
-    calibFilenames.push_back(std::string(argv[8 + 3 * nbrCameras + cameraIndex]));
+    cameras.push_back(LoadCameraInputs(std::string(argv[8 + cameraIndex]),
+                                       std::string(argv[8 + nbrCameras + cameraIndex]),
+                                       std::string(argv[8 + 2 * nbrCameras + cameraIndex]),
+                                       std::string(argv[8 + 3 * nbrCameras + cameraIndex])));
 
     std::cout << cameraIndex << std::endl;
     std::cout << std::string(argv[8 + cameraIndex]) << std::endl;
@@ -542,8 +724,15 @@ int main(int argc, char* argv[])
   vtkSmartPointer<vtkTemporalTransforms> trajectory = vtkTemporalTransforms::CreateFromPolyData(polyTraj);
   vtkSmartPointer<vtkCustomTransformInterpolator> interpolator = trajectory->CreateInterpolator();
   interpolator->SetInterpolationTypeToLinear();
+  // The interpolator initializes itself lazily on the first interpolation,
+  // do it now since it is then shared read-only between the threads
+  vtkSmartPointer<vtkTransform> warmUpTransform = vtkSmartPointer<vtkTransform>::New();
+  interpolator->InterpolateTransform(0., warmUpTransform);
 
-  size_t nbrClouds = GetNumberOfClouds(cloudFrameSeries);
+  std::vector<std::string> vtpPaths;
+  std::vector<double> vtpPipelineTimes; // network time, not used for projection (points have their own lidar time)
+  ReadSeries(cloudFrameSeries, vtpPaths, vtpPipelineTimes);
+  size_t nbrClouds = vtpPaths.size();
 
   // allow negative (python like) indexes
   if (firstLidarFrameToProcess < 0) {
@@ -553,40 +742,60 @@ int main(int argc, char* argv[])
       lastLidarFrameToProcess += nbrClouds;
   }
 
-  Json::Value outputSeries;
-  Json::Value files(Json::arrayValue);
+  // The frames are processed in parallel, and the cameras of a frame too if
+  // there are less frames than cores
+  const int nbFrames = std::max(0, lastLidarFrameToProcess - firstLidarFrameToProcess + 1);
+  const unsigned int nbThreads = std::max(1u, boost::thread::hardware_concurrency());
+  const unsigned int frameThreads = std::max(1u, std::min(nbThreads, static_cast<unsigned int>(nbFrames)));
+  const unsigned int cameraThreads = std::max(1u, nbThreads / frameThreads);
+  std::vector<std::string> yamlOutputs(nbFrames);
+  boost::mutex logMutex;
 
   // For each lidar frame, launch the detection and tracking process
-  for (size_t cloudIndex = static_cast<size_t>(firstLidarFrameToProcess); cloudIndex < static_cast<size_t>(lastLidarFrameToProcess + 1); ++cloudIndex)
+  ParallelFor(0, nbFrames, [&](int firstFrame, int lastFrame)
   {
-    // read cloud
-    std::string vtpPath = "";
-    double vtpPipelineTime = 0.0; // network time, not used for projection (points have their own lidar time)
-    ReadFromSeries(cloudFrameSeries, cloudIndex, vtpPath, vtpPipelineTime);
-    vtkSmartPointer<vtkPolyData> cloud = ReadCloudFrame(vtpPath);
+    for (int frame = firstFrame; frame < lastFrame; ++frame)
+    {
+      // read cloud
+      const size_t cloudIndex = static_cast<size_t>(firstLidarFrameToProcess + frame);
+      vtkSmartPointer<vtkPolyData> cloud = ReadCloudFrame(vtpPaths[cloudIndex]);
 
-    // object detected
-    std::vector<std::vector<SemanticCentroid>> objects;
+      // object detected, and log of each camera
+      std::vector<std::vector<SemanticCentroid>> objects(cameras.size());
+      std::vector<std::stringstream> logs(cameras.size());
 
-    // for each image, launch detection back projection
-    for (unsigned int cameraIndex = 0; cameraIndex < imageFolders.size(); ++cameraIndex)
-    {
-      std::vector<SemanticCentroid> currentCamObjects = LaunchDetectionBackProjection(cloud, interpolator, timeshift,
-                                                                                      imageFolders[cameraIndex],
-                                                                                      pspnetFolders[cameraIndex],
-                                                                                      yoloFolders[cameraIndex],
-                                                                                      calibFilenames[cameraIndex]);
-      std::cout << "Added: " << currentCamObjects.size() << " objects for camera: " << cameraIndex << std::endl;
-      objects.push_back(currentCamObjects);
+      // for each image, launch detection back projection
+      ParallelFor(0, static_cast<int>(cameras.size()), [&](int firstCamera, int lastCamera)
+      {
+        for (int cameraIndex = firstCamera; cameraIndex < lastCamera; ++cameraIndex)
+        {
+          objects[cameraIndex] = LaunchDetectionBackProjection(cloud, interpolator, timeshift,
+                                                               cameras[cameraIndex], logs[cameraIndex]);
+          logs[cameraIndex] << "Added: " << objects[cameraIndex].size() << " objects for camera: " << cameraIndex << std::endl;
+        }
+      }, cameraThreads);
+
+      {
+        boost::lock_guard<boost::mutex> lock(logMutex);
+        for (const std::stringstream& log : logs)
+        {
+          std::cout << log.str();
+        }
+      }
+
+      // Export as yaml
+      yamlOutputs[frame] = (boost::filesystem::path(export3DBBFolder) / boost::filesystem::path(vtpPaths[cloudIndex]).stem()).string() + ".yml";
+      Export3DBBAsYaml(objects, yamlOutputs[frame]);
     }
+  }, frameThreads);
 
-    // Export as yaml
-    std::string yamlOutput = (boost::filesystem::path(export3DBBFolder) / boost::filesystem::path(vtpPath).stem()).string() + ".yml";
-    Export3DBBAsYaml(objects, yamlOutput);
-    //std::vector<std::string>["files"] = YAML::NodeType.
+  Json::Value outputSeries;
+  Json::Value files(Json::arrayValue);
+  for (int frame = 0; frame < nbFrames; ++frame)
+  {
     Json::Value node;
-    node["name"] = boost::filesystem::path(yamlOutput).filename().string();
-    node["time"] = vtpPipelineTime;
+    node["name"] = boost::filesystem::path(yamlOutputs[frame]).filename().string();
+    node["time"] = vtpPipelineTimes[firstLidarFrameToProcess + frame];
     files.append(node);
   }
 
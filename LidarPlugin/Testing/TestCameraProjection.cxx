@@ -0,0 +1,131 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// STD
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// EIGEN
+#include <Eigen/Dense>
+
+// LOCAL
+#include "CameraProjection.h"
+
+namespace
+{
+double Random(double min, double max)
+{
+  return min + (max - min) * std::rand() / static_cast<double>(RAND_MAX);
+}
+
+//! Pixel of a point computed by the projection of a single point, with clipping
+Eigen::Vector2d ProjectPoint(ProjectionType type, const Eigen::VectorXd& W, const Eigen::Vector3d& X)
+{
+  if (type == ProjectionType::FishEye)
+  {
+    return FisheyeProjection(W.head<15>(), X, true);
+  }
+  if (type == ProjectionType::BrownConradyPinhole)
+  {
+    return BrownConradyPinholeProjection(W.head<17>(), X, true);
+  }
+  // the pinhole model is the Brown-Conrady one without distortion
+  Eigen::Matrix<double, 17, 1> pinhole = W.head<17>();
+  pinhole.tail<6>().setZero();
+  return BrownConradyPinholeProjection(pinhole, X, true);
+}
+}
+
+//-----------------------------------------------------------------------------
+template <typename T>
+int TestProjectPoints(ProjectionType type, const Eigen::VectorXd& W, const std::string& name)
+{
+  const double epsilon = 1e-6;
+  const double imageBounds[4] = { 0., 1280., 0., 960. };
+
+  // points all around the camera, more than a block of points
+  const int nbPoints = 5000;
+  std::vector<T> points(3 * nbPoints);
+  for (T& coordinate : points)
+  {
+    coordinate = static_cast<T>(Random(-20., 20.));
+  }
+
+  std::vector<double> pixels(2 * nbPoints, 0.);
+  const std::vector<int> visible = ProjectPoints(type, W, points.data(), nbPoints, imageBounds, pixels.data());
+
+  int nbErrors = 0;
+  std::vector<int> expectedVisible;
+  for (int i = 0; i < nbPoints; ++i)
+  {
+    const Eigen::Vector3d X(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+    const Eigen::Vector2d expected = ProjectPoint(type, W, X);
+    // the points close to the camera plane are projected very far, where the
+    // rounding errors grow with the pixel coordinates
+    const double tolerance = epsilon * std::max(1., expected.norm());
+    if (std::abs(pixels[2 * i] - expected(0)) > tolerance || std::abs(pixels[2 * i + 1] - expected(1)) > tolerance)
+    {
+      std::cout << name << ": wrong pixel (" << pixels[2 * i] << ", " << pixels[2 * i + 1]
+                << ") instead of (" << expected(0) << ", " << expected(1) << ") for the point " << i << std::endl;
+      nbErrors++;
+    }
+    const bool isInFront = expected(0) != -1. || expected(1) != -1.;
+    if (isInFront && expected(0) >= imageBounds[0] && expected(0) < imageBounds[1] &&
+        expected(1) >= imageBounds[2] && expected(1) < imageBounds[3])
+    {
+      expectedVisible.push_back(i);
+    }
+  }
+
+  if (visible != expectedVisible)
+  {
+    std::cout << name << ": " << visible.size() << " visible points instead of "
+              << expectedVisible.size() << std::endl;
+    nbErrors++;
+  }
+  if (expectedVisible.empty())
+  {
+    std::cout << name << ": no point in the image, the test is meaningless" << std::endl;
+    nbErrors++;
+  }
+  return nbErrors;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+  // initialize the random generator to a fixed seed
+  // for test repetability
+  std::srand(1992);
+
+  // roll, pitch, yaw, translation, fx, fy, cx, cy, skew, then the distortion
+  Eigen::VectorXd W(17);
+  W << 0.1, -0.2, 0.3, 0.5, -1., 0.2,
+       800., 780., 640., 480., 0.5,
+       -0.05, 0.01, 0.001, -0.002, 0.01, 0.001;
+  Eigen::VectorXd fisheye = W.head(15);
+  fisheye.tail<4>() << 0.02, -0.01, 0.003, -0.0005;
+
+  int nbrErrors = 0;
+  nbrErrors += TestProjectPoints<double>(ProjectionType::BrownConradyPinhole, W, "Brown-Conrady double");
+  nbrErrors += TestProjectPoints<float>(ProjectionType::BrownConradyPinhole, W, "Brown-Conrady float");
+  nbrErrors += TestProjectPoints<double>(ProjectionType::FishEye, fisheye, "Fisheye double");
+  nbrErrors += TestProjectPoints<float>(ProjectionType::FishEye, fisheye, "Fisheye float");
+  nbrErrors += TestProjectPoints<double>(ProjectionType::Pinhole, W, "Pinhole double");
+  return nbrErrors;
+}
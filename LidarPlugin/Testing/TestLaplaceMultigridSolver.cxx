@@ -0,0 +1,174 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// STD
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+
+// Eigen
+#include <Eigen/Sparse>
+#include <Eigen/SparseCholesky>
+
+// LOCAL
+#include "LaplaceMultigridSolver.h"
+
+namespace
+{
+/**
+ * @brief SolveCholesky reference solution: assemble the same finite difference
+ *        scheme as LaplaceMultigridSolver and factorize it
+ */
+std::vector<double> SolveCholesky(int width, int height, const std::vector<bool>& isUnknown,
+                                  const std::vector<double>& grid)
+{
+  std::vector<int> unknownIndex(grid.size(), -1);
+  int n = 0;
+  for (size_t index = 0; index < grid.size(); ++index)
+  {
+    if (isUnknown[index])
+    {
+      unknownIndex[index] = n++;
+    }
+  }
+
+  std::vector<Eigen::Triplet<double>> coefficients;
+  Eigen::VectorXd b = Eigen::VectorXd::Zero(n);
+  for (int y = 0; y < height; ++y)
+  {
+    for (int x = 0; x < width; ++x)
+    {
+      const int index = x + width * y;
+      const int row = unknownIndex[index];
+      if (row < 0)
+      {
+        continue;
+      }
+      const int neighbors[4] = { x > 0 ? index - 1 : -1, x < width - 1 ? index + 1 : -1,
+                                 y > 0 ? index - width : -1, y < height - 1 ? index + width : -1 };
+      int degree = 0;
+      for (int neighbor : neighbors)
+      {
+        if (neighbor < 0)
+        {
+          continue;
+        }
+        degree++;
+        if (isUnknown[neighbor])
+        {
+          coefficients.push_back(Eigen::Triplet<double>(row, unknownIndex[neighbor], -1.));
+        }
+        else
+        {
+          b(row) += grid[neighbor];
+        }
+      }
+      coefficients.push_back(Eigen::Triplet<double>(row, row, degree));
+    }
+  }
+  Eigen::SparseMatrix<double> laplacian(n, n);
+  laplacian.setFromTriplets(coefficients.begin(), coefficients.end());
+  Eigen::SimplicialLDLT<Eigen::SparseMatrix<double>> solver(laplacian);
+  const Eigen::VectorXd solution = solver.solve(b);
+
+  std::vector<double> result(grid);
+  for (size_t index = 0; index < grid.size(); ++index)
+  {
+    if (unknownIndex[index] >= 0)
+    {
+      result[index] = solution(unknownIndex[index]);
+    }
+  }
+  return result;
+}
+}
+
+//-----------------------------------------------------------------------------
+int TestLaplaceMultigridSolver(int width, int height)
+{
+  // the grid is large enough to use several levels, the sparse known pixels
+  // and the wide holes make a badly conditioned system
+  std::vector<bool> isUnknown(width * height, true);
+  std::vector<double> grid(width * height, 0.);
+  for (int y = 0; y < height; ++y)
+  {
+    for (int x = 0; x < width; ++x)
+    {
+      const int index = x + width * y;
+      const bool isOnLattice = x % 13 == 0 && y % 11 == 0;
+      const bool isInHole = std::abs(x - width / 3) < width / 5 && std::abs(y - height / 2) < height / 4;
+      if ((isOnLattice || std::rand() % 20 == 0) && !isInHole)
+      {
+        isUnknown[index] = false;
+        grid[index] = std::sin(0.05 * x) * std::cos(0.07 * y) + std::rand() / static_cast<double>(RAND_MAX);
+      }
+    }
+  }
+  const std::vector<double> expected = SolveCholesky(width, height, isUnknown, grid);
+
+  LaplaceMultigridSolver solver;
+  solver.Setup(width, height, isUnknown);
+  std::vector<double> solution(grid);
+  const int iterations = solver.Solve(solution, 1e-12, 200);
+  if (!solver.HasConverged())
+  {
+    std::cout << "The solver did not converge after " << iterations << " iterations on a "
+              << width << "x" << height << " grid" << std::endl;
+    return 1;
+  }
+
+  int nbErrors = 0;
+  double maxError = 0.;
+  for (size_t index = 0; index < grid.size(); ++index)
+  {
+    if (!isUnknown[index] && solution[index] != grid[index])
+    {
+      std::cout << "The known pixel " << index << " has been modified" << std::endl;
+      nbErrors++;
+    }
+    maxError = std::max(maxError, std::abs(solution[index] - expected[index]));
+  }
+  if (maxError > 1e-7)
+  {
+    std::cout << "The multigrid solution differs from the Cholesky one by " << maxError
+              << " on a " << width << "x" << height << " grid" << std::endl;
+    nbErrors++;
+  }
+
+  // solving again from the solution must stop right away
+  const int nextIterations = solver.Solve(solution, 1e-6, 200);
+  if (!solver.HasConverged() || nextIterations != 0)
+  {
+    std::cout << "The solver did " << nextIterations << " iterations from the solution" << std::endl;
+    nbErrors++;
+  }
+  return nbErrors;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+  // initialize the random generator to a fixed seed
+  // for test repetability
+  std::srand(1992);
+
+  int nbrErrors = 0;
+  // single level, odd sizes, several levels
+  nbrErrors += TestLaplaceMultigridSolver(40, 30);
+  nbrErrors += TestLaplaceMultigridSolver(131, 97);
+  nbrErrors += TestLaplaceMultigridSolver(400, 300);
+  return nbrErrors;
+}
@@ -0,0 +1,182 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// STD
+#include <algorithm>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+// BOOST
+#include <boost/filesystem.hpp>
+
+// LOCAL
+#include "MappedTextFile.h"
+
+namespace
+{
+const size_t NumberOfLines = 200000;
+
+// Parse "index value" lines, reject the other ones
+bool ParseLine(const char* begin, const char* end, ColumnStore& columns)
+{
+  const char* space = std::find(begin, end, ' ');
+  double index, value;
+  if (space == end || !MappedTextFile::ParseDouble(begin, space, index) ||
+      !MappedTextFile::ParseDouble(space + 1, end, value))
+  {
+    return false;
+  }
+  columns.Columns[0].push_back(index);
+  columns.Columns[1].push_back(value);
+  return true;
+}
+
+bool CheckColumns(const ColumnStore& columns, const std::vector<double>& expected,
+                  const std::string& label)
+{
+  if (columns.Columns.size() != 2 || columns.Columns[0].size() != expected.size() ||
+      columns.Columns[1].size() != expected.size())
+  {
+    std::cerr << label << ": wrong number of values" << std::endl;
+    return false;
+  }
+  for (size_t i = 0; i < expected.size(); ++i)
+  {
+    // the values must be in the order of the file, and parsed exactly
+    if (columns.Columns[0][i] != static_cast<double>(i) || columns.Columns[1][i] != expected[i])
+    {
+      std::cerr << label << ": wrong value at line " << i << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+}
+
+int main(int, char*[])
+{
+  boost::filesystem::path directory = boost::filesystem::temp_directory_path();
+  std::string filename = (directory / boost::filesystem::unique_path("%%%%-%%%%.txt")).string();
+  std::string cacheFilename = filename + ".cache";
+
+  // Write lines with various number formats, and a few malformed lines
+  std::vector<double> expected;
+  {
+    std::ofstream file(filename);
+    srand(42);
+    for (size_t i = 0; i < NumberOfLines; ++i)
+    {
+      std::string value;
+      switch (i % 4)
+      {
+        case 0: value = std::to_string(rand() % 100000) + "." + std::to_string(rand() % 1000000); break;
+        case 1: value = "-0.00" + std::to_string(rand() % 1000); break;
+        case 2: value = std::to_string(rand()) + "e-3"; break;
+        default: value = "123456789.1234567891"; break;
+      }
+      expected.push_back(std::strtod(value.c_str(), nullptr));
+      file << i << " " << value << (i % 3 ? "\n" : "\r\n");
+      if (i % 50000 == 0)
+      {
+        file << "\n   \nnot a number\n";
+      }
+    }
+  }
+
+  bool success = true;
+  MappedTextFile text;
+  if (!text.Open(filename))
+  {
+    std::cerr << "Could not open " << filename << std::endl;
+    return EXIT_FAILURE;
+  }
+  for (unsigned int numberOfThreads : { 1u, 3u, 8u })
+  {
+    ColumnStore columns;
+    columns.AddColumn("index");
+    columns.AddColumn("value");
+    size_t malformed = text.ParseLines(0, ParseLine, columns, numberOfThreads);
+    std::string label = std::to_string(numberOfThreads) + " threads";
+    if (malformed != 4)
+    {
+      std::cerr << label << ": " << malformed << " malformed lines instead of 4" << std::endl;
+      success = false;
+    }
+    success &= CheckColumns(columns, expected, label);
+
+    if (numberOfThreads == 8)
+    {
+      // Cache round trip, and rejection of a cache written by another reader
+      ColumnStore loaded, other;
+      if (!columns.Save(cacheFilename, filename, "test 1") ||
+          !loaded.Load(cacheFilename, filename, "test 1") ||
+          other.Load(cacheFilename, filename, "test 2"))
+      {
+        std::cerr << "Cache not saved or loaded as expected" << std::endl;
+        success = false;
+      }
+      success &= CheckColumns(loaded, expected, "cache");
+    }
+  }
+  text.Close();
+
+  // Once the source is modified, the cache is outdated. The modification time
+  // is kept for the first check, so that only the size differs, then the size
+  // is kept for the second one, so that only the modification time differs
+  const std::time_t sourceTime = boost::filesystem::last_write_time(filename) - 10;
+  boost::filesystem::last_write_time(filename, sourceTime);
+  ColumnStore store;
+  store.AddColumn("index");
+  if (!store.Save(cacheFilename, filename, "test 1") || !store.Load(cacheFilename, filename, "test 1"))
+  {
+    std::cerr << "Cache not saved or loaded as expected" << std::endl;
+    success = false;
+  }
+  {
+    std::ofstream file(filename, std::ios::app);
+    file << "0 0\n";
+  }
+  boost::filesystem::last_write_time(filename, sourceTime);
+  ColumnStore outdated;
+  if (outdated.Load(cacheFilename, filename, "test 1"))
+  {
+    std::cerr << "Cache of a source of another size loaded" << std::endl;
+    success = false;
+  }
+  if (!store.Save(cacheFilename, filename, "test 1"))
+  {
+    std::cerr << "Cache not saved" << std::endl;
+    success = false;
+  }
+  {
+    std::fstream file(filename, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(0);
+    file << "1";
+  }
+  boost::filesystem::last_write_time(filename, sourceTime + 1);
+  if (outdated.Load(cacheFilename, filename, "test 1"))
+  {
+    std::cerr << "Cache of a source modified later loaded" << std::endl;
+    success = false;
+  }
+
+  std::remove(filename.c_str());
+  std::remove(cacheFilename.c_str());
+  return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -251,6 +251,30 @@ int main(int argc, char* argv[])
                            true, // no FAA
                            NMEALocation::DIFFERENTIAL_FAA);
 
+  // Sentences with more words than NMEAWords can hold
+  std::string longSentence = "$GPXXX";
+  for (int i = 0; i < 40; ++i)
+  {
+    longSentence += "," + std::to_string(i);
+  }
+  if (parser.SplitWords(longSentence).size() != 41)
+  {
+    std::cerr << "SplitWords dropped words of a long sentence" << std::endl;
+    allgood = false;
+  }
+  NMEAWords words;
+  if (parser.SplitWords(longSentence.c_str(), longSentence.size(), words)
+      || words.size() != NMEAWords::MaximumNumberOfWords)
+  {
+    std::cerr << "Splitting a sentence with too many words did not fail" << std::endl;
+    allgood = false;
+  }
+  NMEALocation location;
+  if (parser.ParseLocation(longSentence, location))
+  {
+    std::cerr << "A sentence with too many words has been parsed" << std::endl;
+    allgood = false;
+  }
 
   return allgood ? 0 : 1;
 }
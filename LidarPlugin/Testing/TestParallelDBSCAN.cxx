@@ -0,0 +1,203 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// STD
+#include <algorithm>
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+
+// LOCAL
+#include "ParallelDBSCAN.h"
+
+namespace
+{
+double Random(double min, double max)
+{
+  return min + (max - min) * std::rand() / static_cast<double>(RAND_MAX);
+}
+
+/**
+ * @brief BruteForceDBSCAN reference clustering, with the neighborhoods computed
+ *        on all pairs of points and the clusters grown by a breadth first search
+ * @param isCore set to true for the core points
+ * @return the cluster of the core points, numbered in the order of their
+ *         first core point, NOISE for the other points
+ */
+std::vector<int> BruteForceDBSCAN(const std::vector<double>& coordinates, double epsilon, int minPts,
+                                  std::vector<std::vector<int>>& neighborhoods, std::vector<bool>& isCore)
+{
+  const int nbPoints = static_cast<int>(coordinates.size() / 3);
+  neighborhoods.assign(nbPoints, std::vector<int>());
+  isCore.assign(nbPoints, false);
+  for (int i = 0; i < nbPoints; ++i)
+  {
+    for (int j = 0; j < nbPoints; ++j)
+    {
+      double squaredDistance = 0.;
+      for (int k = 0; k < 3; ++k)
+      {
+        const double delta = coordinates[3 * i + k] - coordinates[3 * j + k];
+        squaredDistance += delta * delta;
+      }
+      if (squaredDistance <= epsilon * epsilon)
+      {
+        neighborhoods[i].push_back(j);
+      }
+    }
+    isCore[i] = static_cast<int>(neighborhoods[i].size()) >= minPts;
+  }
+
+  std::vector<int> label(nbPoints, ParallelDBSCAN::NOISE);
+  int nbCluster = 0;
+  for (int seed = 0; seed < nbPoints; ++seed)
+  {
+    if (!isCore[seed] || label[seed] != ParallelDBSCAN::NOISE)
+    {
+      continue;
+    }
+    label[seed] = ++nbCluster;
+    std::vector<int> queue(1, seed);
+    for (size_t q = 0; q < queue.size(); ++q)
+    {
+      for (int neighbor : neighborhoods[queue[q]])
+      {
+        if (isCore[neighbor] && label[neighbor] == ParallelDBSCAN::NOISE)
+        {
+          label[neighbor] = nbCluster;
+          queue.push_back(neighbor);
+        }
+      }
+    }
+  }
+  return label;
+}
+}
+
+//-----------------------------------------------------------------------------
+int TestParallelDBSCAN(const std::vector<double>& coordinates, ParallelDBSCAN& dbscan,
+                       double epsilon, int minPts)
+{
+  std::vector<std::vector<int>> neighborhoods;
+  std::vector<bool> isCore;
+  const std::vector<int> expected = BruteForceDBSCAN(coordinates, epsilon, minPts, neighborhoods, isCore);
+  const int expectedNbCluster = expected.empty() ? 0 : *std::max_element(expected.begin(), expected.end());
+
+  int nbErrors = 0;
+  std::vector<int> singleThreadLabels;
+  for (unsigned int numberOfThreads : { 1u, 4u, 0u })
+  {
+    const std::vector<int> labels = dbscan.Fit(epsilon, minPts, numberOfThreads);
+    if (labels.size() != expected.size() || dbscan.GetNbCluster() != expectedNbCluster)
+    {
+      std::cout << "Expected " << expectedNbCluster << " clusters, found " << dbscan.GetNbCluster()
+                << " with epsilon " << epsilon << " and " << numberOfThreads << " threads" << std::endl;
+      return 1;
+    }
+
+    for (size_t i = 0; i < labels.size(); ++i)
+    {
+      bool isValid = labels[i] == expected[i];
+      if (!isCore[i])
+      {
+        // a border point belongs to the cluster of one of its core neighbors
+        bool hasCoreNeighbor = false;
+        bool isInNeighborCluster = false;
+        for (int neighbor : neighborhoods[i])
+        {
+          if (isCore[neighbor])
+          {
+            hasCoreNeighbor = true;
+            isInNeighborCluster = isInNeighborCluster || labels[i] == expected[neighbor];
+          }
+        }
+        isValid = hasCoreNeighbor ? isInNeighborCluster : labels[i] == ParallelDBSCAN::NOISE;
+      }
+      if (!isValid)
+      {
+        std::cout << "Wrong label " << labels[i] << " for the point " << i << " with epsilon "
+                  << epsilon << " and " << numberOfThreads << " threads" << std::endl;
+        nbErrors++;
+      }
+    }
+
+    // the core points do not depend on the number of threads
+    if (singleThreadLabels.empty())
+    {
+      singleThreadLabels = labels;
+    }
+    for (size_t i = 0; i < labels.size(); ++i)
+    {
+      if (isCore[i] && labels[i] != singleThreadLabels[i])
+      {
+        std::cout << "The label of the core point " << i << " depends on the number of threads" << std::endl;
+        nbErrors++;
+        break;
+      }
+    }
+  }
+  return nbErrors;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+  // initialize the random generator to a fixed seed
+  // for test repetability
+  std::srand(1992);
+
+  // dense blobs, some of them touching, in a sparse noise. There are more
+  // points than the size of a block of neighborhoods
+  std::vector<double> coordinates;
+  for (int blob = 0; blob < 8; ++blob)
+  {
+    const double center[3] = { Random(-10, 10), Random(-10, 10), Random(-2, 2) };
+    const double radius = Random(0.5, 2.);
+    for (int i = 0; i < 300; ++i)
+    {
+      for (int k = 0; k < 3; ++k)
+      {
+        coordinates.push_back(center[k] + Random(-radius, radius));
+      }
+    }
+  }
+  for (int i = 0; i < 600; ++i)
+  {
+    coordinates.push_back(Random(-12, 12));
+    coordinates.push_back(Random(-12, 12));
+    coordinates.push_back(Random(-3, 3));
+  }
+
+  int nbrErrors = 0;
+  ParallelDBSCAN dbscan;
+  dbscan.SetPoints(coordinates, 3);
+  if (dbscan.GetNumberOfPoints() != static_cast<int>(coordinates.size() / 3))
+  {
+    std::cout << "Wrong number of points " << dbscan.GetNumberOfPoints() << std::endl;
+    return 1;
+  }
+  // the KD-tree is reused when the parameters change
+  nbrErrors += TestParallelDBSCAN(coordinates, dbscan, 0.3, 5);
+  nbrErrors += TestParallelDBSCAN(coordinates, dbscan, 0.6, 10);
+  nbrErrors += TestParallelDBSCAN(coordinates, dbscan, 1.5, 4);
+
+  // no point, no cluster
+  dbscan.SetPoints(std::vector<double>(), 3);
+  if (!dbscan.Fit(0.5, 5).empty() || dbscan.GetNbCluster() != 0)
+  {
+    std::cout << "Clusters found without any point" << std::endl;
+    nbrErrors++;
+  }
+  return nbrErrors;
+}
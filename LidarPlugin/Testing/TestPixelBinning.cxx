@@ -0,0 +1,159 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// STD
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+
+// LOCAL
+#include "ParallelFor.h"
+#include "PixelBinning.h"
+
+//-----------------------------------------------------------------------------
+int TestParallelFor()
+{
+  int nbErrors = 0;
+  const std::vector<int> sizes = { 0, 1, 7, 1000, 1001 };
+  for (int size : sizes)
+  {
+    for (unsigned int numberOfThreads : { 0u, 1u, 3u, 8u })
+    {
+      for (int minimumChunkSize : { 1, 100 })
+      {
+        // each index must be processed exactly once
+        std::vector<std::atomic<int>> calls(size + 10);
+        for (std::atomic<int>& call : calls)
+        {
+          call = 0;
+        }
+        ParallelFor(10, 10 + size, [&calls](int chunkBegin, int chunkEnd) {
+          for (int i = chunkBegin; i < chunkEnd; ++i)
+          {
+            calls[i]++;
+          }
+        }, numberOfThreads, minimumChunkSize);
+        for (int i = 0; i < size + 10; ++i)
+        {
+          if (calls[i] != (i >= 10 ? 1 : 0))
+          {
+            std::cout << "Index " << i << " processed " << calls[i] << " times, with " << size
+                      << " indices and " << numberOfThreads << " threads" << std::endl;
+            nbErrors++;
+            break;
+          }
+        }
+      }
+    }
+  }
+  return nbErrors;
+}
+
+//-----------------------------------------------------------------------------
+int TestPixelBinning()
+{
+  int nbErrors = 0;
+  const size_t numberOfPixels = 500;
+  const size_t numberOfValues = 20000;
+
+  // some points are out of the image, some pixels stay empty
+  std::vector<int> pixelOfValue(numberOfValues);
+  std::vector<double> values(numberOfValues);
+  std::vector<std::vector<double>> expectedBins(numberOfPixels);
+  for (size_t i = 0; i < numberOfValues; ++i)
+  {
+    const int pixel = std::rand() % (numberOfPixels + 50) - 25;
+    const bool isInImage = pixel >= 0 && pixel < static_cast<int>(numberOfPixels) && pixel % 7 != 0;
+    pixelOfValue[i] = isInImage ? pixel : -1;
+    values[i] = std::rand() / static_cast<double>(RAND_MAX);
+    if (isInImage)
+    {
+      expectedBins[pixel].push_back(values[i]);
+    }
+  }
+
+  PixelBinning bins;
+  bins.Build(numberOfPixels, pixelOfValue, values);
+  if (bins.GetNumberOfPixels() != numberOfPixels)
+  {
+    std::cout << "Expected " << numberOfPixels << " pixels, found " << bins.GetNumberOfPixels() << std::endl;
+    return 1;
+  }
+
+  // same values, in the order of the points
+  for (size_t pixel = 0; pixel < numberOfPixels; ++pixel)
+  {
+    const std::vector<double> binned(bins.Begin(pixel), bins.End(pixel));
+    if (binned != expectedBins[pixel] || bins.IsEmpty(pixel) != expectedBins[pixel].empty())
+    {
+      std::cout << "Wrong values in the pixel " << pixel << std::endl;
+      nbErrors++;
+    }
+  }
+
+  // parallel reduction of the pixels, compared to a sequential sort
+  const double percentile = 0.3;
+  std::vector<double> ranks(numberOfPixels, -1.);
+  ParallelFor(0, static_cast<int>(numberOfPixels), [&bins, &ranks, percentile](int chunkBegin, int chunkEnd) {
+    for (int pixel = chunkBegin; pixel < chunkEnd; ++pixel)
+    {
+      if (!bins.IsEmpty(pixel))
+      {
+        ranks[pixel] = bins.Rank(pixel, percentile);
+      }
+    }
+  }, 4);
+  for (size_t pixel = 0; pixel < numberOfPixels; ++pixel)
+  {
+    std::vector<double>& expected = expectedBins[pixel];
+    double expectedRank = -1.;
+    if (!expected.empty())
+    {
+      std::sort(expected.begin(), expected.end());
+      expectedRank = expected[static_cast<size_t>(std::floor((expected.size() - 1) * percentile))];
+    }
+    if (ranks[pixel] != expectedRank)
+    {
+      std::cout << "Wrong rank in the pixel " << pixel << ": " << ranks[pixel]
+                << " instead of " << expectedRank << std::endl;
+      nbErrors++;
+    }
+  }
+
+  // rebuilding with fewer pixels must not keep the previous values
+  bins.Build(2, std::vector<int>{ 1, -1, 1 }, std::vector<double>{ 3., 2., 1. });
+  if (bins.GetNumberOfPixels() != 2 || !bins.IsEmpty(0) || bins.End(1) - bins.Begin(1) != 2 ||
+      bins.Rank(1, 0.) != 1. || bins.Rank(1, 1.) != 3.)
+  {
+    std::cout << "Wrong bins after a rebuild" << std::endl;
+    nbErrors++;
+  }
+  return nbErrors;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+  // initialize the random generator to a fixed seed
+  // for test repetability
+  std::srand(1992);
+
+  int nbrErrors = 0;
+  nbrErrors += TestParallelFor();
+  nbrErrors += TestPixelBinning();
+  return nbrErrors;
+}
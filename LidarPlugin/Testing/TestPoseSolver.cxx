@@ -0,0 +1,266 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// STD
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+
+// EIGEN
+#include <Eigen/Dense>
+
+// LOCAL
+#include "PoseSolver.h"
+
+namespace
+{
+double Random(double min, double max)
+{
+  return min + (max - min) * std::rand() / static_cast<double>(RAND_MAX);
+}
+
+Eigen::Vector3d RandomVector(double amplitude)
+{
+  return Eigen::Vector3d(Random(-amplitude, amplitude), Random(-amplitude, amplitude),
+                         Random(-amplitude, amplitude));
+}
+
+//! R = Rz * Ry * Rx, as in the SLAM
+Eigen::Quaterniond EulerToQuaternion(const double* angles)
+{
+  return Eigen::AngleAxisd(angles[2], Eigen::Vector3d::UnitZ()) *
+         Eigen::AngleAxisd(angles[1], Eigen::Vector3d::UnitY()) *
+         Eigen::AngleAxisd(angles[0], Eigen::Vector3d::UnitX());
+}
+
+//! Keypoint X transformed by the pose interpolated at time t in [0, 1]
+Eigen::Vector3d Transform(const double* parameters, double t, bool isInterpolated, const Eigen::Vector3d& X)
+{
+  const Eigen::Vector3d T0(parameters[3], parameters[4], parameters[5]);
+  if (!isInterpolated)
+  {
+    return EulerToQuaternion(parameters) * X + T0;
+  }
+  const Eigen::Vector3d T1(parameters[9], parameters[10], parameters[11]);
+  const Eigen::Quaterniond q = EulerToQuaternion(parameters).slerp(t, EulerToQuaternion(parameters + 6));
+  return q * X + (1. - t) * T0 + t * T1;
+}
+
+/**
+ * @brief Matches of keypoints with planes and lines. The point P of a match
+ *        is the transformed keypoint moved along the plane or the line, so
+ *        that the residuals are null at the true pose, except for outliers.
+ */
+struct Matches
+{
+  std::vector<Eigen::Matrix3d> A;
+  std::vector<Eigen::Vector3d> P;
+  std::vector<Eigen::Vector3d> X;
+  std::vector<double> Coefficients;
+  std::vector<double> Times;
+
+  Matches(int nbMatches, const double* truth, bool isInterpolated, double outliersRatio)
+  {
+    for (int k = 0; k < nbMatches; ++k)
+    {
+      const Eigen::Vector3d x = RandomVector(20.);
+      const double t = Random(0., 1.);
+      const Eigen::Vector3d direction = RandomVector(1.).normalized();
+      const bool isPlane = k % 3 != 0;
+      const Eigen::Matrix3d a = isPlane ? Eigen::Matrix3d(direction * direction.transpose())
+                                        : Eigen::Matrix3d(Eigen::Matrix3d::Identity() - direction * direction.transpose());
+      // move the point in the plane or along the line
+      Eigen::Vector3d p = Transform(truth, t, isInterpolated, x);
+      const Eigen::Vector3d tangent = RandomVector(0.5);
+      p += isPlane ? Eigen::Vector3d(tangent - tangent.dot(direction) * direction)
+                   : Eigen::Vector3d(tangent.dot(direction) * direction);
+      if (Random(0., 1.) < outliersRatio)
+      {
+        p += RandomVector(3.);
+      }
+      this->A.push_back(a);
+      this->P.push_back(p);
+      this->X.push_back(x);
+      this->Coefficients.push_back(Random(0.5, 1.));
+      this->Times.push_back(t);
+    }
+  }
+
+  //! cost = 1/2 * sum(c_k * rho(c_k * Y_k^t * A_k * Y_k)), rho(s) = a * atan(s / a)
+  double Cost(const double* parameters, bool isInterpolated, double lossScale) const
+  {
+    double cost = 0.;
+    for (size_t k = 0; k < this->X.size(); ++k)
+    {
+      const Eigen::Vector3d Y = Transform(parameters, this->Times[k], isInterpolated, this->X[k]) - this->P[k];
+      const double c = this->Coefficients[k];
+      cost += 0.5 * c * lossScale * std::atan(c * Y.dot(this->A[k] * Y) / lossScale);
+    }
+    return cost;
+  }
+};
+
+//! Largest difference between the keypoints transformed with the two sets of parameters
+double PoseError(const double* parameters, const double* truth, bool isInterpolated)
+{
+  double error = 0.;
+  const Eigen::Vector3d corners[2] = { Eigen::Vector3d(-20., -20., -20.), Eigen::Vector3d(20., 20., 20.) };
+  for (double t : { 0., 0.5, 1. })
+  {
+    for (const Eigen::Vector3d& corner : corners)
+    {
+      error = std::max(error, (Transform(parameters, t, isInterpolated, corner) -
+                               Transform(truth, t, isInterpolated, corner)).norm());
+    }
+  }
+  return error;
+}
+}
+
+//-----------------------------------------------------------------------------
+int TestExactMatches(bool isInterpolated)
+{
+  const int nbParameters = isInterpolated ? 12 : 6;
+  const double truth[12] = { 0.1, -0.05, 0.3, 1.5, -0.7, 0.2, 0.12, -0.02, 0.38, 2.1, -0.9, 0.25 };
+  const Matches matches(2000, truth, isInterpolated, 0.);
+  PoseSolver solver(matches.A, matches.P, matches.X, matches.Coefficients);
+  solver.SetMaxIterations(50);
+
+  std::vector<double> initialGuess(truth, truth + nbParameters);
+  for (int i = 0; i < nbParameters; ++i)
+  {
+    initialGuess[i] += (i % 6 < 3) ? Random(-0.05, 0.05) : Random(-0.3, 0.3);
+  }
+
+  // the result does not depend on the number of threads
+  int nbErrors = 0;
+  std::vector<double> singleThreadResult;
+  for (unsigned int numberOfThreads : { 1u, 4u })
+  {
+    std::vector<double> parameters(initialGuess);
+    solver.SetNumberOfThreads(numberOfThreads);
+    const PoseSolver::Summary summary = isInterpolated ?
+      solver.SolveInterpolatedMotion(matches.Times, parameters.data()) :
+      solver.SolveIsometry(parameters.data());
+
+    const double error = PoseError(parameters.data(), truth, isInterpolated);
+    if (!summary.Converged || error > 1e-6 || summary.FinalCost > 1e-10)
+    {
+      std::cout << (isInterpolated ? "Interpolated motion" : "Isometry") << " not recovered with "
+                << numberOfThreads << " threads, error: " << error << std::endl
+                << summary.BriefReport() << std::endl;
+      nbErrors++;
+    }
+    if (numberOfThreads == 1)
+    {
+      singleThreadResult = parameters;
+    }
+    else if (parameters != singleThreadResult)
+    {
+      std::cout << "The result depends on the number of threads" << std::endl;
+      nbErrors++;
+    }
+  }
+
+  const Eigen::MatrixXd covariance = solver.GetCovariance();
+  if (covariance.rows() != nbParameters || covariance.cols() != nbParameters ||
+      (covariance - covariance.transpose()).norm() > 1e-9 * covariance.norm())
+  {
+    std::cout << "Wrong covariance of size " << covariance.rows() << "x" << covariance.cols() << std::endl;
+    nbErrors++;
+  }
+  return nbErrors;
+}
+
+//-----------------------------------------------------------------------------
+int TestRobustLoss()
+{
+  const double truth[6] = { 0.1, -0.05, 0.3, 1.5, -0.7, 0.2 };
+  const double initialGuess[6] = { 0.13, -0.08, 0.27, 1.8, -0.5, 0.1 };
+  const Matches matches(3000, truth, false, 0.2);
+  PoseSolver solver(matches.A, matches.P, matches.X, matches.Coefficients);
+  solver.SetMaxIterations(100);
+
+  int nbErrors = 0;
+  double errors[2];
+  const double lossScales[2] = { 0.2, 1e6 };
+  for (int test = 0; test < 2; ++test)
+  {
+    const double lossScale = lossScales[test];
+    double parameters[6];
+    std::copy(initialGuess, initialGuess + 6, parameters);
+    solver.SetLossScale(lossScale);
+    const PoseSolver::Summary summary = solver.SolveIsometry(parameters);
+    errors[test] = PoseError(parameters, truth, false);
+
+    // the cost minimized is the arctan robust cost
+    const double cost = matches.Cost(parameters, false, lossScale);
+    if (!summary.Converged || std::abs(summary.FinalCost - cost) > 1e-9 * cost)
+    {
+      std::cout << "Final cost " << summary.FinalCost << " instead of " << cost
+                << " with a loss scale of " << lossScale << std::endl << summary.BriefReport() << std::endl;
+      nbErrors++;
+    }
+
+    // with the IRLS weights of the arctan loss, the solution is a minimum of
+    // the robust cost: its gradient vanishes, up to the function tolerance
+    const double h = 1e-6;
+    Eigen::Matrix<double, 6, 1> gradient, initialGradient;
+    for (int i = 0; i < 6; ++i)
+    {
+      double plus[6], minus[6];
+      std::copy(parameters, parameters + 6, plus);
+      std::copy(parameters, parameters + 6, minus);
+      plus[i] += h;
+      minus[i] -= h;
+      gradient(i) = (matches.Cost(plus, false, lossScale) - matches.Cost(minus, false, lossScale)) / (2. * h);
+      std::copy(initialGuess, initialGuess + 6, plus);
+      std::copy(initialGuess, initialGuess + 6, minus);
+      plus[i] += h;
+      minus[i] -= h;
+      initialGradient(i) = (matches.Cost(plus, false, lossScale) - matches.Cost(minus, false, lossScale)) / (2. * h);
+    }
+    if (gradient.norm() > 1e-4 * initialGradient.norm())
+    {
+      std::cout << "The gradient of the robust cost does not vanish with a loss scale of "
+                << lossScale << ": " << gradient.transpose() << std::endl;
+      nbErrors++;
+    }
+  }
+
+  // the outliers barely move the robust solution, unlike the least squares one
+  if (errors[0] > 0.1 || errors[0] > 0.2 * errors[1])
+  {
+    std::cout << "The robust loss does not reject the outliers, error: " << errors[0]
+              << " against " << errors[1] << " for the least squares" << std::endl;
+    nbErrors++;
+  }
+  return nbErrors;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+  // initialize the random generator to a fixed seed
+  // for test repetability
+  std::srand(1992);
+
+  int nbrErrors = 0;
+  nbrErrors += TestExactMatches(false);
+  nbrErrors += TestExactMatches(true);
+  nbrErrors += TestRobustLoss();
+  return nbrErrors;
+}
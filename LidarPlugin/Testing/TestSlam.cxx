@@ -26,6 +26,10 @@
 #include "TestHelpers.h"
 #include "Slam.h"
 
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+
 //-----------------------------------------------------------------------------
 std::vector<size_t> ComputeLaserMapping(vtkTable* calib)
 {
@@ -46,6 +50,68 @@ std::vector<size_t> ComputeLaserMapping(vtkTable* calib)
     return laserIdMapping;
 }
 
+//-----------------------------------------------------------------------------
+std::string ReadFile(const std::string& filename)
+{
+  std::ifstream file(filename, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+//-----------------------------------------------------------------------------
+int TestMapRoundTrip(Slam& slam, const std::string& mapFileName)
+{
+  const std::string resavedFileName = mapFileName + ".resaved";
+  if (!slam.SaveMap(mapFileName))
+  {
+    std::cerr << "Could not save the map to " << mapFileName << std::endl;
+    return 1;
+  }
+
+  // resuming from the map restores the maps and the last pose
+  int nbErrors = 0;
+  Slam loaded;
+  if (!loaded.LoadMap(mapFileName, true))
+  {
+    std::cerr << "Could not load the map saved to " << mapFileName << std::endl;
+    return 1;
+  }
+  Transform expected = slam.GetWorldTransform();
+  Transform resumed = loaded.GetWorldTransform();
+  if (!compare(expected.position, resumed.position, 3, 1e-12) ||
+      !compare(expected.orientation, resumed.orientation, 3, 1e-12))
+  {
+    std::cerr << "The pose resumed from the map differs from the saved one" << std::endl;
+    nbErrors++;
+  }
+  if (slam.GetEdgesMap()->size() != loaded.GetEdgesMap()->size() ||
+      slam.GetPlanarsMap()->size() != loaded.GetPlanarsMap()->size() ||
+      slam.GetBlobsMap()->size() != loaded.GetBlobsMap()->size())
+  {
+    std::cerr << "The loaded maps do not have the size of the saved ones" << std::endl;
+    nbErrors++;
+  }
+
+  // saving the loaded map again gives the same file
+  const std::string saved = ReadFile(mapFileName);
+  if (!loaded.SaveMap(resavedFileName) || ReadFile(resavedFileName) != saved)
+  {
+    std::cerr << "Saving a loaded map does not give the same file" << std::endl;
+    nbErrors++;
+  }
+
+  // a truncated map is rejected
+  std::ofstream(resavedFileName, std::ios::binary | std::ios::trunc) << saved.substr(0, saved.size() / 2);
+  if (loaded.LoadMap(resavedFileName, true))
+  {
+    std::cerr << "A truncated map has been loaded" << std::endl;
+    nbErrors++;
+  }
+
+  std::remove(mapFileName.c_str());
+  std::remove(resavedFileName.c_str());
+  return nbErrors;
+}
+
 //-----------------------------------------------------------------------------
 int main(int argc, char* argv[])
 {  
@@ -126,6 +192,8 @@ int main(int argc, char* argv[])
       retVal +=1;
     }
   }
+
+  retVal += TestMapRoundTrip(slam, "TestSlam.map");
   return retVal;
 }
 
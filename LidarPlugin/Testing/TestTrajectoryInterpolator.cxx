@@ -0,0 +1,160 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// STD
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <stdlib.h>
+#include <vector>
+
+// VTK
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkTransform.h>
+
+// LOCAL
+#include "TrajectoryInterpolator.h"
+#include "vtkCustomTransformInterpolator.h"
+
+namespace
+{
+// Constant speed and yaw rate: the linear interpolation of the position and
+// the SLERP of the orientation are exact between two poses
+Eigen::Vector3d Position(double t)
+{
+  return Eigen::Vector3d(2.0 * t, -0.5 * t, 0.1 * t);
+}
+
+Eigen::Quaterniond Orientation(double t)
+{
+  return Eigen::Quaterniond(Eigen::AngleAxisd(0.3 * t, Eigen::Vector3d::UnitZ()));
+}
+
+double RandomTime(double tMin, double tMax)
+{
+  return tMin + (tMax - tMin) * std::rand() / static_cast<double>(RAND_MAX);
+}
+}
+
+//-----------------------------------------------------------------------------
+int TestTrajectoryInterpolator()
+{
+  const double epsilon = 1e-9;
+  TrajectoryInterpolator trajectory;
+  vtkNew<vtkCustomTransformInterpolator> interpolator;
+  interpolator->SetInterpolationTypeToLinear();
+
+  // irregular sampling, the maximum rotation between two poses is below 90 degrees
+  double t = 0;
+  std::vector<double> poseTimes;
+  while (t < 100)
+  {
+    poseTimes.push_back(t);
+    t += 0.05 + 0.5 * std::rand() / static_cast<double>(RAND_MAX);
+  }
+  for (double time : poseTimes)
+  {
+    if (!trajectory.AddPose(time, Position(time), Orientation(time)))
+    {
+      std::cout << "Could not add the pose at " << time << std::endl;
+      return 1;
+    }
+    vtkNew<vtkTransform> transform;
+    Eigen::AngleAxisd rotation(Orientation(time));
+    transform->Translate(Position(time).data());
+    transform->RotateWXYZ(rotation.angle() * 180. / M_PI, rotation.axis().data());
+    interpolator->AddTransform(time, transform.GetPointer());
+  }
+  if (trajectory.AddPose(poseTimes.back(), Position(0), Orientation(0)))
+  {
+    std::cout << "A pose with a time already used has been added" << std::endl;
+    return 1;
+  }
+
+  // increasing, decreasing and random queries, outside of the range as well
+  const double tMin = poseTimes.front();
+  const double tMax = poseTimes.back();
+  std::vector<double> times;
+  for (int i = 0; i < 10000; ++i)
+  {
+    times.push_back(RandomTime(tMin - 1, tMax + 1));
+  }
+  std::sort(times.begin(), times.end());
+  std::vector<double> decreasingTimes(times.rbegin(), times.rend());
+  times.insert(times.end(), decreasingTimes.begin(), decreasingTimes.end());
+  for (int i = 0; i < 1000; ++i)
+  {
+    times.push_back(RandomTime(tMin - 1, tMax + 1));
+  }
+
+  int nbErrors = 0;
+  TrajectoryInterpolator::Cursor cursor(trajectory);
+  std::vector<double> positions(3 * times.size()), rotations(9 * times.size());
+  trajectory.InterpolateRotations(times.data(), times.size(), positions.data(), rotations.data(), 4);
+  vtkNew<vtkTransform> transform;
+  vtkNew<vtkMatrix4x4> matrix;
+  for (size_t k = 0; k < times.size(); ++k)
+  {
+    const double time = std::min(std::max(times[k], tMin), tMax);
+    const Eigen::Vector3d expectedPosition = Position(time);
+    const Eigen::Matrix3d expectedRotation = Orientation(time).toRotationMatrix();
+
+    Eigen::Vector3d position, cursorPosition;
+    Eigen::Quaterniond orientation, cursorOrientation;
+    trajectory.Interpolate(times[k], position, orientation);
+    cursor.Interpolate(times[k], cursorPosition, cursorOrientation);
+    Eigen::Map<Eigen::Vector3d> batchPosition(&positions[3 * k]);
+    Eigen::Map<Eigen::Matrix<double, 3, 3, Eigen::RowMajor>> batchRotation(&rotations[9 * k]);
+
+    interpolator->InterpolateTransform(times[k], transform.GetPointer());
+    transform->GetMatrix(matrix.GetPointer());
+    Eigen::Vector3d vtkPosition;
+    Eigen::Matrix3d vtkRotation;
+    for (int i = 0; i < 3; ++i)
+    {
+      vtkPosition(i) = matrix->GetElement(i, 3);
+      for (int j = 0; j < 3; ++j)
+      {
+        vtkRotation(i, j) = matrix->GetElement(i, j);
+      }
+    }
+
+    if ((position - expectedPosition).norm() > epsilon ||
+        (orientation.toRotationMatrix() - expectedRotation).norm() > epsilon ||
+        (cursorPosition - expectedPosition).norm() > epsilon ||
+        (cursorOrientation.toRotationMatrix() - expectedRotation).norm() > epsilon ||
+        (batchPosition - expectedPosition).norm() > epsilon ||
+        (batchRotation - expectedRotation).norm() > epsilon ||
+        (vtkPosition - expectedPosition).norm() > 1e-6 ||
+        (vtkRotation - expectedRotation).norm() > 1e-6)
+    {
+      std::cout << "Wrong pose at time " << times[k] << std::endl;
+      nbErrors++;
+    }
+  }
+  return nbErrors;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+  // initialize the random generator to a fixed seed
+  // for test repetability
+  std::srand(1992);
+
+  int nbrErrors = 0;
+  nbrErrors += TestTrajectoryInterpolator();
+  return nbrErrors;
+}
@@ -0,0 +1,173 @@
+// Copyright 2019 Kitware SAS.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// STD
+#include <cmath>
+#include <iostream>
+#include <set>
+#include <vector>
+
+// VTK
+#include <vtkDataArray.h>
+#include <vtkGeometryFilter.h>
+#include <vtkInformation.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+#include <vtkTimeSourceExample.h>
+
+// LOCAL
+#include "vtkVoxelGridAccumulation.h"
+
+namespace
+{
+//! vtkTimeSourceExample sets the array "Point Value" to sin(2*PI*t) at time t
+double PointValue(double t)
+{
+  return std::sin(2 * vtkMath::Pi() * t);
+}
+
+//! Update the filter at a given time, as the animation does
+vtkPolyData* UpdateAt(vtkVoxelGridAccumulation* filter, double time)
+{
+  filter->GetOutputInformation(0)->Set(vtkStreamingDemandDrivenPipeline::UPDATE_TIME_STEP(), time);
+  filter->Update();
+  return filter->GetOutput();
+}
+}
+
+//-----------------------------------------------------------------------------
+int TestVoxelGridAccumulation()
+{
+  const double epsilon = 1e-9;
+  int nbErrors = 0;
+
+  // the geometry of the source does not change with time, only "Point Value"
+  vtkNew<vtkTimeSourceExample> source;
+  vtkNew<vtkGeometryFilter> toPolyData;
+  toPolyData->SetInputConnection(source->GetOutputPort());
+  toPolyData->Update();
+  vtkPolyData* frame = toPolyData->GetOutput();
+  const vtkIdType framePoints = frame->GetNumberOfPoints();
+  double expectedCentroid[3] = { 0., 0., 0. };
+  for (vtkIdType i = 0; i < framePoints; ++i)
+  {
+    double point[3];
+    frame->GetPoint(i, point);
+    for (int k = 0; k < 3; ++k)
+    {
+      expectedCentroid[k] += point[k] / framePoints;
+    }
+  }
+
+  // a single voxel contains all the points
+  vtkNew<vtkVoxelGridAccumulation> voxelGrid;
+  voxelGrid->SetInputConnection(toPolyData->GetOutputPort());
+  voxelGrid->SetInputArrayToProcess(0, 0, 0, vtkDataObject::FIELD_ASSOCIATION_POINTS, "Point Value");
+  voxelGrid->SetLeafSize(1000);
+  voxelGrid->UpdateInformation();
+  vtkInformation* outInfo = voxelGrid->GetOutputInformation(0);
+  const int nbTimeSteps = outInfo->Length(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
+  const double* timeSteps = outInfo->Get(vtkStreamingDemandDrivenPipeline::TIME_STEPS());
+  if (nbTimeSteps < 4)
+  {
+    std::cerr << "Expected at least 4 time steps, found " << nbTimeSteps << std::endl;
+    return 1;
+  }
+
+  // accumulate 3 frames, then go back to a frame already accumulated
+  const std::vector<int> indices = { 0, 2, 3, 2 };
+  vtkSmartPointer<vtkDataArray> previousCount;
+  double previousCountValue = 0.;
+  std::set<int> accumulated;
+  double intensitySum = 0.;
+  for (int index : indices)
+  {
+    vtkPolyData* output = UpdateAt(voxelGrid, timeSteps[index]);
+    if (accumulated.insert(index).second)
+    {
+      intensitySum += PointValue(timeSteps[index]);
+    }
+    const int nbFrames = static_cast<int>(accumulated.size());
+    if (voxelGrid->GetNumberOfAccumulatedFrames() != nbFrames)
+    {
+      std::cerr << "Expected " << nbFrames << " accumulated frames, found "
+                << voxelGrid->GetNumberOfAccumulatedFrames() << std::endl;
+      nbErrors++;
+    }
+
+    if (output->GetNumberOfPoints() != 1 || voxelGrid->GetNumberOfVoxels() != 1)
+    {
+      std::cerr << "Expected 1 voxel, found " << output->GetNumberOfPoints() << std::endl;
+      nbErrors++;
+      continue;
+    }
+
+    vtkDataArray* count = output->GetPointData()->GetArray("voxel_count");
+    if (!count || count->GetTuple1(0) != nbFrames * framePoints)
+    {
+      std::cerr << "Wrong number of points in the voxel after " << nbFrames << " frames" << std::endl;
+      nbErrors++;
+    }
+
+    double point[3];
+    output->GetPoint(0, point);
+    for (int k = 0; k < 3; ++k)
+    {
+      if (std::abs(point[k] - expectedCentroid[k]) > epsilon)
+      {
+        std::cerr << "Wrong centroid at time " << timeSteps[index] << std::endl;
+        nbErrors++;
+        break;
+      }
+    }
+
+    vtkDataArray* intensity = output->GetPointData()->GetArray("intensity");
+    if (!intensity || std::abs(intensity->GetTuple1(0) - intensitySum / nbFrames) > 1e-6)
+    {
+      std::cerr << "Wrong mean intensity at time " << timeSteps[index] << std::endl;
+      nbErrors++;
+    }
+
+    // the previous output must not be updated by the new frames
+    if (previousCount && (previousCount == count || previousCount->GetTuple1(0) != previousCountValue))
+    {
+      std::cerr << "The previous output has been modified" << std::endl;
+      nbErrors++;
+    }
+    previousCount = count;
+    previousCountValue = count ? count->GetTuple1(0) : 0.;
+  }
+
+  // modifying the pipeline upstream outdates the accumulated frames
+  source->Modified();
+  UpdateAt(voxelGrid, timeSteps[1]);
+  if (voxelGrid->GetNumberOfAccumulatedFrames() != 1)
+  {
+    std::cerr << "The accumulation has not been cleared after an upstream modification" << std::endl;
+    nbErrors++;
+  }
+  return nbErrors;
+}
+
+//-----------------------------------------------------------------------------
+int main()
+{
+  int nbrErrors = 0;
+  nbrErrors += TestVoxelGridAccumulation();
+  return nbrErrors;
+}
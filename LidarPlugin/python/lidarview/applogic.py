@@ -19,6 +19,7 @@ import time
 import math
 import sys
 import paraview.simple as smp
+import LidarPluginPython as vvmod
 from paraview import servermanager
 from paraview import vtk
 
@@ -798,23 +799,35 @@ def saveFrameRange(filename, frameStart, frameStop, saveFunction):
 
 def saveCSV(filename, timesteps):
 
+    reader = getReader()
+    if reader is None:
+        return
+
     tempDir = kiwiviewerExporter.tempfile.mkdtemp()
     basenameWithoutExtension = os.path.splitext(os.path.basename(filename))[0]
     outDir = os.path.join(tempDir, basenameWithoutExtension)
-    filenameTemplate = os.path.join(outDir, basenameWithoutExtension + ' (Frame %04d).csv')
     os.makedirs(outDir)
 
-    writer = smp.CreateWriter('tmp.csv', getLidar())
-    writer.FieldAssociation = 'Points'
-    writer.Precision = 16
-
-    for t in timesteps:
-        app.scene.AnimationTime = t
-        writer.FileName = filenameTemplate % t
-        writer.UpdatePipeline()
-        rotateCSVFile(writer.FileName)
-
-    smp.Delete(writer)
+    # The frames are decoded and written directly by the exporter, the
+    # points coordinates are always the first columns of each file
+    exporter = vvmod.vtkLidarFramesExporter()
+    exporter.SetReader(reader.GetClientSideObject())
+    exporter.SetOutputDirectory(outDir)
+    exporter.SetFilePrefix(basenameWithoutExtension)
+    exporter.SetFormat(vvmod.vtkLidarFramesExporter.CSV)
+    exporter.SetPrecision(16)
+
+    # consecutive frames are exported at once, so that the reader decodes them in order
+    frameRanges = []
+    for frame in sorted(int(t) for t in timesteps):
+        if frameRanges and frame <= frameRanges[-1][1] + 1:
+            frameRanges[-1][1] = frame
+        else:
+            frameRanges.append([frame, frame])
+    for first, last in frameRanges:
+        exporter.SetFirstFrame(first)
+        exporter.SetLastFrame(last)
+        exporter.Write()
 
     kiwiviewerExporter.zipDir(outDir, filename)
     kiwiviewerExporter.shutil.rmtree(tempDir)
@@ -926,7 +939,7 @@ def onSaveCSV():
             setTransformMode(1 if frameOptions.transform else 0)
 
             if frameOptions.mode == vvSelectFramesDialog.ALL_FRAMES:
-                saveAllFrames(fileName, saveCSV)
+                saveCSV(fileName, getLidar().TimestepValues)
             else:
                 start = frameOptions.start
                 stop = frameOptions.stop
@@ -41,6 +41,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <QPointer>
 #include <QtDebug>
 #include <QApplication>
+#include <QTimer>
 
 // ParaView includes.
 #include "pqAnimationScene.h"
@@ -48,10 +49,21 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "pqEventDispatcher.h"
 #include "pqPipelineSource.h"
 #include "pqSMAdaptor.h"
+#include "pqServerManagerModel.h"
 #include "pqUndoStack.h"
 #include "vtkAnimationScene.h"
+#include "vtkSMPropertyHelper.h"
+
+#include <algorithm>
 
 namespace {
+// frames decoded ahead by each lidar reader during a scheduled playback
+const int DecodeAheadWindowSize = 8;
+
+// period at which the animation clock is checked during a scheduled playback,
+// which also bounds the frame rate
+const int ScheduledTickInterval = 10;
+
 void SetProperty(QPointer<pqAnimationScene> scene, const char* property, int value)
 {
   dynamic_cast<vtkSMIntVectorProperty*>
@@ -64,8 +76,17 @@ void SetProperty(QPointer<pqAnimationScene> scene, const char* property, int val
 vvPlayerControlsController::vvPlayerControlsController(QObject* _parent/*=null*/)
   : QObject(_parent),
     speed(1),
-    duration(0)
+    duration(0),
+    decodeAhead(false),
+    playbackStartTime(0),
+    lastShownIndex(-1),
+    shownFrames(0),
+    skippedFrames(0)
 {
+  this->playbackTimer = new QTimer(this);
+  this->playbackTimer->setTimerType(Qt::PreciseTimer);
+  this->playbackTimer->setInterval(ScheduledTickInterval);
+  QObject::connect(this->playbackTimer, SIGNAL(timeout()), this, SLOT(onScheduledTick()));
 }
 
 //-----------------------------------------------------------------------------
@@ -85,6 +106,7 @@ void vvPlayerControlsController::setAnimationScene(pqAnimationScene* scene)
     {
     return;
     }
+  this->stopScheduledPlay();
   if (this->Scene)
     {
     QObject::disconnect(this->Scene, 0, this, 0);
@@ -130,6 +152,12 @@ void vvPlayerControlsController::onPlay()
     return;
     }
 
+  if (this->decodeAhead)
+    {
+    this->startScheduledPlay();
+    return;
+    }
+
   BEGIN_UNDO_EXCLUDE();
 
   SM_SCOPED_TRACE(CallMethod)
@@ -206,6 +234,7 @@ void vvPlayerControlsController::onPause()
     qDebug() << "No active scene. Cannot play.";
     return;
     }
+  this->stopScheduledPlay();
   this->Scene->getProxy()->InvokeCommand("Stop");
   SetProperty(this->Scene, "PlayMode", 2);
 }
@@ -263,3 +292,208 @@ void vvPlayerControlsController::onSpeedChange(double speed)
   this->onPause();
 }
 
+//-----------------------------------------------------------------------------
+void vvPlayerControlsController::onDecodeAheadChange(bool enabled)
+{
+  if (this->Scene)
+    {
+    this->onPause();
+    }
+  this->decodeAhead = enabled;
+  if (!enabled)
+    {
+    this->disableDecodeAhead();
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vvPlayerControlsController::startScheduledPlay()
+{
+  if (this->playbackTimer->isActive())
+    {
+    return;
+    }
+  QList<double> timeSteps = this->Scene->getTimeSteps();
+  if (timeSteps.isEmpty())
+    {
+    return;
+    }
+
+  this->enableDecodeAhead();
+
+  // start from the current frame, or from the beginning when at the end
+  this->playbackStartTime = this->Scene->getAnimationTime();
+  if (this->playbackStartTime >= timeSteps.last())
+    {
+    this->playbackStartTime = timeSteps.first();
+    this->lastShownIndex = -1;
+    }
+  else
+    {
+    this->lastShownIndex = static_cast<int>(std::upper_bound(timeSteps.begin(),
+      timeSteps.end(), this->playbackStartTime) - timeSteps.begin()) - 1;
+    }
+  this->playbackClock.start();
+  this->frameRateClock.start();
+  this->shownFrames = 0;
+  this->skippedFrames = 0;
+  this->playbackTimer->start();
+
+  emit this->playing(true);
+  emit this->beginNonUndoableChanges();
+}
+
+//-----------------------------------------------------------------------------
+void vvPlayerControlsController::stopScheduledPlay()
+{
+  if (!this->playbackTimer->isActive())
+    {
+    return;
+    }
+  this->playbackTimer->stop();
+  emit this->playing(false);
+  emit this->endNonUndoableChanges();
+}
+
+//-----------------------------------------------------------------------------
+void vvPlayerControlsController::onScheduledTick()
+{
+  if (!this->Scene)
+    {
+    this->stopScheduledPlay();
+    return;
+    }
+  QList<double> timeSteps = this->Scene->getTimeSteps();
+  if (timeSteps.isEmpty())
+    {
+    this->stopScheduledPlay();
+    return;
+    }
+
+  // frame reached by the clock. With "All frames", the next one as soon as it is decoded
+  int targetIndex = this->lastShownIndex + 1;
+  if (this->speed != 0)
+    {
+    double time = this->playbackStartTime + this->speed * this->playbackClock.nsecsElapsed() * 1e-9;
+    targetIndex = static_cast<int>(std::upper_bound(timeSteps.begin(),
+      timeSteps.end(), time) - timeSteps.begin()) - 1;
+    }
+  if (this->lastShownIndex == timeSteps.size() - 1 && targetIndex >= timeSteps.size() - 1)
+    {
+    bool loop = pqSMAdaptor::getElementProperty(
+      this->Scene->getProxy()->GetProperty("Loop")).toBool();
+    if (!loop)
+      {
+      this->onPause();
+      return;
+      }
+    this->playbackStartTime = timeSteps.first();
+    this->playbackClock.restart();
+    this->lastShownIndex = -1;
+    targetIndex = 0;
+    }
+  targetIndex = std::min(targetIndex, timeSteps.size() - 1);
+  if (targetIndex <= this->lastShownIndex)
+    {
+    return;
+    }
+
+  // Display the latest frame already decoded, the frames in between are skipped.
+  // If none is, the frame reached by the clock is decoded now, which also moves
+  // the readers decode ahead window there.
+  int index = targetIndex;
+  if (this->speed != 0)
+    {
+    while (index > this->lastShownIndex && !this->isFrameDecoded(timeSteps[index]))
+      {
+      --index;
+      }
+    if (index == this->lastShownIndex)
+      {
+      index = targetIndex;
+      }
+    }
+  if (this->lastShownIndex >= 0)
+    {
+    this->skippedFrames += index - this->lastShownIndex - 1;
+    }
+  this->lastShownIndex = index;
+  this->Scene->setAnimationTime(timeSteps[index]);
+  this->shownFrames++;
+  emit this->timestepChanged();
+
+  qint64 elapsed = this->frameRateClock.elapsed();
+  if (elapsed >= 1000)
+    {
+    double achieved = 1000. * this->shownFrames / elapsed;
+    double target = 0;
+    if (this->speed != 0 && timeSteps.size() > 1 && timeSteps.last() > timeSteps.first())
+      {
+      double recordFrameRate = (timeSteps.size() - 1) / (timeSteps.last() - timeSteps.first());
+      target = std::min(recordFrameRate * this->speed, 1000. / ScheduledTickInterval);
+      }
+    emit this->frameRate(achieved, target, this->skippedFrames);
+    this->frameRateClock.restart();
+    this->shownFrames = 0;
+    this->skippedFrames = 0;
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vvPlayerControlsController::enableDecodeAhead()
+{
+  this->decodeAheadSources.clear();
+  pqServerManagerModel* smModel = pqApplicationCore::instance()->getServerManagerModel();
+  foreach (pqPipelineSource* source, smModel->findItems<pqPipelineSource*>())
+    {
+    vtkSMProxy* proxy = source->getProxy();
+    if (!proxy->GetProperty("DecodeAheadWindow"))
+      {
+      continue;
+      }
+    // keep a window chosen by the user
+    if (vtkSMPropertyHelper(proxy, "DecodeAheadWindow").GetAsInt() == 0)
+      {
+      vtkSMPropertyHelper(proxy, "DecodeAheadWindow").Set(DecodeAheadWindowSize);
+      proxy->UpdateVTKObjects();
+      this->enabledDecodeAheadSources.append(source);
+      }
+    this->decodeAheadSources.append(source);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vvPlayerControlsController::disableDecodeAhead()
+{
+  foreach (QPointer<pqPipelineSource> source, this->enabledDecodeAheadSources)
+    {
+    if (source)
+      {
+      vtkSMPropertyHelper(source->getProxy(), "DecodeAheadWindow").Set(0);
+      source->getProxy()->UpdateVTKObjects();
+      }
+    }
+  this->enabledDecodeAheadSources.clear();
+  this->decodeAheadSources.clear();
+}
+
+//-----------------------------------------------------------------------------
+bool vvPlayerControlsController::isFrameDecoded(double time)
+{
+  foreach (QPointer<pqPipelineSource> source, this->decodeAheadSources)
+    {
+    if (!source)
+      {
+      continue;
+      }
+    vtkSMProxy* proxy = source->getProxy();
+    vtkSMPropertyHelper(proxy, "DecodedFrameQueryTime").Set(time);
+    proxy->UpdateVTKObjects();
+    proxy->UpdatePropertyInformation(proxy->GetProperty("IsQueriedFrameDecoded"));
+    if (vtkSMPropertyHelper(proxy, "IsQueriedFrameDecoded").GetAsInt() == 0)
+      {
+      return false;
+      }
+    }
+  return true;
+}
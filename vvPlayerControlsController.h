@@ -34,11 +34,14 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 
 #include "pqComponentsModule.h"
+#include <QElapsedTimer>
+#include <QList>
 #include <QPointer>
 #include <QObject>
 
 class pqPipelineSource;
 class pqAnimationScene;
+class QTimer;
 
 // vvPlayerControlsController is the QObject that encapsulates the
 // VCR control functionality.
@@ -81,6 +84,11 @@ signals:
   /// emitted when the animation ends playing.
   void endNonUndoableChanges();
 
+  /// emitted about once per second while playing with the frames decoded
+  /// ahead: frames displayed per second, frames per second expected at the
+  /// current speed and number of frames skipped to keep up with the clock.
+  void frameRate(double achieved, double target, int skipped);
+
 public slots:
   // Set the animation scene. If null, the VCR control is disabled
   // (emits enabled(false)).
@@ -99,8 +107,16 @@ public slots:
   void onLoop(bool checked);
   void onSpeedChange(double speed);
 
+  // When enabled, play does not use the animation scene clock. The lidar
+  // readers decode the upcoming frames on a dedicated thread, and each tick
+  // displays the latest decoded frame the clock has reached, skipping the
+  // others, so that the playback follows the speed even if a frame takes
+  // longer to decode than the frame period.
+  void onDecodeAheadChange(bool enabled);
+
 protected slots:
   void onTick();
+  void onScheduledTick();
   void onLoopPropertyChanged();
   void onBeginPlay();
   void onEndPlay();
@@ -109,9 +125,30 @@ private:
   vvPlayerControlsController(const vvPlayerControlsController&); // Not implemented.
   void operator=(const vvPlayerControlsController&); // Not implemented.
 
+  void startScheduledPlay();
+  void stopScheduledPlay();
+  void enableDecodeAhead();
+  void disableDecodeAhead();
+  bool isFrameDecoded(double time);
+
   QPointer<pqAnimationScene> Scene;
   double speed;
   double duration;
+
+  // play with the frames decoded ahead
+  bool decodeAhead;
+  QTimer* playbackTimer;
+  // wall clock time since the animation time was playbackStartTime
+  QElapsedTimer playbackClock;
+  double playbackStartTime;
+  int lastShownIndex;
+  // lidar readers decoding ahead, and the ones for which it has been enabled here
+  QList<QPointer<pqPipelineSource> > decodeAheadSources;
+  QList<QPointer<pqPipelineSource> > enabledDecodeAheadSources;
+  // frames shown and skipped since frameRateClock started
+  QElapsedTimer frameRateClock;
+  int shownFrames;
+  int skippedFrames;
 };
 
 #endif // VVPLAYERCONTROLSCONTROLLER_H
@@ -36,6 +36,7 @@ SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <limits>
 
 #include <QLabel>
+#include <QCheckBox>
 #include <QComboBox>
 #include <QSlider>
 #include <QSpinBox>
@@ -64,6 +65,8 @@ public:
   pqPropertyLinks Links;
   QList<QPair<double, QString> > speedFactor;
   QComboBox* speedComboBox;
+  QCheckBox* decodeAheadCheckBox;
+  QLabel* frameRateLabel;
   QSlider* frameSlider;
   QDoubleSpinBox* timeSpinBox;
   QSpinBox* frameQSpinBox;
@@ -163,6 +166,17 @@ vvPlayerControlsToolbar::vvPlayerControlsToolbar(QWidget* parentObject)
   QObject::connect(this, SIGNAL(speedChange(double)),
     controller, SLOT(onSpeedChange(double)));
 
+  //------------------------//
+  // Add the decode ahead playback
+  //------------------------//
+  this->UI->decodeAheadCheckBox = new QCheckBox("Decode ahead", this);
+  this->UI->decodeAheadCheckBox->setToolTip(
+    "Decode the upcoming frames on a dedicated thread while playing, and skip "
+    "frames to keep up with the speed instead of slowing down");
+  this->addWidget(this->UI->decodeAheadCheckBox);
+  QObject::connect(this->UI->decodeAheadCheckBox, SIGNAL(toggled(bool)),
+    controller, SLOT(onDecodeAheadChange(bool)));
+
   // add a separator to visualy group the element together
   this->addSeparator();
 
@@ -200,6 +214,10 @@ vvPlayerControlsToolbar::vvPlayerControlsToolbar(QWidget* parentObject)
   this->UI->frameLabel = new QLabel();
   this->addWidget(this->UI->frameLabel);
 
+  // achieved versus target frame rate, only shown when decoding ahead
+  this->UI->frameRateLabel = new QLabel();
+  this->addWidget(this->UI->frameRateLabel);
+
   // create connection
   this->connect(this->UI->frameQSpinBox, SIGNAL(valueChanged(int)),
     this, SLOT(setTimeStep(int)));
@@ -236,6 +254,8 @@ vvPlayerControlsToolbar::vvPlayerControlsToolbar(QWidget* parentObject)
     ui.actionLoop, SLOT(setChecked(bool)));
   QObject::connect(controller, SIGNAL(playing(bool)),
     this, SLOT(onPlaying(bool)));
+  QObject::connect(controller, SIGNAL(frameRate(double, double, int)),
+    this, SLOT(onFrameRate(double, double, int)));
 }
 
 //-----------------------------------------------------------------------------
@@ -268,6 +288,7 @@ void vvPlayerControlsToolbar::onPlaying(bool playing)
     this->UI->actionPlay->setIcon(
       QIcon(":/vvResources/Icons/media-playback-start.png"));
     this->UI->actionPlay->setText("&Play");
+    this->UI->frameRateLabel->clear();
     }
 
   // this becomes a behavior.
@@ -287,6 +308,23 @@ void vvPlayerControlsToolbar::onSpeedChanged()
   }
 }
 
+//-----------------------------------------------------------------------------
+void vvPlayerControlsToolbar::onFrameRate(double achieved, double target, int skipped)
+{
+  if (target > 0)
+  {
+    this->UI->frameRateLabel->setText(
+      QString("%1 / %2 fps").arg(achieved, 0, 'f', 1).arg(target, 0, 'f', 1));
+  }
+  else
+  {
+    this->UI->frameRateLabel->setText(QString("%1 fps").arg(achieved, 0, 'f', 1));
+  }
+  this->UI->frameRateLabel->setToolTip(
+    QString("Frames displayed per second versus expected at this speed.\n"
+            "%1 frame(s) skipped in the last second").arg(skipped));
+}
+
 //-----------------------------------------------------------------------------
 void vvPlayerControlsToolbar::setAnimationScene(pqAnimationScene* scene)
 {